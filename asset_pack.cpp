@@ -0,0 +1,252 @@
+#include "asset_pack.h"
+#include "hash.h"
+#include "lz4.h"
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Отображение файла -----------------------------------------------------
+
+static const unsigned char* map_file(const char* path, size_t* size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER file_size;
+    const unsigned char* data = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        // Отображение держит файл открытым само, дескрипторы можно закрыть сразу
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        *size = (size_t)info.st_size;
+    }
+    close(fd);
+    return data == MAP_FAILED ? NULL : (const unsigned char*)data;
+#endif
+}
+
+static void unmap_file(const unsigned char* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+// --- Чтение ----------------------------------------------------------------
+
+bool asset_pack_open(AssetPack* pack, const char* path, const char* mount) {
+    pack->data = NULL;
+    pack->size = 0;
+    pack->mount = mount ? mount : "";
+    size_t size = 0;
+    const unsigned char* data = map_file(path, &size);
+    if (!data)
+        return false;
+
+    // Проверяем только заголовок и границы таблиц — записи проверяются при чтении
+    const AssetPackHeader* header = (const AssetPackHeader*)data;
+    bool valid = size >= sizeof(AssetPackHeader) && header->magic == ASSET_PACK_MAGIC && header->version == ASSET_PACK_VERSION
+                 && header->file_size == size && header->toc_offset % ASSET_PACK_TOC_ALIGNMENT == 0
+                 && header->toc_offset <= size && (size - header->toc_offset) / sizeof(AssetPackEntry) >= header->entry_count
+                 && header->names_offset <= size && header->names_size <= size - header->names_offset
+                 && (header->names_size == 0 || data[header->names_offset + header->names_size - 1] == 0);
+    if (!valid) {
+        unmap_file(data, size);
+        return false;
+    }
+    pack->data = data;
+    pack->size = size;
+    pack->header = header;
+    pack->entries = (const AssetPackEntry*)(data + header->toc_offset);
+    pack->names = (const char*)(data + header->names_offset);
+    return true;
+}
+
+void asset_pack_close(AssetPack* pack) {
+    if (pack->data)
+        unmap_file(pack->data, pack->size);
+    pack->data = NULL;
+    pack->size = 0;
+}
+
+const char* asset_pack_entry_name(const AssetPack* pack, const AssetPackEntry* entry) {
+    return entry->name_offset < pack->header->names_size ? pack->names + entry->name_offset : "";
+}
+
+const AssetPackEntry* asset_pack_find(const AssetPack* pack, const char* path) {
+    if (!pack || !pack->data)
+        return NULL;
+    if (!pack->mount.empty() && strncmp(path, pack->mount.c_str(), pack->mount.size()) == 0)
+        path += pack->mount.size();
+
+    uint64_t hash = fnv1a_64(path);
+    const AssetPackEntry* begin = pack->entries;
+    const AssetPackEntry* end = pack->entries + pack->header->entry_count;
+    const AssetPackEntry* it = std::lower_bound(begin, end, hash,
+                                                [](const AssetPackEntry& entry, uint64_t value) { return entry.name_hash < value; });
+    // Коллизии хешей редки, но возможны — сверяем имя
+    for (; it != end && it->name_hash == hash; ++it) {
+        if (strcmp(asset_pack_entry_name(pack, it), path) == 0)
+            return it;
+    }
+    return NULL;
+}
+
+bool asset_pack_read(const AssetPack* pack, const AssetPackEntry* entry, const unsigned char** data, size_t* size,
+                     std::vector<unsigned char>* scratch) {
+    if (entry->offset > pack->size || entry->stored_size > pack->size - entry->offset)
+        return false;
+    const unsigned char* stored = pack->data + entry->offset;
+    if (entry->compression == ASSET_COMPRESSION_NONE) {
+        if (entry->stored_size != entry->size)
+            return false;
+        *data = stored;
+        *size = (size_t)entry->size;
+        return true;
+    }
+    if (entry->compression != ASSET_COMPRESSION_LZ4)
+        return false;
+    scratch->resize((size_t)entry->size);
+    if (!lz4_decompress(stored, (size_t)entry->stored_size, scratch->data(), scratch->size()))
+        return false;
+    *data = scratch->data();
+    *size = scratch->size();
+    return true;
+}
+
+const char* asset_pack_parse_path(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--pack") == 0)
+            return argv[i + 1];
+    }
+    return NULL;
+}
+
+// --- Сборка ----------------------------------------------------------------
+
+static bool ends_with(const char* path, const char* suffix) {
+    size_t length = strlen(path), suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(path + length - suffix_length, suffix) == 0;
+}
+
+AssetType asset_type_from_path(const char* path) {
+    if (ends_with(path, ".vert") || ends_with(path, ".frag") || ends_with(path, ".glsl"))
+        return ASSET_TYPE_SHADER;
+    if (ends_with(path, ".ktx2") || ends_with(path, ".dds"))
+        return ASSET_TYPE_TEXTURE;
+    if (ends_with(path, ".mesh"))
+        return ASSET_TYPE_MESH;
+    return ASSET_TYPE_BLOB;
+}
+
+const char* asset_type_name(AssetType type) {
+    switch (type) {
+        case ASSET_TYPE_SHADER: return "shader";
+        case ASSET_TYPE_TEXTURE: return "texture";
+        case ASSET_TYPE_MESH: return "mesh";
+        default: return "blob";
+    }
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool asset_pack_write(const char* path, const std::vector<AssetPackSource>& sources) {
+    std::vector<const AssetPackSource*> sorted;
+    for (const AssetPackSource& source : sources)
+        sorted.push_back(&source);
+    std::sort(sorted.begin(), sorted.end(), [](const AssetPackSource* a, const AssetPackSource* b) {
+        uint64_t ha = fnv1a_64(a->name.c_str()), hb = fnv1a_64(b->name.c_str());
+        return ha != hb ? ha < hb : a->name < b->name;
+    });
+
+    AssetPackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = (uint32_t)sorted.size();
+    header.toc_offset = align_up(sizeof(AssetPackHeader), ASSET_PACK_TOC_ALIGNMENT);
+    header.names_offset = header.toc_offset + sizeof(AssetPackEntry) * sorted.size();
+
+    std::vector<char> names;
+    std::vector<AssetPackEntry> entries(sorted.size());
+    std::vector<std::vector<unsigned char>> compressed(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const AssetPackSource* source = sorted[i];
+        AssetPackEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.name_hash = fnv1a_64(source->name.c_str());
+        entry.content_hash = fnv1a_64_bytes(source->data.data(), source->data.size());
+        entry.name_offset = (uint32_t)names.size();
+        entry.type = (uint8_t)source->type;
+        entry.size = source->data.size();
+        entry.stored_size = entry.size;
+        names.insert(names.end(), source->name.begin(), source->name.end());
+        names.push_back('\0');
+
+        if (source->compress && !source->data.empty()) {
+            std::vector<unsigned char>& packed = compressed[i];
+            packed.resize(lz4_compress_bound(source->data.size()));
+            size_t packed_size = lz4_compress(source->data.data(), source->data.size(), packed.data(), packed.size());
+            if (packed_size && packed_size <= source->data.size() * (1.0 - ASSET_PACK_MIN_SAVING)) {
+                packed.resize(packed_size);
+                entry.compression = ASSET_COMPRESSION_LZ4;
+                entry.stored_size = packed_size;
+            } else {
+                packed.clear();
+            }
+        }
+    }
+    header.names_size = names.size();
+
+    uint64_t offset = header.names_offset + header.names_size;
+    for (AssetPackEntry& entry : entries) {
+        offset = align_up(offset, ASSET_PACK_DATA_ALIGNMENT);
+        entry.offset = offset;
+        offset += entry.stored_size;
+    }
+    header.file_size = offset;
+
+    std::vector<unsigned char> out((size_t)header.file_size, 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + header.toc_offset, entries.data(), sizeof(AssetPackEntry) * entries.size());
+    memcpy(out.data() + header.names_offset, names.data(), names.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const std::vector<unsigned char>& payload = compressed[i].empty() ? sorted[i]->data : compressed[i];
+        if (!payload.empty())
+            memcpy(out.data() + entries[i].offset, payload.data(), payload.size());
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write((const char*)out.data(), (std::streamsize)out.size());
+    return (bool)file;
+}
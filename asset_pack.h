@@ -0,0 +1,105 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Пакет ресурсов: один файл с шейдерами, готовыми текстурами (KTX2/DDS) и мешами.
+// Файл целиком отображается в память; открытие проверяет только заголовок, поиск —
+// двоичный по хешам имён в выровненном оглавлении, так что ни открытие, ни чтение
+// записи не делают системных вызовов на каждый ресурс. Несжатые записи читаются
+// прямо из отображения, сжатые (LZ4) распаковываются в буфер вызывающего.
+//
+// Раскладка (little-endian):
+//   AssetPackHeader (64 байта)
+//   AssetPackEntry[entry_count] с ASSET_PACK_TOC_ALIGNMENT, отсортированы по name_hash
+//   имена, каждое завершено нулём
+//   данные записей, каждая с ASSET_PACK_DATA_ALIGNMENT
+
+static const uint32_t ASSET_PACK_MAGIC = 0x4b505256; // "VRPK"
+static const uint32_t ASSET_PACK_VERSION = 1;
+static const uint64_t ASSET_PACK_TOC_ALIGNMENT = 64;
+static const uint64_t ASSET_PACK_DATA_ALIGNMENT = 256; // под копирование в буфер распаковки пикселей
+
+typedef enum {
+    ASSET_TYPE_BLOB,
+    ASSET_TYPE_SHADER,
+    ASSET_TYPE_TEXTURE, // KTX2 или DDS
+    ASSET_TYPE_MESH     // mesh_write_blob
+} AssetType;
+
+typedef enum {
+    ASSET_COMPRESSION_NONE,
+    ASSET_COMPRESSION_LZ4
+} AssetCompression;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved0;
+    uint64_t toc_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint64_t file_size;
+    uint64_t reserved[2];
+} AssetPackHeader;
+
+typedef struct {
+    uint64_t name_hash;    // FNV-1a имени
+    uint64_t content_hash; // FNV-1a распакованного содержимого — ключ кэшей без повторного хеширования
+    uint64_t offset;       // от начала файла
+    uint64_t stored_size;  // в файле
+    uint64_t size;         // после распаковки
+    uint32_t name_offset;  // в таблице имён
+    uint8_t type;          // AssetType
+    uint8_t compression;   // AssetCompression
+    uint16_t reserved;
+} AssetPackEntry;
+
+static_assert(sizeof(AssetPackHeader) == 64, "AssetPackHeader must be 64 bytes");
+static_assert(sizeof(AssetPackEntry) == 48, "AssetPackEntry must be 48 bytes");
+
+typedef struct {
+    const unsigned char* data; // всё отображение; NULL — пакет не открыт
+    size_t size;
+    const AssetPackHeader* header;
+    const AssetPackEntry* entries;
+    const char* names;
+    std::string mount; // префикс путей, под которым видны записи (например "D:/vr/zad3/")
+} AssetPack;
+
+// mount может быть NULL — тогда записи ищутся только по именам внутри пакета
+bool asset_pack_open(AssetPack* pack, const char* path, const char* mount);
+void asset_pack_close(AssetPack* pack);
+
+// Путь с префиксом mount или имя внутри пакета; NULL — записи нет (или пакет не открыт)
+const AssetPackEntry* asset_pack_find(const AssetPack* pack, const char* path);
+const char* asset_pack_entry_name(const AssetPack* pack, const AssetPackEntry* entry);
+// Несжатые записи — указатель прямо в отображение; сжатые распаковываются в scratch
+bool asset_pack_read(const AssetPack* pack, const AssetPackEntry* entry, const unsigned char** data, size_t* size,
+                     std::vector<unsigned char>* scratch);
+
+// --pack FILE; NULL — пакет не задан
+const char* asset_pack_parse_path(int argc, char** argv);
+
+// --- Сборка ----------------------------------------------------------------
+
+typedef struct {
+    std::string name;
+    AssetType type;
+    std::vector<unsigned char> data;
+    bool compress; // LZ4, если это экономит хотя бы ASSET_PACK_MIN_SAVING
+} AssetPackSource;
+
+static const double ASSET_PACK_MIN_SAVING = 0.1;
+
+// По расширению: .vert/.frag/.glsl — шейдер, .ktx2/.dds — текстура, .mesh — меш
+AssetType asset_type_from_path(const char* path);
+const char* asset_type_name(AssetType type);
+
+bool asset_pack_write(const char* path, const std::vector<AssetPackSource>& sources);
+
+#endif
@@ -0,0 +1,88 @@
+// Сборка пакета ресурсов: шейдеры, готовые текстуры (после texcook) и меши в один файл.
+//   assetpack <output.vrpk> [--root DIR] [--lz4] <files...>
+// Имя записи — путь файла относительно DIR (по умолчанию как есть), с прямыми слешами.
+// --lz4 сжимает шейдеры и меши; текстуры остаются несжатыми, чтобы копироваться
+// из отображения прямо в буфер распаковки.
+#include "asset_pack.h"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+
+static void print_usage() {
+    fprintf(stderr, "usage: assetpack <output.vrpk> [--root DIR] [--lz4] <files...>\n");
+}
+
+static std::string entry_name(const std::string& path, const std::string& root) {
+    std::string name = path;
+    for (char& c : name) {
+        if (c == '\\')
+            c = '/';
+    }
+    if (!root.empty() && name.compare(0, root.size(), root) == 0)
+        name.erase(0, root.size());
+    return name;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    const char* output = argv[1];
+
+    std::string root;
+    bool lz4 = false;
+    std::vector<const char*> inputs;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = entry_name(argv[++i], "");
+            if (!root.empty() && root.back() != '/')
+                root += '/';
+        } else if (strcmp(argv[i], "--lz4") == 0) {
+            lz4 = true;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<AssetPackSource> sources;
+    size_t raw_bytes = 0;
+    for (const char* input : inputs) {
+        std::ifstream file(input, std::ios::binary);
+        if (!file.is_open()) {
+            fprintf(stderr, "Failed to open %s\n", input);
+            return 1;
+        }
+        AssetPackSource source;
+        source.name = entry_name(input, root);
+        source.type = asset_type_from_path(input);
+        source.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        source.compress = lz4 && source.type != ASSET_TYPE_TEXTURE;
+        raw_bytes += source.data.size();
+        printf("  %-8s %s (%zu bytes)\n", asset_type_name(source.type), source.name.c_str(), source.data.size());
+        sources.push_back(std::move(source));
+    }
+
+    if (!asset_pack_write(output, sources)) {
+        fprintf(stderr, "Failed to write %s\n", output);
+        return 1;
+    }
+
+    AssetPack pack;
+    if (!asset_pack_open(&pack, output, NULL)) {
+        fprintf(stderr, "Written pack %s does not open\n", output);
+        return 1;
+    }
+    unsigned compressed = 0;
+    for (uint32_t i = 0; i < pack.header->entry_count; i++)
+        compressed += pack.entries[i].compression == ASSET_COMPRESSION_LZ4;
+    printf("%s: %u entries (%u lz4), %zu bytes of assets -> %zu bytes\n", output, pack.header->entry_count, compressed,
+           raw_bytes, pack.size);
+    asset_pack_close(&pack);
+    return 0;
+}
@@ -0,0 +1,752 @@
+#include "block_compress.h"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BLOCK_HAVE_SIMD 1
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define BLOCK_HAVE_SIMD 1
+#endif
+
+// Пиксели блока по каналам: 16 значений подряд удобно перебирать и скалярно, и векторами
+typedef struct {
+    alignas(32) int c[4][16];
+} BlockPixels;
+
+static void load_block_pixels(const unsigned char* rgba, BlockPixels* px) {
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++)
+            px->c[c][i] = rgba[i * 4 + c];
+}
+
+// --- Выбор индексов палитры ------------------------------------------------
+// Для каждого пикселя — ближайший элемент палитры по сумме квадратов разностей
+// в каналах [first, first + dims); при равенстве — элемент с меньшим номером.
+// Возвращает суммарную ошибку блока. Векторные версии дают те же индексы:
+// целочисленная арифметика и строгое сравнение, как в скалярной.
+
+static int select_indices_scalar(const BlockPixels* px, int first, int dims, const int (*palette)[4], int count, int* indices) {
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, best_error = INT_MAX;
+        for (int p = 0; p < count; p++) {
+            int error = 0;
+            for (int c = first; c < first + dims; c++) {
+                int d = px->c[c][i] - palette[p][c];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best = p;
+            }
+        }
+        indices[i] = best;
+        total += best_error;
+    }
+    return total;
+}
+
+#if defined(__AVX2__)
+static int select_indices_simd(const BlockPixels* px, int first, int dims, const int (*palette)[4], int count, int* indices) {
+    __m256i best[2], best_index[2];
+    for (int g = 0; g < 2; g++) {
+        best[g] = _mm256_set1_epi32(INT_MAX);
+        best_index[g] = _mm256_setzero_si256();
+    }
+    for (int p = 0; p < count; p++) {
+        __m256i index = _mm256_set1_epi32(p);
+        for (int g = 0; g < 2; g++) {
+            __m256i error = _mm256_setzero_si256();
+            for (int c = first; c < first + dims; c++) {
+                __m256i d = _mm256_sub_epi32(_mm256_load_si256((const __m256i*)(px->c[c] + 8 * g)), _mm256_set1_epi32(palette[p][c]));
+                error = _mm256_add_epi32(error, _mm256_mullo_epi32(d, d));
+            }
+            __m256i less = _mm256_cmpgt_epi32(best[g], error);
+            best[g] = _mm256_blendv_epi8(best[g], error, less);
+            best_index[g] = _mm256_blendv_epi8(best_index[g], index, less);
+        }
+    }
+    __m256i sum = _mm256_add_epi32(best[0], best[1]);
+    __m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2, 3, 0, 1)));
+    _mm256_storeu_si256((__m256i*)indices, best_index[0]);
+    _mm256_storeu_si256((__m256i*)(indices + 8), best_index[1]);
+    return _mm_cvtsi128_si32(sum4);
+}
+#elif defined(BLOCK_HAVE_SIMD)
+static int select_indices_simd(const BlockPixels* px, int first, int dims, const int (*palette)[4], int count, int* indices) {
+    __m128i best[4], best_index[4];
+    for (int g = 0; g < 4; g++) {
+        best[g] = _mm_set1_epi32(INT_MAX);
+        best_index[g] = _mm_setzero_si128();
+    }
+    for (int p = 0; p < count; p++) {
+        __m128i index = _mm_set1_epi32(p);
+        for (int g = 0; g < 4; g++) {
+            __m128i error = _mm_setzero_si128();
+            for (int c = first; c < first + dims; c++) {
+                __m128i d = _mm_sub_epi32(_mm_load_si128((const __m128i*)(px->c[c] + 4 * g)), _mm_set1_epi32(palette[p][c]));
+                error = _mm_add_epi32(error, _mm_mullo_epi32(d, d));
+            }
+            __m128i less = _mm_cmpgt_epi32(best[g], error);
+            best[g] = _mm_blendv_epi8(best[g], error, less);
+            best_index[g] = _mm_blendv_epi8(best_index[g], index, less);
+        }
+    }
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(best[0], best[1]), _mm_add_epi32(best[2], best[3]));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    for (int g = 0; g < 4; g++)
+        _mm_storeu_si128((__m128i*)(indices + 4 * g), best_index[g]);
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+static int select_indices(const BlockPixels* px, int first, int dims, const int (*palette)[4], int count, int* indices, bool simd) {
+#ifdef BLOCK_HAVE_SIMD
+    if (simd)
+        return select_indices_simd(px, first, dims, palette, count, indices);
+#else
+    (void)simd;
+#endif
+    return select_indices_scalar(px, first, dims, palette, count, indices);
+}
+
+// --- Концы отрезка ---------------------------------------------------------
+
+typedef struct {
+    float mean[4];
+    float axis[4];
+} ColorLine;
+
+// Главная ось облака точек степенным методом по ковариационной матрице
+static ColorLine fit_color_line(const BlockPixels* px, int dims) {
+    ColorLine line;
+    memset(&line, 0, sizeof(line));
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < dims; c++)
+            line.mean[c] += px->c[c][i];
+    for (int c = 0; c < dims; c++)
+        line.mean[c] /= 16.0f;
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; i++) {
+        float d[4];
+        for (int c = 0; c < dims; c++)
+            d[c] = px->c[c][i] - line.mean[c];
+        for (int a = 0; a < dims; a++)
+            for (int b = 0; b < dims; b++)
+                cov[a][b] += d[a] * d[b];
+    }
+
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = {};
+        for (int a = 0; a < dims; a++)
+            for (int b = 0; b < dims; b++)
+                next[a] += cov[a][b] * axis[b];
+        float length = 0.0f;
+        for (int c = 0; c < dims; c++)
+            length += next[c] * next[c];
+        if (length < 1e-12f)
+            break;
+        length = 1.0f / sqrtf(length);
+        for (int c = 0; c < dims; c++)
+            axis[c] = next[c] * length;
+    }
+    memcpy(line.axis, axis, sizeof(axis));
+    return line;
+}
+
+// Крайние проекции пикселей на главную ось
+static void line_endpoints(const BlockPixels* px, int dims, float* low, float* high) {
+    ColorLine line = fit_color_line(px, dims);
+    float t_min = 1e30f, t_max = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < dims; c++)
+            t += (px->c[c][i] - line.mean[c]) * line.axis[c];
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+    for (int c = 0; c < dims; c++) {
+        low[c] = std::clamp(line.mean[c] + line.axis[c] * t_min, 0.0f, 255.0f);
+        high[c] = std::clamp(line.mean[c] + line.axis[c] * t_max, 0.0f, 255.0f);
+    }
+}
+
+// Углы ограничивающего параллелепипеда, сдвинутые внутрь на 1/16 диапазона
+static void box_endpoints(const BlockPixels* px, int dims, float* low, float* high) {
+    for (int c = 0; c < dims; c++) {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; i++) {
+            lo = std::min(lo, px->c[c][i]);
+            hi = std::max(hi, px->c[c][i]);
+        }
+        float inset = (hi - lo) / 16.0f;
+        low[c] = lo + inset;
+        high[c] = hi - inset;
+    }
+}
+
+static void block_endpoints(const BlockPixels* px, int dims, BlockQuality quality, float* low, float* high) {
+    if (quality == BLOCK_QUALITY_FAST)
+        box_endpoints(px, dims, low, high);
+    else
+        line_endpoints(px, dims, low, high);
+}
+
+// Наименьшие квадраты: при фиксированных индексах пиксель i приближается как
+// w_i * e0 + (1 - w_i) * e1, где w_i = weight0[indices[i]]. false — система вырождена.
+static bool refine_endpoints(const BlockPixels* px, int dims, const int* indices, const float* weight0, float* e0, float* e1) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; i++) {
+        float a = weight0[indices[i]], b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < dims; c++) {
+            ax[c] += a * px->c[c][i];
+            bx[c] += b * px->c[c][i];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+        return false;
+    float inv = 1.0f / det;
+    for (int c = 0; c < dims; c++) {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inv, 0.0f, 255.0f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inv, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+static const int BLOCK_REFINE_ITERATIONS = 2;
+
+static void write_le16(unsigned char* out, uint16_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+}
+
+static void write_le32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        out[i] = (unsigned char)(value >> (8 * i));
+}
+
+// --- BC1 -------------------------------------------------------------------
+
+static uint16_t pack_565(const float* color) {
+    int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t value, int* color) {
+    int r = value >> 11, g = (value >> 5) & 63, b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Доля c0 в цвете палитры BC1 с данным индексом (четырёхцветный режим)
+static const float bc1_weight0[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+typedef struct {
+    uint16_t c0, c1;
+    int indices[16];
+    int error;
+} Bc1Fit;
+
+static void fit_bc1(const BlockPixels* px, uint16_t c0, uint16_t c1, bool simd, Bc1Fit* fit) {
+    // c0 > c1 — четырёхцветный режим без прозрачности
+    if (c0 < c1)
+        std::swap(c0, c1);
+    fit->c0 = c0;
+    fit->c1 = c1;
+    int palette[4][4] = {};
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    // При c0 == c1 все индексы нулевые: в трёхцветном режиме индекс 0 тоже c0
+    fit->error = select_indices(px, 0, 3, palette, c0 == c1 ? 1 : 4, fit->indices, simd);
+}
+
+static void encode_bc1(const BlockPixels* px, BlockQuality quality, bool simd, unsigned char* out) {
+    float low[4], high[4];
+    block_endpoints(px, 3, quality, low, high);
+    Bc1Fit best;
+    fit_bc1(px, pack_565(high), pack_565(low), simd, &best);
+
+    for (int iteration = 0; quality == BLOCK_QUALITY_HIGH && iteration < BLOCK_REFINE_ITERATIONS && best.error > 0; iteration++) {
+        float e0[4], e1[4];
+        if (best.c0 == best.c1 || !refine_endpoints(px, 3, best.indices, bc1_weight0, e0, e1))
+            break;
+        Bc1Fit fit;
+        fit_bc1(px, pack_565(e0), pack_565(e1), simd, &fit);
+        if (fit.error >= best.error)
+            break;
+        best = fit;
+    }
+
+    write_le16(out, best.c0);
+    write_le16(out + 2, best.c1);
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++)
+        indices |= (uint32_t)best.indices[i] << (2 * i);
+    write_le32(out + 4, indices);
+}
+
+// --- BC4 (и альфа BC3, и каналы BC5) ----------------------------------------
+
+static int fit_bc4(const BlockPixels* px, int channel, int hi, int lo, bool simd, int* indices) {
+    // a0 > a1 — восемь интерполированных значений
+    int palette[8][4] = {};
+    palette[0][channel] = hi;
+    palette[1][channel] = lo;
+    for (int i = 1; i < 7; i++)
+        palette[i + 1][channel] = ((7 - i) * hi + i * lo) / 7;
+    return select_indices(px, channel, 1, palette, hi == lo ? 1 : 8, indices, simd);
+}
+
+static void encode_bc4_channel(const BlockPixels* px, int channel, BlockQuality quality, bool simd, unsigned char* out) {
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        lo = std::min(lo, px->c[channel][i]);
+        hi = std::max(hi, px->c[channel][i]);
+    }
+    int indices[16];
+    int best_hi = hi, best_lo = lo;
+    int best_error = fit_bc4(px, channel, hi, lo, simd, indices);
+
+    // Крайние значения блока редко лучшие концы: перебираем сдвиги внутрь
+    if (quality == BLOCK_QUALITY_HIGH && best_error > 0) {
+        int candidate[16];
+        for (int dl = 0; dl <= 4; dl++) {
+            for (int dh = 0; dh <= 4; dh++) {
+                int h = hi - dh, l = lo + dl;
+                if ((dl == 0 && dh == 0) || h <= l)
+                    continue;
+                int error = fit_bc4(px, channel, h, l, simd, candidate);
+                if (error < best_error) {
+                    best_error = error;
+                    best_hi = h;
+                    best_lo = l;
+                    memcpy(indices, candidate, sizeof(candidate));
+                }
+            }
+        }
+    }
+
+    out[0] = (unsigned char)best_hi;
+    out[1] = (unsigned char)best_lo;
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; i++)
+        bits |= (uint64_t)indices[i] << (3 * i);
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// --- BC7, режим 6 ----------------------------------------------------------
+
+static const int bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+typedef struct {
+    unsigned char* out;
+    int position;
+} BitWriter;
+
+static void write_bits(BitWriter* writer, uint32_t value, int count) {
+    for (int i = 0; i < count; i++, writer->position++) {
+        if (value & (1u << i))
+            writer->out[writer->position >> 3] |= (unsigned char)(1u << (writer->position & 7));
+    }
+}
+
+// Конец режима 6: 7 бит на канал плюс общий p-бит, который становится младшим битом
+static void quantize_bc7_endpoint(const float* endpoint, int* q, int* pbit) {
+    int best_error = 1 << 30;
+    for (int p = 0; p < 2; p++) {
+        int candidate[4], error = 0;
+        for (int c = 0; c < 4; c++) {
+            candidate[c] = std::clamp((int)((endpoint[c] - p) / 2.0f + 0.5f), 0, 127);
+            int d = ((candidate[c] << 1) | p) - (int)(endpoint[c] + 0.5f);
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            *pbit = p;
+            memcpy(q, candidate, sizeof(candidate));
+        }
+    }
+}
+
+typedef struct {
+    int q[2][4];
+    int pbit[2];
+    int indices[16];
+    int error;
+} Bc7Fit;
+
+static void fit_bc7(const BlockPixels* px, const float* low, const float* high, bool simd, Bc7Fit* fit) {
+    quantize_bc7_endpoint(low, fit->q[0], &fit->pbit[0]);
+    quantize_bc7_endpoint(high, fit->q[1], &fit->pbit[1]);
+    int endpoints[2][4];
+    for (int e = 0; e < 2; e++)
+        for (int c = 0; c < 4; c++)
+            endpoints[e][c] = (fit->q[e][c] << 1) | fit->pbit[e];
+    int palette[16][4];
+    for (int w = 0; w < 16; w++)
+        for (int c = 0; c < 4; c++)
+            palette[w][c] = ((64 - bc7_weights4[w]) * endpoints[0][c] + bc7_weights4[w] * endpoints[1][c] + 32) >> 6;
+    fit->error = select_indices(px, 0, 4, palette, 16, fit->indices, simd);
+}
+
+static void encode_bc7(const BlockPixels* px, BlockQuality quality, bool simd, unsigned char* out) {
+    float low[4], high[4];
+    block_endpoints(px, 4, quality, low, high);
+    Bc7Fit best;
+    fit_bc7(px, low, high, simd, &best);
+
+    if (quality == BLOCK_QUALITY_HIGH) {
+        float weight0[16];
+        for (int w = 0; w < 16; w++)
+            weight0[w] = (64 - bc7_weights4[w]) / 64.0f;
+        for (int iteration = 0; iteration < BLOCK_REFINE_ITERATIONS && best.error > 0; iteration++) {
+            if (!refine_endpoints(px, 4, best.indices, weight0, low, high))
+                break;
+            Bc7Fit fit;
+            fit_bc7(px, low, high, simd, &fit);
+            if (fit.error >= best.error)
+                break;
+            best = fit;
+        }
+    }
+
+    // Старший бит индекса опорного пикселя не хранится: меняем концы местами
+    if (best.indices[0] & 8) {
+        for (int c = 0; c < 4; c++)
+            std::swap(best.q[0][c], best.q[1][c]);
+        std::swap(best.pbit[0], best.pbit[1]);
+        for (int i = 0; i < 16; i++)
+            best.indices[i] = 15 - best.indices[i];
+    }
+
+    memset(out, 0, 16);
+    BitWriter writer = { out, 0 };
+    write_bits(&writer, 1u << 6, 7); // режим 6
+    for (int c = 0; c < 4; c++) {
+        write_bits(&writer, (uint32_t)best.q[0][c], 7);
+        write_bits(&writer, (uint32_t)best.q[1][c], 7);
+    }
+    write_bits(&writer, (uint32_t)best.pbit[0], 1);
+    write_bits(&writer, (uint32_t)best.pbit[1], 1);
+    write_bits(&writer, (uint32_t)best.indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        write_bits(&writer, (uint32_t)best.indices[i], 4);
+}
+
+// --- ETC2 RGB (блоки ETC1: индивидуальный и дифференциальный режимы) --------
+
+static const int etc_modifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+// Значение индекса пикселя (старший, младший бит): 0 → +a, 1 → +b, 2 → -a, 3 → -b
+static int etc_modifier(int table, int index) {
+    int value = etc_modifiers[table][index & 1];
+    return index & 2 ? -value : value;
+}
+
+static int color_distance(const int* a, const unsigned char* b, int dims) {
+    int sum = 0;
+    for (int c = 0; c < dims; c++) {
+        int d = a[c] - b[c];
+        sum += d * d;
+    }
+    return sum;
+}
+
+typedef struct {
+    int table;
+    int indices[8];
+    int error;
+} EtcSubblockFit;
+
+static bool in_subblock(int x, int y, int flip, int subblock) {
+    return (flip ? y : x) / 2 == subblock;
+}
+
+static EtcSubblockFit fit_etc_subblock(const unsigned char* rgba, int flip, int subblock, const int* base) {
+    EtcSubblockFit best;
+    best.error = 1 << 30;
+    for (int table = 0; table < 8; table++) {
+        EtcSubblockFit fit;
+        fit.table = table;
+        fit.error = 0;
+        int n = 0;
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                if (!in_subblock(x, y, flip, subblock))
+                    continue;
+                const unsigned char* pixel = rgba + (y * 4 + x) * 4;
+                int best_index = 0, best_error = 1 << 30;
+                for (int index = 0; index < 4; index++) {
+                    int modifier = etc_modifier(table, index), color[3];
+                    for (int c = 0; c < 3; c++)
+                        color[c] = std::clamp(base[c] + modifier, 0, 255);
+                    int error = color_distance(color, pixel, 3);
+                    if (error < best_error) {
+                        best_error = error;
+                        best_index = index;
+                    }
+                }
+                fit.indices[n++] = best_index;
+                fit.error += best_error;
+            }
+        }
+        if (fit.error < best.error)
+            best = fit;
+    }
+    return best;
+}
+
+static void subblock_average(const unsigned char* rgba, int flip, int subblock, float* average) {
+    average[0] = average[1] = average[2] = 0.0f;
+    for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 4; x++)
+            if (in_subblock(x, y, flip, subblock))
+                for (int c = 0; c < 3; c++)
+                    average[c] += rgba[(y * 4 + x) * 4 + c] / 8.0f;
+}
+
+static void write_etc_block(unsigned char* out, uint32_t high, const EtcSubblockFit* fits, int flip) {
+    uint32_t low = 0;
+    int n[2] = {0, 0};
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int subblock = in_subblock(x, y, flip, 1) ? 1 : 0;
+            int index = fits[subblock].indices[n[subblock]++];
+            int bit = x * 4 + y; // пиксели нумеруются по столбцам
+            low |= (uint32_t)(index >> 1) << (16 + bit);
+            low |= (uint32_t)(index & 1) << bit;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        out[i] = (unsigned char)(high >> (24 - 8 * i));
+        out[4 + i] = (unsigned char)(low >> (24 - 8 * i));
+    }
+}
+
+static void encode_etc2_rgb(const unsigned char* rgba, unsigned char* out) {
+    int best_error = 1 << 30;
+    for (int flip = 0; flip < 2; flip++) {
+        float average[2][3];
+        subblock_average(rgba, flip, 0, average[0]);
+        subblock_average(rgba, flip, 1, average[1]);
+
+        // Дифференциальный режим: 5 бит на канал и разница второго цвета в [-4, 3].
+        // Сумма всегда в диапазоне, поэтому декодер ETC2 не примет блок за режимы T/H/planar.
+        int c5[2][3], diff_ok = 1;
+        for (int s = 0; s < 2; s++)
+            for (int c = 0; c < 3; c++)
+                c5[s][c] = std::clamp((int)(average[s][c] * 31.0f / 255.0f + 0.5f), 0, 31);
+        for (int c = 0; c < 3; c++) {
+            int d = c5[1][c] - c5[0][c];
+            if (d < -4 || d > 3)
+                diff_ok = 0;
+        }
+        if (diff_ok) {
+            int base[2][3];
+            for (int s = 0; s < 2; s++)
+                for (int c = 0; c < 3; c++)
+                    base[s][c] = (c5[s][c] << 3) | (c5[s][c] >> 2);
+            EtcSubblockFit fits[2] = { fit_etc_subblock(rgba, flip, 0, base[0]), fit_etc_subblock(rgba, flip, 1, base[1]) };
+            if (fits[0].error + fits[1].error < best_error) {
+                best_error = fits[0].error + fits[1].error;
+                uint32_t high = 0;
+                for (int c = 0; c < 3; c++)
+                    high |= ((uint32_t)c5[0][c] << (27 - 8 * c)) | ((uint32_t)((c5[1][c] - c5[0][c]) & 7) << (24 - 8 * c));
+                high |= ((uint32_t)fits[0].table << 5) | ((uint32_t)fits[1].table << 2) | (1u << 1) | (uint32_t)flip;
+                write_etc_block(out, high, fits, flip);
+            }
+        }
+
+        // Индивидуальный режим: два независимых цвета по 4 бита на канал
+        int c4[2][3], base[2][3];
+        for (int s = 0; s < 2; s++) {
+            for (int c = 0; c < 3; c++) {
+                c4[s][c] = std::clamp((int)(average[s][c] * 15.0f / 255.0f + 0.5f), 0, 15);
+                base[s][c] = (c4[s][c] << 4) | c4[s][c];
+            }
+        }
+        EtcSubblockFit fits[2] = { fit_etc_subblock(rgba, flip, 0, base[0]), fit_etc_subblock(rgba, flip, 1, base[1]) };
+        if (fits[0].error + fits[1].error < best_error) {
+            best_error = fits[0].error + fits[1].error;
+            uint32_t high = 0;
+            for (int c = 0; c < 3; c++)
+                high |= ((uint32_t)c4[0][c] << (28 - 8 * c)) | ((uint32_t)c4[1][c] << (24 - 8 * c));
+            high |= ((uint32_t)fits[0].table << 5) | ((uint32_t)fits[1].table << 2) | (uint32_t)flip;
+            write_etc_block(out, high, fits, flip);
+        }
+    }
+}
+
+// --- Изображения -----------------------------------------------------------
+
+BlockEncodeOptions block_default_options(BlockFormat format) {
+    BlockEncodeOptions options;
+    options.format = format;
+    options.quality = BLOCK_QUALITY_NORMAL;
+    options.simd = true;
+    return options;
+}
+
+int block_format_bytes(BlockFormat format) {
+    switch (format) {
+        case BLOCK_FORMAT_BC1:
+        case BLOCK_FORMAT_ETC2_RGB:
+        case BLOCK_FORMAT_BC4:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+const char* block_format_name(BlockFormat format) {
+    switch (format) {
+        case BLOCK_FORMAT_BC1: return "bc1";
+        case BLOCK_FORMAT_BC3: return "bc3";
+        case BLOCK_FORMAT_BC7: return "bc7";
+        case BLOCK_FORMAT_ETC2_RGB: return "etc2";
+        case BLOCK_FORMAT_BC4: return "bc4";
+        case BLOCK_FORMAT_BC5: return "bc5";
+    }
+    return "?";
+}
+
+bool block_format_parse(const char* name, BlockFormat* format) {
+    for (int i = 0; i < BLOCK_FORMAT_COUNT; i++) {
+        if (strcmp(name, block_format_name((BlockFormat)i)) == 0) {
+            *format = (BlockFormat)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* block_quality_name(BlockQuality quality) {
+    switch (quality) {
+        case BLOCK_QUALITY_FAST: return "fast";
+        case BLOCK_QUALITY_HIGH: return "high";
+        default: return "normal";
+    }
+}
+
+bool block_quality_parse(const char* name, BlockQuality* quality) {
+    const BlockQuality qualities[] = { BLOCK_QUALITY_FAST, BLOCK_QUALITY_NORMAL, BLOCK_QUALITY_HIGH };
+    for (BlockQuality candidate : qualities) {
+        if (strcmp(name, block_quality_name(candidate)) == 0) {
+            *quality = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* block_simd_name() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(BLOCK_HAVE_SIMD)
+    return "SSE4.1";
+#else
+    return "scalar";
+#endif
+}
+
+void block_encode(const BlockEncodeOptions* options, const unsigned char* rgba, unsigned char* out) {
+    if (options->format == BLOCK_FORMAT_ETC2_RGB) {
+        encode_etc2_rgb(rgba, out);
+        return;
+    }
+    BlockPixels px;
+    load_block_pixels(rgba, &px);
+    switch (options->format) {
+        case BLOCK_FORMAT_BC1:
+            encode_bc1(&px, options->quality, options->simd, out);
+            break;
+        case BLOCK_FORMAT_BC3:
+            encode_bc4_channel(&px, 3, options->quality, options->simd, out);
+            encode_bc1(&px, options->quality, options->simd, out + 8);
+            break;
+        case BLOCK_FORMAT_BC7:
+            encode_bc7(&px, options->quality, options->simd, out);
+            break;
+        case BLOCK_FORMAT_BC4:
+            encode_bc4_channel(&px, 0, options->quality, options->simd, out);
+            break;
+        case BLOCK_FORMAT_BC5:
+            encode_bc4_channel(&px, 0, options->quality, options->simd, out);
+            encode_bc4_channel(&px, 1, options->quality, options->simd, out + 8);
+            break;
+        default:
+            break;
+    }
+}
+
+size_t block_compressed_size(BlockFormat format, int width, int height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * block_format_bytes(format);
+}
+
+// Блок 4x4 в RGBA8; серый размножается в RGB, недостающая альфа — 255.
+// Для BC4/BC5 два канала — это R и G, как у несжатой текстуры GL_RG8.
+static void fetch_block(const unsigned char* pixels, int width, int height, int channels, bool two_channel_rg,
+                        int bx, int by, unsigned char* rgba) {
+    for (int y = 0; y < 4; y++) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const unsigned char* src = pixels + ((size_t)sy * width + sx) * channels;
+            unsigned char* dst = rgba + (y * 4 + x) * 4;
+            if (channels >= 3) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            } else if (channels == 2 && two_channel_rg) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = 0;
+            } else {
+                dst[0] = dst[1] = dst[2] = src[0];
+            }
+            dst[3] = channels == 4 ? src[3] : (channels == 2 && !two_channel_rg ? src[1] : 255);
+        }
+    }
+}
+
+void block_compress_rows(const unsigned char* pixels, int width, int height, int channels, const BlockEncodeOptions* options,
+                         int first_row, int last_row, unsigned char* out) {
+    const int blocks_x = (width + 3) / 4;
+    const int block_bytes = block_format_bytes(options->format);
+    const bool two_channel_rg = options->format == BLOCK_FORMAT_BC4 || options->format == BLOCK_FORMAT_BC5;
+    unsigned char rgba[64];
+    for (int by = first_row; by < last_row; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            fetch_block(pixels, width, height, channels, two_channel_rg, bx, by, rgba);
+            block_encode(options, rgba, out + ((size_t)by * blocks_x + bx) * block_bytes);
+        }
+    }
+}
+
+void block_compress_image(const unsigned char* pixels, int width, int height, int channels, const BlockEncodeOptions* options,
+                          std::vector<unsigned char>* out) {
+    out->resize(block_compressed_size(options->format, width, height));
+    block_compress_rows(pixels, width, height, channels, options, 0, (height + 3) / 4, out->data());
+}
@@ -0,0 +1,59 @@
+#ifndef BLOCK_COMPRESS_H
+#define BLOCK_COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Кодировщики блочного сжатия 4x4. Вход блока — 16 пикселей RGBA8 построчно.
+// От OpenGL не зависит: используется и texcook, и загрузчиком во время работы.
+// Выбор индексов палитры векторизован (SSE4.1/AVX2) и побитово совпадает со скалярной версией.
+
+typedef enum {
+    BLOCK_FORMAT_BC1,      // RGB, 8 байт на блок
+    BLOCK_FORMAT_BC3,      // RGBA (альфа как BC4), 16 байт
+    BLOCK_FORMAT_BC7,      // RGBA, режим 6 — одна пара концов на блок, 16 байт
+    BLOCK_FORMAT_ETC2_RGB, // RGB, блоки ETC1 (подмножество ETC2), 8 байт
+    BLOCK_FORMAT_BC4,      // один канал (R), 8 байт
+    BLOCK_FORMAT_BC5       // два канала (R, G) — карты нормалей, 16 байт
+} BlockFormat;
+
+static const int BLOCK_FORMAT_COUNT = 6;
+
+typedef enum {
+    BLOCK_QUALITY_FAST,   // концы по ограничивающему параллелепипеду
+    BLOCK_QUALITY_NORMAL, // концы по главной оси
+    BLOCK_QUALITY_HIGH    // главная ось + уточнение концов методом наименьших квадратов
+} BlockQuality;
+
+typedef struct {
+    BlockFormat format;
+    BlockQuality quality;
+    bool simd; // false — скалярная эталонная реализация
+} BlockEncodeOptions;
+
+BlockEncodeOptions block_default_options(BlockFormat format);
+
+int block_format_bytes(BlockFormat format);
+const char* block_format_name(BlockFormat format);
+// "bc1", "bc3", "bc7", "etc2", "bc4", "bc5"; false — неизвестное имя
+bool block_format_parse(const char* name, BlockFormat* format);
+const char* block_quality_name(BlockQuality quality);
+// "fast", "normal", "high"; false — неизвестное имя
+bool block_quality_parse(const char* name, BlockQuality* quality);
+// Набор инструкций, с которым собраны SIMD-ядра
+const char* block_simd_name();
+
+void block_encode(const BlockEncodeOptions* options, const unsigned char* rgba, unsigned char* out);
+
+// Сжимает строки блоков [first_row, last_row) изображения (1-4 канала) в out,
+// где out — начало всего сжатого изображения. Края неполных блоков повторяют последний пиксель.
+void block_compress_rows(const unsigned char* pixels, int width, int height, int channels, const BlockEncodeOptions* options,
+                         int first_row, int last_row, unsigned char* out);
+// Всё изображение в вызывающем потоке; параллельный вариант — в block_encoder.h
+void block_compress_image(const unsigned char* pixels, int width, int height, int channels, const BlockEncodeOptions* options,
+                          std::vector<unsigned char>* out);
+
+size_t block_compressed_size(BlockFormat format, int width, int height);
+
+#endif
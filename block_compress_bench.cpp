@@ -0,0 +1,72 @@
+// Бенчмарк блочного сжатия: скалярная эталонная реализация против SIMD в одном потоке
+// и SIMD в пуле на всех ядрах, для каждого формата и уровня качества.
+// Пропускная способность — блоки 4x4 в секунду на одно ядро.
+//   blockbench [image] [iterations]
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "block_encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static const char* const DEFAULT_IMAGE = "D:/vr/zad3/wood-2045380_1280.jpg";
+static const int DEFAULT_ITERATIONS = 3;
+
+// Блоки в секунду; encoder == NULL — в вызывающем потоке
+static double run(BlockEncoder* encoder, const unsigned char* pixels, int width, int height, int channels,
+                  const BlockEncodeOptions* options, int iterations, std::vector<unsigned char>* out) {
+    block_encoder_compress(encoder, pixels, width, height, channels, options, out); // прогрев
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        block_encoder_compress(encoder, pixels, width, height, channels, options, out);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)((width + 3) / 4) * ((height + 3) / 4) * iterations / seconds;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : DEFAULT_IMAGE;
+    int iterations = argc > 2 ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+        iterations = DEFAULT_ITERATIONS;
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(path, &width, &height, &channels, 0);
+    if (!pixels) {
+        fprintf(stderr, "Failed to load %s (%s)\n", path, stbi_failure_reason());
+        return 1;
+    }
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    BlockEncoder* encoder = block_encoder_create(cores);
+    printf("%s: %dx%d, %d channels, %d blocks, SIMD kernels: %s, %u threads\n",
+           path, width, height, channels, ((width + 3) / 4) * ((height + 3) / 4), block_simd_name(), cores);
+
+    const BlockFormat formats[] = { BLOCK_FORMAT_BC1, BLOCK_FORMAT_BC4, BLOCK_FORMAT_BC5, BLOCK_FORMAT_BC7 };
+    const BlockQuality qualities[] = { BLOCK_QUALITY_FAST, BLOCK_QUALITY_NORMAL, BLOCK_QUALITY_HIGH };
+    bool all_match = true;
+    for (BlockFormat format : formats) {
+        for (BlockQuality quality : qualities) {
+            BlockEncodeOptions options = block_default_options(format);
+            options.quality = quality;
+
+            std::vector<unsigned char> reference, out;
+            options.simd = false;
+            double scalar = run(NULL, pixels, width, height, channels, &options, iterations, &reference);
+            options.simd = true;
+            double simd = run(NULL, pixels, width, height, channels, &options, iterations, &out);
+            bool match = out == reference;
+            double threaded = run(encoder, pixels, width, height, channels, &options, iterations, &out);
+            match = match && out == reference;
+            all_match = all_match && match;
+
+            printf("%-4s %-6s scalar %9.0f blocks/s | %s %9.0f blocks/s (x%.2f) | x%u %9.0f blocks/s/core (%.0f total) | %s\n",
+                   block_format_name(format), block_quality_name(quality), scalar, block_simd_name(), simd, simd / scalar,
+                   cores, threaded / cores, threaded, match ? "bit-exact" : "MISMATCH");
+        }
+    }
+
+    block_encoder_destroy(encoder);
+    stbi_image_free(pixels);
+    return all_match ? 0 : 1;
+}
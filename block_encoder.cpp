@@ -0,0 +1,224 @@
+#include "block_encoder.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Примерно столько блоков в одной полосе: достаточно крупно, чтобы не упираться
+// в мьютекс очереди, и достаточно мелко, чтобы 1280x853 делился на десятки полос
+static const int BLOCK_BAND_BLOCKS = 2048;
+
+typedef struct {
+    int level;
+    const unsigned char* pixels;
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+} StreamLevel;
+
+struct BlockStream {
+    BlockEncoder* encoder;
+    BlockEncodeOptions options;
+    int channels;
+    std::deque<StreamLevel> levels; // deque: ссылки на уровни не меняются при push_back
+    int pending_bands;              // под encoder->mutex
+};
+
+typedef struct {
+    BlockStream* stream;
+    StreamLevel* level;
+    int first_row;
+    int last_row;
+} BlockBand;
+
+struct BlockEncoder {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable band_done;
+    std::deque<BlockBand> bands;
+    bool stopping;
+    BlockEncoderStats stats;
+};
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void run_band(const BlockBand& band) {
+    const StreamLevel* level = band.level;
+    block_compress_rows(level->pixels, level->width, level->height, band.stream->channels, &band.stream->options,
+                        band.first_row, band.last_row, band.level->data.data());
+}
+
+// Выполняет полосу вне мьютекса; lock держится на входе и на выходе
+static void run_band_unlocked(BlockEncoder* encoder, std::unique_lock<std::mutex>& lock, const BlockBand& band) {
+    lock.unlock();
+    double start = now_ms();
+    run_band(band);
+    double ms = now_ms() - start;
+    lock.lock();
+
+    int blocks_x = (band.level->width + 3) / 4;
+    encoder->stats.blocks += (uint64_t)blocks_x * (band.last_row - band.first_row);
+    encoder->stats.bands++;
+    encoder->stats.busy_ms += ms;
+    if (--band.stream->pending_bands == 0)
+        encoder->band_done.notify_all();
+}
+
+static void worker_main(BlockEncoder* encoder) {
+    std::unique_lock<std::mutex> lock(encoder->mutex);
+    for (;;) {
+        encoder->work_ready.wait(lock, [encoder] { return encoder->stopping || !encoder->bands.empty(); });
+        if (encoder->bands.empty())
+            return;
+        BlockBand band = encoder->bands.front();
+        encoder->bands.pop_front();
+        run_band_unlocked(encoder, lock, band);
+    }
+}
+
+BlockEncoder* block_encoder_create(unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    BlockEncoder* encoder = new BlockEncoder();
+    encoder->stopping = false;
+    memset(&encoder->stats, 0, sizeof(encoder->stats));
+    for (unsigned i = 0; i < threads; i++)
+        encoder->workers.emplace_back(worker_main, encoder);
+    return encoder;
+}
+
+void block_encoder_destroy(BlockEncoder* encoder) {
+    if (!encoder)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(encoder->mutex);
+        encoder->stopping = true;
+    }
+    encoder->work_ready.notify_all();
+    for (std::thread& worker : encoder->workers)
+        worker.join();
+    delete encoder;
+}
+
+unsigned block_encoder_threads(const BlockEncoder* encoder) {
+    return encoder ? (unsigned)encoder->workers.size() : 0;
+}
+
+BlockEncoderStats block_encoder_stats(BlockEncoder* encoder) {
+    std::lock_guard<std::mutex> lock(encoder->mutex);
+    return encoder->stats;
+}
+
+BlockStream* block_stream_begin(BlockEncoder* encoder, const BlockEncodeOptions* options, int channels) {
+    BlockStream* stream = new BlockStream();
+    stream->encoder = encoder;
+    stream->options = *options;
+    stream->channels = channels;
+    stream->pending_bands = 0;
+    return stream;
+}
+
+void block_stream_push(BlockStream* stream, int level, const unsigned char* pixels, int width, int height) {
+    BlockEncoder* encoder = stream->encoder;
+    const int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    const int rows_per_band = std::max(1, BLOCK_BAND_BLOCKS / blocks_x);
+
+    std::unique_lock<std::mutex> lock;
+    if (encoder)
+        lock = std::unique_lock<std::mutex>(encoder->mutex);
+    stream->levels.push_back({ level, pixels, width, height, {} });
+    StreamLevel* stream_level = &stream->levels.back();
+    stream_level->data.resize(block_compressed_size(stream->options.format, width, height));
+
+    for (int row = 0; row < blocks_y; row += rows_per_band) {
+        BlockBand band = { stream, stream_level, row, std::min(blocks_y, row + rows_per_band) };
+        if (!encoder) {
+            run_band(band);
+            continue;
+        }
+        encoder->bands.push_back(band);
+        stream->pending_bands++;
+    }
+    if (encoder) {
+        lock.unlock();
+        encoder->work_ready.notify_all();
+    }
+}
+
+void block_stream_finish(BlockStream* stream, CompressedTexture* texture) {
+    if (BlockEncoder* encoder = stream->encoder) {
+        std::unique_lock<std::mutex> lock(encoder->mutex);
+        while (stream->pending_bands > 0) {
+            // Берём полосы этого потока, не дожидаясь рабочих; чужие не трогаем,
+            // чтобы не задерживать вызывающего из-за соседних текстур
+            auto it = std::find_if(encoder->bands.begin(), encoder->bands.end(),
+                                   [stream](const BlockBand& band) { return band.stream == stream; });
+            if (it == encoder->bands.end()) {
+                encoder->band_done.wait(lock);
+                continue;
+            }
+            BlockBand band = *it;
+            encoder->bands.erase(it);
+            run_band_unlocked(encoder, lock, band);
+        }
+    }
+
+    std::sort(stream->levels.begin(), stream->levels.end(),
+              [](const StreamLevel& a, const StreamLevel& b) { return a.level < b.level; });
+    texture->format = stream->options.format;
+    texture->width = stream->levels.empty() ? 0 : stream->levels.front().width;
+    texture->height = stream->levels.empty() ? 0 : stream->levels.front().height;
+    texture->levels.clear();
+    for (StreamLevel& level : stream->levels)
+        texture->levels.push_back({ level.width, level.height, std::move(level.data) });
+    delete stream;
+}
+
+void block_encoder_compress(BlockEncoder* encoder, const unsigned char* pixels, int width, int height, int channels,
+                            const BlockEncodeOptions* options, std::vector<unsigned char>* out) {
+    BlockStream* stream = block_stream_begin(encoder, options, channels);
+    block_stream_push(stream, 0, pixels, width, height);
+    CompressedTexture texture;
+    block_stream_finish(stream, &texture);
+    *out = std::move(texture.levels[0].data);
+}
+
+BlockRuntimeOptions block_runtime_parse(int argc, char** argv) {
+    BlockRuntimeOptions options;
+    options.enabled = false;
+    options.auto_format = true;
+    options.encode = block_default_options(BLOCK_FORMAT_BC1);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compress") == 0) {
+            options.enabled = true;
+            if (i + 1 < argc && block_format_parse(argv[i + 1], &options.encode.format)) {
+                options.auto_format = false;
+                i++;
+            } else if (i + 1 < argc && strcmp(argv[i + 1], "auto") == 0) {
+                i++;
+            }
+        } else if (strcmp(argv[i], "--compress-quality") == 0 && i + 1 < argc) {
+            block_quality_parse(argv[++i], &options.encode.quality);
+        }
+    }
+    return options;
+}
+
+BlockEncodeOptions block_runtime_encode_options(const BlockRuntimeOptions* options, int channels) {
+    BlockEncodeOptions encode = options->encode;
+    if (options->auto_format) {
+        switch (channels) {
+            case 1: encode.format = BLOCK_FORMAT_BC4; break;
+            case 2: encode.format = BLOCK_FORMAT_BC5; break;
+            case 3: encode.format = BLOCK_FORMAT_BC1; break;
+            default: encode.format = BLOCK_FORMAT_BC7; break;
+        }
+    }
+    return encode;
+}
@@ -0,0 +1,52 @@
+#ifndef BLOCK_ENCODER_H
+#define BLOCK_ENCODER_H
+
+#include "block_compress.h"
+#include "texture_container.h"
+#include <stdint.h>
+#include <vector>
+
+// Пул потоков блочного сжатия. Сетка блоков каждого уровня режется на полосы
+// строк блоков, полосы всех поставленных уровней разбирают рабочие потоки.
+// Результат не зависит от числа потоков: каждая полоса пишет только свои блоки.
+
+typedef struct BlockEncoder BlockEncoder;
+typedef struct BlockStream BlockStream;
+
+typedef struct {
+    uint64_t blocks;
+    uint64_t bands;
+    double busy_ms; // суммарно по всем потокам, включая помогающих в block_stream_finish
+} BlockEncoderStats;
+
+// threads == 0 — по числу ядер
+BlockEncoder* block_encoder_create(unsigned threads);
+void block_encoder_destroy(BlockEncoder* encoder);
+unsigned block_encoder_threads(const BlockEncoder* encoder);
+BlockEncoderStats block_encoder_stats(BlockEncoder* encoder);
+
+// Потоковое сжатие мип-цепочки: уровни ставятся в работу по мере готовности
+// (например, из MipOptions::level_ready), пока следующие ещё строятся.
+// encoder == NULL — уровни сжимаются прямо в block_stream_push.
+BlockStream* block_stream_begin(BlockEncoder* encoder, const BlockEncodeOptions* options, int channels);
+// Пиксели не копируются и должны жить до block_stream_finish; вызов не ждёт сжатия
+void block_stream_push(BlockStream* stream, int level, const unsigned char* pixels, int width, int height);
+// Ждёт все полосы (помогая пулу), собирает уровни по порядку и освобождает stream
+void block_stream_finish(BlockStream* stream, CompressedTexture* texture);
+
+// Одно изображение целиком, полосы параллельно
+void block_encoder_compress(BlockEncoder* encoder, const unsigned char* pixels, int width, int height, int channels,
+                            const BlockEncodeOptions* options, std::vector<unsigned char>* out);
+
+// Сжатие текстур при загрузке (то, что не подготовлено texcook)
+typedef struct {
+    bool enabled;
+    bool auto_format;          // BC4/BC5/BC1/BC7 по числу каналов изображения
+    BlockEncodeOptions encode; // формат, если не auto_format
+} BlockRuntimeOptions;
+
+// --compress [auto|bc1|bc3|bc4|bc5|bc7|etc2] --compress-quality fast|normal|high
+BlockRuntimeOptions block_runtime_parse(int argc, char** argv);
+BlockEncodeOptions block_runtime_encode_options(const BlockRuntimeOptions* options, int channels);
+
+#endif
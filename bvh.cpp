@@ -0,0 +1,647 @@
+#include "bvh.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode must stay 32 bytes: two nodes per cache line");
+
+static const int BVH_STACK_SIZE = BVH_MAX_DEPTH * 2;
+
+typedef struct {
+    float min[3];
+    float max[3];
+} Box;
+
+// Узел на время сборки; каждая задача пишет в свою часть
+typedef struct {
+    Box box;
+    int32_t left;   // в той же части; -1 — лист
+    int32_t right;
+    uint32_t first;
+    uint32_t count;
+    int32_t task;   // >= 0 — поддерево строит задача task (только в верхней части)
+} BuildNode;
+
+// Объект на время сборки: рамка едет вместе с индексом при разделении диапазонов,
+// так что проходы по диапазону читают память подряд
+typedef struct {
+    float min[3];
+    float max[3];
+    uint32_t object;
+} BuildPrim;
+
+// Диапазон объектов с рамкой и рамкой центров — у детей их знает раскладка родителя
+typedef struct {
+    uint32_t first;
+    uint32_t count;
+    Box box;
+    Box centers;
+} BuildRange;
+
+typedef struct {
+    BuildRange range;
+    int depth;      // глубина корня поддерева во всём дереве — предел BVH_MAX_DEPTH общий
+} BuildTask;
+
+typedef struct {
+    BuildPrim* prims;
+    size_t task_size;    // 0 — всё в вызывающем потоке
+    std::vector<BuildTask> tasks;
+} BuildContext;
+
+typedef struct {
+    uint32_t part;
+    int32_t node;
+    int depth;
+} BuildRef;
+
+static void box_empty(Box* box) {
+    for (int k = 0; k < 3; k++) {
+        box->min[k] = FLT_MAX;
+        box->max[k] = -FLT_MAX;
+    }
+}
+
+static void box_grow(Box* box, const float* min, const float* max) {
+    for (int k = 0; k < 3; k++) {
+        box->min[k] = std::min(box->min[k], min[k]);
+        box->max[k] = std::max(box->max[k], max[k]);
+    }
+}
+
+static float box_area(const Box& box) {
+    float d[3];
+    for (int k = 0; k < 3; k++)
+        d[k] = box.max[k] - box.min[k];
+    if (d[0] < 0.0f)
+        return 0.0f;
+    return 2.0f * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+}
+
+static inline float prim_center(const BuildPrim& prim, int axis) {
+    return 0.5f * (prim.min[axis] + prim.max[axis]);
+}
+
+static inline int lowest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+    for (; !(bits & 1); bits >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+static void range_bounds(const BuildContext* ctx, BuildRange* range) {
+    box_empty(&range->box);
+    box_empty(&range->centers);
+    for (uint32_t i = range->first; i < range->first + range->count; i++) {
+        const BuildPrim& prim = ctx->prims[i];
+        float c[3] = { prim_center(prim, 0), prim_center(prim, 1), prim_center(prim, 2) };
+        box_grow(&range->box, prim.min, prim.max);
+        box_grow(&range->centers, c, c);
+    }
+}
+
+// Лучшее деление диапазона по SAH: центры раскладываются в BVH_BINS корзин вдоль самой
+// длинной оси рамки центров. Рамки детей собираются из корзин, так что каждый уровень —
+// один проход раскладки и один partition. false — лист дешевле или объектов мало
+static bool split_range(const BuildContext* ctx, const BuildRange& range, BuildRange children[2]) {
+    if (range.count <= (uint32_t)BVH_MIN_LEAF)
+        return false;
+    int axis = 0;
+    for (int k = 1; k < 3; k++)
+        if (range.centers.max[k] - range.centers.min[k] > range.centers.max[axis] - range.centers.min[axis])
+            axis = k;
+    float extent = range.centers.max[axis] - range.centers.min[axis];
+    if (extent <= 0.0f) {
+        // Все центры совпали: делим пополам, чтобы лист не разрастался
+        if (range.count <= (uint32_t)BVH_MAX_LEAF)
+            return false;
+        children[0].first = range.first;
+        children[0].count = range.count / 2;
+        children[1].first = range.first + children[0].count;
+        children[1].count = range.count - children[0].count;
+        range_bounds(ctx, &children[0]);
+        range_bounds(ctx, &children[1]);
+        return true;
+    }
+
+    const BuildPrim* prims = ctx->prims + range.first;
+    const float axis_min = range.centers.min[axis];
+    const float scale = BVH_BINS / extent;
+    Box bins[BVH_BINS], bin_centers[BVH_BINS];
+    uint32_t bin_count[BVH_BINS] = {};
+    for (int b = 0; b < BVH_BINS; b++) {
+        box_empty(&bins[b]);
+        box_empty(&bin_centers[b]);
+    }
+    for (uint32_t i = 0; i < range.count; i++) {
+        float c[3] = { prim_center(prims[i], 0), prim_center(prims[i], 1), prim_center(prims[i], 2) };
+        int b = std::min(BVH_BINS - 1, (int)((c[axis] - axis_min) * scale));
+        box_grow(&bins[b], prims[i].min, prims[i].max);
+        box_grow(&bin_centers[b], c, c);
+        bin_count[b]++;
+    }
+
+    // Справа налево копим площади правых частей, затем слева направо — стоимость делений
+    float right_area[BVH_BINS];
+    uint32_t right_count[BVH_BINS];
+    Box right;
+    box_empty(&right);
+    uint32_t accumulated = 0;
+    for (int b = BVH_BINS - 1; b > 0; b--) {
+        box_grow(&right, bins[b].min, bins[b].max);
+        accumulated += bin_count[b];
+        right_area[b] = box_area(right);
+        right_count[b] = accumulated;
+    }
+    float best_cost = FLT_MAX;
+    int best_bin = -1;
+    Box left;
+    box_empty(&left);
+    accumulated = 0;
+    for (int b = 0; b + 1 < BVH_BINS; b++) {
+        box_grow(&left, bins[b].min, bins[b].max);
+        accumulated += bin_count[b];
+        if (accumulated == 0 || right_count[b + 1] == 0)
+            continue;
+        float cost = box_area(left) * accumulated + right_area[b + 1] * right_count[b + 1];
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_bin = b;
+        }
+    }
+    if (best_bin < 0)
+        return false;
+    // Обход узла стоит как одна проверка объекта
+    float parent_area = box_area(range.box);
+    float split_cost = 1.0f + (parent_area > 0.0f ? best_cost / parent_area : 0.0f);
+    if (range.count <= (uint32_t)BVH_MAX_LEAF && split_cost >= (float)range.count)
+        return false;
+
+    for (int side = 0; side < 2; side++) {
+        box_empty(&children[side].box);
+        box_empty(&children[side].centers);
+        children[side].count = 0;
+    }
+    for (int b = 0; b < BVH_BINS; b++) {
+        BuildRange& child = children[b <= best_bin ? 0 : 1];
+        box_grow(&child.box, bins[b].min, bins[b].max);
+        box_grow(&child.centers, bin_centers[b].min, bin_centers[b].max);
+        child.count += bin_count[b];
+    }
+    // Номер корзины считается той же формулой, что при раскладке, — счётчики сходятся
+    std::partition(ctx->prims + range.first, ctx->prims + range.first + range.count, [&](const BuildPrim& prim) {
+        return std::min(BVH_BINS - 1, (int)((prim_center(prim, axis) - axis_min) * scale)) <= best_bin;
+    });
+    children[0].first = range.first;
+    children[1].first = range.first + children[0].count;
+    return true;
+}
+
+static int32_t build_node(BuildContext* ctx, std::vector<BuildNode>* part, const BuildRange& range, int depth, bool top) {
+    BuildNode node;
+    node.box = range.box;
+    node.left = node.right = -1;
+    node.first = range.first;
+    node.count = range.count;
+    node.task = -1;
+    int32_t index = (int32_t)part->size();
+    part->push_back(node);
+
+    if (top && range.count <= ctx->task_size) {
+        (*part)[index].task = (int32_t)ctx->tasks.size();
+        ctx->tasks.push_back({ range, depth });
+        return index;
+    }
+    BuildRange children[2];
+    if (depth + 1 >= BVH_MAX_DEPTH || !split_range(ctx, range, children))
+        return index;
+    int32_t left = build_node(ctx, part, children[0], depth + 1, top);
+    int32_t right = build_node(ctx, part, children[1], depth + 1, top);
+    (*part)[index].left = left;
+    (*part)[index].right = right;
+    return index;
+}
+
+void bvh_init(Bvh* bvh) {
+    bvh->depth = 0;
+    memset(&bvh->stats, 0, sizeof(bvh->stats));
+}
+
+static void set_node_box(BvhNode* node, const Box& box) {
+    memcpy(node->min, box.min, sizeof(node->min));
+    memcpy(node->max, box.max, sizeof(node->max));
+}
+
+void bvh_build(Bvh* bvh, const BoundsSoA* bounds, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t count = bounds->count;
+
+    std::vector<BuildPrim> prims(count);
+    for (size_t i = 0; i < count; i++) {
+        for (int k = 0; k < 3; k++) {
+            prims[i].min[k] = bounds->center[k][i] - bounds->extent[k][i];
+            prims[i].max[k] = bounds->center[k][i] + bounds->extent[k][i];
+        }
+        prims[i].object = (uint32_t)i;
+    }
+    bvh->indices.resize(count);
+    bvh->nodes.clear();
+    bvh->parent.clear();
+    bvh->depth = 0;
+    bvh->object_bounds.resize(count * 6);
+    bvh->object_slot.resize(count);
+    bvh->object_leaf.resize(count);
+    bvh->marks.assign((count + 63) / 64, 0);
+    if (count == 0) {
+        bvh->dirty.clear();
+        return;
+    }
+
+    // Верх дерева делится здесь, пока куски больше task_size; куски — задачи для потоков
+    BuildContext ctx;
+    ctx.prims = prims.data();
+    ctx.task_size = threads > 1 && count >= BVH_PARALLEL_MIN ? std::max<size_t>(BVH_PARALLEL_MIN / 4, count / (threads * 4)) : 0;
+    std::vector<std::vector<BuildNode>> parts(1);
+    BuildRange root;
+    root.first = 0;
+    root.count = (uint32_t)count;
+    range_bounds(&ctx, &root);
+    build_node(&ctx, &parts[0], root, 0, ctx.task_size > 0);
+
+    parts.resize(ctx.tasks.size() + 1);
+    std::atomic<size_t> next_task(0);
+    auto run_tasks = [&ctx, &parts, &next_task]() {
+        for (size_t t; (t = next_task++) < ctx.tasks.size();)
+            build_node(&ctx, &parts[t + 1], ctx.tasks[t].range, ctx.tasks[t].depth, false);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < std::min<size_t>(threads, ctx.tasks.size()); i++)
+        workers.emplace_back(run_tasks);
+    run_tasks();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (size_t k = 0; k < count; k++) {
+        uint32_t object = prims[k].object;
+        bvh->indices[k] = object;
+        memcpy(&bvh->object_bounds[k * 6], prims[k].min, 3 * sizeof(float));
+        memcpy(&bvh->object_bounds[k * 6 + 3], prims[k].max, 3 * sizeof(float));
+        bvh->object_slot[object] = (uint32_t)k;
+    }
+
+    // Укладка в ширину; узел верхней части, отданный задаче, заменяется корнем её части
+    auto resolve = [&parts](BuildRef ref) {
+        const BuildNode& node = parts[ref.part][ref.node];
+        if (node.task >= 0)
+            return BuildRef{ (uint32_t)node.task + 1, 0, ref.depth };
+        return ref;
+    };
+    std::vector<BuildRef> refs;
+    refs.push_back(resolve({ 0, 0, 0 }));
+    bvh->nodes.resize(1);
+    bvh->parent.push_back(0);
+    for (size_t i = 0; i < refs.size(); i++) {
+        BuildRef ref = refs[i];
+        const BuildNode& node = parts[ref.part][ref.node];
+        BvhNode& out = bvh->nodes[i];
+        set_node_box(&out, node.box);
+        bvh->depth = std::max(bvh->depth, ref.depth + 1);
+        if (node.left < 0) {
+            out.first = node.first;
+            out.count = node.count;
+            for (uint32_t k = node.first; k < node.first + node.count; k++)
+                bvh->object_leaf[bvh->indices[k]] = (uint32_t)i;
+            continue;
+        }
+        out.first = (uint32_t)refs.size();
+        out.count = 0;
+        refs.push_back(resolve({ ref.part, node.left, ref.depth + 1 }));
+        refs.push_back(resolve({ ref.part, node.right, ref.depth + 1 }));
+        bvh->nodes.resize(refs.size());
+        bvh->parent.push_back((uint32_t)i);
+        bvh->parent.push_back((uint32_t)i);
+    }
+
+    bvh->dirty.assign(bvh->nodes.size(), 0);
+    bvh->stats.builds++;
+    bvh->stats.build_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void load_object_bounds(Bvh* bvh, const BoundsSoA* bounds, uint32_t object) {
+    float* box = &bvh->object_bounds[(size_t)bvh->object_slot[object] * 6];
+    for (int k = 0; k < 3; k++) {
+        box[k] = bounds->center[k][object] - bounds->extent[k][object];
+        box[3 + k] = bounds->center[k][object] + bounds->extent[k][object];
+    }
+}
+
+// Пересчитывает рамку узла по детям или объектам листа; true — рамка изменилась
+static bool refit_node(Bvh* bvh, uint32_t index) {
+    BvhNode* node = &bvh->nodes[index];
+    Box box;
+    box_empty(&box);
+    if (node->count > 0) {
+        for (uint32_t k = node->first; k < node->first + node->count; k++)
+            box_grow(&box, &bvh->object_bounds[(size_t)k * 6], &bvh->object_bounds[(size_t)k * 6 + 3]);
+    } else {
+        box_grow(&box, bvh->nodes[node->first].min, bvh->nodes[node->first].max);
+        box_grow(&box, bvh->nodes[node->first + 1].min, bvh->nodes[node->first + 1].max);
+    }
+    bvh->stats.refit_nodes++;
+    if (memcmp(node->min, box.min, sizeof(box.min)) == 0 && memcmp(node->max, box.max, sizeof(box.max)) == 0)
+        return false;
+    set_node_box(node, box);
+    return true;
+}
+
+void bvh_refit(Bvh* bvh, const BoundsSoA* bounds) {
+    for (uint32_t object = 0; object < (uint32_t)bvh->object_slot.size(); object++)
+        load_object_bounds(bvh, bounds, object);
+    // Дети лежат дальше родителя — обратный проход видит их уже пересчитанными
+    for (size_t i = bvh->nodes.size(); i-- > 0;)
+        refit_node(bvh, (uint32_t)i);
+    bvh->stats.refits++;
+}
+
+void bvh_refit_objects(Bvh* bvh, const BoundsSoA* bounds, const uint32_t* objects, size_t count) {
+    // Куча по убыванию номера узла: все грязные потомки пересчитываются раньше предка
+    std::vector<uint32_t>& heap = bvh->scratch;
+    heap.clear();
+    for (size_t i = 0; i < count; i++) {
+        load_object_bounds(bvh, bounds, objects[i]);
+        uint32_t leaf = bvh->object_leaf[objects[i]];
+        if (!bvh->dirty[leaf]) {
+            bvh->dirty[leaf] = 1;
+            heap.push_back(leaf);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        uint32_t index = heap.back();
+        heap.pop_back();
+        bvh->dirty[index] = 0;
+        if (!refit_node(bvh, index) || index == 0)
+            continue;
+        uint32_t parent = bvh->parent[index];
+        if (!bvh->dirty[parent]) {
+            bvh->dirty[parent] = 1;
+            heap.push_back(parent);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    bvh->stats.refits++;
+}
+
+double bvh_sah_cost(const Bvh* bvh) {
+    if (bvh->nodes.empty())
+        return 0.0;
+    Box root;
+    memcpy(root.min, bvh->nodes[0].min, sizeof(root.min));
+    memcpy(root.max, bvh->nodes[0].max, sizeof(root.max));
+    double root_area = box_area(root);
+    if (root_area <= 0.0)
+        return (double)bvh->indices.size();
+    double cost = 0.0;
+    for (const BvhNode& node : bvh->nodes) {
+        Box box;
+        memcpy(box.min, node.min, sizeof(box.min));
+        memcpy(box.max, node.max, sizeof(box.max));
+        cost += box_area(box) / root_area * (node.count > 0 ? node.count : 1);
+    }
+    return cost;
+}
+
+typedef struct {
+    float plane[6][4];
+    float abs_normal[6][3];
+} CullPlanes;
+
+// false — рамка снаружи одной из плоскостей mask; плоскости, которым рамка удовлетворяет
+// целиком, снимаются с mask — для потомков они уже не проверяются
+static inline bool classify_box(const CullPlanes* planes, const float* min, const float* max, unsigned* mask) {
+    float c[3], e[3];
+    for (int k = 0; k < 3; k++) {
+        c[k] = 0.5f * (min[k] + max[k]);
+        e[k] = 0.5f * (max[k] - min[k]);
+    }
+    for (int p = 0; p < 6; p++) {
+        if (!(*mask & (1u << p)))
+            continue;
+        const float* n = planes->plane[p];
+        const float* a = planes->abs_normal[p];
+        float s = n[0] * c[0] + n[1] * c[1] + n[2] * c[2] + n[3];
+        float r = a[0] * e[0] + a[1] * e[1] + a[2] * e[2];
+        if (s + r < 0.0f)
+            return false;
+        if (s - r >= 0.0f)
+            *mask &= ~(1u << p);
+    }
+    return true;
+}
+
+size_t bvh_query_frustum(Bvh* bvh, const Frustum* frustum, std::vector<uint32_t>* out) {
+    size_t before = out->size();
+    bvh->stats.queries++;
+    if (bvh->nodes.empty())
+        return 0;
+    CullPlanes planes;
+    for (int p = 0; p < 6; p++) {
+        memcpy(planes.plane[p], frustum->planes[p], sizeof(planes.plane[p]));
+        for (int k = 0; k < 3; k++)
+            planes.abs_normal[p][k] = fabsf(frustum->planes[p][k]);
+    }
+
+    uint32_t stack_node[BVH_STACK_SIZE];
+    unsigned stack_mask[BVH_STACK_SIZE];
+    int top = 0;
+    stack_node[top] = 0;
+    stack_mask[top++] = 0x3f;
+    uint64_t visited = 0, tested = 0;
+    while (top > 0) {
+        top--;
+        const BvhNode& node = bvh->nodes[stack_node[top]];
+        unsigned mask = stack_mask[top];
+        visited++;
+        if (mask && !classify_box(&planes, node.min, node.max, &mask))
+            continue;
+        if (node.count > 0) {
+            for (uint32_t k = node.first; k < node.first + node.count; k++) {
+                unsigned object_mask = mask;
+                const float* box = &bvh->object_bounds[(size_t)k * 6];
+                tested += mask ? 1 : 0;
+                if (object_mask && !classify_box(&planes, box, box + 3, &object_mask))
+                    continue;
+                out->push_back(bvh->indices[k]);
+            }
+            continue;
+        }
+        // mask == 0: поддерево целиком внутри, дальше без проверок
+        stack_node[top] = node.first + 1;
+        stack_mask[top++] = mask;
+        stack_node[top] = node.first;
+        stack_mask[top++] = mask;
+    }
+    bvh->stats.nodes_visited += visited;
+    bvh->stats.objects_tested += tested;
+    bvh->stats.objects_found += out->size() - before;
+    return out->size() - before;
+}
+
+static inline float box_distance_squared(const float* min, const float* max, const float* point) {
+    float distance = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        float d = std::max(std::max(min[k] - point[k], point[k] - max[k]), 0.0f);
+        distance += d * d;
+    }
+    return distance;
+}
+
+size_t bvh_query_sphere(Bvh* bvh, const float center[3], float radius, std::vector<uint32_t>* out) {
+    size_t before = out->size();
+    bvh->stats.queries++;
+    if (bvh->nodes.empty())
+        return 0;
+    const float radius_squared = radius * radius;
+    uint32_t stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    uint64_t visited = 0, tested = 0;
+    while (top > 0) {
+        const BvhNode& node = bvh->nodes[stack[--top]];
+        visited++;
+        if (box_distance_squared(node.min, node.max, center) > radius_squared)
+            continue;
+        if (node.count > 0) {
+            for (uint32_t k = node.first; k < node.first + node.count; k++) {
+                const float* box = &bvh->object_bounds[(size_t)k * 6];
+                tested++;
+                if (box_distance_squared(box, box + 3, center) <= radius_squared)
+                    out->push_back(bvh->indices[k]);
+            }
+            continue;
+        }
+        stack[top++] = node.first + 1;
+        stack[top++] = node.first;
+    }
+    bvh->stats.nodes_visited += visited;
+    bvh->stats.objects_tested += tested;
+    bvh->stats.objects_found += out->size() - before;
+    return out->size() - before;
+}
+
+// Пересечение луча с рамкой методом плит; NaN от нулевых компонент направления
+// fminf/fmaxf отбрасывают — луч в плоскости грани считается внутри плиты
+static inline bool ray_box(const float* origin, const float* inverse, const float* min, const float* max, float max_t,
+                           float* t_near) {
+    float t0 = 0.0f, t1 = max_t;
+    for (int k = 0; k < 3; k++) {
+        float ta = (min[k] - origin[k]) * inverse[k];
+        float tb = (max[k] - origin[k]) * inverse[k];
+        t0 = fmaxf(t0, fminf(ta, tb));
+        t1 = fminf(t1, fmaxf(ta, tb));
+    }
+    *t_near = t0;
+    return t0 <= t1;
+}
+
+bool bvh_raycast(Bvh* bvh, const float origin[3], const float direction[3], float max_t, uint32_t* object, float* t) {
+    bvh->stats.queries++;
+    float inverse[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    float best = max_t;
+    bool hit = false;
+    float t_root;
+    if (bvh->nodes.empty() || !ray_box(origin, inverse, bvh->nodes[0].min, bvh->nodes[0].max, best, &t_root))
+        return false;
+
+    // Ближний ребёнок обходится первым, узлы дальше уже найденного попадания пропускаются
+    uint32_t stack_node[BVH_STACK_SIZE];
+    float stack_t[BVH_STACK_SIZE];
+    int top = 0;
+    stack_node[top] = 0;
+    stack_t[top++] = t_root;
+    uint64_t visited = 0, tested = 0;
+    while (top > 0) {
+        top--;
+        if (stack_t[top] > best)
+            continue;
+        const BvhNode& node = bvh->nodes[stack_node[top]];
+        visited++;
+        if (node.count > 0) {
+            for (uint32_t k = node.first; k < node.first + node.count; k++) {
+                const float* box = &bvh->object_bounds[(size_t)k * 6];
+                float t_object;
+                tested++;
+                if (ray_box(origin, inverse, box, box + 3, best, &t_object) && (!hit || t_object < best)) {
+                    best = t_object;
+                    *object = bvh->indices[k];
+                    hit = true;
+                }
+            }
+            continue;
+        }
+        const BvhNode& left = bvh->nodes[node.first];
+        const BvhNode& right = bvh->nodes[node.first + 1];
+        float t_left, t_right;
+        bool hit_left = ray_box(origin, inverse, left.min, left.max, best, &t_left);
+        bool hit_right = ray_box(origin, inverse, right.min, right.max, best, &t_right);
+        if (hit_left && hit_right) {
+            bool left_first = t_left <= t_right;
+            stack_node[top] = left_first ? node.first + 1 : node.first;
+            stack_t[top++] = left_first ? t_right : t_left;
+            stack_node[top] = left_first ? node.first : node.first + 1;
+            stack_t[top++] = left_first ? t_left : t_right;
+        } else if (hit_left || hit_right) {
+            stack_node[top] = hit_left ? node.first : node.first + 1;
+            stack_t[top++] = hit_left ? t_left : t_right;
+        }
+    }
+    bvh->stats.nodes_visited += visited;
+    bvh->stats.objects_tested += tested;
+    if (hit) {
+        *t = best;
+        bvh->stats.objects_found++;
+    }
+    return hit;
+}
+
+size_t bvh_cull(Bvh* bvh, const Frustum* frustum, std::vector<uint32_t>* visible) {
+    auto start = std::chrono::steady_clock::now();
+    bvh->scratch.clear();
+    bvh_query_frustum(bvh, frustum, &bvh->scratch);
+
+    // Порядок обхода -> по возрастанию: биты объектов, затем проход по словам маски
+    // (n / 64 слов); слова обнуляются по пути, маска к следующему вызову снова чистая
+    for (uint32_t object : bvh->scratch)
+        bvh->marks[object >> 6] |= 1ull << (object & 63);
+    visible->resize(bvh->scratch.size());
+    size_t found = 0;
+    for (size_t word = 0; word < bvh->marks.size(); word++) {
+        uint64_t bits = bvh->marks[word];
+        if (!bits)
+            continue;
+        bvh->marks[word] = 0;
+        for (; bits; bits &= bits - 1)
+            (*visible)[found++] = (uint32_t)(word * 64 + lowest_bit(bits));
+    }
+    bvh->stats.cull_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return found;
+}
+
+bool bvh_parse_enabled(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bvh") == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "frustum_cull.h"
+#include <stdint.h>
+#include <vector>
+
+// Иерархия ограничивающих объёмов над AABB объектов сцены (те же BoundsSoA, что у
+// frustum_cull). Строится бинированным SAH: верхние уровни делятся в вызывающем
+// потоке, поддеревья строятся параллельно. Узлы — 32 байта, уложены в ширину
+// (корень 0, братья рядом, дети всегда дальше родителя), объекты каждого листа
+// лежат подряд вместе с копией своих AABB — обход не прыгает по BoundsSoA.
+// Движущиеся объекты обновляются refit без перестройки: частичный refit поднимается
+// от листьев изменившихся объектов и останавливается, где рамка узла не изменилась.
+// Отсечение по пирамиде снимает плоскости, которым узел целиком удовлетворяет,
+// и полностью видимые поддеревья выдаёт без проверок: O(log n + видимые) узлов.
+
+static const int BVH_BINS = 16;
+static const int BVH_MIN_LEAF = 4;              // столько объектов и меньше — лист без поиска деления
+static const int BVH_MAX_LEAF = 8;              // больше объектов в листе только при вырожденных центрах
+static const int BVH_MAX_DEPTH = 64;
+static const size_t BVH_PARALLEL_MIN = 65536;   // меньше объектов — без потоков
+
+// count == 0 — внутренний узел, first — левый ребёнок (правый — first + 1);
+// иначе лист с объектами indices[first, first + count)
+typedef struct {
+    float min[3];
+    uint32_t first;
+    float max[3];
+    uint32_t count;
+} BvhNode;
+
+typedef struct {
+    uint64_t builds;
+    double build_ms;
+    uint64_t refits;
+    uint64_t refit_nodes;      // пересчитано узлов всеми refit
+    uint64_t queries;
+    uint64_t nodes_visited;
+    uint64_t objects_tested;   // проверок AABB объектов в листах
+    uint64_t objects_found;
+    double cull_ns;            // bvh_cull целиком, включая сортировку
+} BvhStats;
+
+typedef struct {
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> indices;      // объекты по листьям
+    std::vector<float> object_bounds;   // min xyz, max xyz для indices[k] — по 6 float на позицию k
+    std::vector<uint32_t> parent;       // по узлам; у корня — сам корень
+    std::vector<uint32_t> object_slot;  // объект -> позиция в indices
+    std::vector<uint32_t> object_leaf;  // объект -> лист
+    int depth;
+    std::vector<uint32_t> scratch;      // рабочие буферы запросов
+    std::vector<uint64_t> marks;
+    std::vector<uint8_t> dirty;
+    BvhStats stats;
+} Bvh;
+
+void bvh_init(Bvh* bvh);
+// threads == 0 — по числу ядер
+void bvh_build(Bvh* bvh, const BoundsSoA* bounds, unsigned threads);
+
+// Полный refit после движения многих объектов (число объектов то же, что при сборке)
+void bvh_refit(Bvh* bvh, const BoundsSoA* bounds);
+// Частичный: только объекты objects[0..count) сдвинулись
+void bvh_refit_objects(Bvh* bvh, const BoundsSoA* bounds, const uint32_t* objects, size_t count);
+// Стоимость SAH (обходы узлов + проверки объектов на случайный луч); растёт, если refit испортил дерево
+double bvh_sah_cost(const Bvh* bvh);
+
+// Запросы дописывают индексы объектов в порядке обхода; возвращают их число
+size_t bvh_query_frustum(Bvh* bvh, const Frustum* frustum, std::vector<uint32_t>* out);
+size_t bvh_query_sphere(Bvh* bvh, const float center[3], float radius, std::vector<uint32_t>* out);
+// Ближайший объект, чей AABB пересекает луч origin + t * direction при 0 <= t <= max_t
+bool bvh_raycast(Bvh* bvh, const float origin[3], const float direction[3], float max_t, uint32_t* object, float* t);
+
+// Замена frustum_cull: индексы видимых по возрастанию (через битовую маску объектов)
+size_t bvh_cull(Bvh* bvh, const Frustum* frustum, std::vector<uint32_t>* visible);
+
+// --bvh — отсекать иерархически, а не линейным проходом
+bool bvh_parse_enabled(int argc, char** argv);
+
+#endif
@@ -0,0 +1,285 @@
+#include "file_watch.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+typedef struct {
+    std::string path;      // как передали в file_watch_add
+    std::string canonical;
+    int64_t mtime;         // Windows: уведомление не называет файл, изменение видно по mtime
+} WatchedFile;
+
+typedef struct {
+    std::string path;      // канонический путь папки
+    std::unordered_map<std::string, WatchedFile> files; // имя в папке -> файл
+#ifdef __linux__
+    int wd;
+#elif defined(_WIN32)
+    HANDLE handle;
+#endif
+} WatchedFolder;
+
+struct FileWatcher {
+    std::vector<WatchedFolder> folders; // после file_watch_start читается только фоновым потоком
+    std::thread thread;
+    bool started;
+#ifdef __linux__
+    int inotify_fd;
+    int stop_pipe[2];
+#elif defined(_WIN32)
+    HANDLE stop_event;
+#endif
+    std::mutex mutex;
+    std::vector<std::string> changed;   // под mutex, без повторов
+    std::atomic<bool> dirty;            // changed не пуст — единственное, что читает кадр без изменений
+    std::atomic<uint64_t> events;
+    std::atomic<uint64_t> changes;
+};
+
+static int64_t file_mtime(const std::string& path) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? -1 : (int64_t)time.time_since_epoch().count();
+}
+
+static void add_unique(std::vector<std::string>* paths, const std::string& path) {
+    if (std::find(paths->begin(), paths->end(), path) == paths->end())
+        paths->push_back(path);
+}
+
+// Ждёт событий папок не дольше timeout_ms (< 0 — бесконечно) и дописывает
+// в touched изменившиеся файлы под наблюдением. 1 — были события, 0 — тишина, -1 — стоп
+#ifdef __linux__
+static int wait_events(FileWatcher* watcher, int timeout_ms, std::vector<std::string>* touched) {
+    struct pollfd fds[2] = { { watcher->inotify_fd, POLLIN, 0 }, { watcher->stop_pipe[0], POLLIN, 0 } };
+    int ready = poll(fds, 2, timeout_ms);
+    if (ready < 0)
+        return errno == EINTR ? 1 : -1;
+    if (fds[1].revents)
+        return -1;
+    if (ready == 0)
+        return 0;
+
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length = read(watcher->inotify_fd, buffer, sizeof(buffer));
+    for (ssize_t offset = 0; offset < length;) {
+        const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+        offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+        watcher->events++;
+        if (event->len == 0)
+            continue;
+        for (WatchedFolder& folder : watcher->folders) {
+            if (folder.wd != event->wd)
+                continue;
+            auto it = folder.files.find(event->name);
+            if (it != folder.files.end())
+                add_unique(touched, it->second.path);
+        }
+    }
+    return 1;
+}
+#elif defined(_WIN32)
+static int wait_events(FileWatcher* watcher, int timeout_ms, std::vector<std::string>* touched) {
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    DWORD count = 0;
+    handles[count++] = watcher->stop_event;
+    for (const WatchedFolder& folder : watcher->folders)
+        handles[count++] = folder.handle;
+    DWORD result = WaitForMultipleObjects(count, handles, FALSE, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+    if (result == WAIT_TIMEOUT)
+        return 0;
+    if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + count)
+        return -1;
+
+    WatchedFolder& folder = watcher->folders[result - WAIT_OBJECT_0 - 1];
+    FindNextChangeNotification(folder.handle);
+    watcher->events++;
+    for (auto& pair : folder.files) {
+        WatchedFile& file = pair.second;
+        int64_t mtime = file_mtime(file.canonical);
+        if (mtime == file.mtime)
+            continue;
+        file.mtime = mtime;
+        add_unique(touched, file.path);
+    }
+    return 1;
+}
+#endif
+
+#if defined(__linux__) || defined(_WIN32)
+static void publish(FileWatcher* watcher, std::vector<std::string>* settled) {
+    std::lock_guard<std::mutex> lock(watcher->mutex);
+    for (const std::string& path : *settled)
+        add_unique(&watcher->changed, path);
+    watcher->changes += settled->size();
+    watcher->dirty.store(true, std::memory_order_release);
+    settled->clear();
+}
+
+// Изменения отдаются, когда в папках FILE_WATCH_SETTLE_MS тихо: сохранение
+// из редактора — это несколько записей и переименований подряд
+static void watch_thread(FileWatcher* watcher) {
+    std::vector<std::string> settling;
+    for (;;) {
+        int result = wait_events(watcher, settling.empty() ? -1 : FILE_WATCH_SETTLE_MS, &settling);
+        if (result < 0)
+            return;
+        if (result == 0 && !settling.empty())
+            publish(watcher, &settling);
+    }
+}
+#endif
+
+FileWatcher* file_watch_create() {
+#if defined(__linux__)
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    int stop_pipe[2];
+    if (pipe(stop_pipe) != 0) {
+        close(fd);
+        return NULL;
+    }
+    FileWatcher* watcher = new FileWatcher();
+    watcher->inotify_fd = fd;
+    watcher->stop_pipe[0] = stop_pipe[0];
+    watcher->stop_pipe[1] = stop_pipe[1];
+#elif defined(_WIN32)
+    HANDLE stop_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!stop_event)
+        return NULL;
+    FileWatcher* watcher = new FileWatcher();
+    watcher->stop_event = stop_event;
+#else
+    return NULL;
+#endif
+#if defined(__linux__) || defined(_WIN32)
+    watcher->started = false;
+    watcher->dirty = false;
+    watcher->events = 0;
+    watcher->changes = 0;
+    return watcher;
+#endif
+}
+
+void file_watch_destroy(FileWatcher* watcher) {
+    if (!watcher)
+        return;
+#if defined(__linux__)
+    if (watcher->started) {
+        char stop = 1;
+        (void)!write(watcher->stop_pipe[1], &stop, 1);
+        watcher->thread.join();
+    }
+    close(watcher->stop_pipe[0]);
+    close(watcher->stop_pipe[1]);
+    close(watcher->inotify_fd); // снимает и все inotify_add_watch
+#elif defined(_WIN32)
+    if (watcher->started) {
+        SetEvent(watcher->stop_event);
+        watcher->thread.join();
+    }
+    for (const WatchedFolder& folder : watcher->folders)
+        FindCloseChangeNotification(folder.handle);
+    CloseHandle(watcher->stop_event);
+#endif
+    delete watcher;
+}
+
+bool file_watch_add(FileWatcher* watcher, const char* path) {
+    if (!watcher || watcher->started)
+        return false;
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    if (ec || !canonical.has_filename())
+        return false;
+    std::string folder_path = canonical.parent_path().string();
+
+    WatchedFolder* folder = NULL;
+    for (WatchedFolder& existing : watcher->folders)
+        if (existing.path == folder_path)
+            folder = &existing;
+    if (!folder) {
+        WatchedFolder added;
+        added.path = folder_path;
+#if defined(__linux__)
+        // Запись на месте заканчивается IN_CLOSE_WRITE, сохранение через переименование — IN_MOVED_TO
+        added.wd = inotify_add_watch(watcher->inotify_fd, folder_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (added.wd < 0)
+            return false;
+#elif defined(_WIN32)
+        // Нулевой объект ожидания — событие остановки
+        if (watcher->folders.size() + 1 >= MAXIMUM_WAIT_OBJECTS)
+            return false;
+        added.handle = FindFirstChangeNotificationA(folder_path.c_str(), FALSE,
+                                                    FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        if (added.handle == INVALID_HANDLE_VALUE)
+            return false;
+#else
+        return false;
+#endif
+        watcher->folders.push_back(std::move(added));
+        folder = &watcher->folders.back();
+    }
+
+    WatchedFile file = { path, canonical.string(), file_mtime(canonical.string()) };
+    folder->files.emplace(canonical.filename().string(), std::move(file));
+    return true;
+}
+
+bool file_watch_start(FileWatcher* watcher) {
+    if (!watcher)
+        return false;
+#if defined(__linux__) || defined(_WIN32)
+    if (!watcher->started) {
+        watcher->thread = std::thread(watch_thread, watcher);
+        watcher->started = true;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool file_watch_poll(FileWatcher* watcher, std::vector<std::string>* changed) {
+    if (!watcher || !watcher->dirty.load(std::memory_order_acquire))
+        return false;
+    std::lock_guard<std::mutex> lock(watcher->mutex);
+    changed->clear();
+    changed->swap(watcher->changed);
+    watcher->dirty.store(false, std::memory_order_relaxed);
+    return !changed->empty();
+}
+
+FileWatchStats file_watch_stats(FileWatcher* watcher) {
+    FileWatchStats stats = {};
+    if (!watcher)
+        return stats;
+    for (const WatchedFolder& folder : watcher->folders)
+        stats.files += folder.files.size();
+    stats.folders = watcher->folders.size();
+    stats.events = watcher->events.load();
+    stats.changes = watcher->changes.load();
+    return stats;
+}
+
+bool file_watch_parse_enabled(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-hot-reload") == 0)
+            return false;
+    }
+    return true;
+}
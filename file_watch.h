@@ -0,0 +1,45 @@
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Слежение за файлами ресурсов (шейдеры, текстуры) для перезагрузки на лету.
+// Следим за папками, а не за файлами: редакторы часто пишут новый файл и
+// переименовывают его поверх старого, и слежка за самим файлом теряется.
+// Linux — inotify, Windows — FindFirstChangeNotification со сверкой mtime.
+// Фоновый поток спит в ядре, пока в папках ничего не меняется; серия событий
+// одного сохранения склеивается за FILE_WATCH_SETTLE_MS. Поток рендера раз в кадр
+// забирает изменившиеся пути — при отсутствии изменений это одно атомарное чтение.
+
+static const int FILE_WATCH_SETTLE_MS = 50;
+
+typedef struct FileWatcher FileWatcher;
+
+typedef struct {
+    uint64_t files;    // под наблюдением
+    uint64_t folders;
+    uint64_t events;   // событий ОС во всех папках, включая чужие файлы
+    uint64_t changes;  // отдано через file_watch_poll (после склейки)
+} FileWatchStats;
+
+// NULL — на этой платформе слежение не поддерживается
+FileWatcher* file_watch_create();
+void file_watch_destroy(FileWatcher* watcher);
+
+// До file_watch_start; повторное добавление того же файла ничего не меняет
+bool file_watch_add(FileWatcher* watcher, const char* path);
+// Запускает фоновый поток; после этого список файлов не меняется
+bool file_watch_start(FileWatcher* watcher);
+
+// Пути изменившихся файлов — в том виде, в каком их передали в file_watch_add.
+// false — с прошлого вызова ничего не менялось (changed не трогается)
+bool file_watch_poll(FileWatcher* watcher, std::vector<std::string>* changed);
+
+FileWatchStats file_watch_stats(FileWatcher* watcher);
+
+// Перезагрузка на лету включена, если нет флага --no-hot-reload
+bool file_watch_parse_enabled(int argc, char** argv);
+
+#endif
@@ -0,0 +1,220 @@
+#include "frame_profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void frame_profiler_init(FrameProfiler* profiler) {
+    profiler->scope_count = 0;
+    profiler->active = -1;
+    profiler->active_gpu = false;
+    profiler->active_start_us = 0.0;
+    profiler->frame = 0;
+    // Таймерные запросы — ядро GL 3.3, но программные драйверы их иногда не поддерживают
+    profiler->gpu_timing = GLAD_GL_VERSION_3_3 != 0;
+    profiler->origin_us = now_us();
+}
+
+void frame_profiler_destroy(FrameProfiler* profiler) {
+    for (int i = 0; i < profiler->scope_count; i++) {
+        ProfileScope* scope = &profiler->scopes[i];
+        if (profiler->gpu_timing)
+            glDeleteQueries(FRAME_PROFILER_QUERY_RING, scope->queries);
+        scope->samples.clear();
+    }
+    profiler->scope_count = 0;
+}
+
+static void collect_query(ProfileScope* scope, int slot) {
+    if (!scope->query_pending[slot])
+        return;
+    scope->query_pending[slot] = false;
+
+    GLuint available = 0;
+    glGetQueryObjectuiv(scope->queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return; // не ждём: сэмпл остаётся без GPU-времени
+    GLuint64 elapsed_ns = 0;
+    glGetQueryObjectui64v(scope->queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+    ProfileSample& sample = scope->samples[scope->sample_slot[slot]];
+    sample.gpu_ms = elapsed_ns / 1.0e6;
+}
+
+void frame_profiler_begin_frame(FrameProfiler* profiler) {
+    profiler->frame++;
+    if (!profiler->gpu_timing)
+        return;
+    int slot = profiler->frame % FRAME_PROFILER_QUERY_RING;
+    for (int i = 0; i < profiler->scope_count; i++)
+        collect_query(&profiler->scopes[i], slot);
+}
+
+static int find_scope(FrameProfiler* profiler, const char* name) {
+    for (int i = 0; i < profiler->scope_count; i++) {
+        if (strcmp(profiler->scopes[i].name, name) == 0)
+            return i;
+    }
+    if (profiler->scope_count == FRAME_PROFILER_MAX_SCOPES)
+        return -1;
+
+    ProfileScope* scope = &profiler->scopes[profiler->scope_count];
+    scope->name = name;
+    scope->count = 0;
+    scope->samples.assign(FRAME_PROFILER_WINDOW, ProfileSample{0.0, 0.0, -1.0});
+    for (int slot = 0; slot < FRAME_PROFILER_QUERY_RING; slot++) {
+        scope->queries[slot] = 0;
+        scope->query_pending[slot] = false;
+        scope->sample_slot[slot] = 0;
+    }
+    if (profiler->gpu_timing)
+        glGenQueries(FRAME_PROFILER_QUERY_RING, scope->queries);
+    return profiler->scope_count++;
+}
+
+void frame_profiler_begin(FrameProfiler* profiler, const char* name) {
+    if (profiler->active >= 0)
+        frame_profiler_end(profiler);
+    profiler->active = find_scope(profiler, name);
+    if (profiler->active < 0)
+        return;
+
+    ProfileScope* scope = &profiler->scopes[profiler->active];
+    int slot = profiler->frame % FRAME_PROFILER_QUERY_RING;
+    // Участок, встреченный дважды за кадр, измеряется по GPU только в первый раз
+    profiler->active_gpu = profiler->gpu_timing && !scope->query_pending[slot];
+    if (profiler->active_gpu) {
+        glBeginQuery(GL_TIME_ELAPSED, scope->queries[slot]);
+        scope->query_pending[slot] = true;
+        scope->sample_slot[slot] = (int)(scope->count % FRAME_PROFILER_WINDOW);
+    }
+    profiler->active_start_us = now_us();
+}
+
+void frame_profiler_end(FrameProfiler* profiler) {
+    if (profiler->active < 0)
+        return;
+    ProfileScope* scope = &profiler->scopes[profiler->active];
+    double end_us = now_us();
+    if (profiler->active_gpu)
+        glEndQuery(GL_TIME_ELAPSED);
+
+    ProfileSample& sample = scope->samples[scope->count % FRAME_PROFILER_WINDOW];
+    sample.start_us = profiler->active_start_us - profiler->origin_us;
+    sample.cpu_ms = (end_us - profiler->active_start_us) / 1000.0;
+    sample.gpu_ms = -1.0;
+    scope->count++;
+    profiler->active = -1;
+    profiler->active_gpu = false;
+}
+
+typedef struct {
+    int count;
+    double p50, p95, p99;
+} Percentiles;
+
+static Percentiles percentiles(std::vector<double>& values) {
+    Percentiles result = {(int)values.size(), 0.0, 0.0, 0.0};
+    if (values.empty())
+        return result;
+    std::sort(values.begin(), values.end());
+    size_t last = values.size() - 1;
+    result.p50 = values[(size_t)(0.50 * last + 0.5)];
+    result.p95 = values[(size_t)(0.95 * last + 0.5)];
+    result.p99 = values[(size_t)(0.99 * last + 0.5)];
+    return result;
+}
+
+static void scope_percentiles(const ProfileScope* scope, Percentiles* cpu, Percentiles* gpu) {
+    size_t window = (size_t)std::min<uint64_t>(scope->count, FRAME_PROFILER_WINDOW);
+    std::vector<double> cpu_values, gpu_values;
+    cpu_values.reserve(window);
+    gpu_values.reserve(window);
+    for (size_t i = 0; i < window; i++) {
+        const ProfileSample& sample = scope->samples[i];
+        cpu_values.push_back(sample.cpu_ms);
+        if (sample.gpu_ms >= 0.0)
+            gpu_values.push_back(sample.gpu_ms);
+    }
+    *cpu = percentiles(cpu_values);
+    *gpu = percentiles(gpu_values);
+}
+
+static void write_json(FrameProfiler* profiler, FILE* file) {
+    fprintf(file, "{\n  \"frames\": %d,\n  \"window\": %d,\n  \"scopes\": [\n", profiler->frame, FRAME_PROFILER_WINDOW);
+    for (int i = 0; i < profiler->scope_count; i++) {
+        Percentiles cpu, gpu;
+        scope_percentiles(&profiler->scopes[i], &cpu, &gpu);
+        fprintf(file, "    {\"name\": \"%s\", \"count\": %llu, "
+                      "\"cpu_ms\": {\"samples\": %d, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}, "
+                      "\"gpu_ms\": {\"samples\": %d, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f}}%s\n",
+                profiler->scopes[i].name, (unsigned long long)profiler->scopes[i].count,
+                cpu.count, cpu.p50, cpu.p95, cpu.p99, gpu.count, gpu.p50, gpu.p95, gpu.p99,
+                i + 1 < profiler->scope_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+static void write_trace(FrameProfiler* profiler, FILE* file) {
+    // CPU-участки — поток 1, их GPU-время — поток 2 с тем же началом (часы GPU не синхронизируем)
+    fprintf(file, "{\"traceEvents\": [\n");
+    bool first = true;
+    for (int i = 0; i < profiler->scope_count; i++) {
+        const ProfileScope* scope = &profiler->scopes[i];
+        size_t window = (size_t)std::min<uint64_t>(scope->count, FRAME_PROFILER_WINDOW);
+        for (size_t s = 0; s < window; s++) {
+            const ProfileSample& sample = scope->samples[s];
+            fprintf(file, "%s{\"name\": \"%s\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f}",
+                    first ? "" : ",\n", scope->name, sample.start_us, sample.cpu_ms * 1000.0);
+            first = false;
+            if (sample.gpu_ms >= 0.0)
+                fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, \"ts\": %.3f, \"dur\": %.3f}",
+                        scope->name, sample.start_us, sample.gpu_ms * 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+}
+
+int frame_profiler_write(FrameProfiler* profiler, const char* path, ProfileFormat format) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open profile file %s\n", path);
+        return 0;
+    }
+    if (format == PROFILE_FORMAT_TRACE)
+        write_trace(profiler, file);
+    else
+        write_json(profiler, file);
+    fclose(file);
+    printf("Profile written to %s\n", path);
+    return 1;
+}
+
+void frame_profiler_print(FrameProfiler* profiler) {
+    printf("Frame profile (last %d frames):\n", std::min(profiler->frame, FRAME_PROFILER_WINDOW));
+    for (int i = 0; i < profiler->scope_count; i++) {
+        Percentiles cpu, gpu;
+        scope_percentiles(&profiler->scopes[i], &cpu, &gpu);
+        printf("  %-16s cpu p50 %.3f p95 %.3f p99 %.3f ms | gpu p50 %.3f p95 %.3f p99 %.3f ms\n",
+               profiler->scopes[i].name, cpu.p50, cpu.p95, cpu.p99, gpu.p50, gpu.p95, gpu.p99);
+    }
+}
+
+const char* frame_profiler_parse_path(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0)
+            return argv[i + 1];
+    }
+    return NULL;
+}
+
+ProfileFormat frame_profiler_parse_format(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--profile-format") == 0)
+            return strcmp(argv[i + 1], "trace") == 0 ? PROFILE_FORMAT_TRACE : PROFILE_FORMAT_JSON;
+    }
+    return PROFILE_FORMAT_JSON;
+}
@@ -0,0 +1,65 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include "include/glad.h"
+#include <stdint.h>
+#include <vector>
+
+// Именованные участки кадра: CPU-время по steady_clock и GPU-время по GL_TIME_ELAPSED.
+// Запросы двойные — результат кадра N читается в кадре N + 2, когда он уже готов,
+// поэтому чтение никогда не ждёт GPU. Участки не вкладываются друг в друга.
+
+static const int FRAME_PROFILER_MAX_SCOPES = 32;
+static const int FRAME_PROFILER_QUERY_RING = 2;
+static const int FRAME_PROFILER_WINDOW = 512; // кадров в скользящем окне перцентилей
+
+typedef enum {
+    PROFILE_FORMAT_JSON,
+    PROFILE_FORMAT_TRACE // Chrome trace (chrome://tracing, Perfetto)
+} ProfileFormat;
+
+typedef struct {
+    double start_us; // от начала профилирования, для трассы
+    double cpu_ms;
+    double gpu_ms;   // < 0 — результат ещё не получен или запрос пропущен
+} ProfileSample;
+
+typedef struct {
+    const char* name; // строковый литерал, сравнивается по содержимому
+    GLuint queries[FRAME_PROFILER_QUERY_RING];
+    bool query_pending[FRAME_PROFILER_QUERY_RING];
+    int sample_slot[FRAME_PROFILER_QUERY_RING]; // куда дописать GPU-время, когда придёт
+    std::vector<ProfileSample> samples; // кольцо из FRAME_PROFILER_WINDOW
+    uint64_t count;
+} ProfileScope;
+
+typedef struct {
+    ProfileScope scopes[FRAME_PROFILER_MAX_SCOPES];
+    int scope_count;
+    int active;          // открытый участок или -1
+    bool active_gpu;     // для него открыт GL_TIME_ELAPSED
+    double active_start_us;
+    int frame;
+    bool gpu_timing;
+    double origin_us;
+} FrameProfiler;
+
+void frame_profiler_init(FrameProfiler* profiler);
+void frame_profiler_destroy(FrameProfiler* profiler);
+
+// В начале кадра: забирает готовые GPU-результаты кадра, чьи запросы теперь переиспользуются
+void frame_profiler_begin_frame(FrameProfiler* profiler);
+
+// Участки регистрируются при первом begin; больше FRAME_PROFILER_MAX_SCOPES — игнорируются
+void frame_profiler_begin(FrameProfiler* profiler, const char* name);
+void frame_profiler_end(FrameProfiler* profiler);
+
+// p50/p95/p99 по скользящему окну каждого участка (JSON) или последние кадры как трасса
+int frame_profiler_write(FrameProfiler* profiler, const char* path, ProfileFormat format);
+void frame_profiler_print(FrameProfiler* profiler);
+
+// Параметры --profile FILE и --profile-format json|trace; NULL — профиль не пишется
+const char* frame_profiler_parse_path(int argc, char** argv);
+ProfileFormat frame_profiler_parse_format(int argc, char** argv);
+
+#endif
@@ -0,0 +1,80 @@
+#include "frame_uniforms.h"
+#include <string.h>
+
+void frame_uniforms_init(FrameUniformBuffer* ubo) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    ubo->slot_size = ((GLsizeiptr)sizeof(FrameUniforms) + alignment - 1) / alignment * alignment;
+    ubo->persistent = GLAD_GL_VERSION_4_4 != 0;
+    ubo->mapped = NULL;
+    ubo->frame = 0;
+    for (int i = 0; i < FRAME_UNIFORMS_RING; i++)
+        ubo->fences[i] = 0;
+
+    glGenBuffers(1, &ubo->buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo->buffer);
+    if (ubo->persistent) {
+        // Кольцо из нескольких слотов: пишем в слот, который GPU уже дочитал
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, ubo->slot_size * FRAME_UNIFORMS_RING, NULL, flags);
+        ubo->mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, ubo->slot_size * FRAME_UNIFORMS_RING, flags);
+        if (!ubo->mapped) {
+            // Пересоздаём буфер: glBufferStorage делает хранилище неизменяемым
+            glDeleteBuffers(1, &ubo->buffer);
+            glGenBuffers(1, &ubo->buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo->buffer);
+            ubo->persistent = false;
+        }
+    }
+    if (!ubo->persistent)
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void frame_uniforms_destroy(FrameUniformBuffer* ubo) {
+    for (int i = 0; i < FRAME_UNIFORMS_RING; i++) {
+        if (ubo->fences[i])
+            glDeleteSync(ubo->fences[i]);
+        ubo->fences[i] = 0;
+    }
+    if (ubo->mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo->buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        ubo->mapped = NULL;
+    }
+    glDeleteBuffers(1, &ubo->buffer);
+    ubo->buffer = 0;
+}
+
+void frame_uniforms_update(FrameUniformBuffer* ubo, const FrameUniforms* data) {
+    if (ubo->persistent) {
+        int slot = ubo->frame % FRAME_UNIFORMS_RING;
+        if (ubo->fences[slot]) {
+            // Обычно забор уже пройден: GPU отстаёт не больше чем на пару кадров
+            GLenum status = glClientWaitSync(ubo->fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            // За секунду не дождались (или ожидание не удалось) — слот может ещё читаться:
+            // glFinish дожидается всех команд, после него писать безопасно
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                glFinish();
+            glDeleteSync(ubo->fences[slot]);
+            ubo->fences[slot] = 0;
+        }
+        GLintptr offset = ubo->slot_size * slot;
+        memcpy(ubo->mapped + offset, data, sizeof(FrameUniforms));
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, ubo->buffer, offset, sizeof(FrameUniforms));
+        // Забор для слота прошлого кадра: все его команды уже отправлены
+        if (ubo->frame > 0) {
+            int previous = (ubo->frame - 1) % FRAME_UNIFORMS_RING;
+            ubo->fences[previous] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    } else {
+        // Orphaning: драйвер выдаёт новое хранилище, не дожидаясь GPU
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo->buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, ubo->buffer);
+    }
+    ubo->frame++;
+}
@@ -0,0 +1,38 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include "include/glad.h"
+
+// Покадровые константы камеры и света. Раскладка std140 совпадает
+// с блоком FrameData, объявленным в shaders/*.vert и shaders/*.frag.
+typedef struct {
+    GLfloat view[16];
+    GLfloat projection[16];
+    GLfloat view_pos[4];    // vec3 в std140 занимает 16 байт
+    GLfloat light_pos[4];
+    GLfloat light_color[4];
+    GLfloat view_projection[16];
+} FrameUniforms;
+
+static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms must match std140 layout of FrameData");
+
+static const char* const FRAME_UNIFORMS_BLOCK = "FrameData";
+static const GLuint FRAME_UNIFORMS_BINDING = 0;
+static const int FRAME_UNIFORMS_RING = 3; // кадров в полёте
+
+typedef struct {
+    GLuint buffer;
+    GLsizeiptr slot_size;   // sizeof(FrameUniforms), выровненный под GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    bool persistent;        // GL 4.4: постоянно отображённый буфер, иначе — orphaning
+    unsigned char* mapped;
+    GLsync fences[FRAME_UNIFORMS_RING];
+    int frame;
+} FrameUniformBuffer;
+
+void frame_uniforms_init(FrameUniformBuffer* ubo);
+void frame_uniforms_destroy(FrameUniformBuffer* ubo);
+
+// Один раз за кадр: записывает константы и привязывает их к FRAME_UNIFORMS_BINDING
+void frame_uniforms_update(FrameUniformBuffer* ubo, const FrameUniforms* data);
+
+#endif
@@ -0,0 +1,333 @@
+#include "frustum_cull.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+// Как в transform.cpp: AVX2-ядро собирается всегда, выбор — через transform_best_kernel()
+#define FRUSTUM_HAVE_AVX2 1
+#define FRUSTUM_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_HAVE_SSE2 1
+#endif
+
+typedef struct {
+    float plane[6][4];
+    float abs_normal[6][3];
+    const float* center[3];
+    const float* extent[3];
+} CullInput;
+
+typedef struct {
+    size_t first;                  // кратно TRANSFORM_BATCH_WIDTH
+    size_t last;                   // не дальше bounds->count
+    std::vector<uint32_t> visible; // с запасом TRANSFORM_BATCH_WIDTH под запись без ветвлений
+    size_t visible_count;
+} CullChunk;
+
+struct FrustumCuller {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable chunk_done;
+    uint64_t generation;           // под mutex: номер текущей работы
+    int pending;                   // под mutex: кусков, которые ещё считают рабочие
+    bool stopping;
+    TransformKernel kernel;        // текущая работа; пишется до generation++
+    CullInput input;
+    std::vector<CullChunk> chunks; // [0] — вызывающий поток, [i + 1] — рабочий i
+    FrustumCullStats stats;
+};
+
+static size_t padded_count(size_t count) {
+    return (count + TRANSFORM_BATCH_WIDTH - 1) / TRANSFORM_BATCH_WIDTH * TRANSFORM_BATCH_WIDTH;
+}
+
+// Записывает base + k для каждого установленного бита mask; пишет всегда, сдвигается
+// только на видимых — без непредсказуемых ветвлений
+static inline uint32_t* emit_visible(uint32_t* cursor, size_t base, unsigned mask, int width) {
+    for (int k = 0; k < width; k++) {
+        *cursor = (uint32_t)(base + k);
+        cursor += (mask >> k) & 1u;
+    }
+    return cursor;
+}
+
+static inline unsigned tail_mask(size_t first, size_t last, int width) {
+    return last - first < (size_t)width ? (1u << (last - first)) - 1u : (1u << width) - 1u;
+}
+
+static size_t cull_scalar(const CullInput* in, size_t first, size_t last, uint32_t* out) {
+    uint32_t* cursor = out;
+    for (size_t i = first; i < last; i++) {
+        float c[3] = { in->center[0][i], in->center[1][i], in->center[2][i] };
+        float e[3] = { in->extent[0][i], in->extent[1][i], in->extent[2][i] };
+        bool inside = true;
+        for (int p = 0; p < 6; p++) {
+            const float* plane = in->plane[p];
+            const float* a = in->abs_normal[p];
+            float s = plane[0] * c[0] + plane[1] * c[1] + plane[2] * c[2] + plane[3] + a[0] * e[0] + a[1] * e[1] + a[2] * e[2];
+            inside &= s >= 0.0f;
+        }
+        *cursor = (uint32_t)i;
+        cursor += inside ? 1 : 0;
+    }
+    return (size_t)(cursor - out);
+}
+
+#ifdef FRUSTUM_HAVE_SSE2
+static size_t cull_sse2(const CullInput* in, size_t first, size_t last, uint32_t* out) {
+    __m128 n[6][4], a[6][3];
+    for (int p = 0; p < 6; p++) {
+        for (int k = 0; k < 4; k++)
+            n[p][k] = _mm_set1_ps(in->plane[p][k]);
+        for (int k = 0; k < 3; k++)
+            a[p][k] = _mm_set1_ps(in->abs_normal[p][k]);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    uint32_t* cursor = out;
+    for (size_t i = first; i < last; i += 4) {
+        __m128 c[3], e[3];
+        for (int k = 0; k < 3; k++) {
+            c[k] = _mm_loadu_ps(in->center[k] + i);
+            e[k] = _mm_loadu_ps(in->extent[k] + i);
+        }
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[p][0], c[0]), _mm_mul_ps(n[p][1], c[1])),
+                                  _mm_add_ps(_mm_mul_ps(n[p][2], c[2]), n[p][3]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[p][0], e[0]), _mm_mul_ps(a[p][1], e[1])), _mm_mul_ps(a[p][2], e[2]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(s, r), zero));
+        }
+        unsigned mask = (unsigned)_mm_movemask_ps(inside) & tail_mask(i, last, 4);
+        cursor = emit_visible(cursor, i, mask, 4);
+    }
+    return (size_t)(cursor - out);
+}
+#endif
+
+#ifdef FRUSTUM_HAVE_AVX2
+FRUSTUM_AVX2_TARGET static size_t cull_avx2(const CullInput* in, size_t first, size_t last, uint32_t* out) {
+    __m256 n[6][4], a[6][3];
+    for (int p = 0; p < 6; p++) {
+        for (int k = 0; k < 4; k++)
+            n[p][k] = _mm256_set1_ps(in->plane[p][k]);
+        for (int k = 0; k < 3; k++)
+            a[p][k] = _mm256_set1_ps(in->abs_normal[p][k]);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    uint32_t* cursor = out;
+    for (size_t i = first; i < last; i += 8) {
+        __m256 c[3], e[3];
+        for (int k = 0; k < 3; k++) {
+            c[k] = _mm256_loadu_ps(in->center[k] + i);
+            e[k] = _mm256_loadu_ps(in->extent[k] + i);
+        }
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 s = _mm256_fmadd_ps(n[p][0], c[0], _mm256_fmadd_ps(n[p][1], c[1], _mm256_fmadd_ps(n[p][2], c[2], n[p][3])));
+            s = _mm256_fmadd_ps(a[p][0], e[0], _mm256_fmadd_ps(a[p][1], e[1], _mm256_fmadd_ps(a[p][2], e[2], s)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(s, zero, _CMP_GE_OQ));
+        }
+        unsigned mask = (unsigned)_mm256_movemask_ps(inside) & tail_mask(i, last, 8);
+        cursor = emit_visible(cursor, i, mask, 8);
+    }
+    return (size_t)(cursor - out);
+}
+#endif
+
+static void run_chunk(TransformKernel kernel, const CullInput* input, CullChunk* chunk) {
+    chunk->visible_count = 0;
+    if (chunk->first >= chunk->last)
+        return;
+    uint32_t* out = chunk->visible.data();
+    switch (kernel) {
+#ifdef FRUSTUM_HAVE_AVX2
+    case TRANSFORM_KERNEL_AVX2:
+        chunk->visible_count = cull_avx2(input, chunk->first, chunk->last, out);
+        break;
+#endif
+#ifdef FRUSTUM_HAVE_SSE2
+    case TRANSFORM_KERNEL_SSE2:
+        chunk->visible_count = cull_sse2(input, chunk->first, chunk->last, out);
+        break;
+#endif
+    default:
+        chunk->visible_count = cull_scalar(input, chunk->first, chunk->last, out);
+        break;
+    }
+}
+
+static void worker_main(FrustumCuller* culler, size_t chunk_index) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(culler->mutex);
+    for (;;) {
+        culler->work_ready.wait(lock, [culler, seen] { return culler->stopping || culler->generation != seen; });
+        if (culler->stopping)
+            return;
+        seen = culler->generation;
+        lock.unlock();
+        run_chunk(culler->kernel, &culler->input, &culler->chunks[chunk_index]);
+        lock.lock();
+        if (--culler->pending == 0)
+            culler->chunk_done.notify_one();
+    }
+}
+
+void frustum_from_matrix(Frustum* frustum, const glm::mat4& view_projection) {
+    glm::vec4 row[4];
+    for (int r = 0; r < 4; r++)
+        row[r] = glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+    const glm::vec4 planes[6] = { row[3] + row[0], row[3] - row[0], row[3] + row[1],
+                                  row[3] - row[1], row[3] + row[2], row[3] - row[2] };
+    for (int p = 0; p < 6; p++) {
+        float length = glm::length(glm::vec3(planes[p]));
+        for (int k = 0; k < 4; k++)
+            frustum->planes[p][k] = length > 0.0f ? planes[p][k] / length : 0.0f;
+    }
+}
+
+void bounds_soa_resize(BoundsSoA* bounds, size_t count) {
+    for (int k = 0; k < 3; k++) {
+        bounds->center[k].resize(padded_count(count), 0.0f);
+        bounds->extent[k].resize(padded_count(count), 0.0f);
+    }
+    bounds->count = count;
+}
+
+void bounds_soa_set(BoundsSoA* bounds, size_t index, const float center[3], const float extent[3]) {
+    for (int k = 0; k < 3; k++) {
+        bounds->center[k][index] = center[k];
+        bounds->extent[k][index] = extent[k];
+    }
+}
+
+void bounds_soa_set_transformed(BoundsSoA* bounds, size_t index, const glm::mat4& model, const float local_center[3],
+                                const float local_extent[3]) {
+    glm::vec4 center = model * glm::vec4(local_center[0], local_center[1], local_center[2], 1.0f);
+    float world_center[3] = { center.x, center.y, center.z };
+    float world_extent[3];
+    for (int r = 0; r < 3; r++)
+        world_extent[r] = fabsf(model[0][r]) * local_extent[0] + fabsf(model[1][r]) * local_extent[1] +
+                          fabsf(model[2][r]) * local_extent[2];
+    bounds_soa_set(bounds, index, world_center, world_extent);
+}
+
+FrustumCuller* frustum_cull_create(unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    FrustumCuller* culler = new FrustumCuller();
+    culler->generation = 0;
+    culler->pending = 0;
+    culler->stopping = false;
+    culler->kernel = TRANSFORM_KERNEL_SCALAR;
+    memset(&culler->stats, 0, sizeof(culler->stats));
+    culler->chunks.resize(threads);
+    for (unsigned i = 1; i < threads; i++)
+        culler->workers.emplace_back(worker_main, culler, (size_t)i);
+    return culler;
+}
+
+void frustum_cull_destroy(FrustumCuller* culler) {
+    if (!culler)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(culler->mutex);
+        culler->stopping = true;
+    }
+    culler->work_ready.notify_all();
+    for (std::thread& worker : culler->workers)
+        worker.join();
+    delete culler;
+}
+
+unsigned frustum_cull_threads(const FrustumCuller* culler) {
+    return culler ? (unsigned)culler->chunks.size() : 0;
+}
+
+size_t frustum_cull(FrustumCuller* culler, TransformKernel kernel, const Frustum* frustum, const BoundsSoA* bounds,
+                    std::vector<uint32_t>* visible) {
+    auto start = std::chrono::steady_clock::now();
+    if (kernel > transform_best_kernel())
+        kernel = transform_best_kernel();
+
+    CullInput input;
+    for (int p = 0; p < 6; p++) {
+        memcpy(input.plane[p], frustum->planes[p], sizeof(input.plane[p]));
+        for (int k = 0; k < 3; k++)
+            input.abs_normal[p][k] = fabsf(frustum->planes[p][k]);
+    }
+    for (int k = 0; k < 3; k++) {
+        input.center[k] = bounds->center[k].data();
+        input.extent[k] = bounds->extent[k].data();
+    }
+
+    // Куски кратны ширине пакета, чтобы SIMD-ядра не резали группы между потоками
+    size_t count = bounds->count;
+    size_t parts = count >= FRUSTUM_CULL_PARALLEL_MIN ? culler->chunks.size() : 1;
+    size_t part_size = padded_count((count + parts - 1) / parts);
+    for (size_t i = 0; i < parts; i++) {
+        CullChunk& chunk = culler->chunks[i];
+        chunk.first = std::min(count, i * part_size);
+        chunk.last = std::min(count, chunk.first + part_size);
+        if (chunk.visible.size() < chunk.last - chunk.first + TRANSFORM_BATCH_WIDTH)
+            chunk.visible.resize(chunk.last - chunk.first + TRANSFORM_BATCH_WIDTH);
+    }
+
+    if (parts > 1) {
+        {
+            std::lock_guard<std::mutex> lock(culler->mutex);
+            culler->kernel = kernel;
+            culler->input = input;
+            culler->pending = (int)parts - 1;
+            culler->generation++;
+        }
+        culler->work_ready.notify_all();
+    }
+    run_chunk(kernel, &input, &culler->chunks[0]);
+    if (parts > 1) {
+        std::unique_lock<std::mutex> lock(culler->mutex);
+        culler->chunk_done.wait(lock, [culler] { return culler->pending == 0; });
+        culler->stats.parallel_calls++;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < parts; i++)
+        total += culler->chunks[i].visible_count;
+    visible->resize(total);
+    size_t offset = 0;
+    for (size_t i = 0; i < parts; i++) {
+        const CullChunk& chunk = culler->chunks[i];
+        memcpy(visible->data() + offset, chunk.visible.data(), chunk.visible_count * sizeof(uint32_t));
+        offset += chunk.visible_count;
+    }
+
+    culler->stats.calls++;
+    culler->stats.objects += count;
+    culler->stats.visible += total;
+    culler->stats.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+FrustumCullStats frustum_cull_stats(const FrustumCuller* culler) {
+    FrustumCullStats stats = {};
+    return culler ? culler->stats : stats;
+}
+
+FrustumCullOptions frustum_cull_parse(int argc, char** argv) {
+    FrustumCullOptions options = { true, 0 };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-cull") == 0)
+            options.enabled = false;
+        else if (strcmp(argv[i], "--cull-threads") == 0 && i + 1 < argc)
+            options.threads = (unsigned)std::max(0, atoi(argv[++i]));
+    }
+    return options;
+}
@@ -0,0 +1,67 @@
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include "transform.h"
+#include <stdint.h>
+#include <vector>
+
+// Отсечение по пирамиде видимости. Шесть плоскостей извлекаются из view-projection
+// кадра (Gribb–Hartmann), AABB объектов лежат в SoA, и SIMD-ядро проверяет
+// TRANSFORM_BATCH_WIDTH объектов за инструкцию: для плоскости (n, d) объект снаружи,
+// если n·c + d + |n|·e < 0 (c — центр, e — половины рёбер). Результат — сжатый
+// список индексов видимых объектов по возрастанию, так что группировка
+// экземпляров по материалам сохраняется. Большие сцены делятся на куски
+// между постоянными рабочими потоками; вызывающий поток считает первый кусок.
+
+static const size_t FRUSTUM_CULL_PARALLEL_MIN = 16384; // меньше объектов — без рабочих потоков
+
+// ax + by + cz + d >= 0 — внутри; нормали единичные
+typedef struct {
+    float planes[6][4]; // left, right, bottom, top, near, far
+} Frustum;
+
+// Дополняются до кратного TRANSFORM_BATCH_WIDTH, как TransformSoA
+typedef struct {
+    std::vector<float> center[3];
+    std::vector<float> extent[3]; // половины рёбер
+    size_t count;
+} BoundsSoA;
+
+typedef struct FrustumCuller FrustumCuller;
+
+typedef struct {
+    uint64_t calls;
+    uint64_t objects;
+    uint64_t visible;
+    uint64_t parallel_calls; // с рабочими потоками
+    double ns;               // время frustum_cull целиком, включая сборку списка
+} FrustumCullStats;
+
+typedef struct {
+    bool enabled;      // --no-cull — рисовать всё
+    unsigned threads;  // --cull-threads N; 0 — по числу ядер
+} FrustumCullOptions;
+
+void frustum_from_matrix(Frustum* frustum, const glm::mat4& view_projection);
+
+void bounds_soa_resize(BoundsSoA* bounds, size_t count);
+void bounds_soa_set(BoundsSoA* bounds, size_t index, const float center[3], const float extent[3]);
+// AABB мирового пространства для локального AABB под аффинной матрицей model
+void bounds_soa_set_transformed(BoundsSoA* bounds, size_t index, const glm::mat4& model, const float local_center[3],
+                                const float local_extent[3]);
+
+// threads == 0 — по числу ядер (вызывающий поток — один из них)
+FrustumCuller* frustum_cull_create(unsigned threads);
+void frustum_cull_destroy(FrustumCuller* culler);
+unsigned frustum_cull_threads(const FrustumCuller* culler);
+
+// visible — индексы видимых объектов по возрастанию; возвращает их число.
+// kernel — как у transform_batch, не выше transform_best_kernel()
+size_t frustum_cull(FrustumCuller* culler, TransformKernel kernel, const Frustum* frustum, const BoundsSoA* bounds,
+                    std::vector<uint32_t>* visible);
+
+FrustumCullStats frustum_cull_stats(const FrustumCuller* culler);
+
+FrustumCullOptions frustum_cull_parse(int argc, char** argv);
+
+#endif
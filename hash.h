@@ -0,0 +1,31 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// FNV-1a (64 бита) — используется как ключ для кэшей ресурсов
+static const uint64_t FNV1A_64_SEED = 0xcbf29ce484222325ull;
+static const uint64_t FNV1A_64_PRIME = 0x100000001b3ull;
+
+inline uint64_t fnv1a_64_bytes(const void* data, size_t size, uint64_t seed = FNV1A_64_SEED) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+// constexpr-версия для строковых литералов (имена юниформов и т.п.)
+constexpr uint64_t fnv1a_64(const char* str, uint64_t seed = FNV1A_64_SEED) {
+    uint64_t hash = seed;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+#endif
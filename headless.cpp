@@ -0,0 +1,275 @@
+#include "headless.h"
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+void headless_parse_options(HeadlessOptions* options, int argc, char** argv) {
+    options->enabled = false;
+    options->frames = HEADLESS_DEFAULT_FRAMES;
+    options->width = 800;
+    options->height = 600;
+    options->dump_dir = NULL;
+    options->dump_every = 1;
+    options->dump_format = FRAME_DUMP_PPM;
+    options->stats_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            options->enabled = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            break;
+        if (strcmp(argv[i], "--frames") == 0) {
+            int frames = atoi(argv[++i]);
+            options->frames = frames > 0 ? frames : HEADLESS_DEFAULT_FRAMES;
+        } else if (strcmp(argv[i], "--size") == 0) {
+            int width = 0, height = 0;
+            if (sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                options->width = width;
+                options->height = height;
+            }
+        } else if (strcmp(argv[i], "--dump-dir") == 0) {
+            options->dump_dir = argv[++i];
+        } else if (strcmp(argv[i], "--dump-every") == 0) {
+            int every = atoi(argv[++i]);
+            options->dump_every = every > 0 ? every : 1;
+        } else if (strcmp(argv[i], "--dump-format") == 0) {
+            options->dump_format = strcmp(argv[++i], "png") == 0 ? FRAME_DUMP_PNG : FRAME_DUMP_PPM;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->stats_path = argv[++i];
+        }
+    }
+}
+
+static bool has_display() {
+#ifdef _WIN32
+    return true;
+#else
+    return getenv("DISPLAY") != NULL || getenv("WAYLAND_DISPLAY") != NULL;
+#endif
+}
+
+void headless_init_hints(const HeadlessOptions* options) {
+    if (options->enabled && !has_display())
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+}
+
+void headless_window_hints(const HeadlessOptions* options) {
+    if (!options->enabled)
+        return;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+}
+
+void headless_camera_script(const HeadlessOptions* options, int frame, float* position, float* yaw, float* pitch) {
+    // Один оборот по эллипсу перед рядом кубов с покачиванием взгляда
+    float t = options->frames > 1 ? (float)frame / (float)(options->frames - 1) : 0.0f;
+    float angle = t * 2.0f * (float)M_PI;
+    position[0] = 4.0f * sinf(angle);
+    position[1] = 1.0f * sinf(2.0f * angle);
+    position[2] = 3.0f - 2.0f * (1.0f - cosf(angle));
+    *yaw = -90.0f - 25.0f * sinf(angle);
+    *pitch = -8.0f * sinf(2.0f * angle);
+}
+
+int headless_target_create(HeadlessTarget* target, int width, int height) {
+    target->width = width;
+    target->height = height;
+
+    glGenTextures(1, &target->color);
+    glBindTexture(GL_TEXTURE_2D, target->color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &target->depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &target->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->depth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Headless framebuffer incomplete: 0x%x\n", status);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        headless_target_destroy(target);
+        return 0;
+    }
+    glViewport(0, 0, width, height);
+    target->pixels.resize((size_t)width * height * 4);
+    return 1;
+}
+
+void headless_target_destroy(HeadlessTarget* target) {
+    if (target->fbo)
+        glDeleteFramebuffers(1, &target->fbo);
+    if (target->depth)
+        glDeleteRenderbuffers(1, &target->depth);
+    if (target->color)
+        glDeleteTextures(1, &target->color);
+    target->fbo = target->depth = target->color = 0;
+    target->pixels.clear();
+}
+
+static int write_ppm(FILE* file, const HeadlessTarget* target) {
+    fprintf(file, "P6\n%d %d\n255\n", target->width, target->height);
+    std::vector<unsigned char> row((size_t)target->width * 3);
+    for (int y = target->height - 1; y >= 0; y--) {
+        const unsigned char* src = &target->pixels[(size_t)y * target->width * 4];
+        for (int x = 0; x < target->width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        if (fwrite(row.data(), 1, row.size(), file) != row.size())
+            return 0;
+    }
+    return 1;
+}
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t size) {
+    static uint32_t table[256];
+    static bool table_ready = false;
+    if (!table_ready) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        table_ready = true;
+    }
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(std::vector<unsigned char>& out, uint32_t value) {
+    out.push_back((unsigned char)(value >> 24));
+    out.push_back((unsigned char)(value >> 16));
+    out.push_back((unsigned char)(value >> 8));
+    out.push_back((unsigned char)value);
+}
+
+static void png_chunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+    put_be32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    uint32_t crc = crc32_update(0xffffffffu, &out[start], out.size() - start) ^ 0xffffffffu;
+    put_be32(out, crc);
+}
+
+static int write_png(FILE* file, const HeadlessTarget* target) {
+    // Несжатый PNG: zlib-поток из stored-блоков deflate. Размер больше, зато без
+    // зависимостей, а байты детерминированы — удобно для побайтового сравнения в CI
+    const size_t stride = (size_t)target->width * 4 + 1;
+    std::vector<unsigned char> raw(stride * target->height);
+    for (int y = 0; y < target->height; y++) {
+        unsigned char* dst = &raw[(size_t)y * stride];
+        dst[0] = 0; // фильтр None
+        memcpy(dst + 1, &target->pixels[(size_t)(target->height - 1 - y) * target->width * 4], stride - 1);
+    }
+
+    std::vector<unsigned char> idat;
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    const size_t max_block = 65535;
+    for (size_t offset = 0; offset < raw.size() || offset == 0; offset += max_block) {
+        size_t size = std::min(max_block, raw.size() - offset);
+        bool last = offset + size >= raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back((unsigned char)size);
+        idat.push_back((unsigned char)(size >> 8));
+        idat.push_back((unsigned char)~size);
+        idat.push_back((unsigned char)(~size >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+        if (last)
+            break;
+    }
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_be32(idat, (b << 16) | a);
+
+    std::vector<unsigned char> header;
+    put_be32(header, (uint32_t)target->width);
+    put_be32(header, (uint32_t)target->height);
+    header.push_back(8); // бит на канал
+    header.push_back(6); // RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<unsigned char> out(signature, signature + 8);
+    png_chunk(out, "IHDR", header);
+    png_chunk(out, "IDAT", idat);
+    png_chunk(out, "IEND", std::vector<unsigned char>());
+    return fwrite(out.data(), 1, out.size(), file) == out.size();
+}
+
+int headless_target_dump(HeadlessTarget* target, const char* path, FrameDumpFormat format) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target->fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, target->width, target->height, GL_RGBA, GL_UNSIGNED_BYTE, target->pixels.data());
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to open frame dump %s\n", path);
+        return 0;
+    }
+    int ok = format == FRAME_DUMP_PNG ? write_png(file, target) : write_ppm(file, target);
+    fclose(file);
+    if (!ok)
+        fprintf(stderr, "Failed to write frame dump %s\n", path);
+    return ok;
+}
+
+void headless_dump_path(const HeadlessOptions* options, int frame, char* path, size_t size) {
+    snprintf(path, size, "%s/frame_%05d.%s", options->dump_dir, frame,
+             options->dump_format == FRAME_DUMP_PNG ? "png" : "ppm");
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void headless_report(const HeadlessOptions* options, const HeadlessStats* stats) {
+    if (stats->frame_ms.empty())
+        return;
+
+    std::vector<double> sorted = stats->frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : sorted)
+        total += ms;
+    printf("Headless: %d frames at %dx%d, frame ms min %.3f avg %.3f p50 %.3f p95 %.3f max %.3f, %d frames dumped\n",
+           (int)sorted.size(), options->width, options->height, sorted.front(), total / sorted.size(),
+           percentile(sorted, 0.50), percentile(sorted, 0.95), sorted.back(), stats->dumped);
+
+    if (!options->stats_path)
+        return;
+    FILE* file = fopen(options->stats_path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open stats file %s\n", options->stats_path);
+        return;
+    }
+    fprintf(file, "frame,ms\n");
+    for (size_t i = 0; i < stats->frame_ms.size(); i++)
+        fprintf(file, "%d,%.4f\n", (int)i, stats->frame_ms[i]);
+    fclose(file);
+}
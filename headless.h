@@ -0,0 +1,65 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "include/glad.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Безоконный режим для CI: рендер в FBO заданное число кадров по сценарию камеры,
+// статистика времени кадра и, по желанию, дамп кадров на диск
+
+typedef enum {
+    FRAME_DUMP_PPM,
+    FRAME_DUMP_PNG
+} FrameDumpFormat;
+
+static const int HEADLESS_DEFAULT_FRAMES = 300;
+
+typedef struct {
+    bool enabled;              // --headless
+    int frames;                // --frames N
+    int width, height;         // --size WxH
+    const char* dump_dir;      // --dump-dir DIR; NULL — без дампов
+    int dump_every;            // --dump-every N
+    FrameDumpFormat dump_format; // --dump-format ppm|png
+    const char* stats_path;    // --stats FILE.csv; NULL — только сводка в stdout
+} HeadlessOptions;
+
+typedef struct {
+    GLuint fbo;
+    GLuint color;
+    GLuint depth;
+    int width, height;
+    std::vector<unsigned char> pixels; // буфер чтения RGBA, переиспользуется между кадрами
+} HeadlessTarget;
+
+typedef struct {
+    std::vector<double> frame_ms; // время каждого кадра вместе с glFinish
+    int dumped;
+} HeadlessStats;
+
+void headless_parse_options(HeadlessOptions* options, int argc, char** argv);
+
+// Хинты GLFW: до glfwInit — null-платформа, если нет дисплея; после — невидимое окно
+// и, на null-платформе, контекст OSMesa (программный llvmpipe)
+void headless_init_hints(const HeadlessOptions* options);
+void headless_window_hints(const HeadlessOptions* options);
+
+// Сценарий камеры: облёт сцены за options->frames кадров, детерминированный для сравнения кадров
+void headless_camera_script(const HeadlessOptions* options, int frame, float* position, float* yaw, float* pitch);
+
+// Создаёт FBO с RGBA8-цветом и depth24-буфером; 0 при неполном FBO
+int headless_target_create(HeadlessTarget* target, int width, int height);
+void headless_target_destroy(HeadlessTarget* target);
+
+// Читает текущий кадр из FBO и пишет в файл (строки разворачиваются сверху вниз)
+int headless_target_dump(HeadlessTarget* target, const char* path, FrameDumpFormat format);
+
+// Имя файла дампа: <dir>/frame_00012.ppm
+void headless_dump_path(const HeadlessOptions* options, int frame, char* path, size_t size);
+
+// Сводка min/avg/p50/p95/max в stdout и построчный CSV, если задан stats_path
+void headless_report(const HeadlessOptions* options, const HeadlessStats* stats);
+
+#endif
@@ -0,0 +1,170 @@
+// Бенчмарк декодирования корпуса JPEG/PNG по наборам SIMD-ядер stb_image:
+// скаляр, SSE2 и AVX2 (насколько поддерживает процессор). Для каждого набора —
+// входные (сжатые) и выходные (пиксели) МБ/с по форматам и сверка с эталоном.
+//   decodebench [--iterations N] [файл или папка ...]
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static const char* const DEFAULT_CORPUS = "D:/vr/zad3";
+static const int DEFAULT_ITERATIONS = 3;
+
+enum CorpusFormat { CORPUS_JPEG = 0, CORPUS_PNG = 1, CORPUS_FORMAT_COUNT = 2 };
+static const char* const CORPUS_FORMAT_NAMES[CORPUS_FORMAT_COUNT] = { "JPEG", "PNG" };
+static const char* const SIMD_LEVEL_NAMES[] = { "scalar", "SSE2", "AVX2" };
+
+typedef struct {
+    std::string path;
+    CorpusFormat format;
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> reference; // пиксели скалярного декодирования
+} CorpusFile;
+
+static bool corpus_format(const std::filesystem::path& path, CorpusFormat* format) {
+    std::string extension = path.extension().string();
+    for (char& c : extension)
+        c = (char)tolower((unsigned char)c);
+    if (extension == ".jpg" || extension == ".jpeg")
+        *format = CORPUS_JPEG;
+    else if (extension == ".png")
+        *format = CORPUS_PNG;
+    else
+        return false;
+    return true;
+}
+
+static void corpus_add_file(std::vector<CorpusFile>* corpus, const std::filesystem::path& path) {
+    CorpusFile file;
+    if (!corpus_format(path, &file.format))
+        return;
+    std::ifstream stream(path, std::ios::binary);
+    file.data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    if (file.data.empty())
+        return;
+    file.path = path.generic_string();
+    corpus->push_back(std::move(file));
+}
+
+static void corpus_add(std::vector<CorpusFile>* corpus, const char* path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::is_directory(path, ec)) {
+        corpus_add_file(corpus, path);
+        return;
+    }
+    for (fs::recursive_directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+        if (it->is_regular_file(ec))
+            corpus_add_file(corpus, it->path());
+}
+
+// Декодирует файл в pixels; 16-битные PNG остаются 16-битными, как их грузит кэш текстур
+static bool decode(const CorpusFile& file, std::vector<unsigned char>* pixels, size_t* pixel_bytes) {
+    int width, height, channels;
+    int size = (int)file.data.size();
+    bool wide = stbi_is_16_bit_from_memory(file.data.data(), size) != 0;
+    unsigned char* decoded = wide ? (unsigned char*)stbi_load_16_from_memory(file.data.data(), size, &width, &height, &channels, 0)
+                                  : stbi_load_from_memory(file.data.data(), size, &width, &height, &channels, 0);
+    if (!decoded)
+        return false;
+    *pixel_bytes = (size_t)width * height * channels * (wide ? 2 : 1);
+    if (pixels)
+        pixels->assign(decoded, decoded + *pixel_bytes);
+    stbi_image_free(decoded);
+    return true;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    std::vector<CorpusFile> corpus;
+    bool have_paths = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+            continue;
+        }
+        corpus_add(&corpus, argv[i]);
+        have_paths = true;
+    }
+    if (!have_paths)
+        corpus_add(&corpus, DEFAULT_CORPUS);
+
+    // Эталон — скалярные ядра; файлы, которые stb_image не читает, выкидываем
+    stbi_set_simd_level(STBI_SIMD_NONE);
+    size_t input_bytes[CORPUS_FORMAT_COUNT] = {}, output_bytes[CORPUS_FORMAT_COUNT] = {};
+    int file_count[CORPUS_FORMAT_COUNT] = {};
+    for (size_t i = 0; i < corpus.size();) {
+        size_t pixel_bytes;
+        if (!decode(corpus[i], &corpus[i].reference, &pixel_bytes)) {
+            fprintf(stderr, "Skipping %s (%s)\n", corpus[i].path.c_str(), stbi_failure_reason());
+            corpus.erase(corpus.begin() + (ptrdiff_t)i);
+            continue;
+        }
+        input_bytes[corpus[i].format] += corpus[i].data.size();
+        output_bytes[corpus[i].format] += pixel_bytes;
+        file_count[corpus[i].format]++;
+        i++;
+    }
+    if (corpus.empty()) {
+        fprintf(stderr, "No decodable .jpg/.jpeg/.png files\n");
+        return 1;
+    }
+
+    stbi_set_simd_level(STBI_SIMD_AVX2);
+    int max_level = stbi_simd_level();
+    printf("corpus: %d JPEG (%.1f MB), %d PNG (%.1f MB); CPU kernel sets up to %s; best of %d\n", file_count[CORPUS_JPEG],
+           input_bytes[CORPUS_JPEG] / 1.0e6, file_count[CORPUS_PNG], input_bytes[CORPUS_PNG] / 1.0e6, SIMD_LEVEL_NAMES[max_level],
+           iterations);
+
+    double scalar_ms[CORPUS_FORMAT_COUNT] = {};
+    for (int level = STBI_SIMD_NONE; level <= max_level; level++) {
+        stbi_set_simd_level(level);
+        double total_ms[CORPUS_FORMAT_COUNT] = {};
+        int max_diff[CORPUS_FORMAT_COUNT] = {};
+        std::vector<unsigned char> pixels;
+        for (const CorpusFile& file : corpus) {
+            double best = 1e30;
+            for (int i = 0; i <= iterations; i++) {
+                size_t pixel_bytes;
+                auto start = std::chrono::steady_clock::now();
+                decode(file, i == 0 ? &pixels : NULL, &pixel_bytes);
+                double ms = elapsed_ms(start);
+                if (i > 0) // первый прогон — прогрев и сверка
+                    best = std::min(best, ms);
+            }
+            total_ms[file.format] += best;
+            // Цветовое преобразование JPEG в SIMD округляет иначе, чем скалярное (±1)
+            for (size_t i = 0; i < pixels.size() && i < file.reference.size(); i++)
+                max_diff[file.format] = std::max(max_diff[file.format], abs((int)pixels[i] - (int)file.reference[i]));
+            if (pixels.size() != file.reference.size())
+                max_diff[file.format] = 255;
+        }
+
+        for (int format = 0; format < CORPUS_FORMAT_COUNT; format++) {
+            if (file_count[format] == 0)
+                continue;
+            if (level == STBI_SIMD_NONE)
+                scalar_ms[format] = total_ms[format];
+            double seconds = total_ms[format] / 1000.0;
+            printf("%-6s %-4s %9.2f ms  in %7.1f MB/s  out %8.1f MB/s  (x%.2f)  %s", SIMD_LEVEL_NAMES[level], CORPUS_FORMAT_NAMES[format],
+                   total_ms[format], input_bytes[format] / 1.0e6 / seconds, output_bytes[format] / 1.0e6 / seconds,
+                   scalar_ms[format] / total_ms[format], max_diff[format] == 0 ? "bit-exact" : "");
+            if (max_diff[format] != 0)
+                printf("max diff %d", max_diff[format]);
+            printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include "image_decoder.h"
+#include "hash.h"
+#include <stb_image.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static double now_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Потоковое чтение файла для stbi_load_from_callbacks; попутно считаем хеш содержимого,
+// чтобы кэш текстур мог распознать одинаковые файлы
+typedef struct {
+    FILE* file;
+    uint64_t hash;
+} HashingReader;
+
+static int hashing_read(void* user, char* data, int size) {
+    HashingReader* reader = (HashingReader*)user;
+    size_t count = fread(data, 1, (size_t)size, reader->file);
+    reader->hash = fnv1a_64_bytes(data, count, reader->hash);
+    return (int)count;
+}
+
+static void hashing_skip(void* user, int n) {
+    HashingReader* reader = (HashingReader*)user;
+    if (n < 0) {
+        // stb_image не откатывается назад для потоков, но на всякий случай
+        fseek(reader->file, n, SEEK_CUR);
+        return;
+    }
+    char buffer[4096];
+    while (n > 0) {
+        int chunk = n < (int)sizeof(buffer) ? n : (int)sizeof(buffer);
+        int count = hashing_read(user, buffer, chunk);
+        if (count <= 0)
+            break;
+        n -= count;
+    }
+}
+
+static int hashing_eof(void* user) {
+    HashingReader* reader = (HashingReader*)user;
+    return feof(reader->file) || ferror(reader->file);
+}
+
+static const stbi_io_callbacks hashing_callbacks = { hashing_read, hashing_skip, hashing_eof };
+
+static void decode_job(ImageDecodeJob& job, DecodedImage* image) {
+    image->pixels = NULL;
+    if (!job.memory.empty()) {
+        image->content_hash = fnv1a_64_bytes(job.memory.data(), job.memory.size());
+        image->pixels = stbi_load_from_memory_scaled(job.memory.data(), (int)job.memory.size(), &image->width, &image->height,
+                                                     &image->channels, job.desired_channels, job.scale_denom, 1);
+        return;
+    }
+    if (job.scale_denom > 1) {
+        // Превью живёт до полного декодирования, которое и посчитает хеш
+        image->content_hash = 0;
+        image->pixels = stbi_load_scaled(job.path.c_str(), &image->width, &image->height, &image->channels,
+                                         job.desired_channels, job.scale_denom, 1);
+        return;
+    }
+
+    HashingReader reader = { fopen(job.path.c_str(), "rb"), FNV1A_64_SEED };
+    if (!reader.file)
+        return;
+    image->pixels = stbi_load_from_callbacks(&hashing_callbacks, &reader,
+                                             &image->width, &image->height, &image->channels, job.desired_channels);
+    // Дочитываем хвост, чтобы хеш покрывал весь файл
+    char buffer[4096];
+    while (hashing_read(&reader, buffer, sizeof(buffer)) > 0) {
+    }
+    image->content_hash = reader.hash;
+    fclose(reader.file);
+}
+
+static void atomic_max(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+static void push_mip_level(void* user, int level, const MipLevel* mip) {
+    block_stream_push((BlockStream*)user, level, mip->pixels.data(), mip->width, mip->height);
+}
+
+static void worker_main(ImageDecoder* decoder) {
+    for (;;) {
+        ImageDecodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(decoder->mutex);
+            decoder->wake.wait(lock, [decoder] { return decoder->stopping || !decoder->jobs.empty(); });
+            if (decoder->stopping && decoder->jobs.empty()) {
+                decoder->running_workers.fetch_sub(1, std::memory_order_release);
+                return;
+            }
+            job = std::move(decoder->jobs.front());
+            decoder->jobs.pop_front();
+        }
+
+        DecodedImage* image = new DecodedImage();
+        image->request_id = job.request_id;
+        image->path = job.path;
+        image->width = image->height = image->channels = 0;
+        image->preview = job.scale_denom > 1;
+
+        double start = now_ms();
+        decode_job(job, image);
+        double end = now_ms();
+
+        image->ok = image->pixels != NULL;
+        if (job.desired_channels != 0 && image->ok)
+            image->channels = job.desired_channels;
+        image->decode_ms = end - start;
+        image->mip_ms = 0.0;
+        image->compress_ms = 0.0;
+        BlockStream* stream = NULL;
+        if (job.compress && image->ok) {
+            BlockEncodeOptions encode = block_runtime_encode_options(&job.compress_options, image->channels);
+            stream = block_stream_begin(decoder->block_encoder, &encode, image->channels);
+            block_stream_push(stream, 0, image->pixels, image->width, image->height);
+            job.mip_options.level_ready = push_mip_level;
+            job.mip_options.level_ready_user = stream;
+        }
+        if (job.build_mips && image->ok) {
+            mip_build_chain(&image->mips, image->pixels, image->width, image->height, image->channels, &job.mip_options);
+            image->mip_ms = now_ms() - end;
+            end += image->mip_ms;
+        }
+        if (stream) {
+            block_stream_finish(stream, &image->compressed);
+            image->compress_ms = now_ms() - end;
+            end += image->compress_ms;
+        }
+        image->latency_ms = end - job.submit_time_ms;
+
+        decoder->decode_us_total.fetch_add((uint64_t)(image->decode_ms * 1000.0), std::memory_order_relaxed);
+        decoder->latency_us_total.fetch_add((uint64_t)(image->latency_ms * 1000.0), std::memory_order_relaxed);
+        atomic_max(decoder->latency_us_max, (uint64_t)(image->latency_ms * 1000.0));
+        if (!image->ok)
+            decoder->failed.fetch_add(1, std::memory_order_relaxed);
+
+        // Очередь результатов ограничена: если поток рендера не успевает забирать, ждём
+        while (!decoder->results.try_push(image))
+            std::this_thread::yield();
+        decoder->completed.fetch_add(1, std::memory_order_relaxed);
+        decoder->in_flight.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+ImageDecoder* image_decoder_create(unsigned thread_count, size_t result_capacity) {
+    if (thread_count == 0) {
+        unsigned cores = std::thread::hardware_concurrency();
+        thread_count = cores > 1 ? cores - 1 : 1;
+    }
+
+    ImageDecoder* decoder = new ImageDecoder(result_capacity);
+    decoder->stopping = false;
+    decoder->next_request_id = 1;
+    decoder->in_flight = 0;
+    decoder->submitted = 0;
+    decoder->completed = 0;
+    decoder->failed = 0;
+    decoder->decode_us_total = 0;
+    decoder->latency_us_total = 0;
+    decoder->latency_us_max = 0;
+    decoder->running_workers = thread_count;
+    decoder->block_encoder = NULL;
+    for (unsigned i = 0; i < thread_count; i++)
+        decoder->workers.emplace_back(worker_main, decoder);
+    return decoder;
+}
+
+void image_decoder_destroy(ImageDecoder* decoder) {
+    if (!decoder)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(decoder->mutex);
+        decoder->stopping = true;
+        decoder->in_flight.fetch_sub(decoder->jobs.size(), std::memory_order_relaxed);
+        decoder->jobs.clear();
+    }
+    decoder->wake.notify_all();
+
+    // Потоки могут ждать места в очереди результатов — освобождаем её, пока они не завершатся
+    while (decoder->running_workers.load(std::memory_order_acquire) != 0) {
+        DecodedImage* image;
+        while (decoder->results.try_pop(image))
+            image_decoder_free(image);
+        std::this_thread::yield();
+    }
+    for (std::thread& worker : decoder->workers)
+        worker.join();
+
+    DecodedImage* image;
+    while (decoder->results.try_pop(image))
+        image_decoder_free(image);
+    delete decoder;
+}
+
+static uint64_t submit_job(ImageDecoder* decoder, ImageDecodeJob&& job, bool urgent = false) {
+    job.request_id = decoder->next_request_id.fetch_add(1, std::memory_order_relaxed);
+    job.submit_time_ms = now_ms();
+    uint64_t request_id = job.request_id;
+
+    decoder->submitted.fetch_add(1, std::memory_order_relaxed);
+    decoder->in_flight.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(decoder->mutex);
+        if (urgent)
+            decoder->jobs.push_front(std::move(job));
+        else
+            decoder->jobs.push_back(std::move(job));
+    }
+    decoder->wake.notify_one();
+    return request_id;
+}
+
+static void set_job_mips(ImageDecodeJob& job, const MipOptions* mip_options, const BlockRuntimeOptions* compress) {
+    job.build_mips = mip_options != NULL;
+    job.mip_options = mip_options ? *mip_options : mip_default_options();
+    job.compress = compress && compress->enabled;
+    if (job.compress)
+        job.compress_options = *compress;
+}
+
+uint64_t image_decoder_submit_file(ImageDecoder* decoder, const char* path, int desired_channels, const MipOptions* mip_options,
+                                   const BlockRuntimeOptions* compress) {
+    ImageDecodeJob job;
+    job.path = path;
+    job.desired_channels = desired_channels;
+    job.scale_denom = 1;
+    set_job_mips(job, mip_options, compress);
+    return submit_job(decoder, std::move(job));
+}
+
+uint64_t image_decoder_submit_memory(ImageDecoder* decoder, const char* name, const void* data, size_t size, int desired_channels,
+                                     const MipOptions* mip_options, const BlockRuntimeOptions* compress) {
+    ImageDecodeJob job;
+    job.path = name ? name : "";
+    job.memory.assign((const unsigned char*)data, (const unsigned char*)data + size);
+    job.desired_channels = desired_channels;
+    job.scale_denom = 1;
+    set_job_mips(job, mip_options, compress);
+    return submit_job(decoder, std::move(job));
+}
+
+uint64_t image_decoder_submit_preview(ImageDecoder* decoder, const char* path, int scale_denom, int desired_channels) {
+    ImageDecodeJob job;
+    job.path = path;
+    job.desired_channels = desired_channels;
+    job.scale_denom = scale_denom;
+    set_job_mips(job, NULL, NULL);
+    return submit_job(decoder, std::move(job), true);
+}
+
+bool image_decoder_poll(ImageDecoder* decoder, DecodedImage** image) {
+    return decoder->results.try_pop(*image);
+}
+
+void image_decoder_free(DecodedImage* image) {
+    if (!image)
+        return;
+    if (image->pixels)
+        stbi_image_free(image->pixels);
+    delete image;
+}
+
+void image_decoder_wait_idle(ImageDecoder* decoder) {
+    while (decoder->in_flight.load(std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+}
+
+ImageDecoderStats image_decoder_stats(ImageDecoder* decoder) {
+    ImageDecoderStats stats;
+    stats.submitted = decoder->submitted.load(std::memory_order_relaxed);
+    stats.completed = decoder->completed.load(std::memory_order_relaxed);
+    stats.failed = decoder->failed.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(decoder->mutex);
+        stats.jobs_queued = decoder->jobs.size();
+    }
+    stats.results_queued = decoder->results.size_approx();
+    stats.avg_decode_ms = stats.completed ? decoder->decode_us_total.load() / 1000.0 / stats.completed : 0.0;
+    stats.avg_latency_ms = stats.completed ? decoder->latency_us_total.load() / 1000.0 / stats.completed : 0.0;
+    stats.max_latency_ms = decoder->latency_us_max.load() / 1000.0;
+    return stats;
+}
@@ -0,0 +1,109 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include "mpmc_queue.h"
+#include "mipmap.h"
+#include "block_encoder.h"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Пул потоков, декодирующих изображения через stb_image вне потока рендера.
+// Модуль не зависит от OpenGL — результаты забирает поток с GL-контекстом.
+
+typedef struct {
+    uint64_t request_id;
+    std::string path;
+    uint64_t content_hash;   // FNV-1a содержимого файла
+    unsigned char* pixels;   // освобождать через image_decoder_free
+    int width;
+    int height;
+    int channels;
+    MipChain mips;           // пусто, если мип-уровни не запрашивались
+    CompressedTexture compressed; // уровни пусты, если сжатие не запрашивалось
+    double decode_ms;        // чистое время декодирования
+    double mip_ms;           // построение мип-цепочки
+    double compress_ms;      // ожидание сжатия после мип-цепочки (уровни сжимаются по мере построения)
+    double latency_ms;       // от постановки в очередь до готовности
+    bool preview;            // уменьшенная копия (image_decoder_submit_preview): без хеша и мип-уровней
+    bool ok;
+} DecodedImage;
+
+typedef struct {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t jobs_queued;    // ждут свободного потока
+    uint64_t results_queued; // декодированы, ждут загрузки в GL
+    double avg_decode_ms;
+    double avg_latency_ms;
+    double max_latency_ms;
+} ImageDecoderStats;
+
+struct ImageDecodeJob {
+    uint64_t request_id;
+    std::string path;
+    std::vector<unsigned char> memory; // если не пусто — декодируем из памяти, а не из файла
+    int desired_channels;
+    int scale_denom;                   // > 1 — JPEG декодируется сразу уменьшенным (1/2, 1/4, 1/8)
+    bool build_mips;
+    MipOptions mip_options;
+    bool compress;
+    BlockRuntimeOptions compress_options;
+    double submit_time_ms;
+};
+
+struct ImageDecoder {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<ImageDecodeJob> jobs;
+    bool stopping;
+
+    MpmcQueue<DecodedImage*> results;
+    std::atomic<uint64_t> next_request_id;
+    std::atomic<uint64_t> in_flight;
+    std::atomic<unsigned> running_workers;
+    BlockEncoder* block_encoder; // пул для сжатия при загрузке; NULL — сжатие в потоке декодера
+
+    std::atomic<uint64_t> submitted;
+    std::atomic<uint64_t> completed;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> decode_us_total;
+    std::atomic<uint64_t> latency_us_total;
+    std::atomic<uint64_t> latency_us_max;
+
+    explicit ImageDecoder(size_t result_capacity) : results(result_capacity) {}
+};
+
+// thread_count == 0 — по числу ядер минус один (поток рендера)
+ImageDecoder* image_decoder_create(unsigned thread_count, size_t result_capacity = 256);
+void image_decoder_destroy(ImageDecoder* decoder);
+
+// Возвращают идентификатор запроса. С mip_options рабочий поток сразу после
+// декодирования строит мип-цепочку, и потоку рендера остаётся только загрузка.
+// С включённым compress уровни ещё и сжимаются в block_encoder по мере построения.
+uint64_t image_decoder_submit_file(ImageDecoder* decoder, const char* path, int desired_channels = 0, const MipOptions* mip_options = NULL,
+                                   const BlockRuntimeOptions* compress = NULL);
+uint64_t image_decoder_submit_memory(ImageDecoder* decoder, const char* name, const void* data, size_t size, int desired_channels = 0,
+                                     const MipOptions* mip_options = NULL, const BlockRuntimeOptions* compress = NULL);
+
+// Уменьшенная в scale_denom раз копия JPEG (2, 4 или 8; остальные форматы — в полном размере)
+// для показа до полного декодирования. Встаёт в начало очереди, хеш содержимого не считается.
+uint64_t image_decoder_submit_preview(ImageDecoder* decoder, const char* path, int scale_denom, int desired_channels = 0);
+
+// Неблокирующее извлечение готового результата; вызывающий владеет *image
+bool image_decoder_poll(ImageDecoder* decoder, DecodedImage** image);
+void image_decoder_free(DecodedImage* image);
+
+// Ждёт, пока все поставленные задачи не будут декодированы (не извлечены)
+void image_decoder_wait_idle(ImageDecoder* decoder);
+
+ImageDecoderStats image_decoder_stats(ImageDecoder* decoder);
+
+#endif
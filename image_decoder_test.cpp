@@ -0,0 +1,198 @@
+// Проверка декодирования без GL-контекста: ImageDecoder на файлах и буферах в памяти
+// (пиксели, хеш содержимого, ошибки, счётчики) и TextureCache с бэкендом-заглушкой
+// (попадания, попадания по содержимому, промахи, bytes_resident, асинхронная загрузка).
+// Код возврата 1 — какая-то проверка не прошла.
+//   image_decoder_test
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "image_decoder.h"
+#include "texture_cache.h"
+#include "hash.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int IMAGE_SIZE = 4;
+static const int POLL_ATTEMPTS = 2000; // по 1 мс — асинхронные результаты ждём не дольше 2 с
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+// Бинарный PPM IMAGE_SIZE x IMAGE_SIZE, все байты пикселей равны value
+static std::vector<unsigned char> make_ppm(unsigned char value) {
+    char header[32];
+    int header_size = snprintf(header, sizeof(header), "P6 %d %d 255\n", IMAGE_SIZE, IMAGE_SIZE);
+    std::vector<unsigned char> data(header, header + header_size);
+    data.insert(data.end(), (size_t)IMAGE_SIZE * IMAGE_SIZE * 3, value);
+    return data;
+}
+
+static void write_file(const std::string& path, const std::vector<unsigned char>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)data.data(), (std::streamsize)data.size());
+}
+
+static DecodedImage* wait_result(ImageDecoder* decoder) {
+    DecodedImage* image = NULL;
+    for (int i = 0; i < POLL_ATTEMPTS && !image_decoder_poll(decoder, &image); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return image;
+}
+
+static bool pixels_equal(const DecodedImage* image, unsigned char value) {
+    size_t size = (size_t)image->width * image->height * image->channels;
+    for (size_t i = 0; i < size; i++)
+        if (image->pixels[i] != value)
+            return false;
+    return true;
+}
+
+static void test_decoder(const std::string& dir) {
+    std::vector<unsigned char> gray = make_ppm(100);
+    std::string path = dir + "/gray.ppm";
+    write_file(path, gray);
+    ImageDecoder* decoder = image_decoder_create(2);
+
+    // Файл: пиксели и хеш содержимого считаются на лету при чтении
+    uint64_t id = image_decoder_submit_file(decoder, path.c_str());
+    DecodedImage* image = wait_result(decoder);
+    CHECK(image && image->request_id == id);
+    if (image) {
+        CHECK(image->ok);
+        CHECK(image->width == IMAGE_SIZE && image->height == IMAGE_SIZE && image->channels == 3);
+        CHECK(pixels_equal(image, 100));
+        CHECK(image->content_hash == fnv1a_64_bytes(gray.data(), gray.size()));
+        CHECK(image->mips.levels.empty());
+        image_decoder_free(image);
+    }
+
+    // Память: тот же хеш, desired_channels и мип-цепочка в рабочем потоке
+    MipOptions mip_options = mip_default_options();
+    image_decoder_submit_memory(decoder, "gray", gray.data(), gray.size(), 4, &mip_options);
+    image = wait_result(decoder);
+    CHECK(image != NULL);
+    if (image) {
+        CHECK(image->ok && image->channels == 4);
+        CHECK(image->content_hash == fnv1a_64_bytes(gray.data(), gray.size()));
+        CHECK((int)image->mips.levels.size() == mip_level_count(IMAGE_SIZE, IMAGE_SIZE) - 1);
+        image_decoder_free(image);
+    }
+
+    // Ошибки: мусор в памяти и несуществующий файл
+    static const char garbage[] = "not an image";
+    image_decoder_submit_memory(decoder, "garbage", garbage, sizeof(garbage));
+    image_decoder_submit_file(decoder, (dir + "/missing.ppm").c_str());
+    for (int i = 0; i < 2; i++) {
+        image = wait_result(decoder);
+        CHECK(image && !image->ok && !image->pixels);
+        if (image)
+            image_decoder_free(image);
+    }
+
+    ImageDecoderStats stats = image_decoder_stats(decoder);
+    CHECK(stats.submitted == 4);
+    CHECK(stats.completed == 4);
+    CHECK(stats.failed == 2);
+    CHECK(stats.jobs_queued == 0 && stats.results_queued == 0);
+    CHECK(stats.max_latency_ms >= stats.avg_latency_ms);
+    image_decoder_destroy(decoder);
+}
+
+// Бэкенд без GL: выдаёт номера текстур и следит, чтобы каждая удалялась ровно один раз
+static GLuint stub_next_texture = 1;
+static std::set<GLuint> stub_live;
+
+static GLuint stub_upload(const unsigned char*, int, int, int, const MipChain*) {
+    stub_live.insert(stub_next_texture);
+    return stub_next_texture++;
+}
+
+static void stub_destroy(GLuint texture) {
+    CHECK(stub_live.erase(texture) == 1);
+}
+
+static const TextureBackend stub_backend = { stub_upload, NULL, stub_destroy, NULL };
+
+static void test_cache(const std::string& dir) {
+    std::string a = dir + "/a.ppm", b = dir + "/b.ppm", c = dir + "/c.ppm";
+    write_file(a, make_ppm(10));
+    write_file(b, make_ppm(10));
+    write_file(c, make_ppm(20));
+
+    TextureCache cache;
+    texture_cache_init(&cache, 1ull << 30, &stub_backend);
+
+    TextureHandle first = texture_cache_acquire(&cache, a.c_str());
+    CHECK(first && first->texture && first->ref_count == 1);
+    CHECK(cache.stats.misses == 1 && cache.stats.hits == 0);
+    uint64_t texture_bytes = cache.stats.bytes_resident;
+    CHECK(texture_bytes > 0);
+
+    // Тот же путь без изменений — файл даже не открывается
+    TextureHandle again = texture_cache_acquire(&cache, a.c_str());
+    CHECK(again == first && first->ref_count == 2);
+    CHECK(cache.stats.hits == 1);
+
+    // Другой путь с тем же содержимым — та же запись, без второй загрузки
+    TextureHandle copy = texture_cache_acquire(&cache, b.c_str());
+    CHECK(copy == first);
+    CHECK(cache.stats.content_hits == 1 && cache.stats.misses == 1);
+    CHECK(cache.stats.bytes_resident == texture_bytes);
+
+    // Асинхронно: до pump — заглушка, после — своя текстура
+    ImageDecoder* decoder = image_decoder_create(1);
+    TextureHandle async = texture_cache_acquire_async(&cache, decoder, c.c_str());
+    CHECK(async && async->pending && async->texture == cache.placeholder);
+    CHECK(cache.stats.misses == 2 && cache.stats.async_pending == 1);
+    for (int i = 0; i < POLL_ATTEMPTS && cache.stats.async_pending > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        texture_cache_pump(&cache, decoder, 1ull << 30);
+    }
+    CHECK(cache.stats.async_pending == 0 && cache.stats.async_uploads == 1);
+    CHECK(!async->pending && async->texture != cache.placeholder && async->width == IMAGE_SIZE);
+    CHECK(cache.stats.bytes_resident == 2 * texture_bytes);
+    CHECK(texture_cache_acquire_async(&cache, decoder, c.c_str()) == async);
+    CHECK(cache.stats.hits == 2);
+
+    // Без ссылок и с нулевым бюджетом всё вытесняется
+    for (TextureHandle handle : { first, again, copy, async, async })
+        texture_cache_release(&cache, handle);
+    cache.budget_bytes = 0;
+    texture_cache_release(&cache, first);
+    CHECK(cache.stats.evictions == 2 && cache.stats.bytes_resident == 0);
+    CHECK(cache.entries.empty());
+
+    texture_cache_shutdown(&cache);
+    image_decoder_destroy(decoder);
+    CHECK(stub_live.empty());
+}
+
+int main() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "image_decoder_test";
+    fs::create_directories(dir);
+
+    test_decoder(dir.generic_string());
+    test_cache(dir.generic_string());
+
+    fs::remove_all(dir);
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("image_decoder_test: all checks passed\n");
+    return 0;
+}
@@ -429,6 +429,25 @@ STBIDEF stbi_uc *stbi_load_from_file  (FILE *f, int *x, int *y, int *channels_in
 // for stbi_load_from_file, file pointer is left pointing immediately after image
 #endif
 
+// Parallel JPEG decoding with up to 'threads' threads: baseline scans with restart markers are
+// entropy-decoded in parallel at RST boundaries, and IDCT, chroma upsampling and color conversion
+// run over bands of MCU rows. Other formats (and builds compiled as C or with STBI_NO_THREADS)
+// decode exactly like the serial entry points; the output is identical either way.
+STBIDEF stbi_uc *stbi_load_from_memory_parallel(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int threads);
+#ifndef STBI_NO_STDIO
+STBIDEF stbi_uc *stbi_load_parallel(char const *filename, int *x, int *y, int *channels_in_file, int desired_channels, int threads);
+#endif
+
+// Reduced-size JPEG decoding: scale_denom 2, 4 or 8 yields a 1/2, 1/4 or 1/8 scale image
+// (dimensions rounded up) by running 4x4, 2x2 or 1x1 IDCTs instead of the full 8x8 one, so
+// the cost drops to roughly the entropy decoding alone. Other values round down to one of
+// these (1 or less is a full decode). Non-JPEG input decodes at full size; check *x and *y.
+// threads > 1 works as for stbi_load_from_memory_parallel.
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int scale_denom, int threads);
+#ifndef STBI_NO_STDIO
+STBIDEF stbi_uc *stbi_load_scaled(char const *filename, int *x, int *y, int *channels_in_file, int desired_channels, int scale_denom, int threads);
+#endif
+
 #ifndef STBI_NO_GIF
 STBIDEF stbi_uc *stbi_load_gif_from_memory(stbi_uc const *buffer, int len, int **delays, int *x, int *y, int *z, int *comp, int req_comp);
 #endif
@@ -524,6 +543,20 @@ STBIDEF void stbi_set_unpremultiply_on_load_thread(int flag_true_if_should_unpre
 STBIDEF void stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert);
 STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip);
 
+// SIMD kernel sets for the JPEG IDCT, color conversion and chroma upsampling and for PNG
+// unfiltering. The best set the CPU supports is picked at run time; the cap set here (default
+// STBI_SIMD_AVX2) limits it, e.g. to compare sets. STBI_SIMD_SSE2 also stands for NEON builds.
+// Every set produces identical output.
+enum
+{
+   STBI_SIMD_NONE = 0,
+   STBI_SIMD_SSE2 = 1,
+   STBI_SIMD_AVX2 = 2
+};
+STBIDEF void stbi_set_simd_level(int max_level);
+// the set decoding uses now: the cap, lowered to what this build and CPU support
+STBIDEF int  stbi_simd_level(void);
+
 // ZLIB client - used by PNG, available for other purposes
 
 STBIDEF char *stbi_zlib_decode_malloc_guesssize(const char *buffer, int len, int initial_size, int *outlen);
@@ -598,6 +631,13 @@ STBIDEF int   stbi_zlib_decode_noheader_buffer(char *obuffer, int olen, const ch
 #include <stdio.h>
 #endif
 
+#if defined(__cplusplus) && !defined(STBI_NO_THREADS)
+#include <atomic>
+#include <thread>
+#include <vector>
+#define STBI__THREADS
+#endif
+
 #ifndef STBI_ASSERT
 #include <assert.h>
 #define STBI_ASSERT(x) assert(x)
@@ -750,7 +790,7 @@ static int stbi__cpuid3(void)
 
 #define STBI_SIMD_ALIGN(type, name) __declspec(align(16)) type name
 
-#if !defined(STBI_NO_JPEG) && defined(STBI_SSE2)
+#if (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)) && defined(STBI_SSE2)
 static int stbi__sse2_available(void)
 {
    int info3 = stbi__cpuid3();
@@ -761,7 +801,7 @@ static int stbi__sse2_available(void)
 #else // assume GCC-style if not VC++
 #define STBI_SIMD_ALIGN(type, name) type name __attribute__((aligned(16)))
 
-#if !defined(STBI_NO_JPEG) && defined(STBI_SSE2)
+#if (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)) && defined(STBI_SSE2)
 static int stbi__sse2_available(void)
 {
    // If we're even attempting to compile this on GCC/Clang, that means
@@ -774,6 +814,43 @@ static int stbi__sse2_available(void)
 #endif
 #endif
 
+// AVX2 kernels are compiled for AVX2 whatever the global -m flags are, and picked at run
+// time only when cpuid (and the OS, via XGETBV) report AVX2, so one binary runs everywhere.
+// MinGW GCC can't keep 32-byte stack alignment on Windows (GCC bug 54412) and spills ymm
+// registers with aligned moves; define STBI_MINGW_ENABLE_AVX2 after adding
+// -Wa,-muse-unaligned-vector-move (binutils 2.38+) to your build. STBI_NO_AVX2 opts out.
+#if defined(STBI_SSE2) && !defined(STBI_NO_AVX2) && !(defined(__MINGW32__) && !defined(__clang__) && !defined(STBI_MINGW_ENABLE_AVX2))
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define STBI_AVX2
+#endif
+#endif
+
+#ifdef STBI_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define STBI__AVX2_TARGET
+static int stbi__avx2_available(void)
+{
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7) return 0;
+   __cpuid(info, 1);
+   // OSXSAVE and AVX, then the OS must save the ymm state
+   if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return 0;
+   if ((_xgetbv(0) & 6) != 6) return 0;
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) != 0;
+}
+#else
+#define STBI__AVX2_TARGET __attribute__((target("avx2")))
+static int stbi__avx2_available(void)
+{
+   // libgcc/compiler-rt check the OS side (XGETBV) too
+   return __builtin_cpu_supports("avx2");
+}
+#endif
+#endif
+
 // ARM NEON
 #if defined(STBI_NO_SIMD) && defined(STBI_NEON)
 #undef STBI_NEON
@@ -1111,6 +1188,27 @@ static float   *stbi__ldr_to_hdr(stbi_uc *data, int x, int y, int comp);
 static stbi_uc *stbi__hdr_to_ldr(float   *data, int x, int y, int comp);
 #endif
 
+static int stbi__simd_level_max = STBI_SIMD_AVX2;
+
+STBIDEF void stbi_set_simd_level(int max_level)
+{
+   stbi__simd_level_max = max_level;
+}
+
+STBIDEF int stbi_simd_level(void)
+{
+   int level = STBI_SIMD_NONE;
+#if defined(STBI_SSE2) && (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG))
+   if (stbi__sse2_available()) level = STBI_SIMD_SSE2;
+#elif defined(STBI_NEON)
+   level = STBI_SIMD_SSE2;
+#endif
+#ifdef STBI_AVX2
+   if (level == STBI_SIMD_SSE2 && stbi__avx2_available()) level = STBI_SIMD_AVX2;
+#endif
+   return level < stbi__simd_level_max ? level : stbi__simd_level_max;
+}
+
 static int stbi__vertically_flip_on_load_global = 0;
 
 STBIDEF void stbi_set_flip_vertically_on_load(int flag_true_if_should_flip)
@@ -1998,6 +2096,13 @@ typedef struct
    void (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
    void (*YCbCr_to_RGB_kernel)(stbi_uc *out, const stbi_uc *y, const stbi_uc *pcb, const stbi_uc *pcr, int count, int step);
    stbi_uc *(*resample_row_hv_2_kernel)(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs);
+
+// parallel decoding (stbi_load_*_parallel)
+   int threads;       // <= 1: everything runs on the calling thread
+   int deferred_idct; // baseline scans keep coefficients for a parallel idct in stbi__jpeg_finish
+
+// reduced-size decoding (stbi_load_*_scaled): each 8x8 block is idct'ed straight to (8>>scale_shift)^2
+   int scale_shift;   // 0..3
 } stbi__jpeg;
 
 static int stbi__build_huffman(stbi__huffman *h, int *count)
@@ -2523,6 +2628,81 @@ static void stbi__idct_block(stbi_uc *out, int out_stride, short data[64])
    }
 }
 
+// reduced IDCTs for stbi_load_*_scaled: each output pixel is the exact average of its
+// (8/N)x(8/N) cell of the full 8x8 reconstruction, i.e. the full IDCT followed by a box
+// filter, folded into one N-point transform per axis. all 8 frequencies contribute, so a
+// 1/2 or 1/4 scale image matches decode-and-downsample within rounding, without aliasing.
+//
+// 4-point: rows y and 3-y share the even part (e) and negate the odd part (o)
+#define STBI__IDCT_4_1D(s0,s1,s2,s3,s4,s5,s6,s7) \
+   int a  = (s0) * stbi__f2f(0.353553391f);   \
+   int t  = (s2) * stbi__f2f(0.326640741f) - (s6) * stbi__f2f(0.135299025f); \
+   int e0 = a + t, e1 = a - t;                 \
+   int o0 = (s1) * stbi__f2f(0.453063723f) + (s3) * stbi__f2f(0.159094823f) \
+          - (s5) * stbi__f2f(0.106303762f) - (s7) * stbi__f2f(0.090119978f); \
+   int o1 = (s1) * stbi__f2f(0.187665139f) - (s3) * stbi__f2f(0.384088878f) \
+          + (s5) * stbi__f2f(0.256639984f) - (s7) * stbi__f2f(0.037328917f); \
+   STBI_NOTUSED(s4);
+
+// 2-point: the even frequencies above DC average out over half a block
+#define STBI__IDCT_2_1D(s0,s1,s3,s5,s7) \
+   int a = (s0) * stbi__f2f(0.353553391f);   \
+   int o = (s1) * stbi__f2f(0.320364431f) - (s3) * stbi__f2f(0.112497028f) \
+         + (s5) * stbi__f2f(0.075168111f) - (s7) * stbi__f2f(0.063724447f);
+
+static void stbi__idct_block_4x4(stbi_uc *out, int out_stride, short data[64])
+{
+   int i,val[32],*v=val;
+   short *d = data;
+
+   // columns; like stbi__idct_block, keep 2 extra bits of precision
+   for (i=0; i < 8; ++i,++d,++v) {
+      STBI__IDCT_4_1D(d[0],d[8],d[16],d[24],d[32],d[40],d[48],d[56])
+      v[ 0] = (e0 + o0 + 512) >> 10;
+      v[24] = (e0 - o0 + 512) >> 10;
+      v[ 8] = (e1 + o1 + 512) >> 10;
+      v[16] = (e1 - o1 + 512) >> 10;
+   }
+
+   // rows; 1<<12 from the constants and 1<<2 from the columns. the weights already
+   // include the DCT normalization, so 1<<14 is all there is to remove
+   for (i=0, v=val; i < 4; ++i,v+=8,out+=out_stride) {
+      STBI__IDCT_4_1D(v[0],v[1],v[2],v[3],v[4],v[5],v[6],v[7])
+      e0 += 8192 + (128<<14);
+      e1 += 8192 + (128<<14);
+      out[0] = stbi__clamp((e0 + o0) >> 14);
+      out[3] = stbi__clamp((e0 - o0) >> 14);
+      out[1] = stbi__clamp((e1 + o1) >> 14);
+      out[2] = stbi__clamp((e1 - o1) >> 14);
+   }
+}
+
+static void stbi__idct_block_2x2(stbi_uc *out, int out_stride, short data[64])
+{
+   int i,val[16],*v=val;
+   short *d = data;
+
+   for (i=0; i < 8; ++i,++d,++v) {
+      STBI__IDCT_2_1D(d[0],d[8],d[24],d[40],d[56])
+      v[0] = (a + o + 512) >> 10;
+      v[8] = (a - o + 512) >> 10;
+   }
+
+   for (i=0, v=val; i < 2; ++i,v+=8,out+=out_stride) {
+      STBI__IDCT_2_1D(v[0],v[1],v[3],v[5],v[7])
+      a += 8192 + (128<<14);
+      out[0] = stbi__clamp((a + o) >> 14);
+      out[1] = stbi__clamp((a - o) >> 14);
+   }
+}
+
+static void stbi__idct_block_1x1(stbi_uc *out, int out_stride, short data[64])
+{
+   // the block average, rounded like the DC-only path of stbi__idct_block
+   STBI_NOTUSED(out_stride);
+   out[0] = stbi__clamp(((data[0] + 4) >> 3) + 128);
+}
+
 #ifdef STBI_SSE2
 // sse2 integer IDCT. not the fastest possible implementation but it
 // produces bit-identical results to the generic C version so it's
@@ -2704,6 +2884,160 @@ static void stbi__idct_simd(stbi_uc *out, int out_stride, short data[64])
 
 #endif // STBI_SSE2
 
+#ifdef STBI_AVX2
+// avx2 version of the sse2 IDCT above: the 32-bit intermediates of a row of 8
+// live in one ymm register instead of a lo/hi pair, which halves the multiply
+// and add count. same math, same rounding, so still bit-identical.
+STBI__AVX2_TARGET
+static void stbi__idct_avx2(stbi_uc *out, int out_stride, short data[64])
+{
+   __m128i row0, row1, row2, row3, row4, row5, row6, row7;
+   __m128i tmp;
+
+   #define dct_const(x,y)  _mm256_setr_epi16((x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y))
+
+   // columns 0..3 in the low lane, 4..7 in the high lane
+   #define dct_rot(out0,out1, x,y,c0,c1) \
+      __m256i c0##xy = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16((x),(y))), _mm_unpackhi_epi16((x),(y)), 1); \
+      __m256i out0 = _mm256_madd_epi16(c0##xy, c0); \
+      __m256i out1 = _mm256_madd_epi16(c0##xy, c1)
+
+   #define dct_widen(out, in) \
+      __m256i out = _mm256_slli_epi32(_mm256_cvtepi16_epi32(in), 12)
+
+   // butterfly a/b, add bias, then shift by "s" and pack; packs works per lane,
+   // so the 64-bit permute puts sums in the low half and differences in the high
+   #define dct_bfly32o(out0, out1, a,b,bias,s) \
+      { \
+         __m256i abiased = _mm256_add_epi32(a, bias); \
+         __m256i sum = _mm256_srai_epi32(_mm256_add_epi32(abiased, b), s); \
+         __m256i dif = _mm256_srai_epi32(_mm256_sub_epi32(abiased, b), s); \
+         __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(sum, dif), 0xd8); \
+         out0 = _mm256_castsi256_si128(packed); \
+         out1 = _mm256_extracti128_si256(packed, 1); \
+      }
+
+   #define dct_interleave8(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi8(a, b); \
+      b = _mm_unpackhi_epi8(tmp, b)
+
+   #define dct_interleave16(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi16(a, b); \
+      b = _mm_unpackhi_epi16(tmp, b)
+
+   #define dct_pass(bias,shift) \
+      { \
+         /* even part */ \
+         dct_rot(t2e,t3e, row2,row6, rot0_0,rot0_1); \
+         __m128i sum04 = _mm_add_epi16(row0, row4); \
+         __m128i dif04 = _mm_sub_epi16(row0, row4); \
+         dct_widen(t0e, sum04); \
+         dct_widen(t1e, dif04); \
+         __m256i x0 = _mm256_add_epi32(t0e, t3e); \
+         __m256i x3 = _mm256_sub_epi32(t0e, t3e); \
+         __m256i x1 = _mm256_add_epi32(t1e, t2e); \
+         __m256i x2 = _mm256_sub_epi32(t1e, t2e); \
+         /* odd part */ \
+         dct_rot(y0o,y2o, row7,row3, rot2_0,rot2_1); \
+         dct_rot(y1o,y3o, row5,row1, rot3_0,rot3_1); \
+         __m128i sum17 = _mm_add_epi16(row1, row7); \
+         __m128i sum35 = _mm_add_epi16(row3, row5); \
+         dct_rot(y4o,y5o, sum17,sum35, rot1_0,rot1_1); \
+         __m256i x4 = _mm256_add_epi32(y0o, y4o); \
+         __m256i x5 = _mm256_add_epi32(y1o, y5o); \
+         __m256i x6 = _mm256_add_epi32(y2o, y5o); \
+         __m256i x7 = _mm256_add_epi32(y3o, y4o); \
+         dct_bfly32o(row0,row7, x0,x7,bias,shift); \
+         dct_bfly32o(row1,row6, x1,x6,bias,shift); \
+         dct_bfly32o(row2,row5, x2,x5,bias,shift); \
+         dct_bfly32o(row3,row4, x3,x4,bias,shift); \
+      }
+
+   __m256i rot0_0 = dct_const(stbi__f2f(0.5411961f), stbi__f2f(0.5411961f) + stbi__f2f(-1.847759065f));
+   __m256i rot0_1 = dct_const(stbi__f2f(0.5411961f) + stbi__f2f( 0.765366865f), stbi__f2f(0.5411961f));
+   __m256i rot1_0 = dct_const(stbi__f2f(1.175875602f) + stbi__f2f(-0.899976223f), stbi__f2f(1.175875602f));
+   __m256i rot1_1 = dct_const(stbi__f2f(1.175875602f), stbi__f2f(1.175875602f) + stbi__f2f(-2.562915447f));
+   __m256i rot2_0 = dct_const(stbi__f2f(-1.961570560f) + stbi__f2f( 0.298631336f), stbi__f2f(-1.961570560f));
+   __m256i rot2_1 = dct_const(stbi__f2f(-1.961570560f), stbi__f2f(-1.961570560f) + stbi__f2f( 3.072711026f));
+   __m256i rot3_0 = dct_const(stbi__f2f(-0.390180644f) + stbi__f2f( 2.053119869f), stbi__f2f(-0.390180644f));
+   __m256i rot3_1 = dct_const(stbi__f2f(-0.390180644f), stbi__f2f(-0.390180644f) + stbi__f2f( 1.501321110f));
+
+   __m256i bias_0 = _mm256_set1_epi32(512);
+   __m256i bias_1 = _mm256_set1_epi32(65536 + (128<<17));
+
+   // load
+   row0 = _mm_load_si128((const __m128i *) (data + 0*8));
+   row1 = _mm_load_si128((const __m128i *) (data + 1*8));
+   row2 = _mm_load_si128((const __m128i *) (data + 2*8));
+   row3 = _mm_load_si128((const __m128i *) (data + 3*8));
+   row4 = _mm_load_si128((const __m128i *) (data + 4*8));
+   row5 = _mm_load_si128((const __m128i *) (data + 5*8));
+   row6 = _mm_load_si128((const __m128i *) (data + 6*8));
+   row7 = _mm_load_si128((const __m128i *) (data + 7*8));
+
+   // column pass
+   dct_pass(bias_0, 10);
+
+   {
+      // 16bit 8x8 transpose
+      dct_interleave16(row0, row4);
+      dct_interleave16(row1, row5);
+      dct_interleave16(row2, row6);
+      dct_interleave16(row3, row7);
+
+      dct_interleave16(row0, row2);
+      dct_interleave16(row1, row3);
+      dct_interleave16(row4, row6);
+      dct_interleave16(row5, row7);
+
+      dct_interleave16(row0, row1);
+      dct_interleave16(row2, row3);
+      dct_interleave16(row4, row5);
+      dct_interleave16(row6, row7);
+   }
+
+   // row pass
+   dct_pass(bias_1, 17);
+
+   {
+      // pack, then 8bit 8x8 transpose
+      __m128i p0 = _mm_packus_epi16(row0, row1);
+      __m128i p1 = _mm_packus_epi16(row2, row3);
+      __m128i p2 = _mm_packus_epi16(row4, row5);
+      __m128i p3 = _mm_packus_epi16(row6, row7);
+
+      dct_interleave8(p0, p2);
+      dct_interleave8(p1, p3);
+
+      dct_interleave8(p0, p1);
+      dct_interleave8(p2, p3);
+
+      dct_interleave8(p0, p2);
+      dct_interleave8(p1, p3);
+
+      // store
+      _mm_storel_epi64((__m128i *) out, p0); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p0, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p2); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p2, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p1); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p1, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p3); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p3, 0x4e));
+   }
+
+#undef dct_const
+#undef dct_rot
+#undef dct_widen
+#undef dct_bfly32o
+#undef dct_interleave8
+#undef dct_interleave16
+#undef dct_pass
+}
+#endif // STBI_AVX2
+
 #ifdef STBI_NEON
 
 // NEON integer IDCT. should produce bit-identical
@@ -2946,6 +3280,13 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
+// where the idct of block (bx,by) of component n goes; blocks are 8>>scale_shift pixels square
+stbi_inline static stbi_uc *stbi__jpeg_block_out(stbi__jpeg *z, int n, int bx, int by)
+{
+   int size = 8 >> z->scale_shift;
+   return z->img_comp[n].data + z->img_comp[n].w2*by*size + bx*size;
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
 {
    stbi__jpeg_reset(z);
@@ -2964,7 +3305,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               z->idct_block_kernel(stbi__jpeg_block_out(z, n, i, j), z->img_comp[n].w2, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2988,11 +3329,11 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   // by the basic H and V specified for the component
                   for (y=0; y < z->img_comp[n].v; ++y) {
                      for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
+                        int x2 = (i*z->img_comp[n].h + x);
+                        int y2 = (j*z->img_comp[n].v + y);
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
+                        z->idct_block_kernel(stbi__jpeg_block_out(z, n, x2, y2), z->img_comp[n].w2, data);
                      }
                   }
                }
@@ -3070,30 +3411,253 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
    }
 }
 
-static void stbi__jpeg_dequantize(short *data, stbi__uint16 *dequant)
+// run task(user, i) for i in [0, count) on up to 'threads' threads, the calling one included
+typedef void (*stbi__task_func)(void *user, int index);
+
+static void stbi__parallel_for(int count, int threads, stbi__task_func task, void *user)
 {
    int i;
-   for (i=0; i < 64; ++i)
-      data[i] *= dequant[i];
+#ifdef STBI__THREADS
+   if (threads > 1 && count > 1) {
+      std::atomic<int> next(0);
+      auto worker = [&]() {
+         for (int index = next++; index < count; index = next++)
+            task(user, index);
+      };
+      std::vector<std::thread> pool;
+      if (threads > count) threads = count;
+      for (i=1; i < threads; ++i)
+         pool.emplace_back(worker);
+      worker();
+      for (std::thread &t : pool)
+         t.join();
+      return;
+   }
+#else
+   STBI_NOTUSED(threads);
+#endif
+   for (i=0; i < count; ++i)
+      task(user, i);
 }
 
-static void stbi__jpeg_finish(stbi__jpeg *z)
+// baseline MCUs [first, first+count) in scan order, without restart handling: the parallel
+// decoder resets the entropy decoder itself at every restart interval. with deferred idct
+// the dequantized coefficients are kept for stbi__jpeg_finish.
+static int stbi__jpeg_decode_mcus(stbi__jpeg *z, int first, int count, int deferred)
 {
-   if (z->progressive) {
-      // dequantize and idct the data
-      int i,j,n;
-      for (n=0; n < z->s->img_n; ++n) {
+   int m,k,x,y;
+   STBI_SIMD_ALIGN(short, data[64]);
+   for (m=first; m < first + count; ++m) {
+      if (z->scan_n == 1) {
+         int n = z->order[0];
          int w = (z->img_comp[n].x+7) >> 3;
-         int h = (z->img_comp[n].y+7) >> 3;
-         for (j=0; j < h; ++j) {
-            for (i=0; i < w; ++i) {
-               short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
-               stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+         int i = m % w, j = m / w;
+         int ha = z->img_comp[n].ha;
+         short *block = deferred ? z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w) : data;
+         if (!stbi__jpeg_decode_block(z, block, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
+         if (!deferred)
+            z->idct_block_kernel(stbi__jpeg_block_out(z, n, i, j), z->img_comp[n].w2, data);
+      } else {
+         int i = m % z->img_mcu_x, j = m / z->img_mcu_x;
+         for (k=0; k < z->scan_n; ++k) {
+            int n = z->order[k];
+            for (y=0; y < z->img_comp[n].v; ++y) {
+               for (x=0; x < z->img_comp[n].h; ++x) {
+                  int x2 = i*z->img_comp[n].h + x;
+                  int y2 = j*z->img_comp[n].v + y;
+                  int ha = z->img_comp[n].ha;
+                  short *block = deferred ? z->img_comp[n].coeff + 64 * (x2 + y2 * z->img_comp[n].coeff_w) : data;
+                  if (!stbi__jpeg_decode_block(z, block, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
+                  if (!deferred)
+                     z->idct_block_kernel(stbi__jpeg_block_out(z, n, x2, y2), z->img_comp[n].w2, data);
+               }
             }
          }
       }
    }
+   return 1;
+}
+
+static int stbi__jpeg_scan_mcus(stbi__jpeg *z)
+{
+   if (z->scan_n == 1) {
+      int n = z->order[0];
+      return ((z->img_comp[n].x+7) >> 3) * ((z->img_comp[n].y+7) >> 3);
+   }
+   return z->img_mcu_x * z->img_mcu_y;
+}
+
+// find where each restart interval of the scan at the current position starts; *end is left
+// at the 0xff of the marker that ends the scan. returns the number of intervals, 0 if more
+// than 'max' were found
+static int stbi__jpeg_find_restarts(stbi__jpeg *z, stbi_uc const **starts, int max, stbi_uc const **end)
+{
+   stbi_uc const *p = z->s->img_buffer, *e = z->s->img_buffer_end;
+   int n = 0;
+   starts[n++] = p;
+   while (p < e) {
+      if (*p++ != 0xff) continue;
+      while (p < e && *p == 0xff) ++p; // fill bytes
+      if (p >= e) break;
+      if (*p == 0x00) { ++p; continue; } // stuffed zero
+      if (STBI__RESTART(*p)) {
+         if (n == max) return 0;
+         starts[n++] = ++p;
+         continue;
+      }
+      *end = p - 1;
+      return n;
+   }
+   *end = e;
+   return n;
+}
+
+typedef struct
+{
+   stbi__jpeg *z;
+   stbi_uc const **starts;
+   int intervals, per_task, mcus;
+   int *ok;
+} stbi__jpeg_scan_job;
+
+static void stbi__jpeg_scan_task(void *user, int task)
+{
+   stbi__jpeg_scan_job *job = (stbi__jpeg_scan_job *) user;
+   int first = task * job->per_task;
+   int last = first + job->per_task < job->intervals ? first + job->per_task : job->intervals;
+   int r, ok = 1;
+   stbi__context s = *job->z->s;
+   stbi__jpeg *z = (stbi__jpeg *) stbi__malloc(sizeof(stbi__jpeg));
+   if (!z) { job->ok[task] = 0; return; }
+   // huffman and quantization tables are only read; the bit reader and dc predictors are per task
+   memcpy(z, job->z, sizeof(stbi__jpeg));
+   z->s = &s;
+   for (r=first; r < last && ok; ++r) {
+      int mcu = r * z->restart_interval;
+      int count = job->mcus - mcu < z->restart_interval ? job->mcus - mcu : z->restart_interval;
+      s.img_buffer = (stbi_uc *) job->starts[r];
+      stbi__jpeg_reset(z);
+      ok = stbi__jpeg_decode_mcus(z, mcu, count, 0);
+   }
+   job->ok[task] = ok;
+   STBI_FREE(z);
+}
+
+// decode a baseline scan with restart markers in parallel; -1 if it can't be split
+static int stbi__jpeg_parse_restarts_parallel(stbi__jpeg *z)
+{
+   stbi__jpeg_scan_job job;
+   stbi_uc const *end = NULL;
+   int tasks, t, result = 1;
+   job.z = z;
+   job.mcus = stbi__jpeg_scan_mcus(z);
+   job.intervals = (job.mcus + z->restart_interval - 1) / z->restart_interval;
+   if (job.intervals < 2) return -1;
+   job.starts = (stbi_uc const **) stbi__malloc_mad2(job.intervals + 1, sizeof(stbi_uc const *), 0);
+   if (!job.starts) return -1;
+   t = stbi__jpeg_find_restarts(z, job.starts, job.intervals + 1, &end);
+   // a restart marker right before the end of the scan is tolerated, like the serial decoder does
+   if (t != job.intervals && !(t == job.intervals + 1 && job.starts[job.intervals] == end)) {
+      STBI_FREE(job.starts);
+      return -1;
+   }
+
+   // a few tasks per thread balance intervals of uneven entropy density
+   tasks = z->threads * 4 < job.intervals ? z->threads * 4 : job.intervals;
+   job.per_task = (job.intervals + tasks - 1) / tasks;
+   tasks = (job.intervals + job.per_task - 1) / job.per_task;
+   job.ok = (int *) stbi__malloc_mad2(tasks, sizeof(int), 0);
+   if (!job.ok) { STBI_FREE(job.starts); return -1; }
+   stbi__parallel_for(tasks, z->threads, stbi__jpeg_scan_task, &job);
+   for (t=0; t < tasks; ++t)
+      if (!job.ok[t]) result = stbi__err("bad restart interval", "Corrupt JPEG");
+   STBI_FREE(job.ok);
+   STBI_FREE(job.starts);
+
+   // continue after the scan as if the serial decoder had consumed it
+   z->s->img_buffer = (stbi_uc *) end;
+   stbi__jpeg_reset(z);
+   return result;
+}
+
+static int stbi__jpeg_alloc_coeff(stbi__jpeg *z)
+{
+   int i;
+   for (i=0; i < z->s->img_n; ++i) {
+      if (z->img_comp[i].raw_coeff) continue;
+      z->img_comp[i].coeff_w = z->img_mcu_x * z->img_comp[i].h;
+      z->img_comp[i].coeff_h = z->img_mcu_y * z->img_comp[i].v;
+      z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].coeff_w * 8, z->img_comp[i].coeff_h * 8, sizeof(short), 15);
+      if (z->img_comp[i].raw_coeff == NULL) return 0;
+      z->img_comp[i].coeff = (short*) (((size_t) z->img_comp[i].raw_coeff + 15) & ~15);
+   }
+   return 1;
+}
+
+static int stbi__jpeg_parse_scan(stbi__jpeg *z)
+{
+   if (z->threads > 1 && !z->progressive && !z->s->read_from_callbacks) {
+      if (z->restart_interval) {
+         int r = stbi__jpeg_parse_restarts_parallel(z);
+         if (r >= 0) return r;
+      } else if (stbi__jpeg_alloc_coeff(z)) {
+         // entropy decoding is inherently serial here; the idct is deferred to stbi__jpeg_finish
+         z->deferred_idct = 1;
+         stbi__jpeg_reset(z);
+         return stbi__jpeg_decode_mcus(z, 0, stbi__jpeg_scan_mcus(z), 1);
+      }
+   }
+   return stbi__parse_entropy_coded_data(z);
+}
+
+static void stbi__jpeg_dequantize(short *data, stbi__uint16 *dequant)
+{
+   int i;
+   for (i=0; i < 64; ++i)
+      data[i] *= dequant[i];
+}
+
+#define STBI__IDCT_BAND_ROWS 4 // block rows per parallel idct task
+
+static void stbi__jpeg_idct_rows(stbi__jpeg *z, int n, int first, int last)
+{
+   int i,j;
+   int w = (z->img_comp[n].x+7) >> 3;
+   for (j=first; j < last; ++j) {
+      for (i=0; i < w; ++i) {
+         short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
+         if (z->progressive)
+            stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
+         z->idct_block_kernel(stbi__jpeg_block_out(z, n, i, j), z->img_comp[n].w2, data);
+      }
+   }
+}
+
+static void stbi__jpeg_idct_task(void *user, int task)
+{
+   stbi__jpeg *z = (stbi__jpeg *) user;
+   int n;
+   for (n=0; n < z->s->img_n; ++n) {
+      int h = (z->img_comp[n].y+7) >> 3;
+      int bands = (h + STBI__IDCT_BAND_ROWS - 1) / STBI__IDCT_BAND_ROWS;
+      if (task < bands) {
+         int first = task * STBI__IDCT_BAND_ROWS;
+         stbi__jpeg_idct_rows(z, n, first, first + STBI__IDCT_BAND_ROWS < h ? first + STBI__IDCT_BAND_ROWS : h);
+         return;
+      }
+      task -= bands;
+   }
+}
+
+static void stbi__jpeg_finish(stbi__jpeg *z)
+{
+   if (z->progressive || z->deferred_idct) {
+      // dequantize (progressive only, baseline blocks come out dequantized) and idct the data
+      int n, tasks = 0;
+      for (n=0; n < z->s->img_n; ++n)
+         tasks += (((z->img_comp[n].y+7) >> 3) + STBI__IDCT_BAND_ROWS - 1) / STBI__IDCT_BAND_ROWS;
+      stbi__parallel_for(tasks, z->threads, stbi__jpeg_idct_task, z);
+   }
 }
 
 static int stbi__process_marker(stbi__jpeg *z, int m)
@@ -3329,8 +3893,9 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       //
       // img_mcu_x, img_mcu_y: <=17 bits; comp[i].h and .v are <=4 (checked earlier)
       // so these muls can't overflow with 32-bit ints (which we require)
-      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * 8;
-      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * 8;
+      // with scale_shift only the reduced blocks are stored; coefficients stay full size
+      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * (8 >> z->scale_shift);
+      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * (8 >> z->scale_shift);
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
@@ -3340,10 +3905,10 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       // align blocks for idct using mmx/sse
       z->img_comp[i].data = (stbi_uc*) (((size_t) z->img_comp[i].raw_data + 15) & ~15);
       if (z->progressive) {
-         // w2, h2 are multiples of 8 (see above)
-         z->img_comp[i].coeff_w = z->img_comp[i].w2 / 8;
-         z->img_comp[i].coeff_h = z->img_comp[i].h2 / 8;
-         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].w2, z->img_comp[i].h2, sizeof(short), 15);
+         // one 8x8 coefficient block per block of the interleaved MCU grid (see above)
+         z->img_comp[i].coeff_w = z->img_mcu_x * z->img_comp[i].h;
+         z->img_comp[i].coeff_h = z->img_mcu_y * z->img_comp[i].v;
+         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].coeff_w * 8, z->img_comp[i].coeff_h * 8, sizeof(short), 15);
          if (z->img_comp[i].raw_coeff == NULL)
             return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
          z->img_comp[i].coeff = (short*) (((size_t) z->img_comp[i].raw_coeff + 15) & ~15);
@@ -3422,7 +3987,7 @@ static int stbi__decode_jpeg_image(stbi__jpeg *j)
    while (!stbi__EOI(m)) {
       if (stbi__SOS(m)) {
          if (!stbi__process_scan_header(j)) return 0;
-         if (!stbi__parse_entropy_coded_data(j)) return 0;
+         if (!stbi__jpeg_parse_scan(j)) return 0;
          if (j->marker == STBI__MARKER_none ) {
          j->marker = stbi__skip_jpeg_junk_at_end(j);
             // if we reach eof without hitting a marker, stbi__get_marker() below will fail and we'll eventually return 0
@@ -3441,7 +4006,7 @@ static int stbi__decode_jpeg_image(stbi__jpeg *j)
          m = stbi__get_marker(j);
       }
    }
-   if (j->progressive)
+   if (j->progressive || j->deferred_idct)
       stbi__jpeg_finish(j);
    return 1;
 }
@@ -3643,6 +4208,65 @@ static stbi_uc *stbi__resample_row_hv_2_simd(stbi_uc *out, stbi_uc *in_near, stb
 }
 #endif
 
+#ifdef STBI_AVX2
+// 16 pixels per iteration; the filter is exact integer math, so any split
+// between this loop and the scalar tail gives the same result
+STBI__AVX2_TARGET
+static stbi_uc *stbi__resample_row_hv_2_avx2(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
+{
+   int i=0,t0,t1;
+
+   if (w == 1) {
+      out[0] = out[1] = stbi__div4(3*in_near[0] + in_far[0] + 2);
+      return out;
+   }
+
+   t1 = 3*in_near[0] + in_far[0];
+   for (; i < ((w-1) & ~15); i += 16) {
+      // vertical pass, 3*x + y = 4*x + (y - x)
+      __m256i farw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_far + i)));
+      __m256i nearw = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_near + i)));
+      __m256i curr  = _mm256_add_epi16(_mm256_slli_epi16(nearw, 2), _mm256_sub_epi16(farw, nearw));
+
+      // alignr shifts within 128-bit lanes, so the element crossing the lane
+      // boundary comes from a lane swap; t1 and the first pixel of the next
+      // group fill the ends
+      __m256i prv0 = _mm256_insert_epi16(_mm256_permute2x128_si256(curr, curr, 0x08), t1, 7);
+      __m256i nxt0 = _mm256_insert_epi16(_mm256_permute2x128_si256(curr, curr, 0x81), 3*in_near[i+16] + in_far[i+16], 8);
+      __m256i prev = _mm256_alignr_epi8(curr, prv0, 14);
+      __m256i next = _mm256_alignr_epi8(nxt0, curr, 2);
+
+      // horizontal pass, polyphase as in the sse2 version
+      __m256i curb = _mm256_add_epi16(_mm256_slli_epi16(curr, 2), _mm256_set1_epi16(8));
+      __m256i even = _mm256_add_epi16(_mm256_sub_epi16(prev, curr), curb);
+      __m256i odd  = _mm256_add_epi16(_mm256_sub_epi16(next, curr), curb);
+
+      // interleave (per lane, which keeps pixel order after the per-lane pack)
+      __m256i de0  = _mm256_srli_epi16(_mm256_unpacklo_epi16(even, odd), 4);
+      __m256i de1  = _mm256_srli_epi16(_mm256_unpackhi_epi16(even, odd), 4);
+      _mm256_storeu_si256((__m256i *) (out + i*2), _mm256_packus_epi16(de0, de1));
+
+      t1 = 3*in_near[i+15] + in_far[i+15];
+   }
+
+   t0 = t1;
+   t1 = 3*in_near[i] + in_far[i];
+   out[i*2] = stbi__div16(3*t1 + t0 + 8);
+
+   for (++i; i < w; ++i) {
+      t0 = t1;
+      t1 = 3*in_near[i]+in_far[i];
+      out[i*2-1] = stbi__div16(3*t0 + t1 + 8);
+      out[i*2  ] = stbi__div16(3*t1 + t0 + 8);
+   }
+   out[w*2-1] = stbi__div4(t1+2);
+
+   STBI_NOTUSED(hs);
+
+   return out;
+}
+#endif
+
 static stbi_uc *stbi__resample_row_generic(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
 {
    // resample with nearest-neighbor
@@ -3817,6 +4441,82 @@ static void stbi__YCbCr_to_RGB_simd(stbi_uc *out, stbi_uc const *y, stbi_uc cons
 }
 #endif
 
+#ifdef STBI_AVX2
+// the sse2 math on 16 pixels at a time, the rest goes to the sse2 kernel. that
+// math matches the scalar conversion exactly, which is what lets this one take
+// step == 3 too (pshufb makes dropping the alpha bytes cheap)
+STBI__AVX2_TARGET
+static void stbi__YCbCr_to_RGB_avx2(stbi_uc *out, stbi_uc const *y, stbi_uc const *pcb, stbi_uc const *pcr, int count, int step)
+{
+   int i = 0;
+
+   if (step == 4 || step == 3) {
+      __m128i signflip  = _mm_set1_epi8(-0x80);
+      __m256i cr_const0 = _mm256_set1_epi16(   (short) ( 1.40200f*4096.0f+0.5f));
+      __m256i cr_const1 = _mm256_set1_epi16( - (short) ( 0.71414f*4096.0f+0.5f));
+      __m256i cb_const0 = _mm256_set1_epi16( - (short) ( 0.34414f*4096.0f+0.5f));
+      __m256i cb_const1 = _mm256_set1_epi16(   (short) ( 1.77200f*4096.0f+0.5f));
+      __m256i y_bias = _mm256_set1_epi16(128);
+      __m256i xw = _mm256_set1_epi16(255); // alpha channel
+      __m256i rgb_shuffle = _mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1, 0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+      __m256i rgb_gather = _mm256_setr_epi32(0,1,2,4,5,6,3,7);
+
+      for (; i+15 < count; i += 16) {
+         // load and widen: y<<8 | 128, (c-128)<<8
+         __m128i y_bytes  = _mm_loadu_si128((__m128i *) (y+i));
+         __m128i cr_bytes = _mm_loadu_si128((__m128i *) (pcr+i));
+         __m128i cb_bytes = _mm_loadu_si128((__m128i *) (pcb+i));
+         __m256i yw  = _mm256_or_si256(_mm256_slli_epi16(_mm256_cvtepu8_epi16(y_bytes), 8), y_bias);
+         __m256i crw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_xor_si128(cr_bytes, signflip)), 8);
+         __m256i cbw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_xor_si128(cb_bytes, signflip)), 8);
+
+         // color transform
+         __m256i yws = _mm256_srli_epi16(yw, 4);
+         __m256i cr0 = _mm256_mulhi_epi16(cr_const0, crw);
+         __m256i cb0 = _mm256_mulhi_epi16(cb_const0, cbw);
+         __m256i cb1 = _mm256_mulhi_epi16(cbw, cb_const1);
+         __m256i cr1 = _mm256_mulhi_epi16(crw, cr_const1);
+         __m256i rws = _mm256_add_epi16(cr0, yws);
+         __m256i gwt = _mm256_add_epi16(cb0, yws);
+         __m256i bws = _mm256_add_epi16(yws, cb1);
+         __m256i gws = _mm256_add_epi16(gwt, cr1);
+
+         // descale
+         __m256i rw = _mm256_srai_epi16(rws, 4);
+         __m256i bw = _mm256_srai_epi16(bws, 4);
+         __m256i gw = _mm256_srai_epi16(gws, 4);
+
+         // back to byte and interleave; everything works per lane, so the low
+         // lanes hold pixels 0..7 and the high lanes 8..15
+         __m256i brb = _mm256_packus_epi16(rw, bw);
+         __m256i gxb = _mm256_packus_epi16(gw, xw);
+         __m256i t0 = _mm256_unpacklo_epi8(brb, gxb);
+         __m256i t1 = _mm256_unpackhi_epi8(brb, gxb);
+         __m256i o0 = _mm256_unpacklo_epi16(t0, t1);
+         __m256i o1 = _mm256_unpackhi_epi16(t0, t1);
+
+         // store
+         if (step == 4) {
+            _mm256_storeu_si256((__m256i *) (out + 0), _mm256_permute2x128_si256(o0, o1, 0x20));
+            _mm256_storeu_si256((__m256i *) (out + 32), _mm256_permute2x128_si256(o0, o1, 0x31));
+         } else {
+            // squeeze 12 bytes out of each lane, then the two lanes into 24
+            // contiguous bytes; stores stop exactly at the last pixel
+            __m256i p0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_permute2x128_si256(o0, o1, 0x20), rgb_shuffle), rgb_gather);
+            __m256i p1 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_permute2x128_si256(o0, o1, 0x31), rgb_shuffle), rgb_gather);
+            _mm_storeu_si128((__m128i *) (out + 0), _mm256_castsi256_si128(p0));
+            _mm_storel_epi64((__m128i *) (out + 16), _mm256_extracti128_si256(p0, 1));
+            _mm_storeu_si128((__m128i *) (out + 24), _mm256_castsi256_si128(p1));
+            _mm_storel_epi64((__m128i *) (out + 40), _mm256_extracti128_si256(p1, 1));
+         }
+         out += 16*step;
+      }
+   }
+
+   stbi__YCbCr_to_RGB_simd(out, y+i, pcb+i, pcr+i, count-i, step);
+}
+#endif
+
 // set up the kernels
 static void stbi__setup_jpeg(stbi__jpeg *j)
 {
@@ -3824,18 +4524,22 @@ static void stbi__setup_jpeg(stbi__jpeg *j)
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
 
-#ifdef STBI_SSE2
-   if (stbi__sse2_available()) {
-      j->idct_block_kernel = stbi__idct_simd;
-      j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
-      j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
-   }
+#if defined(STBI_SSE2) || defined(STBI_NEON)
+   {
+      int level = stbi_simd_level();
+      if (level >= STBI_SIMD_SSE2) {
+         j->idct_block_kernel = stbi__idct_simd;
+         j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
+         j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
+      }
+#ifdef STBI_AVX2
+      if (level >= STBI_SIMD_AVX2) {
+         j->idct_block_kernel = stbi__idct_avx2;
+         j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_avx2;
+         j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_avx2;
+      }
 #endif
-
-#ifdef STBI_NEON
-   j->idct_block_kernel = stbi__idct_simd;
-   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
-   j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
+   }
 #endif
 }
 
@@ -3862,6 +4566,166 @@ static stbi_uc stbi__blinn_8x8(stbi_uc x, stbi_uc y)
    return (stbi_uc) ((t + (t >>8)) >> 8);
 }
 
+// resample and color-convert output rows [first, last); res_comp holds the resampler state
+// at row 'first' and is advanced. the 3-channel paths store one byte past each pixel, i.e.
+// into the next row; if 'spill' is given, the last row goes there (n*img_x+1 bytes) instead
+static void stbi__jpeg_emit_rows(stbi__jpeg *z, stbi__resample *res_comp, stbi_uc **linebuf, stbi_uc *output,
+                                 stbi_uc *spill, int n, int decode_n, int is_rgb, unsigned int first, unsigned int last)
+{
+   int k;
+   unsigned int i,j;
+   stbi_uc *coutput[4] = { NULL, NULL, NULL, NULL };
+   for (j=first; j < last; ++j) {
+      stbi_uc *out = spill && j == last-1 ? spill : output + n * z->s->img_x * j;
+      for (k=0; k < decode_n; ++k) {
+         stbi__resample *r = &res_comp[k];
+         int y_bot = r->ystep >= (r->vs >> 1);
+         coutput[k] = r->resample(linebuf[k],
+                                  y_bot ? r->line1 : r->line0,
+                                  y_bot ? r->line0 : r->line1,
+                                  r->w_lores, r->hs);
+         if (++r->ystep >= r->vs) {
+            r->ystep = 0;
+            r->line0 = r->line1;
+            if (++r->ypos < z->img_comp[k].y)
+               r->line1 += z->img_comp[k].w2;
+         }
+      }
+      if (n >= 3) {
+         stbi_uc *y = coutput[0];
+         if (z->s->img_n == 3) {
+            if (is_rgb) {
+               for (i=0; i < z->s->img_x; ++i) {
+                  out[0] = y[i];
+                  out[1] = coutput[1][i];
+                  out[2] = coutput[2][i];
+                  out[3] = 255;
+                  out += n;
+               }
+            } else {
+               z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+            }
+         } else if (z->s->img_n == 4) {
+            if (z->app14_color_transform == 0) { // CMYK
+               for (i=0; i < z->s->img_x; ++i) {
+                  stbi_uc m = coutput[3][i];
+                  out[0] = stbi__blinn_8x8(coutput[0][i], m);
+                  out[1] = stbi__blinn_8x8(coutput[1][i], m);
+                  out[2] = stbi__blinn_8x8(coutput[2][i], m);
+                  out[3] = 255;
+                  out += n;
+               }
+            } else if (z->app14_color_transform == 2) { // YCCK
+               z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+               for (i=0; i < z->s->img_x; ++i) {
+                  stbi_uc m = coutput[3][i];
+                  out[0] = stbi__blinn_8x8(255 - out[0], m);
+                  out[1] = stbi__blinn_8x8(255 - out[1], m);
+                  out[2] = stbi__blinn_8x8(255 - out[2], m);
+                  out += n;
+               }
+            } else { // YCbCr + alpha?  Ignore the fourth channel for now
+               z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+            }
+         } else
+            for (i=0; i < z->s->img_x; ++i) {
+               out[0] = out[1] = out[2] = y[i];
+               out[3] = 255; // not used if n==3
+               out += n;
+            }
+      } else {
+         if (is_rgb) {
+            if (n == 1)
+               for (i=0; i < z->s->img_x; ++i)
+                  *out++ = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
+            else {
+               for (i=0; i < z->s->img_x; ++i, out += 2) {
+                  out[0] = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
+                  out[1] = 255;
+               }
+            }
+         } else if (z->s->img_n == 4 && z->app14_color_transform == 0) {
+            for (i=0; i < z->s->img_x; ++i) {
+               stbi_uc m = coutput[3][i];
+               stbi_uc r = stbi__blinn_8x8(coutput[0][i], m);
+               stbi_uc g = stbi__blinn_8x8(coutput[1][i], m);
+               stbi_uc b = stbi__blinn_8x8(coutput[2][i], m);
+               out[0] = stbi__compute_y(r, g, b);
+               out[1] = 255;
+               out += n;
+            }
+         } else if (z->s->img_n == 4 && z->app14_color_transform == 2) {
+            for (i=0; i < z->s->img_x; ++i) {
+               out[0] = stbi__blinn_8x8(255 - coutput[0][i], coutput[3][i]);
+               out[1] = 255;
+               out += n;
+            }
+         } else {
+            stbi_uc *y = coutput[0];
+            if (n == 1)
+               for (i=0; i < z->s->img_x; ++i) out[i] = y[i];
+            else
+               for (i=0; i < z->s->img_x; ++i) { *out++ = y[i]; *out++ = 255; }
+         }
+      }
+   }
+}
+
+// resampler state after 'rows' more output rows, without producing them
+static void stbi__resample_skip(stbi__resample *r, int rows, int comp_y, int w2)
+{
+   for (; rows > 0; --rows) {
+      if (++r->ystep >= r->vs) {
+         r->ystep = 0;
+         r->line0 = r->line1;
+         if (++r->ypos < comp_y)
+            r->line1 += w2;
+      }
+   }
+}
+
+typedef struct
+{
+   stbi__jpeg *z;
+   stbi__resample *res_comp; // state at row 0
+   stbi_uc *output;
+   int n, decode_n, is_rgb, rows;
+   int *ok;
+} stbi__jpeg_rows_job;
+
+static void stbi__jpeg_rows_task(void *user, int task)
+{
+   stbi__jpeg_rows_job *job = (stbi__jpeg_rows_job *) user;
+   stbi__jpeg *z = job->z;
+   stbi__resample res_comp[4];
+   stbi_uc *linebuf[4] = { NULL, NULL, NULL, NULL };
+   stbi_uc *spill = NULL;
+   unsigned int first = task * job->rows;
+   unsigned int last = first + job->rows < z->s->img_y ? first + job->rows : z->s->img_y;
+   size_t row_bytes = (size_t) job->n * z->s->img_x;
+   int k, ok = 1;
+   // the band below owns the first byte of our last row's successor; write that row aside
+   if (last < z->s->img_y) {
+      spill = (stbi_uc *) stbi__malloc(row_bytes + 1);
+      if (!spill) ok = 0;
+   }
+   for (k=0; k < job->decode_n; ++k) {
+      res_comp[k] = job->res_comp[k];
+      stbi__resample_skip(&res_comp[k], first, z->img_comp[k].y, z->img_comp[k].w2);
+      linebuf[k] = (stbi_uc *) stbi__malloc(z->s->img_x + 3);
+      if (!linebuf[k]) ok = 0;
+   }
+   if (ok) {
+      stbi__jpeg_emit_rows(z, res_comp, linebuf, job->output, spill, job->n, job->decode_n, job->is_rgb, first, last);
+      if (spill)
+         memcpy(job->output + row_bytes * (last-1), spill, row_bytes);
+   }
+   for (k=0; k < job->decode_n; ++k)
+      if (linebuf[k]) STBI_FREE(linebuf[k]);
+   if (spill) STBI_FREE(spill);
+   job->ok[task] = ok;
+}
+
 static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp, int req_comp)
 {
    int n, decode_n, is_rgb;
@@ -3873,6 +4737,18 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
    // load a jpeg image from whichever source, but leave in YCbCr format
    if (!stbi__decode_jpeg_image(z)) { stbi__cleanup_jpeg(z); return NULL; }
 
+   // reduced-size decode: the component planes already hold the scaled blocks, so
+   // upsampling and color conversion just run on the smaller image
+   if (z->scale_shift) {
+      int k, round = (1 << z->scale_shift) - 1;
+      z->s->img_x = (z->s->img_x + round) >> z->scale_shift;
+      z->s->img_y = (z->s->img_y + round) >> z->scale_shift;
+      for (k=0; k < z->s->img_n; ++k) {
+         z->img_comp[k].x = (z->img_comp[k].x + round) >> z->scale_shift;
+         z->img_comp[k].y = (z->img_comp[k].y + round) >> z->scale_shift;
+      }
+   }
+
    // determine actual number of components to generate
    n = req_comp ? req_comp : z->s->img_n >= 3 ? 3 : 1;
 
@@ -3889,10 +4765,8 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
 
    // resample and color-convert
    {
-      int k;
-      unsigned int i,j;
+      int k, mcu_h = z->img_mcu_h >> z->scale_shift;
       stbi_uc *output;
-      stbi_uc *coutput[4] = { NULL, NULL, NULL, NULL };
 
       stbi__resample res_comp[4];
 
@@ -3923,99 +4797,31 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
       if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
 
       // now go ahead and resample
-      for (j=0; j < z->s->img_y; ++j) {
-         stbi_uc *out = output + n * z->s->img_x * j;
-         for (k=0; k < decode_n; ++k) {
-            stbi__resample *r = &res_comp[k];
-            int y_bot = r->ystep >= (r->vs >> 1);
-            coutput[k] = r->resample(z->img_comp[k].linebuf,
-                                     y_bot ? r->line1 : r->line0,
-                                     y_bot ? r->line0 : r->line1,
-                                     r->w_lores, r->hs);
-            if (++r->ystep >= r->vs) {
-               r->ystep = 0;
-               r->line0 = r->line1;
-               if (++r->ypos < z->img_comp[k].y)
-                  r->line1 += z->img_comp[k].w2;
-            }
-         }
-         if (n >= 3) {
-            stbi_uc *y = coutput[0];
-            if (z->s->img_n == 3) {
-               if (is_rgb) {
-                  for (i=0; i < z->s->img_x; ++i) {
-                     out[0] = y[i];
-                     out[1] = coutput[1][i];
-                     out[2] = coutput[2][i];
-                     out[3] = 255;
-                     out += n;
-                  }
-               } else {
-                  z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-               }
-            } else if (z->s->img_n == 4) {
-               if (z->app14_color_transform == 0) { // CMYK
-                  for (i=0; i < z->s->img_x; ++i) {
-                     stbi_uc m = coutput[3][i];
-                     out[0] = stbi__blinn_8x8(coutput[0][i], m);
-                     out[1] = stbi__blinn_8x8(coutput[1][i], m);
-                     out[2] = stbi__blinn_8x8(coutput[2][i], m);
-                     out[3] = 255;
-                     out += n;
-                  }
-               } else if (z->app14_color_transform == 2) { // YCCK
-                  z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-                  for (i=0; i < z->s->img_x; ++i) {
-                     stbi_uc m = coutput[3][i];
-                     out[0] = stbi__blinn_8x8(255 - out[0], m);
-                     out[1] = stbi__blinn_8x8(255 - out[1], m);
-                     out[2] = stbi__blinn_8x8(255 - out[2], m);
-                     out += n;
-                  }
-               } else { // YCbCr + alpha?  Ignore the fourth channel for now
-                  z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-               }
-            } else
-               for (i=0; i < z->s->img_x; ++i) {
-                  out[0] = out[1] = out[2] = y[i];
-                  out[3] = 255; // not used if n==3
-                  out += n;
-               }
-         } else {
-            if (is_rgb) {
-               if (n == 1)
-                  for (i=0; i < z->s->img_x; ++i)
-                     *out++ = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
-               else {
-                  for (i=0; i < z->s->img_x; ++i, out += 2) {
-                     out[0] = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
-                     out[1] = 255;
-                  }
-               }
-            } else if (z->s->img_n == 4 && z->app14_color_transform == 0) {
-               for (i=0; i < z->s->img_x; ++i) {
-                  stbi_uc m = coutput[3][i];
-                  stbi_uc r = stbi__blinn_8x8(coutput[0][i], m);
-                  stbi_uc g = stbi__blinn_8x8(coutput[1][i], m);
-                  stbi_uc b = stbi__blinn_8x8(coutput[2][i], m);
-                  out[0] = stbi__compute_y(r, g, b);
-                  out[1] = 255;
-                  out += n;
-               }
-            } else if (z->s->img_n == 4 && z->app14_color_transform == 2) {
-               for (i=0; i < z->s->img_x; ++i) {
-                  out[0] = stbi__blinn_8x8(255 - coutput[0][i], coutput[3][i]);
-                  out[1] = 255;
-                  out += n;
-               }
-            } else {
-               stbi_uc *y = coutput[0];
-               if (n == 1)
-                  for (i=0; i < z->s->img_x; ++i) out[i] = y[i];
-               else
-                  for (i=0; i < z->s->img_x; ++i) { *out++ = y[i]; *out++ = 255; }
-            }
-         }
+      if (z->threads > 1 && z->s->img_y > (unsigned int) mcu_h) {
+         // bands of whole MCU rows, a few per thread
+         stbi__jpeg_rows_job job;
+         int tasks, t, ok = 1;
+         job.z = z;
+         job.res_comp = res_comp;
+         job.output = output;
+         job.n = n;
+         job.decode_n = decode_n;
+         job.is_rgb = is_rgb;
+         job.rows = (z->s->img_y + z->threads * 4 - 1) / (z->threads * 4);
+         job.rows = (job.rows + mcu_h - 1) / mcu_h * mcu_h;
+         tasks = (z->s->img_y + job.rows - 1) / job.rows;
+         job.ok = (int *) stbi__malloc_mad2(tasks, sizeof(int), 0);
+         if (!job.ok) { STBI_FREE(output); stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
+         stbi__parallel_for(tasks, z->threads, stbi__jpeg_rows_task, &job);
+         for (t=0; t < tasks; ++t)
+            ok &= job.ok[t];
+         STBI_FREE(job.ok);
+         if (!ok) { STBI_FREE(output); stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
+      } else {
+         stbi_uc *linebuf[4] = { NULL, NULL, NULL, NULL };
+         for (k=0; k < decode_n; ++k)
+            linebuf[k] = z->img_comp[k].linebuf;
+         stbi__jpeg_emit_rows(z, res_comp, linebuf, output, NULL, n, decode_n, is_rgb, 0, z->s->img_y);
       }
       stbi__cleanup_jpeg(z);
       *out_x = z->s->img_x;
@@ -4078,6 +4884,78 @@ static int stbi__jpeg_info(stbi__context *s, int *x, int *y, int *comp)
 }
 #endif
 
+#ifndef STBI_NO_JPEG
+static stbi_uc *stbi__jpeg_load_ext(stbi__context *s, int *x, int *y, int *comp, int req_comp, int threads, int scale_shift)
+{
+   stbi_uc *result;
+   int channels;
+   stbi__jpeg* j = (stbi__jpeg*) stbi__malloc(sizeof(stbi__jpeg));
+   if (!j) return stbi__errpuc("outofmem", "Out of memory");
+   memset(j, 0, sizeof(stbi__jpeg));
+   j->s = s;
+   j->threads = threads;
+   j->scale_shift = scale_shift;
+   stbi__setup_jpeg(j);
+   if      (scale_shift == 1) j->idct_block_kernel = stbi__idct_block_4x4;
+   else if (scale_shift == 2) j->idct_block_kernel = stbi__idct_block_2x2;
+   else if (scale_shift == 3) j->idct_block_kernel = stbi__idct_block_1x1;
+   result = load_jpeg_image(j, x,y,&channels,req_comp);
+   STBI_FREE(j);
+   if (comp) *comp = channels;
+   if (result && stbi__vertically_flip_on_load)
+      stbi__vertical_flip(result, *x, *y, req_comp ? req_comp : channels);
+   return result;
+}
+#endif
+
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int scale_denom, int threads)
+{
+#ifndef STBI_NO_JPEG
+   stbi__context s;
+   int scale_shift = scale_denom >= 8 ? 3 : scale_denom >= 4 ? 2 : scale_denom >= 2 ? 1 : 0;
+   stbi__start_mem(&s,buffer,len);
+   if ((scale_shift || threads > 1) && stbi__jpeg_test(&s))
+      return stbi__jpeg_load_ext(&s, x,y,comp,req_comp, threads, scale_shift);
+#endif
+   return stbi_load_from_memory(buffer,len,x,y,comp,req_comp);
+}
+
+STBIDEF stbi_uc *stbi_load_from_memory_parallel(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int threads)
+{
+   return stbi_load_from_memory_scaled(buffer,len,x,y,comp,req_comp,1,threads);
+}
+
+#ifndef STBI_NO_STDIO
+STBIDEF stbi_uc *stbi_load_scaled(char const *filename, int *x, int *y, int *comp, int req_comp, int scale_denom, int threads)
+{
+   FILE *f = stbi__fopen(filename, "rb");
+   stbi_uc *buffer, *result;
+   long len;
+   if (!f) return stbi__errpuc("can't fopen", "Unable to open file");
+   // the parallel decoder needs the whole file to find restart intervals up front
+   if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) <= 0 || len > INT_MAX || fseek(f, 0, SEEK_SET) != 0) {
+      fclose(f);
+      return stbi__errpuc("can't fread", "Unable to read file");
+   }
+   buffer = (stbi_uc *) stbi__malloc((size_t) len);
+   if (!buffer) { fclose(f); return stbi__errpuc("outofmem", "Out of memory"); }
+   if (fread(buffer, 1, (size_t) len, f) != (size_t) len) {
+      STBI_FREE(buffer);
+      fclose(f);
+      return stbi__errpuc("can't fread", "Unable to read file");
+   }
+   fclose(f);
+   result = stbi_load_from_memory_scaled(buffer, (int) len, x, y, comp, req_comp, scale_denom, threads);
+   STBI_FREE(buffer);
+   return result;
+}
+
+STBIDEF stbi_uc *stbi_load_parallel(char const *filename, int *x, int *y, int *comp, int req_comp, int threads)
+{
+   return stbi_load_scaled(filename,x,y,comp,req_comp,1,threads);
+}
+#endif
+
 // public domain zlib decode    v0.2  Sean Barrett 2006-11-18
 //    simple implementation
 //      - all input must be provided in an upfront buffer
@@ -4667,6 +5545,103 @@ static int stbi__paeth(int a, int b, int c)
    return t1;
 }
 
+#ifdef STBI_SSE2
+// sub/avg/paeth depend on the pixel to the left, so they go one pixel at a time.
+// that only pays off for 8-byte pixels (16-bit RGBA): for narrower ones the scalar
+// loops below already overlap the independent per-byte chains as well as a
+// single vector chain does.
+static void stbi__png_unfilter_px8(int filter, stbi_uc *cur, stbi_uc const *prior, stbi_uc const *raw, int nk)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i one = _mm_set1_epi8(1);
+   __m128i three = _mm_set1_epi16(3);
+   // the left pixel of the first pixel (and its upper-left) is 0, which turns
+   // each filter into its first-pixel form without a separate case
+   __m128i a = zero, b, c = zero, x;
+   int k;
+
+   switch (filter) {
+      case STBI__F_sub:
+         for (k = 0; k < nk; k += 8) {
+            a = _mm_add_epi8(_mm_loadl_epi64((__m128i const *) (raw + k)), a);
+            _mm_storel_epi64((__m128i *) (cur + k), a);
+         }
+         break;
+      case STBI__F_avg:
+         // (a+b)>>1 = pavgb(a,b) - ((a^b)&1), pavgb rounds up
+         for (k = 0; k < nk; k += 8) {
+            b = _mm_loadl_epi64((__m128i const *) (prior + k));
+            x = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+            a = _mm_add_epi8(_mm_loadl_epi64((__m128i const *) (raw + k)), x);
+            _mm_storel_epi64((__m128i *) (cur + k), a);
+         }
+         break;
+      case STBI__F_paeth:
+         // stbi__paeth on 16-bit lanes
+         for (k = 0; k < nk; k += 8) {
+            __m128i aw, bw, cw, thresh, lo, hi, t0, t1;
+            b = _mm_loadl_epi64((__m128i const *) (prior + k));
+            aw = _mm_unpacklo_epi8(a, zero);
+            bw = _mm_unpacklo_epi8(b, zero);
+            cw = _mm_unpacklo_epi8(c, zero);
+            thresh = _mm_sub_epi16(_mm_mullo_epi16(cw, three), _mm_add_epi16(aw, bw));
+            lo = _mm_min_epi16(aw, bw);
+            hi = _mm_max_epi16(aw, bw);
+            x = _mm_cmpgt_epi16(hi, thresh); // !(hi <= thresh)
+            t0 = _mm_or_si128(_mm_andnot_si128(x, lo), _mm_and_si128(x, cw));
+            x = _mm_cmpgt_epi16(thresh, lo); // !(thresh <= lo)
+            t1 = _mm_or_si128(_mm_andnot_si128(x, hi), _mm_and_si128(x, t0));
+            a = _mm_add_epi8(_mm_loadl_epi64((__m128i const *) (raw + k)), _mm_packus_epi16(t1, t1));
+            _mm_storel_epi64((__m128i *) (cur + k), a);
+            c = b;
+         }
+         break;
+   }
+}
+
+#ifdef STBI_AVX2
+STBI__AVX2_TARGET
+static int stbi__png_unfilter_up_avx2(stbi_uc *cur, stbi_uc const *prior, stbi_uc const *raw, int nk)
+{
+   int k = 0;
+   for (; k+32 <= nk; k += 32) {
+      __m256i r = _mm256_loadu_si256((__m256i const *) (raw + k));
+      __m256i b = _mm256_loadu_si256((__m256i const *) (prior + k));
+      _mm256_storeu_si256((__m256i *) (cur + k), _mm256_add_epi8(r, b));
+   }
+   return k;
+}
+#endif
+
+// returns 0 if the row is left to the scalar code
+static int stbi__png_unfilter_simd(int level, int filter, stbi_uc *cur, stbi_uc const *prior, stbi_uc const *raw, int nk, int filter_bytes)
+{
+   int k = 0;
+
+   if (filter == STBI__F_up) {
+#ifdef STBI_AVX2
+      if (level >= STBI_SIMD_AVX2) k = stbi__png_unfilter_up_avx2(cur, prior, raw, nk);
+#else
+      STBI_NOTUSED(level);
+#endif
+      for (; k+16 <= nk; k += 16) {
+         __m128i r = _mm_loadu_si128((__m128i const *) (raw + k));
+         __m128i b = _mm_loadu_si128((__m128i const *) (prior + k));
+         _mm_storeu_si128((__m128i *) (cur + k), _mm_add_epi8(r, b));
+      }
+      for (; k < nk; ++k)
+         cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+      return 1;
+   }
+
+   if (filter_bytes == 8 && (filter == STBI__F_sub || filter == STBI__F_avg || filter == STBI__F_paeth)) {
+      stbi__png_unfilter_px8(filter, cur, prior, raw, nk);
+      return 1;
+   }
+   return 0;
+}
+#endif
+
 static const stbi_uc stbi__depth_scale_table[9] = { 0, 0xff, 0x55, 0, 0x11, 0,0,0, 0x01 };
 
 // adds an extra all-255 alpha channel
@@ -4707,6 +5682,10 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
    int output_bytes = out_n*bytes;
    int filter_bytes = img_n*bytes;
    int width = x;
+   int handled = 0;
+#ifdef STBI_SSE2
+   int simd_level = stbi_simd_level();
+#endif
 
    STBI_ASSERT(out_n == s->img_n || out_n == s->img_n+1);
    a->out = (stbi_uc *) stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
@@ -4752,6 +5731,11 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
       if (j == 0) filter = first_row_filter[filter];
 
       // perform actual filtering
+#ifdef STBI_SSE2
+      if (simd_level >= STBI_SIMD_SSE2)
+         handled = stbi__png_unfilter_simd(simd_level, filter, cur, prior, raw, nk, filter_bytes);
+#endif
+      if (!handled)
       switch (filter) {
       case STBI__F_none:
          memcpy(cur, raw, nk);
@@ -0,0 +1,124 @@
+// Бенчмарк параллельного декодирования JPEG: stbi_load_from_memory против
+// stbi_load_from_memory_parallel на 1..N потоках. Энтропийное декодирование
+// параллелится только при маркерах перезапуска (DRI), остальное — всегда.
+// Затем — уменьшенное декодирование (stbi_load_from_memory_scaled) в 1/2, 1/4 и 1/8.
+//   jpegbench [image.jpg] [iterations] [max_threads]
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+static const char* const DEFAULT_IMAGE = "D:/vr/zad3/wood-2045380_1280.jpg";
+static const int DEFAULT_ITERATIONS = 10;
+
+// Интервал перезапуска в MCU из маркера DRI; 0 — маркеров перезапуска нет
+static int restart_interval(const std::vector<unsigned char>& data) {
+    size_t i = 2;
+    while (i + 4 <= data.size() && data[i] == 0xff) {
+        unsigned char marker = data[i + 1];
+        size_t length = (size_t)data[i + 2] << 8 | data[i + 3];
+        if (marker == 0xdd && i + 6 <= data.size())
+            return data[i + 4] << 8 | data[i + 5];
+        if (marker == 0xda)
+            break;
+        i += 2 + length;
+    }
+    return 0;
+}
+
+static bool progressive(const std::vector<unsigned char>& data) {
+    for (size_t i = 0; i + 1 < data.size(); i++) {
+        if (data[i] == 0xff && data[i + 1] == 0xc2)
+            return true;
+        if (data[i] == 0xff && data[i + 1] == 0xda)
+            break;
+    }
+    return false;
+}
+
+// Миллисекунды на декодирование (лучшее из iterations); threads == 0 — обычный stbi_load_from_memory
+static double run(const std::vector<unsigned char>& data, int threads, int scale, int iterations, std::vector<unsigned char>* pixels,
+                  int* width = NULL, int* height = NULL) {
+    double best = 1e30;
+    for (int i = 0; i <= iterations; i++) {
+        int decoded_width, decoded_height, channels;
+        auto start = std::chrono::steady_clock::now();
+        unsigned char* decoded = threads == 0
+            ? stbi_load_from_memory(data.data(), (int)data.size(), &decoded_width, &decoded_height, &channels, 0)
+            : stbi_load_from_memory_scaled(data.data(), (int)data.size(), &decoded_width, &decoded_height, &channels, 0, scale, threads);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!decoded)
+            return -1.0;
+        if (i > 0) // первый прогон — прогрев
+            best = std::min(best, ms);
+        pixels->assign(decoded, decoded + (size_t)decoded_width * decoded_height * channels);
+        stbi_image_free(decoded);
+        if (width)
+            *width = decoded_width;
+        if (height)
+            *height = decoded_height;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : DEFAULT_IMAGE;
+    int iterations = argc > 2 ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+        iterations = DEFAULT_ITERATIONS;
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    int width, height, channels;
+    if (data.empty() || !stbi_info_from_memory(data.data(), (int)data.size(), &width, &height, &channels)) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+    int interval = restart_interval(data);
+    unsigned cores = argc > 3 && atoi(argv[3]) > 0 ? (unsigned)atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    printf("%s: %dx%d, %d channels, %s, %s\n", path, width, height, channels,
+           progressive(data) ? "progressive" : "baseline",
+           interval ? "restart markers present" : "no restart markers (entropy decoding stays serial)");
+    if (interval)
+        printf("restart interval: %d MCUs\n", interval);
+
+    std::vector<unsigned char> reference, pixels;
+    double serial = run(data, 0, 1, iterations, &reference);
+    if (serial < 0) {
+        fprintf(stderr, "Failed to decode %s (%s)\n", path, stbi_failure_reason());
+        return 1;
+    }
+    const double megapixels = (double)width * height / 1.0e6;
+    printf("stbi_load_from_memory %8.2f ms %8.1f MP/s\n", serial, megapixels / serial * 1000.0);
+
+    for (unsigned threads = 1; threads <= cores; threads = threads < cores && threads * 2 > cores ? cores : threads * 2) {
+        double ms = run(data, (int)threads, 1, iterations, &pixels);
+        if (ms < 0) {
+            printf("parallel x%-2u           failed (%s)\n", threads, stbi_failure_reason());
+            continue;
+        }
+        printf("parallel x%-2u          %8.2f ms %8.1f MP/s (x%.2f) | %s\n", threads, ms, megapixels / ms * 1000.0,
+               serial / ms, pixels == reference ? "bit-exact" : "MISMATCH");
+        if (threads == cores)
+            break;
+    }
+
+    // IDCT сразу в 4x4, 2x2 или 1x1: остаётся в основном энтропийное декодирование
+    for (int scale = 2; scale <= 8; scale *= 2) {
+        int scaled_width, scaled_height;
+        double ms = run(data, 1, scale, iterations, &pixels, &scaled_width, &scaled_height);
+        if (ms < 0) {
+            printf("scaled 1/%d             failed (%s)\n", scale, stbi_failure_reason());
+            continue;
+        }
+        printf("scaled 1/%d (%4dx%-4d) %8.2f ms            (x%.2f)\n", scale, scaled_width, scaled_height, ms, serial / ms);
+    }
+    return 0;
+}
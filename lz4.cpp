@@ -0,0 +1,143 @@
+#include "lz4.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+static const int LZ4_HASH_BITS = 16;
+static const size_t LZ4_MIN_MATCH = 4;
+static const size_t LZ4_LAST_LITERALS = 5; // последние байты блока — всегда литералы
+static const size_t LZ4_MATCH_LIMIT = 12;  // совпадение не может начинаться ближе к концу
+static const size_t LZ4_MAX_OFFSET = 65535;
+
+static uint32_t read_u32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash_u32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Длина сверх 15 в токене — байты по 255 и остаток
+static bool write_length(unsigned char*& out, const unsigned char* end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (out >= end)
+            return false;
+        *out++ = 255;
+    }
+    if (out >= end)
+        return false;
+    *out++ = (unsigned char)length;
+    return true;
+}
+
+static bool write_sequence(unsigned char*& out, const unsigned char* end, const unsigned char* literals, size_t literal_count,
+                           size_t offset, size_t match_length) {
+    if (out >= end)
+        return false;
+    unsigned char* token = out++;
+    size_t match_code = match_length ? match_length - LZ4_MIN_MATCH : 0;
+    *token = (unsigned char)(((literal_count < 15 ? literal_count : 15) << 4) | (match_code < 15 ? match_code : 15));
+    if (literal_count >= 15 && !write_length(out, end, literal_count - 15))
+        return false;
+    if ((size_t)(end - out) < literal_count)
+        return false;
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+    if (!match_length)
+        return true;
+    if (end - out < 2)
+        return false;
+    *out++ = (unsigned char)offset;
+    *out++ = (unsigned char)(offset >> 8);
+    return match_code < 15 || write_length(out, end, match_code - 15);
+}
+
+size_t lz4_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lz4_compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+    // Позиция + 1; ноль — пустая ячейка
+    std::vector<uint32_t> table((size_t)1 << LZ4_HASH_BITS, 0);
+    unsigned char* out = dst;
+    const unsigned char* end = dst + capacity;
+    size_t anchor = 0, pos = 0;
+
+    if (size > LZ4_MATCH_LIMIT) {
+        const size_t match_start_limit = size - LZ4_MATCH_LIMIT;
+        const size_t match_end_limit = size - LZ4_LAST_LITERALS;
+        while (pos < match_start_limit) {
+            uint32_t sequence = read_u32(src + pos);
+            uint32_t& slot = table[hash_u32(sequence)];
+            size_t candidate = slot;
+            slot = (uint32_t)(pos + 1);
+            if (candidate == 0 || pos - (candidate - 1) > LZ4_MAX_OFFSET || read_u32(src + candidate - 1) != sequence) {
+                pos++;
+                continue;
+            }
+            size_t match = candidate - 1, length = LZ4_MIN_MATCH;
+            while (pos + length < match_end_limit && src[match + length] == src[pos + length])
+                length++;
+            if (!write_sequence(out, end, src + anchor, pos - anchor, pos - match, length))
+                return 0;
+            pos += length;
+            anchor = pos;
+        }
+    }
+    if (!write_sequence(out, end, src + anchor, size - anchor, 0, 0))
+        return 0;
+    return (size_t)(out - dst);
+}
+
+static bool read_length(const unsigned char*& in, const unsigned char* end, size_t* length) {
+    unsigned char byte;
+    do {
+        if (in >= end)
+            return false;
+        byte = *in++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz4_decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t raw_size) {
+    const unsigned char* in = src;
+    const unsigned char* in_end = src + size;
+    size_t written = 0;
+    while (in < in_end) {
+        unsigned char token = *in++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !read_length(in, in_end, &literal_count))
+            return false;
+        if ((size_t)(in_end - in) < literal_count || raw_size - written < literal_count)
+            return false;
+        memcpy(dst + written, in, literal_count);
+        in += literal_count;
+        written += literal_count;
+        if (in == in_end)
+            break; // последняя последовательность — только литералы
+
+        if (in_end - in < 2)
+            return false;
+        size_t offset = in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_length(in, in_end, &match_length))
+            return false;
+        match_length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > written || raw_size - written < match_length)
+            return false;
+        // Совпадение может перекрывать само себя — копируем побайтово
+        const unsigned char* from = dst + written - offset;
+        if (offset >= match_length) {
+            memcpy(dst + written, from, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++)
+                dst[written + i] = from[i];
+        }
+        written += match_length;
+    }
+    return written == raw_size;
+}
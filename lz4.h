@@ -0,0 +1,16 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stddef.h>
+
+// Сжатие в блочном формате LZ4 (без кадра): жадный поиск совпадений по хеш-таблице.
+// Распаковка — несколько ГБ/с, поэтому сжатые записи пакета ресурсов почти не
+// замедляют загрузку. Распаковщик проверяет все границы и не доверяет входу.
+
+size_t lz4_compress_bound(size_t size);
+// Возвращает размер сжатых данных; 0 — не влезло в capacity
+size_t lz4_compress(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity);
+// raw_size — точный размер распакованных данных; false — вход повреждён
+bool lz4_decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t raw_size);
+
+#endif
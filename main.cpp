@@ -1,29 +1,51 @@
 #include "include/glad.h"
 #define GLFW_INCLUDE_NONE
-#include "include/linmath.h"
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <iostream>
 #include <fstream>
-#include <glm.hpp>
-#include <gtc/matrix_transform.hpp>
-#include <gtc/type_ptr.hpp>
+#include <chrono>
+#include "texture_cache.h"
+#include "shader_registry.h"
+#include "frame_uniforms.h"
+#include "scene.h"
+#include "mesh.h"
+#include "headless.h"
+#include "frame_profiler.h"
+#include "render_queue.h"
+#include "asset_pack.h"
+#include "file_watch.h"
+#include "transform.h"
+#include "frustum_cull.h"
+#include "bvh.h"
+#include "occlusion_cull.h"
 
 static const float CAMERA_SPEED = 0.1f;
 static const float MOUSE_SENSITIVITY = 0.1f;
 static const float FOV_MIN = 10.0f;
 static const float FOV_MAX = 120.0f;
+static const uint64_t TEXTURE_BUDGET_BYTES = 256ull * 1024 * 1024;
+static const uint64_t TEXTURE_UPLOAD_BUDGET_BYTES = 8ull * 1024 * 1024; // за кадр
+static const float FAR_PLANE = 100.0f;
+
+// Имена участков профиля для материалов сцены, в порядке SCENE_MATERIAL_COUNT
+static const char* const MATERIAL_SCOPE_NAMES[SCENE_MATERIAL_COUNT] = {
+    "draw phong", "draw diffuse", "draw specular", "draw lambert", "draw no_lighting"
+};
+// Материалы, чьи шейдеры читают массив текстур; остальным привязка не нужна
+static const bool MATERIAL_SAMPLES_TEXTURE[SCENE_MATERIAL_COUNT] = { false, false, false, true, true };
 
 typedef struct {
-    vec3 position;
-    vec3 front;
-    vec3 up;
-    vec3 right;
-    vec3 world_up;
+    glm::vec3 position;
+    glm::vec3 front;
+    glm::vec3 up;
+    glm::vec3 right;
+    glm::vec3 world_up;
     float yaw;
     float pitch;
     float fov;
@@ -32,21 +54,10 @@ typedef struct {
 Camera camera;
 
 void init_camera() {
-    camera.position[0] = 0.0f;
-    camera.position[1] = 0.0f;
-    camera.position[2] = 3.0f;
-
-    camera.front[0] = 0.0f;
-    camera.front[1] = 0.0f;
-    camera.front[2] = -1.0f;
-
-    camera.up[0] = 0.0f;
-    camera.up[1] = 1.0f;
-    camera.up[2] = 0.0f;
-
-    camera.world_up[0] = 0.0f;
-    camera.world_up[1] = 1.0f;
-    camera.world_up[2] = 0.0f;
+    camera.position = glm::vec3(0.0f, 0.0f, 3.0f);
+    camera.front = glm::vec3(0.0f, 0.0f, -1.0f);
+    camera.up = glm::vec3(0.0f, 1.0f, 0.0f);
+    camera.world_up = glm::vec3(0.0f, 1.0f, 0.0f);
 
     camera.yaw = -90.0f;
     camera.pitch = 0.0f;
@@ -56,64 +67,15 @@ void init_camera() {
     printf("Camera initialized.\n");
 }
 
-void check_shader_compile(GLuint shader) {
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER_COMPILATION_ERROR of type: " << infoLog << std::endl;
-    }
-}
-
-void check_program_link(GLuint program) {
-    GLint success;
-    GLchar infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << infoLog << std::endl;
-    }
-}
 void update_camera_vectors() {
-    vec3 front;
-    front[0] = cosf(camera.yaw * M_PI / 180.0f) * cosf(camera.pitch * M_PI / 180.0f);
-    front[1] = sinf(camera.pitch * M_PI / 180.0f);
-    front[2] = sinf(camera.yaw * M_PI / 180.0f) * cosf(camera.pitch * M_PI / 180.0f);
-    vec3_norm(camera.front, front);
-
-    vec3_mul_cross(camera.right, camera.front, camera.world_up);
-    vec3_norm(camera.right, camera.right);
-    vec3_mul_cross(camera.up, camera.right, camera.front);
-    vec3_norm(camera.up, camera.up);
+    float yaw = glm::radians(camera.yaw), pitch = glm::radians(camera.pitch);
+    camera.front = glm::normalize(glm::vec3(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch)));
+    camera.right = glm::normalize(glm::cross(camera.front, camera.world_up));
+    camera.up = glm::normalize(glm::cross(camera.right, camera.front));
 }
 
-void calculate_view_matrix(mat4x4 view_matrix) {
-    vec3 center;
-    vec3_add(center, camera.position, camera.front);
-
-    vec3 f, s, u;
-    vec3_sub(f, center, camera.position);
-    vec3_norm(f, f);
-
-    vec3_mul_cross(s, f, camera.world_up);
-    vec3_norm(s, s);
-
-    vec3_mul_cross(u, s, f);
-
-    mat4x4_identity(view_matrix);
-    view_matrix[0][0] = s[0];
-    view_matrix[0][1] = s[1];
-    view_matrix[0][2] = s[2];
-    view_matrix[1][0] = u[0];
-    view_matrix[1][1] = u[1];
-    view_matrix[1][2] = u[2];
-    view_matrix[2][0] = -f[0];
-    view_matrix[2][1] = -f[1];
-    view_matrix[2][2] = -f[2];
-    view_matrix[3][0] = -vec3_mul_inner(s, camera.position);
-    view_matrix[3][1] = -vec3_mul_inner(u, camera.position);
-    view_matrix[3][2] = vec3_mul_inner(f, camera.position);
+glm::aligned_mat4 calculate_view_matrix() {
+    return glm::aligned_mat4(glm::lookAt(camera.position, camera.position + camera.front, camera.world_up));
 }
 
 
@@ -137,74 +99,6 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
     update_camera_vectors();
 }
 
-GLuint load_shader(const char* vertex_path, const char* fragment_path) {
-
-    std::ifstream vertex_file(vertex_path);
-    std::ifstream fragment_file(fragment_path);
-
-    if (!vertex_file.is_open() || !fragment_file.is_open()) {
-        std::cerr << "Error opening shader files\n";
-        return 0;
-    }
-
-    std::string vertex_source((std::istreambuf_iterator<char>(vertex_file)), std::istreambuf_iterator<char>());
-    std::string fragment_source((std::istreambuf_iterator<char>(fragment_file)), std::istreambuf_iterator<char>());
-
-    GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    const char* vertex_source_cstr = vertex_source.c_str();
-    glShaderSource(vertex_shader, 1, &vertex_source_cstr, NULL);
-    glCompileShader(vertex_shader);
-    check_shader_compile(vertex_shader);
-
-    GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fragment_source_cstr = fragment_source.c_str();
-    glShaderSource(fragment_shader, 1, &fragment_source_cstr, NULL);
-    glCompileShader(fragment_shader);
-    check_shader_compile(fragment_shader);
-
-    GLuint shader_program = glCreateProgram();
-    glAttachShader(shader_program, vertex_shader);
-    glAttachShader(shader_program, fragment_shader);
-    glLinkProgram(shader_program);
-    check_program_link(shader_program);
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-
-    return shader_program;
-}
-
-GLuint load_texture(const char* path) {
-    // Загружаем изображение
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        return 0;
-    }
-
-
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    if (nrChannels == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    else if (nrChannels == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
-
-    return texture;
-}
-
-
 GLuint create_shader_program() {
     const char* vertex_shader_source = R"(
         #version 330 core
@@ -270,8 +164,7 @@ GLuint create_shader_program() {
 
     return shader_program;
 }
-void process_input(GLFWwindow* window, vec3* lightPos, bool* isLightMode) {
-    vec3 movement;
+void process_input(GLFWwindow* window, glm::vec3* lightPos, bool* isLightMode) {
 
     // Переключение между режимами с помощью клавиши L
     if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
@@ -302,20 +195,16 @@ void process_input(GLFWwindow* window, vec3* lightPos, bool* isLightMode) {
     } else {
         // Режим управления камерой
         if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-            vec3_scale(movement, camera.front, CAMERA_SPEED);
-            vec3_add(camera.position, camera.position, movement);
+            camera.position += camera.front * CAMERA_SPEED;
         }
         if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-            vec3_scale(movement, camera.front, CAMERA_SPEED);
-            vec3_sub(camera.position, camera.position, movement);
+            camera.position -= camera.front * CAMERA_SPEED;
         }
         if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-            vec3_scale(movement, camera.right, CAMERA_SPEED);
-            vec3_sub(camera.position, camera.position, movement);
+            camera.position -= camera.right * CAMERA_SPEED;
         }
         if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-            vec3_scale(movement, camera.right, CAMERA_SPEED);
-            vec3_add(camera.position, camera.position, movement);
+            camera.position += camera.right * CAMERA_SPEED;
         }
         if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS && camera.fov < FOV_MAX)
             camera.fov += 1.0f;
@@ -324,16 +213,31 @@ void process_input(GLFWwindow* window, vec3* lightPos, bool* isLightMode) {
     }
 }
 
-int main() {
+// Сэмплер всегда читает нулевой блок — ставим один раз (и после перезагрузки программы), а не на каждый draw
+void set_material_samplers(ShaderProgram* const* material_shaders) {
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++) {
+        glUseProgram(material_shaders[m]->program);
+        uniform_set_int(&material_shaders[m]->uniforms, uniform_hash("uTexture"), 0);
+    }
+    glUseProgram(0);
+}
 
+int main(int argc, char** argv) {
 
+    // --headless: невидимое окно (или OSMesa без дисплея), рендер в FBO по сценарию камеры
+    HeadlessOptions headless;
+    headless_parse_options(&headless, argc, argv);
+    const int window_width = headless.enabled ? headless.width : 800;
+    const int window_height = headless.enabled ? headless.height : 600;
 
+    headless_init_hints(&headless);
     if (!glfwInit()) {
         fprintf(stderr, "Failed to initialize GLFW\n");
         return -1;
     }
 
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Virtual Camera with Light", NULL, NULL);
+    headless_window_hints(&headless);
+    GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Virtual Camera with Light", NULL, NULL);
     if (!window) {
         fprintf(stderr, "Failed to create GLFW window\n");
         glfwTerminate();
@@ -351,11 +255,43 @@ int main() {
     update_camera_vectors();
 
 
-    GLuint phong_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/phong.frag");
-    GLuint diffuse_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/diffuse.frag");
-    GLuint specular_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/specular.frag");
-    GLuint lambert_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/lambert.frag");
-    GLuint no_lighting_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/no_lighting.frag");
+    // --pack FILE: шейдеры, готовые текстуры и меши берутся из пакета, остальное — с диска
+    AssetPack asset_pack = {};
+    if (const char* pack_path = asset_pack_parse_path(argc, argv)) {
+        auto pack_start = std::chrono::high_resolution_clock::now();
+        if (asset_pack_open(&asset_pack, pack_path, "D:/vr/zad3/")) {
+            double open_us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - pack_start).count();
+            printf("Asset pack %s: %u entries, %.1f us to open\n", pack_path, asset_pack.header->entry_count, open_us);
+        } else {
+            fprintf(stderr, "Failed to open asset pack %s\n", pack_path);
+        }
+    }
+
+    ShaderRegistry shader_registry;
+    shader_registry_init(&shader_registry, "D:/vr/zad3/shader_cache");
+    shader_registry.pack = &asset_pack;
+    shader_registry_bind_block(&shader_registry, FRAME_UNIFORMS_BLOCK, FRAME_UNIFORMS_BINDING);
+
+    FrameUniformBuffer frame_ubo;
+    frame_uniforms_init(&frame_ubo);
+
+    // Все загрузки текстур и буферов идут через кольцо загрузки (--staging-mb N, 0 — напрямую)
+    StagingRing staging_ring;
+    StagingRing* staging = staging_ring_init(&staging_ring, staging_ring_parse_capacity(argc, argv)) ? &staging_ring : NULL;
+    gl_texture_set_staging(staging);
+
+    ShaderProgram* phong_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/phong.frag");
+    ShaderProgram* diffuse_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/diffuse.frag");
+    ShaderProgram* specular_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/specular.frag");
+    ShaderProgram* lambert_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/lambert.frag");
+    ShaderProgram* no_lighting_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/no_lighting.frag");
+    ShaderProgram* light_shader = shader_registry_load(&shader_registry, "D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/light_shader.frag");
+
+    // Программа материала i, в порядке SCENE_MATERIAL_COUNT
+    ShaderProgram* material_shaders[SCENE_MATERIAL_COUNT] = {
+        phong_shader, diffuse_shader, specular_shader, lambert_shader, no_lighting_shader
+    };
+    set_material_samplers(material_shaders);
 
 
 
@@ -404,28 +340,50 @@ int main() {
             -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
      };
 
-    unsigned int lightVAO, lightVBO;
+    // Сварка одинаковых вершин: 36 вершин -> 24 уникальных + 36 индексов
+    MeshFormat mesh_format = mesh_parse_format(argc, argv);
+    Mesh cube_mesh;
+    std::vector<unsigned char> mesh_scratch;
+    const unsigned char* mesh_blob;
+    size_t mesh_blob_size;
+    const AssetPackEntry* mesh_entry = asset_pack_find(&asset_pack, "D:/vr/zad3/meshes/cube.mesh");
+    if (!mesh_entry || !asset_pack_read(&asset_pack, mesh_entry, &mesh_blob, &mesh_blob_size, &mesh_scratch)
+        || !mesh_read_blob(&cube_mesh, mesh_blob, mesh_blob_size))
+        mesh_build_indexed(&cube_mesh, vertices, sizeof(vertices) / (MESH_FLOATS_PER_VERTEX * sizeof(float)));
+    if (const char* mesh_path = mesh_parse_export_path(argc, argv)) {
+        std::vector<unsigned char> blob;
+        mesh_write_blob(&cube_mesh, &blob);
+        std::ofstream mesh_file(mesh_path, std::ios::binary);
+        mesh_file.write((const char*)blob.data(), (std::streamsize)blob.size());
+        printf("Cube mesh written to %s (%zu bytes)\n", mesh_path, blob.size());
+    }
+    MeshStats mesh_info = mesh_stats(&cube_mesh, mesh_format, sizeof(vertices) / (MESH_FLOATS_PER_VERTEX * sizeof(float)));
+    printf("Cube mesh: %d -> %d vertices, %d bytes/vertex, %d bytes (was %d), ACMR %.2f, post-transform cache hit rate %.0f%%\n",
+           mesh_info.source_vertices, mesh_info.unique_vertices, mesh_info.bytes_per_vertex,
+           mesh_info.vertex_bytes + mesh_info.index_bytes, mesh_info.source_bytes,
+           mesh_info.acmr, mesh_info.cache_hit_rate * 100.0f);
+
+    GLuint VBO, EBO;
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    mesh_upload(&cube_mesh, mesh_format, VBO, EBO, staging);
+    const GLsizei cube_index_count = (GLsizei)cube_mesh.indices.size();
+
+    unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
-    glGenBuffers(1, &lightVBO);
 
     // Привязываем VAO (Vertex Array Object)
     glBindVertexArray(lightVAO);
 
-    // Привязываем VBO (Vertex Buffer Object) для вершин
-    glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Устанавливаем аттрибуты для координат вершин (позиции)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Устанавливаем аттрибуты позиций, нормалей и текстурных координат
+    mesh_setup_attributes(mesh_format, VBO, EBO);
 
-    // Устанавливаем аттрибуты для нормалей
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Устанавливаем аттрибуты для текстурных координат
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Куб света рисуется тем же вершинным шейдером — ему тоже нужен экземпляр
+    GLuint lightInstanceVBO;
+    glGenBuffers(1, &lightInstanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, lightInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CubeInstance), NULL, GL_DYNAMIC_DRAW);
+    scene_setup_instance_attributes(lightInstanceVBO, 0);
 
     // Отвязываем VAO
     glBindVertexArray(0);
@@ -433,159 +391,451 @@ int main() {
 
 
 
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
+    if (!headless.enabled)
+        glfwSetCursorPosCallback(window, cursor_position_callback);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    HeadlessTarget headless_target = {};
+    HeadlessStats headless_stats;
+    headless_stats.dumped = 0;
+    if (headless.enabled && !headless_target_create(&headless_target, headless.width, headless.height)) {
+        fprintf(stderr, "Failed to create headless render target\n");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return -1;
+    }
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    TextureCache texture_cache;
+    texture_cache_init(&texture_cache, TEXTURE_BUDGET_BYTES);
+    texture_cache.mip_options.filter = mip_parse_filter(argc, argv);
+    texture_cache.pack = &asset_pack;
+    texture_cache.preview_scale = texture_cache_parse_preview_scale(argc, argv);
+    ImageDecoder* image_decoder = image_decoder_create(0);
+    // --compress: всё, что не подготовлено texcook, сжимается при загрузке в общем пуле
+    texture_cache.compression = block_runtime_parse(argc, argv);
+    BlockEncoder* block_encoder = texture_cache.compression.enabled ? block_encoder_create(0) : NULL;
+    texture_cache.block_encoder = block_encoder;
+    image_decoder->block_encoder = block_encoder;
+
+    // Сцена: число кубов задаётся через --cubes N, экземпляры лежат в одном буфере
+    Scene scene;
+    scene_build_grid(&scene, scene_parse_cube_count(argc, argv));
+    printf("Scene: %d cubes\n", (int)scene.instances.size());
+    // Пакетные преобразования экземпляров (--transform-kernel scalar|sse2|avx2)
+    TransformKernel transform_kernel = transform_parse_kernel(argc, argv);
+    Mat4SoA scene_mvp;
+    double transform_ms = 0.0;
+    // Отсечение по пирамиде видимости тем же ядром (--no-cull — рисовать всё, --cull-threads N)
+    FrustumCullOptions cull_options = frustum_cull_parse(argc, argv);
+    FrustumCuller* frustum_culler = cull_options.enabled ? frustum_cull_create(cull_options.threads) : NULL;
+    std::vector<uint32_t> visible_instances, uploaded_visible;
+    std::vector<CubeInstance> packed_instances;
+    int visible_count[SCENE_MATERIAL_COUNT] = {};
+    uint64_t visible_uploads = 0;
+    // --bvh — иерархическое отсечение: дерево над неподвижными кубами строится один раз
+    bool use_bvh = frustum_culler && bvh_parse_enabled(argc, argv);
+    Bvh scene_bvh;
+    bvh_init(&scene_bvh);
+    if (use_bvh) {
+        bvh_build(&scene_bvh, &scene.bounds, cull_options.threads);
+        printf("BVH: %d nodes, depth %d, built in %.2f ms, SAH cost %.1f\n", (int)scene_bvh.nodes.size(), scene_bvh.depth,
+               scene_bvh.stats.build_ms, bvh_sah_cost(&scene_bvh));
+    }
+    // --occlusion — после пирамиды отбросить кубы, перекрытые ближними (программный буфер глубины).
+    // Окклюдер — сам меш куба: он совпадает с объектом, так что перекрытие не завышается
+    OcclusionCullOptions occlusion_options = occlusion_cull_parse(argc, argv);
+    OcclusionCuller* occlusion_culler =
+        frustum_culler && occlusion_options.enabled
+            ? occlusion_cull_create(occlusion_options.width, occlusion_options.height, cull_options.threads)
+            : NULL;
+    const OccluderMesh cube_occluder = { cube_mesh.vertices.data(), MESH_FLOATS_PER_VERTEX,
+                                         (int)(cube_mesh.vertices.size() / MESH_FLOATS_PER_VERTEX), cube_mesh.indices.data(),
+                                         (int)cube_mesh.indices.size() };
+    std::vector<uint32_t> occluder_instances;
+
+    // Текстуры сцены (--textures A B ...) раскладываются по слоям и атласам одного массива:
+    // кубы с разными текстурами остаются в одном инстансном вызове на материал
+    std::vector<const char*> texture_paths;
+    scene_parse_texture_paths(argc, argv, &texture_paths);
+    TextureArray texture_array;
+    texture_array_init(&texture_array, texture_array_parse_size(argc, argv));
+    std::vector<TextureHandle> scene_textures;
+    std::vector<TextureSlot> texture_slots;
+    for (const char* path : texture_paths) {
+        // Слои копируются через FBO, поэтому источник нужен несжатым: мимо texcook, пакета и --compress
+        TextureHandle handle = texture_cache_acquire_async(&texture_cache, image_decoder, path, true);
+        // Размер — из заголовка; если он не прочитался, текстура берёт слой целиком
+        int width, height, channels;
+        if (!stbi_info(path, &width, &height, &channels))
+            width = height = texture_array.size;
+        TextureSlot slot;
+        if (!handle || !texture_array_place(&texture_array, handle, width, height, &slot)) {
+            texture_cache_release(&texture_cache, handle);
+            continue;
+        }
+        scene_textures.push_back(handle);
+        texture_slots.push_back(slot);
+    }
+    scene_assign_textures(&scene, texture_slots.data(), (int)texture_slots.size());
+    printf("Texture array: %d textures in %d layers of %d^2 (%llu whole, %llu in atlases)\n", (int)texture_slots.size(),
+           (int)texture_array.layers.size(), texture_array.size, (unsigned long long)texture_array.stats.whole_layers,
+           (unsigned long long)texture_array.stats.atlas_slots);
+
+    // Правки шейдеров и текстур сцены подхватываются без перезапуска (--no-hot-reload — выключить).
+    // В headless-прогонах слежка не нужна: они меряют стабильный кадр
+    FileWatcher* file_watcher = !headless.enabled && file_watch_parse_enabled(argc, argv) ? file_watch_create() : NULL;
+    if (file_watcher) {
+        for (const auto& pair : shader_registry.programs) {
+            file_watch_add(file_watcher, pair.second.vertex_path.c_str());
+            file_watch_add(file_watcher, pair.second.fragment_path.c_str());
+        }
+        for (const char* path : texture_paths)
+            file_watch_add(file_watcher, path);
+        file_watch_start(file_watcher);
+    }
+    std::vector<std::string> changed_files;
+
+    GLuint instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    const size_t instance_bytes = scene.instances.size() * sizeof(CubeInstance);
+    if (frustum_culler) {
+        // С отсечением буфер заполняется в кадре видимыми экземплярами (scene_pack_visible)
+        glBufferData(GL_ARRAY_BUFFER, instance_bytes, NULL, GL_STREAM_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, instance_bytes, staging ? NULL : scene.instances.data(), GL_STATIC_DRAW);
+        if (staging && !staging_ring_upload_buffer(staging, instanceVBO, 0, scene.instances.data(), instance_bytes))
+            glBufferSubData(GL_ARRAY_BUFFER, 0, instance_bytes, scene.instances.data());
+    }
 
-    glfwSetCursorPosCallback(window, cursor_position_callback);
+    // По VAO на материал: смещение инстанс-атрибутов указывает на его диапазон экземпляров
+    GLuint material_vaos[SCENE_MATERIAL_COUNT];
+    glGenVertexArrays(SCENE_MATERIAL_COUNT, material_vaos);
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++) {
+        glBindVertexArray(material_vaos[m]);
 
-    vec3 cube_positions[] = {
-    {-4.0f, 0.0f, -5.0f},
-    {-2.0f, 0.0f, -5.0f},
-    { 0.0f, 0.0f, -5.0f},
-    { 2.0f, 0.0f, -5.0f},
-    { 4.0f, 0.0f, -5.0f}
-    };
+        mesh_setup_attributes(mesh_format, VBO, EBO);
+        scene_setup_instance_attributes(instanceVBO, scene.material_first[m]);
+    }
+    glBindVertexArray(0);
 
-    // Массив цветов для кубов
-    vec4 cube_colors[] = {
-        {1.0f, 0.0f, 0.0f, 1.0f}, // Красный
-        {0.0f, 1.0f, 0.0f, 1.0f}, // Зеленый
-        {0.0f, 0.0f, 1.0f, 1.0f}, // Синий
-        {1.0f, 1.0f, 0.0f, 1.0f}, // Желтый
-        {1.0f, 0.0f, 1.0f, 1.0f}  // Розовый
-    };
+    uint64_t frame_count = 0, draw_call_count = 0;
+
+    // Профиль кадра: --profile FILE пишет его при выходе, клавиша P — по требованию
+    FrameProfiler profiler;
+    frame_profiler_init(&profiler);
+    const char* profile_path = frame_profiler_parse_path(argc, argv);
+    ProfileFormat profile_format = frame_profiler_parse_format(argc, argv);
+    bool profile_key_down = false;
 
-   while (!glfwWindowShouldClose(window)) {
+    RenderQueue render_queue;
+    RenderStateTracker render_state;
+    render_state_init(&render_state);
+
+   while (headless.enabled ? frame_count < (uint64_t)headless.frames : !glfwWindowShouldClose(window)) {
+       auto frame_start = std::chrono::steady_clock::now();
+       frame_profiler_begin_frame(&profiler);
        bool isLightMode = false;
 
        // Перемещаем вычисление lightPos в начало цикла
-       mat4x4 model;
-       mat4x4_identity(model);
-       mat4x4_translate(model, 0.0f, 2.0f, -6.0f);  // Перемещение в точку (0, 2, -6)
+       glm::aligned_mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, -6.0f));  // Перемещение в точку (0, 2, -6)
 
        // Извлекаем lightPos из матрицы модели
-       glm::vec3 lightPos;
-       lightPos.x = model[3][0];
-       lightPos.y = model[3][1];
-       lightPos.z = model[3][2];
-       vec3 lightPosVec3 = {lightPos.x, lightPos.y, lightPos.z};
+       glm::vec3 lightPos = glm::vec3(model[3]);
+       glm::vec3 lightPosVec3 = lightPos;
        // Теперь вызываем process_input, передавая актуальное значение lightPos
-       process_input(window, &lightPosVec3, &isLightMode);
-
+       frame_profiler_begin(&profiler, "input");
+       if (headless.enabled) {
+           headless_camera_script(&headless, (int)frame_count, glm::value_ptr(camera.position), &camera.yaw, &camera.pitch);
+           update_camera_vectors();
+       } else {
+           process_input(window, &lightPosVec3, &isLightMode);
+           bool profile_key = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+           if (profile_key && !profile_key_down)
+               frame_profiler_write(&profiler, profile_path ? profile_path : "frame_profile.json", profile_format);
+           profile_key_down = profile_key;
+       }
+
+       // Изменённые на диске файлы подменяются на границе кадра: программа — сразу,
+       // текстура — после декодирования в пуле, через texture_cache_pump
+       if (file_watch_poll(file_watcher, &changed_files)) {
+           frame_profiler_begin(&profiler, "hot reload");
+           for (const std::string& path : changed_files) {
+               if (shader_registry_reload(&shader_registry, path.c_str()) > 0)
+                   set_material_samplers(material_shaders);
+               texture_cache_reload(&texture_cache, image_decoder, path.c_str());
+           }
+       }
+
+       // Загружаем в GL то, что успели декодировать фоновые потоки
+       frame_profiler_begin(&profiler, "texture upload");
+       texture_cache_pump(&texture_cache, image_decoder, TEXTURE_UPLOAD_BUDGET_BYTES);
+       frame_profiler_begin(&profiler, "texture array");
+       texture_array_sync(&texture_array);
+
+       frame_profiler_begin(&profiler, "clear");
        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-       mat4x4 view, projection;
-       calculate_view_matrix(view);
-       mat4x4_perspective(projection, camera.fov, 800.0f / 600.0f, 0.1f, 100.0f);
-
-       GLuint light_shader = load_shader("D:/vr/zad3/shaders/shader.vert", "D:/vr/zad3/shaders/light_shader.frag");
-
-       // Активируем шейдер программы
-       glUseProgram(light_shader);
-
-       // Используем вычисленный lightPos
-       glUniform3f(glGetUniformLocation(light_shader, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
-
-
-       // Передаем модельную матрицу в шейдер
-       glUniformMatrix4fv(glGetUniformLocation(light_shader, "model"), 1, GL_FALSE, (const GLfloat*)model);
-
-       // Передаем видовую матрицу в шейдер
-       glUniformMatrix4fv(glGetUniformLocation(light_shader, "view"), 1, GL_FALSE, (const GLfloat*)view);
-
-       // Передаем проекционную матрицу в шейдер
-       glUniformMatrix4fv(glGetUniformLocation(light_shader, "projection"), 1, GL_FALSE, (const GLfloat*)projection);
-
-       // Передаем цвет объекта, который будет использован в шейдере (это будет цвет куба света)
-       glUniform3f(glGetUniformLocation(light_shader, "objectColor"), 1.0f, 1.0f, 1.0f);  // Белый цвет
-
-       // Передаем цвет источника света (если используется в фрагментном шейдере для освещения)
-       glUniform3f(glGetUniformLocation(light_shader, "lightColor"), 1.0f, 1.0f, 1.0f);  // Белый цвет света
-
-       // Отрисовываем куб света
-       glBindVertexArray(lightVAO);  // Привязываем VAO для куба
-       glDrawArrays(GL_TRIANGLES, 0, 36);
-    // Отрисовываем объекты сцены с различными шейдерами
-    for (int i = 0; i <= 4; i++) {
-        GLuint shader_to_use = 0;
-
-        switch(i) {
-            case 0: shader_to_use = phong_shader; break;
-            case 1: shader_to_use = diffuse_shader; break;
-            case 2: shader_to_use = specular_shader; break;
-            case 3: shader_to_use = lambert_shader; break;
-            case 4: shader_to_use = no_lighting_shader; break;
-            default: shader_to_use = phong_shader; break;
+       glm::aligned_mat4 view = calculate_view_matrix();
+       glm::aligned_mat4 projection(glm::perspective(glm::radians(camera.fov), (float)window_width / (float)window_height, 0.1f, FAR_PLANE));
+       glm::aligned_mat4 view_projection = projection * view;
+
+       // Без отсечения рисуется всё: MVP всех экземпляров одним пакетом, по ним выбирается глубина
+       // пакетов материалов. С отсечением проход по всем экземплярам не нужен — глубину дают
+       // центры AABB видимых, а MVP считаются только для окклюдеров
+       if (!frustum_culler) {
+           frame_profiler_begin(&profiler, "transforms");
+           auto transform_start = std::chrono::steady_clock::now();
+           transform_batch(transform_kernel, view_projection, &scene.models, &scene_mvp, NULL);
+           transform_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - transform_start).count();
+       }
+
+       // Видимые экземпляры; инстанс-буфер перезаливается, только когда видимый набор изменился
+       if (frustum_culler) {
+           frame_profiler_begin(&profiler, "culling");
+           Frustum frustum;
+           frustum_from_matrix(&frustum, view_projection);
+           if (use_bvh)
+               bvh_cull(&scene_bvh, &frustum, &visible_instances);
+           else
+               frustum_cull(frustum_culler, transform_kernel, &frustum, &scene.bounds, &visible_instances);
+           if (occlusion_culler) {
+               frame_profiler_begin(&profiler, "occlusion");
+               occlusion_select_occluders(view_projection, &scene.bounds, visible_instances, occlusion_options.occluders,
+                                          &occluder_instances);
+               occlusion_cull_begin(occlusion_culler, view_projection);
+               for (uint32_t index : occluder_instances)
+                   occlusion_cull_add_occluder(occlusion_culler, &cube_occluder,
+                                               glm::mat4(view_projection) * transform_soa_get(&scene.models, index));
+               occlusion_cull_rasterize(occlusion_culler, transform_kernel);
+               occlusion_cull_test(occlusion_culler, &scene.bounds, &visible_instances);
+           }
+           if (visible_instances != uploaded_visible) {
+               scene_pack_visible(&scene, visible_instances, &packed_instances, visible_count);
+               for (int m = 0; m < SCENE_MATERIAL_COUNT; m++) {
+                   if (visible_count[m] == 0)
+                       continue;
+                   GLintptr offset = (GLintptr)scene.material_first[m] * sizeof(CubeInstance);
+                   size_t bytes = (size_t)visible_count[m] * sizeof(CubeInstance);
+                   const CubeInstance* data = packed_instances.data() + scene.material_first[m];
+                   if (!staging_ring_upload_buffer(staging, instanceVBO, offset, data, bytes)) {
+                       glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+                       glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+                   }
+               }
+               uploaded_visible = visible_instances;
+               visible_uploads++;
+           }
+       }
+
+       // Константы кадра загружаются один раз и общие для всех программ
+       frame_profiler_begin(&profiler, "frame uniforms");
+       FrameUniforms frame_data;
+       memcpy(frame_data.view, glm::value_ptr(view), sizeof(frame_data.view));
+       memcpy(frame_data.projection, glm::value_ptr(projection), sizeof(frame_data.projection));
+       memcpy(frame_data.view_projection, glm::value_ptr(view_projection), sizeof(frame_data.view_projection));
+       frame_data.view_pos[0] = camera.position[0];
+       frame_data.view_pos[1] = camera.position[1];
+       frame_data.view_pos[2] = camera.position[2];
+       frame_data.view_pos[3] = 1.0f;
+       frame_data.light_pos[0] = lightPos.x;
+       frame_data.light_pos[1] = lightPos.y;
+       frame_data.light_pos[2] = lightPos.z;
+       frame_data.light_pos[3] = 1.0f;
+       frame_data.light_color[0] = 1.0f; // Белый цвет света
+       frame_data.light_color[1] = 1.0f;
+       frame_data.light_color[2] = 1.0f;
+       frame_data.light_color[3] = 1.0f;
+       frame_uniforms_update(&frame_ubo, &frame_data);
+
+       // Передаем модельную матрицу и цвет куба света через его экземпляр
+       CubeInstance light_instance;
+       memcpy(light_instance.model, glm::value_ptr(model), sizeof(light_instance.model));
+       memcpy(light_instance.normal_matrix, glm::value_ptr(glm::inverseTranspose(glm::mat3(model))), sizeof(light_instance.normal_matrix));
+       light_instance.color[0] = light_instance.color[1] = light_instance.color[2] = light_instance.color[3] = 1.0f; // Белый цвет
+       light_instance.uv_rect[0] = light_instance.uv_rect[1] = 0.0f;
+       light_instance.uv_rect[2] = light_instance.uv_rect[3] = 1.0f;
+       light_instance.layer = 0.0f;
+       if (!staging_ring_upload_buffer(staging, lightInstanceVBO, 0, &light_instance, sizeof(CubeInstance))) {
+           glBindBuffer(GL_ARRAY_BUFFER, lightInstanceVBO);
+           glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(CubeInstance), &light_instance);
+       }
+
+       // Собираем пакеты кадра; порядок отрисовки задаёт ключ сортировки, а не порядок здесь
+       frame_profiler_begin(&profiler, "render queue");
+       render_queue_clear(&render_queue);
+       render_state_begin_frame(&render_state);
+
+       DrawPacket light_packet;
+       light_packet.program = light_shader->program;
+       light_packet.texture = 0;
+       light_packet.texture_target = GL_TEXTURE_2D;
+       light_packet.vao = lightVAO;
+       light_packet.index_count = cube_index_count;
+       light_packet.instance_count = 0;
+       light_packet.scope = "light cube";
+       light_packet.key = render_sort_key(light_packet.program, light_packet.texture, light_packet.vao,
+                                          glm::distance(lightPos, camera.position), FAR_PLANE);
+       render_queue_push(&render_queue, &light_packet);
+
+    // Объекты сцены: один инстансный пакет на материал, глубина — ближайший видимый экземпляр перед камерой
+    // (w клипа центра экземпляра — столбец переноса MVP, строка 3; с отсечением — строка 3
+    // view_projection на центре AABB, он совпадает с началом координат модели куба)
+    const float* clip_w = scene_mvp.m[15].data();
+    const float* center_x = scene.bounds.center[0].data();
+    const float* center_y = scene.bounds.center[1].data();
+    const float* center_z = scene.bounds.center[2].data();
+    const uint32_t* visible_index = visible_instances.data();
+    for (int i = 0; i < SCENE_MATERIAL_COUNT; i++) {
+        int instance_count = frustum_culler ? visible_count[i] : scene.material_count[i];
+        float depth = FAR_PLANE;
+        for (int k = 0; k < instance_count; k++) {
+            int index = frustum_culler ? (int)visible_index[k] : scene.material_first[i] + k;
+            float w = frustum_culler ? view_projection[0][3] * center_x[index] + view_projection[1][3] * center_y[index] +
+                                           view_projection[2][3] * center_z[index] + view_projection[3][3]
+                                     : clip_w[index];
+            if (w > 0.0f && w < depth)
+                depth = w;
         }
-        glUseProgram(shader_to_use);
-        GLuint texture = load_texture("D:/vr/zad3/wood-2045380_1280.jpg");
-        // Используем выбранный шейдер
-
-        glUniform1i(glGetUniformLocation(shader_to_use, "uTexture"), 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        glm::vec3 lightPos;
-        lightPos.x = model[3][0];  // Извлекаем значение из матрицы модели (сдвиг по оси X)
-        lightPos.y = model[3][1];  // Извлекаем значение из матрицы модели (сдвиг по оси Y)
-        lightPos.z = model[3][2];  // Извлекаем значение из матрицы модели (сдвиг по оси Z)
-        vec3 lightColor = {1.0f, 1.0f, 1.0f}; // Цвет источника света (белый)
-
-        // Передача данных в шейдер
-        glUniform3fv(glGetUniformLocation(shader_to_use, "lightPos"), 1, &lightPos[0]);
-        glUniform3fv(glGetUniformLocation(shader_to_use, "lightColor"), 1, (const GLfloat*)lightColor);
-        glUniform3fv(glGetUniformLocation(shader_to_use, "viewPos"), 1, (const GLfloat*)camera.position);
-
-        // Рассчитываем и передаем MVP матрицу для каждого куба
-        mat4x4 model, mvp;
-        mat4x4_identity(model);
-        mat4x4_translate(model, cube_positions[i][0], cube_positions[i][1], cube_positions[i][2]);
-        mat4x4_mul(mvp, projection, view); // Сначала умножаем projection на view
-        mat4x4_mul(mvp, mvp, model); // Затем добавляем модельную матрицу
-
-        GLuint mvp_location = glGetUniformLocation(shader_to_use, "MVP");
-        glUniformMatrix4fv(mvp_location, 1, GL_FALSE, (const GLfloat*)mvp);
-
-        GLuint model_location = glGetUniformLocation(shader_to_use, "model");
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, (const GLfloat*)model);
-
-        GLuint view_location = glGetUniformLocation(shader_to_use, "view");
-        glUniformMatrix4fv(view_location, 1, GL_FALSE, (const GLfloat*)view);
-
-        GLuint projection_location = glGetUniformLocation(shader_to_use, "projection");
-        glUniformMatrix4fv(projection_location, 1, GL_FALSE, (const GLfloat*)projection);
-
-        GLuint objectColor_location = glGetUniformLocation(shader_to_use, "objectColor");
-        glUniform4fv(objectColor_location, 1, (const GLfloat*)cube_colors[i]);
+        if (frustum_culler)
+            visible_index += instance_count;
+        if (instance_count == 0)
+            continue;
+
+        DrawPacket packet;
+        packet.program = material_shaders[i]->program;
+        packet.texture = MATERIAL_SAMPLES_TEXTURE[i] ? texture_array_id(&texture_array) : 0;
+        packet.texture_target = GL_TEXTURE_2D_ARRAY;
+        packet.vao = material_vaos[i];
+        packet.index_count = cube_index_count;
+        packet.instance_count = instance_count;
+        packet.scope = MATERIAL_SCOPE_NAMES[i];
+        packet.key = render_sort_key(packet.program, packet.texture, packet.vao, depth, FAR_PLANE);
+        render_queue_push(&render_queue, &packet);
+    }
 
-        // Передаем атрибуты для текстурных координат, нормалей и вершин
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // Вершины
-        glEnableVertexAttribArray(0);
+    render_queue_sort(&render_queue);
+    render_queue_submit(&render_queue, &render_state, &profiler);
+    draw_call_count += render_state.frame.draws;
+    if (staging)
+        staging_ring_end_frame(staging);
+    frame_profiler_begin(&profiler, "swap");
+    if (headless.enabled) {
+        // Без swap кадр не ограничен vsync: ждём GPU, чтобы время было честным
+        glFinish();
+        headless_stats.frame_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+        if (headless.dump_dir && frame_count % headless.dump_every == 0) {
+            char dump_path[1024];
+            headless_dump_path(&headless, (int)frame_count, dump_path, sizeof(dump_path));
+            headless_stats.dumped += headless_target_dump(&headless_target, dump_path, headless.dump_format);
+        }
+    } else {
+        glfwSwapBuffers(window);
+    }
+    frame_count++;
+    glfwPollEvents();
+    frame_profiler_end(&profiler);
+}
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // Нормали
-        glEnableVertexAttribArray(1);
+    frame_profiler_print(&profiler);
+    if (profile_path)
+        frame_profiler_write(&profiler, profile_path, profile_format);
+    frame_profiler_destroy(&profiler);
 
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // Текстурные координаты
-        glEnableVertexAttribArray(2);
+    if (headless.enabled) {
+        headless_report(&headless, &headless_stats);
+        headless_target_destroy(&headless_target);
+    }
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    if (frame_count > 0) {
+        printf("Draw calls: %.1f per frame for %d cubes\n", (double)draw_call_count / frame_count, (int)scene.instances.size());
+        if (!frustum_culler)
+            printf("Transforms (%s): %.3f ms per frame for %d instances\n", transform_kernel_name(transform_kernel),
+                   transform_ms / frame_count, (int)scene.instances.size());
+        FrustumCullStats cull_stats = frustum_cull_stats(frustum_culler);
+        if (cull_stats.calls > 0)
+            printf("Frustum culling (%s, %u threads): %.1f visible, %.1f culled per frame, %.2f ns per object, %llu visible set uploads\n",
+                   transform_kernel_name(transform_kernel), frustum_cull_threads(frustum_culler),
+                   (double)cull_stats.visible / cull_stats.calls, (double)(cull_stats.objects - cull_stats.visible) / cull_stats.calls,
+                   cull_stats.objects ? cull_stats.ns / cull_stats.objects : 0.0, (unsigned long long)visible_uploads);
+        if (scene_bvh.stats.queries > 0)
+            printf("BVH culling: %.1f visible, %.1f nodes visited, %.1f objects tested per frame, %.3f ms per frame, %llu visible set uploads\n",
+                   (double)scene_bvh.stats.objects_found / scene_bvh.stats.queries,
+                   (double)scene_bvh.stats.nodes_visited / scene_bvh.stats.queries,
+                   (double)scene_bvh.stats.objects_tested / scene_bvh.stats.queries,
+                   scene_bvh.stats.cull_ns / scene_bvh.stats.queries * 1e-6, (unsigned long long)visible_uploads);
+        OcclusionCullStats occlusion_stats = occlusion_cull_stats(occlusion_culler);
+        if (occlusion_stats.frames > 0) {
+            int occlusion_width, occlusion_height;
+            occlusion_cull_size(occlusion_culler, &occlusion_width, &occlusion_height);
+            printf("Occlusion culling (%dx%d, %s, %u threads): %.1f occluders, %.1f triangles, %.1f of %.1f tested occluded (%.1f%%) per frame, "
+                   "%.3f ms raster + %.3f ms test per frame\n",
+                   occlusion_width, occlusion_height, transform_kernel_name(transform_kernel), occlusion_cull_threads(occlusion_culler),
+                   (double)occlusion_stats.occluders / occlusion_stats.frames, (double)occlusion_stats.triangles / occlusion_stats.frames,
+                   (double)occlusion_stats.occluded / occlusion_stats.frames, (double)occlusion_stats.tested / occlusion_stats.frames,
+                   occlusion_stats.tested ? 100.0 * occlusion_stats.occluded / occlusion_stats.tested : 0.0,
+                   occlusion_stats.raster_ns / occlusion_stats.frames * 1e-6, occlusion_stats.test_ns / occlusion_stats.frames * 1e-6);
+        }
+        printf("State changes per frame: %.1f programs, %.1f textures, %.1f VAOs, %.1f redundant binds skipped\n",
+               (double)render_state.total.program_binds / frame_count, (double)render_state.total.texture_binds / frame_count,
+               (double)render_state.total.vao_binds / frame_count, (double)render_state.total.redundant / frame_count);
     }
-    glfwSwapBuffers(window);
-    glfwPollEvents();
-}
 
+    printf("Texture array: %llu copies from the cache, %llu unsupported, %llu mip rebuilds, %.1f MB, atlas fill %.0f%%\n",
+           (unsigned long long)texture_array.stats.copies, (unsigned long long)texture_array.stats.unsupported,
+           (unsigned long long)texture_array.stats.mip_rebuilds, texture_array.stats.bytes / 1048576.0,
+           texture_array_atlas_fill(&texture_array) * 100.0);
+    texture_array_destroy(&texture_array);
+    if (file_watcher) {
+        FileWatchStats watch_stats = file_watch_stats(file_watcher);
+        printf("Hot reload: %llu files in %llu folders, %llu events, %llu changes, %llu textures replaced\n",
+               (unsigned long long)watch_stats.files, (unsigned long long)watch_stats.folders,
+               (unsigned long long)watch_stats.events, (unsigned long long)watch_stats.changes,
+               (unsigned long long)texture_cache.stats.reloads);
+        file_watch_destroy(file_watcher);
+    }
+    for (TextureHandle handle : scene_textures)
+        texture_cache_release(&texture_cache, handle);
+    printf("Texture cache: %llu hits, %llu content hits, %llu misses (%llu cooked), %llu evictions, %llu bytes resident, %.2f ms building %s mips\n",
+           (unsigned long long)texture_cache.stats.hits, (unsigned long long)texture_cache.stats.content_hits,
+           (unsigned long long)texture_cache.stats.misses, (unsigned long long)texture_cache.stats.cooked_loads,
+           (unsigned long long)texture_cache.stats.evictions, (unsigned long long)texture_cache.stats.bytes_resident,
+           texture_cache.stats.mip_build_ms, mip_filter_name(texture_cache.mip_options.filter));
+    if (texture_cache.stats.previews)
+        printf("Texture previews: %llu shown at 1/%d scale before the full decode\n",
+               (unsigned long long)texture_cache.stats.previews, texture_cache.preview_scale);
+    ImageDecoderStats decoder_stats = image_decoder_stats(image_decoder);
+    printf("Image decoder: %llu decoded, %llu failed, avg decode %.2f ms, avg latency %.2f ms, max latency %.2f ms\n",
+           (unsigned long long)decoder_stats.completed, (unsigned long long)decoder_stats.failed,
+           decoder_stats.avg_decode_ms, decoder_stats.avg_latency_ms, decoder_stats.max_latency_ms);
+    if (block_encoder) {
+        BlockEncoderStats encoder_stats = block_encoder_stats(block_encoder);
+        printf("Block encoder (%s, %s, %u threads): %llu textures, %llu blocks, %.2f ms busy, %.2f ms waited after mips\n",
+               block_quality_name(texture_cache.compression.encode.quality), block_simd_name(), block_encoder_threads(block_encoder),
+               (unsigned long long)texture_cache.stats.runtime_compressed, (unsigned long long)encoder_stats.blocks,
+               encoder_stats.busy_ms, texture_cache.stats.compress_ms);
+    }
+    if (asset_pack.data)
+        printf("Asset pack: %llu textures loaded from pack\n", (unsigned long long)texture_cache.stats.packed_loads);
+    if (staging) {
+        const StagingRingStats& ring = staging->stats;
+        printf("Staging ring (%zu MB, %s): %llu uploads, %.1f KB/frame avg, %.1f KB max, %llu stalls (%.2f ms waiting on fences), %llu oversize, %llu full\n",
+               staging->capacity >> 20, staging->persistent ? "persistent" : "unsynchronized maps",
+               (unsigned long long)ring.reservations, ring.frames ? ring.bytes / 1024.0 / ring.frames : 0.0,
+               ring.frame_bytes_max / 1024.0, (unsigned long long)ring.stalls, ring.fence_wait_ms,
+               (unsigned long long)ring.oversize, (unsigned long long)ring.full);
+    }
+    texture_cache_shutdown(&texture_cache);
+    image_decoder_destroy(image_decoder);
+    block_encoder_destroy(block_encoder);
+    frustum_cull_destroy(frustum_culler);
+    occlusion_cull_destroy(occlusion_culler);
+    frame_uniforms_destroy(&frame_ubo);
+    shader_registry_print_stats(&shader_registry);
+    shader_registry_shutdown(&shader_registry);
+    if (staging)
+        staging_ring_destroy(staging);
+    asset_pack_close(&asset_pack);
 
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -0,0 +1,283 @@
+// Микробенчмарк математики горячего цикла: linmath.h против GLM без SIMD,
+// с GLM_FORCE_INTRINSICS и с GLM_FORCE_AVX2 (если его поддерживает процессор).
+// Для каждой операции два числа, лучшее из --iterations замеров:
+//   задержка — по одному элементу за вызов, и вход вызова зависит от выхода предыдущего
+//     (out[0] * 0 прибавляется к входу), данные лежат в L1. Из времени вычитается та же
+//     цепочка с пустым ядром — остаётся сама операция с загрузкой и выгрузкой;
+//   пропускная способность — пакет из --count элементов (по умолчанию 1M) одним вызовом,
+//     с памятью: на 1M матриц это уже не кэш.
+// Результаты сверяются с linmath; --json пишет их для CI, код возврата 1 —
+// какая-то библиотека разошлась с linmath больше чем на ERROR_TOLERANCE.
+//   math_bench [--count N] [--iterations N] [--json results.json]
+#include "math_bench.h"
+#include <linmath.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+static const size_t DEFAULT_COUNT = 1000000;
+static const int DEFAULT_ITERATIONS = 5;
+static const int LATENCY_SET = 64;          // элементов по кругу — вход задержки в L1
+static const int LATENCY_CALLS = 200000;
+static const float ERROR_TOLERANCE = 1e-3f; // относительная, для чисел больше 1 по модулю
+
+// Число float на элемент у входов и выхода; b = 0 — унарная операция
+typedef struct {
+    const char* name;
+    int a, b, out;
+} MathOpLayout;
+
+static const MathOpLayout OP_LAYOUTS[MATH_OP_COUNT] = {
+    { "mat4_mul", 16, 16, 16 },
+    { "mat4_invert", 16, 0, 16 },
+    { "look_at", 3, 3, 16 },
+    { "perspective", 2, 0, 16 },
+    { "quat_mul_vec3", 4, 3, 3 },
+    { "vec3_norm", 3, 0, 3 },
+};
+
+typedef struct {
+    const char* op;
+    const char* library;
+    double latency_ns;
+    double batch_ns;    // на элемент
+    double max_error;
+} MathBenchResult;
+
+static void linmath_mat4_mul(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        mat4x4_mul((vec4*)(out + i * 16), (const vec4*)(a + i * 16), (const vec4*)(b + i * 16));
+}
+
+static void linmath_mat4_invert(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        mat4x4_invert((vec4*)(out + i * 16), (const vec4*)(a + i * 16));
+}
+
+static void linmath_look_at(const float* a, const float* b, float* out, size_t count) {
+    const vec3 up = { 0.0f, 1.0f, 0.0f };
+    for (size_t i = 0; i < count; i++)
+        mat4x4_look_at((vec4*)(out + i * 16), a + i * 3, b + i * 3, up);
+}
+
+static void linmath_perspective(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        mat4x4_perspective((vec4*)(out + i * 16), a[i * 2], a[i * 2 + 1], MATH_BENCH_NEAR, MATH_BENCH_FAR);
+}
+
+static void linmath_quat_mul_vec3(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        quat_mul_vec3(out + i * 3, a + i * 4, b + i * 3);
+}
+
+static void linmath_vec3_norm(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        vec3_norm(out + i * 3, a + i * 3);
+}
+
+static void math_bench_linmath(MathBenchLibrary* library) {
+    library->name = "linmath";
+    library->ops[MATH_OP_MAT4_MUL] = linmath_mat4_mul;
+    library->ops[MATH_OP_MAT4_INVERT] = linmath_mat4_invert;
+    library->ops[MATH_OP_LOOK_AT] = linmath_look_at;
+    library->ops[MATH_OP_PERSPECTIVE] = linmath_perspective;
+    library->ops[MATH_OP_QUAT_MUL_VEC3] = linmath_quat_mul_vec3;
+    library->ops[MATH_OP_VEC3_NORM] = linmath_vec3_norm;
+}
+
+static void empty_kernel(const float* a, const float*, float* out, size_t) {
+    out[0] = a[0];
+}
+// Через volatile, чтобы компилятор не встроил пустое ядро в цепочку: настоящие ядра
+// вызываются по указателю, и эталон должен платить за вызов столько же
+static MathKernel volatile baseline_kernel = empty_kernel;
+
+static bool cpu_has_avx2() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+// Входы без вырожденных случаев: обратимые матрицы, взгляд не вдоль up, ненулевые векторы
+static void fill_inputs(MathOp op, std::mt19937* rng, std::vector<float>* a, std::vector<float>* b, size_t count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    const MathOpLayout* layout = &OP_LAYOUTS[op];
+    a->resize(count * layout->a);
+    b->resize(count * layout->b);
+    for (size_t i = 0; i < count; i++) {
+        float* x = a->data() + i * layout->a;
+        float* y = b->data() + i * layout->b;
+        switch (op) {
+        case MATH_OP_MAT4_MUL:
+        case MATH_OP_MAT4_INVERT:
+            for (int k = 0; k < 16; k++)
+                x[k] = unit(*rng) + (k % 5 == 0 ? 4.0f : 0.0f); // диагональное преобладание
+            for (int k = 0; k < layout->b; k++)
+                y[k] = unit(*rng);
+            break;
+        case MATH_OP_LOOK_AT:
+            for (int k = 0; k < 3; k++) {
+                x[k] = unit(*rng) * 10.0f;
+                y[k] = x[k] + unit(*rng) * 5.0f;
+            }
+            y[0] += fabsf(y[0] - x[0]) < 1.0f ? 2.0f : 0.0f;
+            break;
+        case MATH_OP_PERSPECTIVE:
+            x[0] = 1.25f + unit(*rng) * 0.75f;
+            x[1] = 1.5f + unit(*rng);
+            break;
+        case MATH_OP_QUAT_MUL_VEC3: {
+            float length = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                x[k] = unit(*rng) + (k == 3 ? 2.0f : 0.0f);
+                length += x[k] * x[k];
+            }
+            for (int k = 0; k < 4; k++)
+                x[k] /= sqrtf(length);
+            for (int k = 0; k < 3; k++)
+                y[k] = unit(*rng) * 10.0f;
+            break;
+        }
+        default:
+            for (int k = 0; k < 3; k++)
+                x[k] = unit(*rng) * 10.0f + (k == 0 ? 11.0f : 0.0f);
+            break;
+        }
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Наносекунд на вызов цепочки из одноэлементных вызовов
+static double chain_ns(MathKernel kernel, const MathOpLayout* layout, const float* a, const float* b, int iterations) {
+    float input[16];
+    float out[16] = {};
+    double best = 1e30;
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int call = 0; call < LATENCY_CALLS; call++) {
+            int element = call % LATENCY_SET;
+            memcpy(input, a + element * layout->a, layout->a * sizeof(float));
+            input[0] += out[0] * 0.0f;
+            kernel(input, layout->b ? b + element * layout->b : NULL, out, 1);
+        }
+        best = std::min(best, seconds_since(start) * 1.0e9 / LATENCY_CALLS);
+    }
+    return best;
+}
+
+// Наносекунд на элемент пакета; первый (прогревочный) вызов оставляет результат в out
+static double batch_ns(MathKernel kernel, const float* a, const float* b, float* out, size_t count, int iterations) {
+    kernel(a, b, out, count);
+    double best = 1e30;
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        auto start = std::chrono::steady_clock::now();
+        kernel(a, b, out, count);
+        best = std::min(best, seconds_since(start) * 1.0e9 / (double)count);
+    }
+    return best;
+}
+
+static double max_error(const std::vector<float>& values, const std::vector<float>& reference) {
+    double error = 0.0;
+    for (size_t i = 0; i < values.size(); i++) {
+        double difference = fabs((double)values[i] - reference[i]) / std::max(1.0, fabs((double)reference[i]));
+        error = std::max(error, difference != difference ? 1e30 : difference); // NaN — заведомое расхождение
+    }
+    return error;
+}
+
+static bool write_json(const char* path, const std::vector<MathBenchResult>& results, size_t count, int iterations,
+                       double baseline_ns) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open results file %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"count\": %zu,\n  \"iterations\": %d,\n  \"latency_calls\": %d,\n  \"baseline_ns\": %.3f,\n"
+                  "  \"tolerance\": %g,\n  \"results\": [\n",
+            count, iterations, LATENCY_CALLS, baseline_ns, ERROR_TOLERANCE);
+    for (size_t i = 0; i < results.size(); i++) {
+        const MathBenchResult& r = results[i];
+        fprintf(file, "    {\"op\": \"%s\", \"library\": \"%s\", \"latency_ns\": %.3f, \"batch_ns\": %.3f, "
+                      "\"melem_per_s\": %.2f, \"max_error\": %.3g}%s\n",
+                r.op, r.library, r.latency_ns, r.batch_ns, 1.0e3 / r.batch_ns, r.max_error,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    printf("Results written to %s\n", path);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t count = DEFAULT_COUNT;
+    int iterations = DEFAULT_ITERATIONS;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (size_t)std::max(1LL, atoll(argv[++i]));
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            json_path = argv[++i];
+    }
+    count = std::max(count, (size_t)LATENCY_SET);
+
+    std::vector<MathBenchLibrary> libraries(4);
+    math_bench_linmath(&libraries[0]);
+    math_bench_glm_scalar(&libraries[1]);
+    math_bench_glm_simd(&libraries[2]);
+    bool avx2 = cpu_has_avx2();
+    if (avx2)
+        math_bench_glm_avx2(&libraries[3]);
+    else
+        libraries.pop_back();
+
+    std::vector<float> ones(LATENCY_SET * OP_LAYOUTS[MATH_OP_VEC3_NORM].a, 1.0f);
+    double baseline = chain_ns(baseline_kernel, &OP_LAYOUTS[MATH_OP_VEC3_NORM], ones.data(), NULL, iterations);
+    printf("%zu elements, best of %d, latency chain overhead %.2f ns subtracted%s\n", count, iterations, baseline,
+           avx2 ? "" : ", GLM AVX2 skipped: no AVX2+FMA on this CPU");
+    printf("%-14s %-11s %12s %14s %10s %10s\n", "op", "library", "latency ns", "batch ns/elem", "Melem/s", "max error");
+
+    std::mt19937 rng(2024);
+    std::vector<float> a, b, out, reference;
+    std::vector<MathBenchResult> results;
+    bool mismatch = false;
+    for (int op = 0; op < MATH_OP_COUNT; op++) {
+        const MathOpLayout* layout = &OP_LAYOUTS[op];
+        fill_inputs((MathOp)op, &rng, &a, &b, count);
+        out.assign(count * layout->out, 0.0f);
+        for (size_t l = 0; l < libraries.size(); l++) {
+            MathKernel kernel = libraries[l].ops[op];
+            const float* b_data = layout->b ? b.data() : NULL;
+            MathBenchResult result;
+            result.op = layout->name;
+            result.library = libraries[l].name;
+            result.latency_ns = std::max(0.0, chain_ns(kernel, layout, a.data(), b_data, iterations) - baseline);
+            result.batch_ns = batch_ns(kernel, a.data(), b_data, out.data(), count, iterations);
+            if (l == 0)
+                reference = out;
+            result.max_error = max_error(out, reference);
+            mismatch |= result.max_error > ERROR_TOLERANCE;
+            results.push_back(result);
+            printf("%-14s %-11s %12.2f %14.3f %10.1f %10.2g%s\n", result.op, result.library, result.latency_ns,
+                   result.batch_ns, 1.0e3 / result.batch_ns, result.max_error,
+                   result.max_error > ERROR_TOLERANCE ? "  MISMATCH" : "");
+        }
+    }
+
+    if (json_path && !write_json(json_path, results, count, iterations, baseline))
+        return 1;
+    return mismatch ? 1 : 0;
+}
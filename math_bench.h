@@ -0,0 +1,37 @@
+#ifndef MATH_BENCH_H
+#define MATH_BENCH_H
+
+#include <stddef.h>
+
+// Общий интерфейс ядер math_bench: каждая библиотека (linmath.h, GLM в разных
+// сборках) реализует одни и те же операции над плоскими массивами float, чтобы
+// сравнение не зависело от типов библиотек. Матрицы — 16 float по столбцам,
+// как mat4x4 linmath и glm::mat4; кватернион — x y z w, как quat linmath.
+
+typedef enum {
+    MATH_OP_MAT4_MUL,        // a: mat4, b: mat4 -> mat4 (a * b)
+    MATH_OP_MAT4_INVERT,     // a: mat4 -> mat4
+    MATH_OP_LOOK_AT,         // a: eye vec3, b: center vec3 -> mat4 (up = 0 1 0)
+    MATH_OP_PERSPECTIVE,     // a: fov по вертикали в радианах, aspect -> mat4 (near 0.1, far 100)
+    MATH_OP_QUAT_MUL_VEC3,   // a: quat, b: vec3 -> vec3
+    MATH_OP_VEC3_NORM,       // a: vec3 -> vec3
+    MATH_OP_COUNT
+} MathOp;
+
+// count элементов подряд; b == NULL у унарных операций
+typedef void (*MathKernel)(const float* a, const float* b, float* out, size_t count);
+
+typedef struct {
+    const char* name;
+    MathKernel ops[MATH_OP_COUNT];
+} MathBenchLibrary;
+
+static const float MATH_BENCH_NEAR = 0.1f;
+static const float MATH_BENCH_FAR = 100.0f;
+
+// Реализации GLM собираются из math_bench_glm.cpp трижды с разными макросами
+void math_bench_glm_scalar(MathBenchLibrary* library);  // без GLM_FORCE_INTRINSICS
+void math_bench_glm_simd(MathBenchLibrary* library);    // GLM_FORCE_INTRINSICS (SSE2 и что включено сборкой)
+void math_bench_glm_avx2(MathBenchLibrary* library);    // GLM_FORCE_INTRINSICS + GLM_FORCE_AVX2, -mavx2
+
+#endif
@@ -0,0 +1,121 @@
+// Ядра math_bench на GLM. Файл собирается трижды (см. CMakeLists.txt):
+//   без макросов             — скалярный GLM, обычные (packed) типы;
+//   MATH_BENCH_GLM_SIMD      — GLM_FORCE_INTRINSICS, выровненные типы, SSE2 сборки по умолчанию;
+//   MATH_BENCH_GLM_AVX2      — то же + GLM_FORCE_AVX2, файл собирается с -mavx2 -mfma.
+// Каждая сборка переименовывает пространство имён glm: у встраиваемых функций GLM
+// одни и те же имена, а тела в разных сборках разные, и компоновщик оставил бы
+// одно тело на всех (в том числе AVX2-тело для скалярного варианта).
+#include "math_bench.h"
+
+#if defined(MATH_BENCH_GLM_AVX2)
+#define GLM_FORCE_INTRINSICS
+#define GLM_FORCE_AVX2
+#define glm glm_avx2
+#define MATH_BENCH_GLM_ALIGNED 1
+#define MATH_BENCH_GLM_ENTRY math_bench_glm_avx2
+#define MATH_BENCH_GLM_NAME "GLM AVX2"
+#elif defined(MATH_BENCH_GLM_SIMD)
+#define GLM_FORCE_INTRINSICS
+#define glm glm_simd
+#define MATH_BENCH_GLM_ALIGNED 1
+#define MATH_BENCH_GLM_ENTRY math_bench_glm_simd
+#define MATH_BENCH_GLM_NAME "GLM SIMD"
+#else
+#define MATH_BENCH_GLM_ALIGNED 0
+#define MATH_BENCH_GLM_ENTRY math_bench_glm_scalar
+#define MATH_BENCH_GLM_NAME "GLM scalar"
+#endif
+
+#include <glm.hpp>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
+
+// SIMD-пути GLM есть только у выровненных типов и только у четырёхкомпонентных:
+// vec3 в SIMD-сборках считается как vec4 с w = 0 — так его и держат в горячем цикле
+#if MATH_BENCH_GLM_ALIGNED
+static constexpr glm::qualifier Q = glm::aligned_highp;
+#else
+static constexpr glm::qualifier Q = glm::packed_highp;
+#endif
+typedef glm::mat<4, 4, float, Q> Mat4;
+typedef glm::vec<3, float, Q> Vec3;
+typedef glm::vec<4, float, Q> Vec4;
+typedef glm::qua<float, Q> Quat;
+
+static Mat4 load_mat4(const float* p) {
+    Mat4 m;
+    for (int c = 0; c < 4; c++)
+        m[c] = Vec4(p[c * 4], p[c * 4 + 1], p[c * 4 + 2], p[c * 4 + 3]);
+    return m;
+}
+
+template <typename Matrix>
+static void store_mat4(float* p, const Matrix& m) {
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            p[c * 4 + r] = m[c][r];
+}
+
+static void mat4_mul(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        store_mat4(out + i * 16, load_mat4(a + i * 16) * load_mat4(b + i * 16));
+}
+
+static void mat4_invert(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        store_mat4(out + i * 16, glm::inverse(load_mat4(a + i * 16)));
+}
+
+static void look_at(const float* a, const float* b, float* out, size_t count) {
+    const Vec3 up(0.0f, 1.0f, 0.0f);
+    for (size_t i = 0; i < count; i++) {
+        const float* eye = a + i * 3;
+        const float* center = b + i * 3;
+        store_mat4(out + i * 16, glm::lookAt(Vec3(eye[0], eye[1], eye[2]), Vec3(center[0], center[1], center[2]), up));
+    }
+}
+
+static void perspective(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        store_mat4(out + i * 16, glm::perspective(a[i * 2], a[i * 2 + 1], MATH_BENCH_NEAR, MATH_BENCH_FAR));
+}
+
+static void quat_mul_vec3(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* q = a + i * 4;
+        const float* v = b + i * 3;
+        Quat rotation = Quat::wxyz(q[3], q[0], q[1], q[2]);
+#if MATH_BENCH_GLM_ALIGNED
+        Vec4 r = rotation * Vec4(v[0], v[1], v[2], 0.0f);
+#else
+        Vec3 r = rotation * Vec3(v[0], v[1], v[2]);
+#endif
+        out[i * 3] = r.x;
+        out[i * 3 + 1] = r.y;
+        out[i * 3 + 2] = r.z;
+    }
+}
+
+static void vec3_norm(const float* a, const float*, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* v = a + i * 3;
+#if MATH_BENCH_GLM_ALIGNED
+        Vec4 r = glm::normalize(Vec4(v[0], v[1], v[2], 0.0f));
+#else
+        Vec3 r = glm::normalize(Vec3(v[0], v[1], v[2]));
+#endif
+        out[i * 3] = r.x;
+        out[i * 3 + 1] = r.y;
+        out[i * 3 + 2] = r.z;
+    }
+}
+
+void MATH_BENCH_GLM_ENTRY(MathBenchLibrary* library) {
+    library->name = MATH_BENCH_GLM_NAME;
+    library->ops[MATH_OP_MAT4_MUL] = mat4_mul;
+    library->ops[MATH_OP_MAT4_INVERT] = mat4_invert;
+    library->ops[MATH_OP_LOOK_AT] = look_at;
+    library->ops[MATH_OP_PERSPECTIVE] = perspective;
+    library->ops[MATH_OP_QUAT_MUL_VEC3] = quat_mul_vec3;
+    library->ops[MATH_OP_VEC3_NORM] = vec3_norm;
+}
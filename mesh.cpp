@@ -0,0 +1,165 @@
+#include "mesh.h"
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <glm.hpp>
+#include <gtc/packing.hpp>
+
+static void pack_vertices(Mesh* mesh) {
+    size_t unique_count = mesh->vertices.size() / MESH_FLOATS_PER_VERTEX;
+    mesh->packed.resize(unique_count);
+    for (size_t i = 0; i < unique_count; i++) {
+        const float* v = &mesh->vertices[i * MESH_FLOATS_PER_VERTEX];
+        PackedVertex& p = mesh->packed[i];
+        p.position[0] = glm::packHalf1x16(v[0]);
+        p.position[1] = glm::packHalf1x16(v[1]);
+        p.position[2] = glm::packHalf1x16(v[2]);
+        p.position[3] = glm::packHalf1x16(1.0f);
+        // x — младшие 10 бит, как у GL_INT_2_10_10_10_REV
+        p.normal = glm::packSnorm3x10_1x2(glm::vec4(v[3], v[4], v[5], 0.0f));
+        p.uv[0] = (uint16_t)(glm::clamp(v[6], 0.0f, 1.0f) * 65535.0f + 0.5f);
+        p.uv[1] = (uint16_t)(glm::clamp(v[7], 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+}
+
+void mesh_build_indexed(Mesh* mesh, const float* vertices, int vertex_count) {
+    mesh->vertices.clear();
+    mesh->indices.clear();
+    mesh->packed.clear();
+
+    // Ключ — байты вершины; сравнение побитовое, как и положено для сварки
+    std::unordered_map<std::string, uint16_t> unique;
+    const size_t vertex_size = MESH_FLOATS_PER_VERTEX * sizeof(float);
+
+    for (int i = 0; i < vertex_count; i++) {
+        const float* vertex = vertices + i * MESH_FLOATS_PER_VERTEX;
+        std::string key((const char*)vertex, vertex_size);
+        auto it = unique.find(key);
+        if (it != unique.end()) {
+            mesh->indices.push_back(it->second);
+            continue;
+        }
+        uint16_t index = (uint16_t)(mesh->vertices.size() / MESH_FLOATS_PER_VERTEX);
+        unique.emplace(key, index);
+        mesh->vertices.insert(mesh->vertices.end(), vertex, vertex + MESH_FLOATS_PER_VERTEX);
+        mesh->indices.push_back(index);
+    }
+
+    pack_vertices(mesh);
+}
+
+MeshStats mesh_stats(const Mesh* mesh, MeshFormat format, int source_vertices) {
+    MeshStats stats;
+    stats.source_vertices = source_vertices;
+    stats.unique_vertices = (int)(mesh->vertices.size() / MESH_FLOATS_PER_VERTEX);
+    stats.index_count = (int)mesh->indices.size();
+    stats.bytes_per_vertex = format == MESH_FORMAT_PACKED ? (int)sizeof(PackedVertex) : MESH_FLOATS_PER_VERTEX * (int)sizeof(float);
+    stats.vertex_bytes = stats.unique_vertices * stats.bytes_per_vertex;
+    stats.index_bytes = stats.index_count * (int)sizeof(uint16_t);
+    stats.source_bytes = source_vertices * MESH_FLOATS_PER_VERTEX * (int)sizeof(float);
+
+    // Моделируем FIFO-кэш пост-трансформа
+    std::vector<int> fifo;
+    int misses = 0;
+    for (uint16_t index : mesh->indices) {
+        if (std::find(fifo.begin(), fifo.end(), index) != fifo.end())
+            continue;
+        misses++;
+        fifo.push_back(index);
+        if ((int)fifo.size() > MESH_VERTEX_CACHE_SIZE)
+            fifo.erase(fifo.begin());
+    }
+    int triangles = stats.index_count / 3;
+    stats.acmr = triangles ? (float)misses / triangles : 0.0f;
+    stats.cache_hit_rate = stats.index_count ? 1.0f - (float)misses / stats.index_count : 0.0f;
+    return stats;
+}
+
+void mesh_write_blob(const Mesh* mesh, std::vector<unsigned char>* out) {
+    const uint32_t header[4] = { MESH_BLOB_MAGIC, MESH_BLOB_VERSION, (uint32_t)(mesh->vertices.size() / MESH_FLOATS_PER_VERTEX),
+                                 (uint32_t)mesh->indices.size() };
+    size_t vertex_bytes = mesh->vertices.size() * sizeof(float), index_bytes = mesh->indices.size() * sizeof(uint16_t);
+    out->resize(sizeof(header) + vertex_bytes + index_bytes);
+    memcpy(out->data(), header, sizeof(header));
+    memcpy(out->data() + sizeof(header), mesh->vertices.data(), vertex_bytes);
+    memcpy(out->data() + sizeof(header) + vertex_bytes, mesh->indices.data(), index_bytes);
+}
+
+bool mesh_read_blob(Mesh* mesh, const unsigned char* data, size_t size) {
+    uint32_t header[4];
+    if (size < sizeof(header))
+        return false;
+    memcpy(header, data, sizeof(header));
+    size_t vertex_bytes = (size_t)header[2] * MESH_FLOATS_PER_VERTEX * sizeof(float), index_bytes = (size_t)header[3] * sizeof(uint16_t);
+    if (header[0] != MESH_BLOB_MAGIC || header[1] != MESH_BLOB_VERSION || header[2] > 65536 || size != sizeof(header) + vertex_bytes + index_bytes)
+        return false;
+    mesh->vertices.resize((size_t)header[2] * MESH_FLOATS_PER_VERTEX);
+    mesh->indices.resize(header[3]);
+    memcpy(mesh->vertices.data(), data + sizeof(header), vertex_bytes);
+    memcpy(mesh->indices.data(), data + sizeof(header) + vertex_bytes, index_bytes);
+    for (uint16_t index : mesh->indices) {
+        if (index >= header[2])
+            return false;
+    }
+    pack_vertices(mesh);
+    return true;
+}
+
+MeshFormat mesh_parse_format(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--vertex-format") == 0)
+            return strcmp(argv[i + 1], "float") == 0 ? MESH_FORMAT_FLOAT : MESH_FORMAT_PACKED;
+    }
+    return MESH_FORMAT_PACKED;
+}
+
+const char* mesh_parse_export_path(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--export-mesh") == 0)
+            return argv[i + 1];
+    }
+    return NULL;
+}
+
+// Через GL_COPY_WRITE_BUFFER, чтобы не трогать индексный буфер текущего VAO
+static void upload_static(GLuint buffer, const void* data, size_t size, StagingRing* staging) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, staging ? NULL : data, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (staging && !staging_ring_upload_buffer(staging, buffer, 0, data, size)) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void mesh_upload(const Mesh* mesh, MeshFormat format, GLuint vertex_buffer, GLuint index_buffer, StagingRing* staging) {
+    if (format == MESH_FORMAT_PACKED)
+        upload_static(vertex_buffer, mesh->packed.data(), mesh->packed.size() * sizeof(PackedVertex), staging);
+    else
+        upload_static(vertex_buffer, mesh->vertices.data(), mesh->vertices.size() * sizeof(float), staging);
+    upload_static(index_buffer, mesh->indices.data(), mesh->indices.size() * sizeof(uint16_t), staging);
+}
+
+void mesh_setup_attributes(MeshFormat format, GLuint vertex_buffer, GLuint index_buffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    if (format == MESH_FORMAT_PACKED) {
+        GLsizei stride = sizeof(PackedVertex);
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position)); // Вершины
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal)); // Нормали
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, uv)); // Текстурные координаты
+    } else {
+        GLsizei stride = MESH_FLOATS_PER_VERTEX * sizeof(float);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0); // Вершины
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float))); // Нормали
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float))); // Текстурные координаты
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    // Привязка индексного буфера запоминается в VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+}
@@ -0,0 +1,68 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "include/glad.h"
+#include "staging_ring.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Вершинные форматы: исходный (позиция, нормаль, UV во float — 32 байта)
+// и упакованный (half-позиция, нормаль 2_10_10_10, UV в unorm16 — 16 байт)
+typedef enum {
+    MESH_FORMAT_FLOAT,
+    MESH_FORMAT_PACKED
+} MeshFormat;
+
+typedef struct {
+    uint16_t position[4]; // half float, w — выравнивание
+    uint32_t normal;      // GL_INT_2_10_10_10_REV, нормализованный
+    uint16_t uv[2];       // GL_UNSIGNED_SHORT, нормализованный
+} PackedVertex;
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must be 16 bytes");
+
+static const int MESH_FLOATS_PER_VERTEX = 8; // позиция(3) + нормаль(3) + UV(2)
+static const int MESH_VERTEX_CACHE_SIZE = 16; // FIFO-кэш пост-трансформа для оценки
+
+typedef struct {
+    std::vector<float> vertices;      // уникальные вершины, MESH_FLOATS_PER_VERTEX на вершину
+    std::vector<uint16_t> indices;
+    std::vector<PackedVertex> packed; // те же вершины в упакованном формате
+} Mesh;
+
+typedef struct {
+    int source_vertices;
+    int unique_vertices;
+    int index_count;
+    int bytes_per_vertex;
+    int vertex_bytes;
+    int index_bytes;
+    int source_bytes;     // неиндексированный float-вариант
+    float acmr;           // трансформов вершин на треугольник
+    float cache_hit_rate; // доля индексов, попавших в кэш пост-трансформа
+} MeshStats;
+
+// Сваривает побитово одинаковые вершины неиндексированного списка треугольников
+void mesh_build_indexed(Mesh* mesh, const float* vertices, int vertex_count);
+MeshStats mesh_stats(const Mesh* mesh, MeshFormat format, int source_vertices);
+
+// Двоичный меш для пакета ресурсов: заголовок {"VRMS", версия, число вершин, число индексов},
+// затем вершины (MESH_FLOATS_PER_VERTEX float) и индексы uint16. Упакованные вершины строятся при чтении.
+static const uint32_t MESH_BLOB_MAGIC = 0x534d5256; // "VRMS"
+static const uint32_t MESH_BLOB_VERSION = 1;
+
+void mesh_write_blob(const Mesh* mesh, std::vector<unsigned char>* out);
+bool mesh_read_blob(Mesh* mesh, const unsigned char* data, size_t size);
+
+// Параметр --vertex-format float|packed (по умолчанию packed)
+MeshFormat mesh_parse_format(int argc, char** argv);
+// Параметр --export-mesh FILE: записать меш куба для assetpack; NULL — не задан
+const char* mesh_parse_export_path(int argc, char** argv);
+
+// Загружает вершины и индексы выбранного формата в буферы; staging — кольцо загрузки или NULL
+void mesh_upload(const Mesh* mesh, MeshFormat format, GLuint vertex_buffer, GLuint index_buffer, StagingRing* staging = NULL);
+// Атрибуты 0..2 для текущего VAO; vertex_buffer и index_buffer привязываются к нему
+void mesh_setup_attributes(MeshFormat format, GLuint vertex_buffer, GLuint index_buffer);
+
+#endif
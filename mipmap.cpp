@@ -0,0 +1,361 @@
+#include "mipmap.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+static const int MIP_MAX_TAPS = 12;
+static const int MIP_PARALLEL_MIN_PIXELS = 64 * 1024; // меньшие уровни считаются в одном потоке
+static const int SRGB_ENCODE_LUT_SIZE = 4096;
+
+typedef struct {
+    int taps;
+    float weights[MIP_MAX_TAPS];
+} MipKernel;
+
+// Промежуточный уровень: всегда 4 float на пиксель, лишние каналы нулевые
+typedef struct {
+    int width;
+    int height;
+    std::vector<float> data;
+} FloatLevel;
+
+static float srgb_decode_lut[256];
+static unsigned char srgb_encode_lut[SRGB_ENCODE_LUT_SIZE];
+
+static bool build_srgb_luts() {
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        srgb_decode_lut[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < SRGB_ENCODE_LUT_SIZE; i++) {
+        float l = i / (float)(SRGB_ENCODE_LUT_SIZE - 1);
+        float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+        srgb_encode_lut[i] = (unsigned char)(c * 255.0f + 0.5f);
+    }
+    return true;
+}
+
+// Цепочки строятся из нескольких потоков декодера: таблицы заполняет первый из них
+static void init_srgb_luts() {
+    static const bool ready = build_srgb_luts();
+    (void)ready;
+}
+
+static double sinc(double x) {
+    if (fabs(x) < 1e-8)
+        return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Уменьшение ровно в 2 раза: центр выходного пикселя x лежит между исходными 2x и 2x+1,
+// так что расстояния до отсчётов одинаковы для всех x и ядро одно на уровень
+static MipKernel make_kernel(MipFilter filter) {
+    MipKernel kernel;
+    if (filter == MIP_FILTER_BOX) {
+        kernel.taps = 2;
+        kernel.weights[0] = kernel.weights[1] = 0.5f;
+        return kernel;
+    }
+
+    const double radius = 3.0;   // в выходных пикселях
+    const double kaiser_beta = 4.0;
+    kernel.taps = MIP_MAX_TAPS;
+    double sum = 0.0, weights[MIP_MAX_TAPS];
+    for (int k = 0; k < kernel.taps; k++) {
+        double t = ((k - kernel.taps / 2) + 0.5) / 2.0;
+        double window;
+        if (filter == MIP_FILTER_LANCZOS) {
+            window = sinc(t / radius);
+        } else {
+            double r = t / radius;
+            window = bessel_i0(kaiser_beta * sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(kaiser_beta);
+        }
+        weights[k] = sinc(t) * window;
+        sum += weights[k];
+    }
+    for (int k = 0; k < kernel.taps; k++)
+        kernel.weights[k] = (float)(weights[k] / sum);
+    return kernel;
+}
+
+static void parallel_rows(int rows, int row_pixels, unsigned threads, void (*fn)(void*, int, int), void* context) {
+    if (threads <= 1 || rows < 2 || (int64_t)rows * row_pixels < MIP_PARALLEL_MIN_PIXELS) {
+        fn(context, 0, rows);
+        return;
+    }
+    unsigned bands = std::min<unsigned>(threads, (unsigned)rows);
+    std::vector<std::thread> workers;
+    workers.reserve(bands - 1);
+    for (unsigned b = 0; b + 1 < bands; b++)
+        workers.emplace_back(fn, context, (int)(rows * (int64_t)b / bands), (int)(rows * (int64_t)(b + 1) / bands));
+    fn(context, (int)(rows * (int64_t)(bands - 1) / bands), rows);
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+static bool is_alpha_channel(int channels, int c) {
+    return (channels == 2 || channels == 4) && c == channels - 1;
+}
+
+typedef struct {
+    const unsigned char* pixels;
+    int channels;
+    bool srgb;
+    FloatLevel* level;
+} DecodeContext;
+
+static void decode_rows(void* context, int y0, int y1) {
+    DecodeContext* ctx = (DecodeContext*)context;
+    const int width = ctx->level->width;
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* src = ctx->pixels + (size_t)y * width * ctx->channels;
+        float* dst = &ctx->level->data[(size_t)y * width * 4];
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 4; c++) {
+                float value = 0.0f;
+                if (c < ctx->channels) {
+                    unsigned char byte = src[x * ctx->channels + c];
+                    value = ctx->srgb && !is_alpha_channel(ctx->channels, c) ? srgb_decode_lut[byte] : byte / 255.0f;
+                }
+                dst[x * 4 + c] = value;
+            }
+        }
+    }
+}
+
+static inline unsigned char encode_channel(float value, bool srgb) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    if (srgb)
+        return srgb_encode_lut[(int)(value * (SRGB_ENCODE_LUT_SIZE - 1) + 0.5f)];
+    return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+// Горизонтальный проход: строка исходного уровня -> строка шириной out_width
+static void filter_row_scalar(const float* src, int src_width, float* dst, int out_width, const MipKernel* kernel) {
+    const int half = kernel->taps / 2;
+    for (int x = 0; x < out_width; x++) {
+        float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        int first = 2 * x - half + 1;
+        for (int k = 0; k < kernel->taps; k++) {
+            int sx = std::clamp(first + k, 0, src_width - 1);
+            for (int c = 0; c < 4; c++)
+                acc[c] += kernel->weights[k] * src[sx * 4 + c];
+        }
+        memcpy(dst + x * 4, acc, sizeof(acc));
+    }
+}
+
+// Вертикальный проход: взвешенная сумма taps строк, каждая по count float
+static void filter_columns_scalar(const float* const* rows, const MipKernel* kernel, float* dst, int count) {
+    for (int i = 0; i < count; i++) {
+        float acc = 0.0f;
+        for (int k = 0; k < kernel->taps; k++)
+            acc += kernel->weights[k] * rows[k][i];
+        dst[i] = acc;
+    }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+// Пиксель RGBA float — ровно один __m128, поэтому горизонтальный проход векторизуется по каналам
+static void filter_row_simd(const float* src, int src_width, float* dst, int out_width, const MipKernel* kernel) {
+    const int half = kernel->taps / 2;
+    __m128 weights[MIP_MAX_TAPS];
+    for (int k = 0; k < kernel->taps; k++)
+        weights[k] = _mm_set1_ps(kernel->weights[k]);
+
+    for (int x = 0; x < out_width; x++) {
+        int first = 2 * x - half + 1;
+        __m128 acc = _mm_setzero_ps();
+        if (first >= 0 && first + kernel->taps <= src_width) {
+            const float* p = src + first * 4;
+            for (int k = 0; k < kernel->taps; k++)
+                acc = _mm_add_ps(acc, _mm_mul_ps(weights[k], _mm_loadu_ps(p + k * 4)));
+        } else {
+            for (int k = 0; k < kernel->taps; k++) {
+                int sx = std::clamp(first + k, 0, src_width - 1);
+                acc = _mm_add_ps(acc, _mm_mul_ps(weights[k], _mm_loadu_ps(src + sx * 4)));
+            }
+        }
+        _mm_storeu_ps(dst + x * 4, acc);
+    }
+}
+
+static void filter_columns_simd(const float* const* rows, const MipKernel* kernel, float* dst, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < kernel->taps; k++)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(kernel->weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(dst + i, acc);
+    }
+#endif
+    for (; i + 4 <= count; i += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < kernel->taps; k++)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(kernel->weights[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(dst + i, acc);
+    }
+    for (; i < count; i++) {
+        float acc = 0.0f;
+        for (int k = 0; k < kernel->taps; k++)
+            acc += kernel->weights[k] * rows[k][i];
+        dst[i] = acc;
+    }
+}
+#define MIP_HAVE_SIMD 1
+#endif
+
+typedef struct {
+    const FloatLevel* src;
+    FloatLevel* dst;
+    MipLevel* out;
+    int channels;
+    bool srgb;
+    bool simd;
+    MipKernel kernel;
+} DownsampleContext;
+
+static void downsample_rows(void* context, int y0, int y1) {
+    DownsampleContext* ctx = (DownsampleContext*)context;
+    const FloatLevel* src = ctx->src;
+    FloatLevel* dst = ctx->dst;
+    const int half = ctx->kernel.taps / 2;
+    const int row_floats = dst->width * 4;
+
+    void (*filter_row)(const float*, int, float*, int, const MipKernel*) = filter_row_scalar;
+    void (*filter_columns)(const float* const*, const MipKernel*, float*, int) = filter_columns_scalar;
+#ifdef MIP_HAVE_SIMD
+    if (ctx->simd) {
+        filter_row = filter_row_simd;
+        filter_columns = filter_columns_simd;
+    }
+#endif
+
+    // Горизонтально фильтруем только строки, нужные полосе (соседние полосы пересчитывают края)
+    int first_row = std::max(0, 2 * y0 - half + 1);
+    int last_row = std::min(src->height - 1, 2 * (y1 - 1) - half + ctx->kernel.taps);
+    std::vector<float> band((size_t)(last_row - first_row + 1) * row_floats);
+    for (int sy = first_row; sy <= last_row; sy++)
+        filter_row(&src->data[(size_t)sy * src->width * 4], src->width, &band[(size_t)(sy - first_row) * row_floats], dst->width, &ctx->kernel);
+
+    const float* rows[MIP_MAX_TAPS];
+    for (int y = y0; y < y1; y++) {
+        int first = 2 * y - half + 1;
+        for (int k = 0; k < ctx->kernel.taps; k++) {
+            int sy = std::clamp(first + k, 0, src->height - 1);
+            rows[k] = &band[(size_t)(sy - first_row) * row_floats];
+        }
+        float* dst_row = &dst->data[(size_t)y * row_floats];
+        filter_columns(rows, &ctx->kernel, dst_row, row_floats);
+
+        unsigned char* out_row = &ctx->out->pixels[(size_t)y * dst->width * ctx->channels];
+        for (int x = 0; x < dst->width; x++) {
+            for (int c = 0; c < ctx->channels; c++)
+                out_row[x * ctx->channels + c] = encode_channel(dst_row[x * 4 + c], ctx->srgb && !is_alpha_channel(ctx->channels, c));
+        }
+    }
+}
+
+MipOptions mip_default_options() {
+    MipOptions options;
+    options.filter = MIP_FILTER_KAISER;
+    options.srgb = true;
+    options.threads = 0;
+    options.simd = true;
+    options.level_ready = NULL;
+    options.level_ready_user = NULL;
+    return options;
+}
+
+int mip_level_count(int width, int height) {
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void mip_build_chain(MipChain* chain, const unsigned char* pixels, int width, int height, int channels, const MipOptions* options) {
+    chain->channels = channels;
+    chain->levels.clear();
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+        return;
+    init_srgb_luts();
+
+    unsigned threads = options->threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    FloatLevel current;
+    current.width = width;
+    current.height = height;
+    current.data.resize((size_t)width * height * 4);
+    DecodeContext decode = { pixels, channels, options->srgb, &current };
+    parallel_rows(height, width, threads, decode_rows, &decode);
+
+    chain->levels.resize(mip_level_count(width, height) - 1);
+    MipKernel kernel = make_kernel(options->filter);
+    FloatLevel next;
+    for (MipLevel& level : chain->levels) {
+        next.width = level.width = std::max(1, current.width / 2);
+        next.height = level.height = std::max(1, current.height / 2);
+        next.data.resize((size_t)next.width * next.height * 4);
+        level.pixels.resize((size_t)level.width * level.height * channels);
+
+        DownsampleContext context = { &current, &next, &level, channels, options->srgb, options->simd, kernel };
+        parallel_rows(next.height, next.width, threads, downsample_rows, &context);
+        std::swap(current, next);
+        if (options->level_ready)
+            options->level_ready(options->level_ready_user, (int)(&level - chain->levels.data()) + 1, &level);
+    }
+}
+
+MipFilter mip_parse_filter(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--mip-filter") == 0) {
+            if (strcmp(argv[i + 1], "box") == 0)
+                return MIP_FILTER_BOX;
+            if (strcmp(argv[i + 1], "lanczos") == 0)
+                return MIP_FILTER_LANCZOS;
+            return MIP_FILTER_KAISER;
+        }
+    }
+    return MIP_FILTER_KAISER;
+}
+
+const char* mip_filter_name(MipFilter filter) {
+    switch (filter) {
+        case MIP_FILTER_BOX: return "box";
+        case MIP_FILTER_LANCZOS: return "lanczos";
+        default: return "kaiser";
+    }
+}
+
+const char* mip_simd_name() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(MIP_HAVE_SIMD)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
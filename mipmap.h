@@ -0,0 +1,53 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <stdint.h>
+#include <vector>
+
+// Построение мип-цепочки на CPU вместо glGenerateMipmap: фильтрация в линейном
+// пространстве (sRGB декодируется и кодируется обратно), разделимые фильтры,
+// полосы строк каждого уровня считаются параллельно. От OpenGL не зависит.
+
+typedef enum {
+    MIP_FILTER_BOX,     // 2x2 среднее
+    MIP_FILTER_KAISER,  // sinc с окном Кайзера, 12 отсчётов
+    MIP_FILTER_LANCZOS  // Lanczos3, 12 отсчётов
+} MipFilter;
+
+typedef struct {
+    int width;
+    int height;
+    std::vector<unsigned char> pixels; // channels байт на пиксель, строки без выравнивания
+} MipLevel;
+
+typedef struct {
+    int channels;
+    std::vector<MipLevel> levels; // уровни 1..N; уровень 0 — исходное изображение
+} MipChain;
+
+typedef struct {
+    MipFilter filter;
+    bool srgb;        // цветовые каналы в sRGB; альфа всегда линейна
+    unsigned threads; // 0 — по числу ядер
+    bool simd;        // false — скалярная эталонная реализация
+    // Вызывается сразу после готовности каждого уровня 1..N, пока строятся следующие
+    // (например, чтобы сжимать уровни потоково). mip живёт, пока жива цепочка.
+    void (*level_ready)(void* user, int level, const MipLevel* mip);
+    void* level_ready_user;
+} MipOptions;
+
+MipOptions mip_default_options();
+
+// Полная цепочка до 1x1; channels от 1 до 4
+void mip_build_chain(MipChain* chain, const unsigned char* pixels, int width, int height, int channels, const MipOptions* options);
+
+// Число уровней вместе с нулевым
+int mip_level_count(int width, int height);
+
+// Параметр --mip-filter box|kaiser|lanczos (по умолчанию kaiser)
+MipFilter mip_parse_filter(int argc, char** argv);
+const char* mip_filter_name(MipFilter filter);
+// Набор инструкций, с которым собраны SIMD-ядра
+const char* mip_simd_name();
+
+#endif
@@ -0,0 +1,76 @@
+// Бенчмарк построения мип-цепочек: скалярная эталонная реализация против SIMD,
+// в одном потоке и на всех ядрах. Пропускная способность — мегапиксели уровня 0 в секунду.
+//   mipbench [image] [iterations]
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "mipmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+static const char* const DEFAULT_IMAGE = "D:/vr/zad3/wood-2045380_1280.jpg";
+static const int DEFAULT_ITERATIONS = 10;
+
+static double run(const unsigned char* pixels, int width, int height, int channels, const MipOptions* options, int iterations, MipChain* chain) {
+    mip_build_chain(chain, pixels, width, height, channels, options); // прогрев
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        mip_build_chain(chain, pixels, width, height, channels, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)width * height * iterations / 1.0e6 / seconds;
+}
+
+static bool chains_equal(const MipChain* a, const MipChain* b) {
+    if (a->levels.size() != b->levels.size())
+        return false;
+    for (size_t i = 0; i < a->levels.size(); i++) {
+        if (a->levels[i].pixels != b->levels[i].pixels)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : DEFAULT_IMAGE;
+    int iterations = argc > 2 ? atoi(argv[2]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+        iterations = DEFAULT_ITERATIONS;
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(path, &width, &height, &channels, 0);
+    if (!pixels) {
+        fprintf(stderr, "Failed to load %s (%s)\n", path, stbi_failure_reason());
+        return 1;
+    }
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    printf("%s: %dx%d, %d channels, %d levels, SIMD kernels: %s, %u threads\n",
+           path, width, height, channels, mip_level_count(width, height), mip_simd_name(), cores);
+
+    const MipFilter filters[] = { MIP_FILTER_BOX, MIP_FILTER_KAISER, MIP_FILTER_LANCZOS };
+    bool mismatch = false;
+    for (MipFilter filter : filters) {
+        MipOptions options = mip_default_options();
+        options.filter = filter;
+
+        MipChain reference, chain;
+        options.simd = false;
+        options.threads = 1;
+        double scalar = run(pixels, width, height, channels, &options, iterations, &reference);
+        options.simd = true;
+        double simd = run(pixels, width, height, channels, &options, iterations, &chain);
+        bool match = chains_equal(&reference, &chain);
+        options.threads = cores;
+        double threaded = run(pixels, width, height, channels, &options, iterations, &chain);
+        match = match && chains_equal(&reference, &chain);
+        mismatch |= !match;
+
+        printf("%-8s scalar %8.1f MP/s | %s %8.1f MP/s (x%.2f) | %s x%u %8.1f MP/s (x%.2f) | %s\n",
+               mip_filter_name(filter), scalar, mip_simd_name(), simd, simd / scalar,
+               mip_simd_name(), cores, threaded, threaded / scalar, match ? "bit-exact" : "MISMATCH");
+    }
+
+    stbi_image_free(pixels);
+    return mismatch ? 1 : 0;
+}
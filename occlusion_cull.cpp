@@ -0,0 +1,527 @@
+#include "occlusion_cull.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+// Как в transform.cpp: AVX2-ядро собирается всегда, выбор — через transform_best_kernel()
+#define OCCLUSION_HAVE_AVX2 1
+#define OCCLUSION_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_HAVE_SSE2 1
+#endif
+
+// Треугольник после подготовки, в пикселях буфера (центр пикселя — +0.5)
+typedef struct {
+    float edge[3][3];  // A x + B y + C >= 0 — пиксель целиком внутри ребра
+    float depth[3];    // A x + B y + C — самая дальняя глубина плоскости в пределах пикселя
+    int min_x, min_y;  // пиксели, включительно
+    int max_x, max_y;
+} RasterTriangle;
+
+typedef enum {
+    OCCLUSION_JOB_RASTER,
+    OCCLUSION_JOB_TEST
+} OcclusionJob;
+
+struct OcclusionCuller {
+    int width;
+    int height;
+    int tiles_x;
+    int tiles_y;
+    glm::mat4 view_projection;
+    std::vector<glm::vec4> clip;               // вершины текущего окклюдера
+    std::vector<RasterTriangle> triangles;
+    std::vector<std::vector<uint32_t>> bins;   // по плиткам: номера треугольников
+    std::vector<std::vector<float>> levels;    // Hi-Z; levels[0] — сам буфер глубины
+    std::vector<int> level_width;
+    std::vector<int> level_height;
+    std::chrono::steady_clock::time_point frame_start;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable job_done;
+    uint64_t generation;                       // под mutex: номер текущей работы
+    int pending;                               // под mutex: рабочих, которые ещё не закончили
+    bool stopping;
+    OcclusionJob job;                          // текущая работа; пишется до generation++
+    TransformKernel kernel;
+    std::atomic<int> next_tile;
+    const BoundsSoA* test_bounds;
+    const uint32_t* test_objects;
+    size_t test_count;
+    size_t test_part_size;
+    size_t test_parts;
+    std::vector<uint8_t> keep;                 // по проверяемым объектам
+    OcclusionCullStats stats;
+};
+
+static void raster_scalar(const RasterTriangle* t, float* depth, int stride, int x0, int x1, int y0, int y1) {
+    for (int y = y0; y <= y1; y++) {
+        float fy = (float)y + 0.5f;
+        float row[3], row_z = t->depth[1] * fy + t->depth[2];
+        for (int i = 0; i < 3; i++)
+            row[i] = t->edge[i][1] * fy + t->edge[i][2];
+        float* line = depth + (size_t)y * stride;
+        for (int x = x0; x <= x1; x++) {
+            float fx = (float)x + 0.5f;
+            bool inside = t->edge[0][0] * fx + row[0] >= 0.0f && t->edge[1][0] * fx + row[1] >= 0.0f &&
+                          t->edge[2][0] * fx + row[2] >= 0.0f;
+            float z = t->depth[0] * fx + row_z;
+            if (inside && z < line[x])
+                line[x] = z;
+        }
+    }
+}
+
+#ifdef OCCLUSION_HAVE_SSE2
+// Строка идёт пакетами по 4 пикселя от x0, выровненного вниз: плитка кратна пакету,
+// лишние пиксели слева лежат в той же плитке и отсекаются рёбрами
+static void raster_sse2(const RasterTriangle* t, float* depth, int stride, int x0, int x1, int y0, int y1) {
+    x0 &= ~3;
+    const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 step = _mm_set1_ps(4.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 a[3];
+    for (int i = 0; i < 3; i++)
+        a[i] = _mm_set1_ps(t->edge[i][0]);
+    const __m128 za = _mm_set1_ps(t->depth[0]);
+    for (int y = y0; y <= y1; y++) {
+        float fy = (float)y + 0.5f;
+        __m128 row[3];
+        for (int i = 0; i < 3; i++)
+            row[i] = _mm_set1_ps(t->edge[i][1] * fy + t->edge[i][2]);
+        __m128 row_z = _mm_set1_ps(t->depth[1] * fy + t->depth[2]);
+        __m128 xs = _mm_add_ps(_mm_set1_ps((float)x0), lane);
+        float* line = depth + (size_t)y * stride;
+        for (int x = x0; x <= x1; x += 4, xs = _mm_add_ps(xs, step)) {
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a[0], xs), row[0]), zero),
+                                       _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a[1], xs), row[1]), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a[2], xs), row[2]), zero));
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+            __m128 old = _mm_loadu_ps(line + x);
+            __m128 z = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(za, xs), row_z));
+            _mm_storeu_ps(line + x, _mm_or_ps(_mm_and_ps(inside, z), _mm_andnot_ps(inside, old)));
+        }
+    }
+}
+#endif
+
+#ifdef OCCLUSION_HAVE_AVX2
+OCCLUSION_AVX2_TARGET static void raster_avx2(const RasterTriangle* t, float* depth, int stride, int x0, int x1, int y0, int y1) {
+    x0 &= ~7;
+    const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 step = _mm256_set1_ps(8.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 a[3];
+    for (int i = 0; i < 3; i++)
+        a[i] = _mm256_set1_ps(t->edge[i][0]);
+    const __m256 za = _mm256_set1_ps(t->depth[0]);
+    for (int y = y0; y <= y1; y++) {
+        float fy = (float)y + 0.5f;
+        __m256 row[3];
+        for (int i = 0; i < 3; i++)
+            row[i] = _mm256_set1_ps(t->edge[i][1] * fy + t->edge[i][2]);
+        __m256 row_z = _mm256_set1_ps(t->depth[1] * fy + t->depth[2]);
+        __m256 xs = _mm256_add_ps(_mm256_set1_ps((float)x0), lane);
+        float* line = depth + (size_t)y * stride;
+        for (int x = x0; x <= x1; x += 8, xs = _mm256_add_ps(xs, step)) {
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_fmadd_ps(a[0], xs, row[0]), zero, _CMP_GE_OQ),
+                                          _mm256_cmp_ps(_mm256_fmadd_ps(a[1], xs, row[1]), zero, _CMP_GE_OQ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_fmadd_ps(a[2], xs, row[2]), zero, _CMP_GE_OQ));
+            if (_mm256_movemask_ps(inside) == 0)
+                continue;
+            __m256 old = _mm256_loadu_ps(line + x);
+            __m256 z = _mm256_min_ps(old, _mm256_fmadd_ps(za, xs, row_z));
+            _mm256_storeu_ps(line + x, _mm256_blendv_ps(old, z, inside));
+        }
+    }
+}
+#endif
+
+// Тексель уровня level — самая дальняя глубина своих 2x2 на уровне ниже; нечётный край берётся один раз
+static void downsample(OcclusionCuller* culler, int level, int x0, int y0, int x1, int y1) {
+    const std::vector<float>& src = culler->levels[level - 1];
+    std::vector<float>& dst = culler->levels[level];
+    int src_width = culler->level_width[level - 1];
+    int src_height = culler->level_height[level - 1];
+    int dst_width = culler->level_width[level];
+    for (int y = y0; y < y1; y++) {
+        int sy0 = y * 2, sy1 = std::min(y * 2 + 1, src_height - 1);
+        for (int x = x0; x < x1; x++) {
+            int sx0 = x * 2, sx1 = std::min(x * 2 + 1, src_width - 1);
+            float far_depth = std::max(std::max(src[(size_t)sy0 * src_width + sx0], src[(size_t)sy0 * src_width + sx1]),
+                                       std::max(src[(size_t)sy1 * src_width + sx0], src[(size_t)sy1 * src_width + sx1]));
+            dst[(size_t)y * dst_width + x] = far_depth;
+        }
+    }
+}
+
+// Плитка целиком: очистка, треугольники из корзины и уровни Hi-Z, не выходящие за плитку
+static void raster_tile(OcclusionCuller* culler, int tile) {
+    int tile_x = tile % culler->tiles_x * OCCLUSION_TILE_WIDTH;
+    int tile_y = tile / culler->tiles_x * OCCLUSION_TILE_HEIGHT;
+    float* depth = culler->levels[0].data();
+    for (int y = tile_y; y < tile_y + OCCLUSION_TILE_HEIGHT; y++)
+        std::fill_n(depth + (size_t)y * culler->width + tile_x, OCCLUSION_TILE_WIDTH, 1.0f);
+
+    for (uint32_t index : culler->bins[tile]) {
+        const RasterTriangle* t = &culler->triangles[index];
+        int x0 = std::max(t->min_x, tile_x), x1 = std::min(t->max_x, tile_x + OCCLUSION_TILE_WIDTH - 1);
+        int y0 = std::max(t->min_y, tile_y), y1 = std::min(t->max_y, tile_y + OCCLUSION_TILE_HEIGHT - 1);
+        switch (culler->kernel) {
+#ifdef OCCLUSION_HAVE_AVX2
+        case TRANSFORM_KERNEL_AVX2:
+            raster_avx2(t, depth, culler->width, x0, x1, y0, y1);
+            break;
+#endif
+#ifdef OCCLUSION_HAVE_SSE2
+        case TRANSFORM_KERNEL_SSE2:
+            raster_sse2(t, depth, culler->width, x0, x1, y0, y1);
+            break;
+#endif
+        default:
+            raster_scalar(t, depth, culler->width, x0, x1, y0, y1);
+            break;
+        }
+    }
+
+    int levels = std::min(OCCLUSION_TILE_LEVELS, (int)culler->levels.size() - 1);
+    for (int level = 1; level <= levels; level++)
+        downsample(culler, level, tile_x >> level, tile_y >> level, (tile_x + OCCLUSION_TILE_WIDTH) >> level,
+                   (tile_y + OCCLUSION_TILE_HEIGHT) >> level);
+}
+
+// Видим ли AABB: проекция восьми углов, прямоугольник на экране и ближайшая глубина
+// против самой дальней глубины окклюдеров под ним
+static bool test_object(const OcclusionCuller* culler, const float center[3], const float extent[3]) {
+    const glm::mat4& vp = culler->view_projection;
+    glm::vec4 c = vp * glm::vec4(center[0], center[1], center[2], 1.0f);
+    glm::vec4 axis[3] = { vp[0] * extent[0], vp[1] * extent[1], vp[2] * extent[2] };
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX, min_z = FLT_MAX;
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec4 p = c;
+        for (int k = 0; k < 3; k++)
+            p += ((corner >> k) & 1) ? axis[k] : -axis[k];
+        // Угол перед ближней плоскостью: проекция не определена — считаем видимым
+        if (p.w <= 0.0f || p.z < -p.w)
+            return true;
+        float inv_w = 1.0f / p.w;
+        min_x = std::min(min_x, p.x * inv_w);
+        max_x = std::max(max_x, p.x * inv_w);
+        min_y = std::min(min_y, p.y * inv_w);
+        max_y = std::max(max_y, p.y * inv_w);
+        min_z = std::min(min_z, p.z * inv_w);
+    }
+    if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f)
+        return true; // вне экрана — дело frustum_cull
+    int x0 = std::max(0, (int)floorf((min_x * 0.5f + 0.5f) * culler->width));
+    int x1 = std::min(culler->width - 1, (int)floorf((max_x * 0.5f + 0.5f) * culler->width));
+    int y0 = std::max(0, (int)floorf((min_y * 0.5f + 0.5f) * culler->height));
+    int y1 = std::min(culler->height - 1, (int)floorf((max_y * 0.5f + 0.5f) * culler->height));
+    float nearest = min_z * 0.5f + 0.5f;
+
+    int level = 0, top = (int)culler->levels.size() - 1;
+    while (level < top && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+        level++;
+    const float* hiz = culler->levels[level].data();
+    int level_width = culler->level_width[level];
+    for (int y = y0 >> level; y <= y1 >> level; y++)
+        for (int x = x0 >> level; x <= x1 >> level; x++)
+            if (hiz[(size_t)y * level_width + x] >= nearest)
+                return true;
+    return false;
+}
+
+static void test_part(OcclusionCuller* culler, size_t part) {
+    size_t first = std::min(culler->test_count, part * culler->test_part_size);
+    size_t last = std::min(culler->test_count, first + culler->test_part_size);
+    const BoundsSoA* bounds = culler->test_bounds;
+    for (size_t i = first; i < last; i++) {
+        uint32_t object = culler->test_objects[i];
+        float center[3] = { bounds->center[0][object], bounds->center[1][object], bounds->center[2][object] };
+        float extent[3] = { bounds->extent[0][object], bounds->extent[1][object], bounds->extent[2][object] };
+        culler->keep[i] = test_object(culler, center, extent) ? 1 : 0;
+    }
+}
+
+static void run_job(OcclusionCuller* culler, size_t worker) {
+    if (culler->job == OCCLUSION_JOB_RASTER) {
+        int tiles = culler->tiles_x * culler->tiles_y;
+        for (int tile = culler->next_tile++; tile < tiles; tile = culler->next_tile++)
+            raster_tile(culler, tile);
+    } else if (worker < culler->test_parts) {
+        test_part(culler, worker);
+    }
+}
+
+static void worker_main(OcclusionCuller* culler, size_t worker) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(culler->mutex);
+    for (;;) {
+        culler->work_ready.wait(lock, [culler, seen] { return culler->stopping || culler->generation != seen; });
+        if (culler->stopping)
+            return;
+        seen = culler->generation;
+        lock.unlock();
+        run_job(culler, worker);
+        lock.lock();
+        if (--culler->pending == 0)
+            culler->job_done.notify_one();
+    }
+}
+
+// Работа на всех потоках; вызывающий — поток 0
+static void run_parallel(OcclusionCuller* culler, OcclusionJob job, bool parallel) {
+    culler->job = job;
+    if (!parallel || culler->workers.empty()) {
+        run_job(culler, 0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(culler->mutex);
+        culler->pending = (int)culler->workers.size();
+        culler->generation++;
+    }
+    culler->work_ready.notify_all();
+    run_job(culler, 0);
+    std::unique_lock<std::mutex> lock(culler->mutex);
+    culler->job_done.wait(lock, [culler] { return culler->pending == 0; });
+}
+
+OcclusionCuller* occlusion_cull_create(int width, int height, unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    OcclusionCuller* culler = new OcclusionCuller();
+    culler->tiles_x = std::max(1, (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH);
+    culler->tiles_y = std::max(1, (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT);
+    culler->width = culler->tiles_x * OCCLUSION_TILE_WIDTH;
+    culler->height = culler->tiles_y * OCCLUSION_TILE_HEIGHT;
+    culler->bins.resize((size_t)culler->tiles_x * culler->tiles_y);
+    for (int w = culler->width, h = culler->height;; w = (w + 1) / 2, h = (h + 1) / 2) {
+        culler->level_width.push_back(w);
+        culler->level_height.push_back(h);
+        culler->levels.emplace_back((size_t)w * h, 1.0f);
+        if (w == 1 && h == 1)
+            break;
+    }
+    culler->view_projection = glm::mat4(1.0f);
+    culler->generation = 0;
+    culler->pending = 0;
+    culler->stopping = false;
+    culler->job = OCCLUSION_JOB_RASTER;
+    culler->kernel = TRANSFORM_KERNEL_SCALAR;
+    culler->next_tile = 0;
+    culler->test_bounds = NULL;
+    culler->test_objects = NULL;
+    culler->test_count = culler->test_part_size = culler->test_parts = 0;
+    memset(&culler->stats, 0, sizeof(culler->stats));
+    for (unsigned i = 1; i < threads; i++)
+        culler->workers.emplace_back(worker_main, culler, (size_t)i);
+    return culler;
+}
+
+void occlusion_cull_destroy(OcclusionCuller* culler) {
+    if (!culler)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(culler->mutex);
+        culler->stopping = true;
+    }
+    culler->work_ready.notify_all();
+    for (std::thread& worker : culler->workers)
+        worker.join();
+    delete culler;
+}
+
+unsigned occlusion_cull_threads(const OcclusionCuller* culler) {
+    return culler ? (unsigned)culler->workers.size() + 1 : 0;
+}
+
+void occlusion_select_occluders(const glm::mat4& view_projection, const BoundsSoA* bounds, const std::vector<uint32_t>& visible,
+                                int max_count, std::vector<uint32_t>* occluders) {
+    occluders->clear();
+    if (max_count <= 0)
+        return;
+    // Ряд w матрицы: расстояние до центра вдоль взгляда
+    const glm::vec4 row_w(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+    std::vector<std::pair<float, uint32_t>> candidates;
+    candidates.reserve(visible.size());
+    for (uint32_t object : visible) {
+        float size = bounds->extent[0][object] + bounds->extent[1][object] + bounds->extent[2][object];
+        float w = row_w.x * bounds->center[0][object] + row_w.y * bounds->center[1][object] +
+                  row_w.z * bounds->center[2][object] + row_w.w;
+        // Пересекающие ближнюю плоскость отбросила бы растеризация — не тратим на них место
+        if (w <= size)
+            continue;
+        candidates.push_back({ -size / w, object });
+    }
+    size_t count = std::min(candidates.size(), (size_t)max_count);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+    for (size_t i = 0; i < count; i++)
+        occluders->push_back(candidates[i].second);
+}
+
+void occlusion_cull_begin(OcclusionCuller* culler, const glm::mat4& view_projection) {
+    culler->frame_start = std::chrono::steady_clock::now();
+    culler->view_projection = view_projection;
+    culler->triangles.clear();
+    for (std::vector<uint32_t>& bin : culler->bins)
+        bin.clear();
+}
+
+void occlusion_cull_add_occluder(OcclusionCuller* culler, const OccluderMesh* mesh, const glm::mat4& mvp) {
+    culler->stats.occluders++;
+    culler->clip.resize(mesh->vertex_count);
+    for (int v = 0; v < mesh->vertex_count; v++) {
+        const float* p = mesh->positions + (size_t)v * mesh->stride;
+        culler->clip[v] = mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+    }
+
+    const float width = (float)culler->width, height = (float)culler->height;
+    for (int i = 0; i + 2 < mesh->index_count; i += 3) {
+        const glm::vec4* v[3] = { &culler->clip[mesh->indices[i]], &culler->clip[mesh->indices[i + 1]],
+                                  &culler->clip[mesh->indices[i + 2]] };
+        // Треугольник у ближней плоскости не клиппируется, а пропускается: меньше окклюдеров — не ошибка
+        float sx[3], sy[3], sz[3];
+        bool skip = false;
+        for (int k = 0; k < 3; k++) {
+            if (v[k]->w <= 0.0f || v[k]->z < -v[k]->w) {
+                skip = true;
+                break;
+            }
+            float inv_w = 1.0f / v[k]->w;
+            sx[k] = (v[k]->x * inv_w * 0.5f + 0.5f) * width;
+            sy[k] = (v[k]->y * inv_w * 0.5f + 0.5f) * height;
+            sz[k] = v[k]->z * inv_w * 0.5f + 0.5f;
+        }
+        if (skip)
+            continue;
+
+        float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+        if (fabsf(area) < 1e-6f)
+            continue;
+        if (area < 0.0f) {
+            // Окклюдеры двусторонние: обход приводим к положительной площади
+            std::swap(sx[1], sx[2]);
+            std::swap(sy[1], sy[2]);
+            std::swap(sz[1], sz[2]);
+            area = -area;
+        }
+
+        // Пиксель [x, x + 1) целиком внутри только между ceil(min) и floor(max) - 1
+        float lo_x = std::max(-1.0f, std::min(sx[0], std::min(sx[1], sx[2])));
+        float hi_x = std::min(width + 1.0f, std::max(sx[0], std::max(sx[1], sx[2])));
+        float lo_y = std::max(-1.0f, std::min(sy[0], std::min(sy[1], sy[2])));
+        float hi_y = std::min(height + 1.0f, std::max(sy[0], std::max(sy[1], sy[2])));
+        RasterTriangle t;
+        t.min_x = std::max(0, (int)ceilf(lo_x));
+        t.max_x = std::min(culler->width - 1, (int)floorf(hi_x) - 1);
+        t.min_y = std::max(0, (int)ceilf(lo_y));
+        t.max_y = std::min(culler->height - 1, (int)floorf(hi_y) - 1);
+        if (t.min_x > t.max_x || t.min_y > t.max_y)
+            continue;
+
+        // Рёбра сдвинуты внутрь на полпикселя по норме: проверка центра означает пиксель целиком
+        for (int k = 0; k < 3; k++) {
+            int a = k, b = (k + 1) % 3;
+            float A = sy[a] - sy[b], B = sx[b] - sx[a];
+            t.edge[k][0] = A;
+            t.edge[k][1] = B;
+            t.edge[k][2] = sx[a] * sy[b] - sx[b] * sy[a] - 0.5f * (fabsf(A) + fabsf(B));
+        }
+        float dz1 = sz[1] - sz[0], dz2 = sz[2] - sz[0];
+        t.depth[0] = (dz1 * (sy[2] - sy[0]) - dz2 * (sy[1] - sy[0])) / area;
+        t.depth[1] = ((sx[1] - sx[0]) * dz2 - (sx[2] - sx[0]) * dz1) / area;
+        t.depth[2] = sz[0] - t.depth[0] * sx[0] - t.depth[1] * sy[0] + 0.5f * (fabsf(t.depth[0]) + fabsf(t.depth[1]));
+
+        uint32_t index = (uint32_t)culler->triangles.size();
+        culler->triangles.push_back(t);
+        for (int ty = t.min_y / OCCLUSION_TILE_HEIGHT; ty <= t.max_y / OCCLUSION_TILE_HEIGHT; ty++)
+            for (int tx = t.min_x / OCCLUSION_TILE_WIDTH; tx <= t.max_x / OCCLUSION_TILE_WIDTH; tx++) {
+                culler->bins[(size_t)ty * culler->tiles_x + tx].push_back(index);
+                culler->stats.tile_triangles++;
+            }
+    }
+}
+
+void occlusion_cull_rasterize(OcclusionCuller* culler, TransformKernel kernel) {
+    culler->kernel = std::min(kernel, transform_best_kernel());
+    culler->next_tile = 0;
+    run_parallel(culler, OCCLUSION_JOB_RASTER, true);
+    // Верхние уровни меньше плитки — их достраивает вызывающий поток
+    for (int level = OCCLUSION_TILE_LEVELS + 1; level < (int)culler->levels.size(); level++)
+        downsample(culler, level, 0, 0, culler->level_width[level], culler->level_height[level]);
+    culler->stats.triangles += culler->triangles.size();
+    culler->stats.raster_ns +=
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - culler->frame_start).count();
+}
+
+size_t occlusion_cull_test(OcclusionCuller* culler, const BoundsSoA* bounds, std::vector<uint32_t>* visible) {
+    auto start = std::chrono::steady_clock::now();
+    size_t count = visible->size();
+    culler->test_bounds = bounds;
+    culler->test_objects = visible->data();
+    culler->test_count = count;
+    culler->test_parts = count >= OCCLUSION_TEST_PARALLEL_MIN ? culler->workers.size() + 1 : 1;
+    culler->test_part_size = (count + culler->test_parts - 1) / culler->test_parts;
+    culler->keep.resize(count);
+    run_parallel(culler, OCCLUSION_JOB_TEST, culler->test_parts > 1);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        (*visible)[kept] = (*visible)[i];
+        kept += culler->keep[i];
+    }
+    visible->resize(kept);
+
+    culler->stats.frames++;
+    culler->stats.tested += count;
+    culler->stats.occluded += count - kept;
+    culler->stats.test_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return kept;
+}
+
+float occlusion_cull_depth(const OcclusionCuller* culler, int x, int y) {
+    return culler->levels[0][(size_t)y * culler->width + x];
+}
+
+void occlusion_cull_size(const OcclusionCuller* culler, int* width, int* height) {
+    *width = culler->width;
+    *height = culler->height;
+}
+
+OcclusionCullStats occlusion_cull_stats(const OcclusionCuller* culler) {
+    OcclusionCullStats stats = {};
+    return culler ? culler->stats : stats;
+}
+
+OcclusionCullOptions occlusion_cull_parse(int argc, char** argv) {
+    OcclusionCullOptions options = { false, OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT, OCCLUSION_DEFAULT_OCCLUDERS };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--occlusion") == 0) {
+            options.enabled = true;
+        } else if (strcmp(argv[i], "--occlusion-size") == 0 && i + 1 < argc) {
+            int width, height;
+            if (sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                options.width = width;
+                options.height = height;
+            }
+        } else if (strcmp(argv[i], "--occluders") == 0 && i + 1 < argc) {
+            options.occluders = std::max(0, atoi(argv[++i]));
+        }
+    }
+    return options;
+}
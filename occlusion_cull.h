@@ -0,0 +1,83 @@
+#ifndef OCCLUSION_CULL_H
+#define OCCLUSION_CULL_H
+
+#include "frustum_cull.h"
+#include "transform.h"
+#include <stdint.h>
+#include <vector>
+
+// Программное отсечение перекрытых объектов, без GPU. Несколько ближних окклюдеров
+// растеризуются в маленький буфер глубины (по умолчанию 256x128): треугольники
+// раскладываются по корзинам плиток, плитки разбирают рабочие потоки, строка плитки
+// считается SIMD-ядром (8 пикселей AVX2, 4 — SSE2). Растеризация консервативная:
+// пиксель закрашивается, только если целиком внутри треугольника, и получает самую
+// дальнюю глубину плоскости треугольника в его пределах. Над буфером строится
+// иерархический Z (в каждом текселе — самая дальняя глубина блока), и AABB объекта
+// проверяется по нескольким текселям уровня, где его прямоугольник не шире четырёх.
+// Объект отбрасывается, только если он целиком дальше окклюдеров — ложных отсечений нет.
+
+static const int OCCLUSION_TILE_WIDTH = 32;       // кратно ширине AVX2-пакета
+static const int OCCLUSION_TILE_HEIGHT = 16;
+static const int OCCLUSION_TILE_LEVELS = 4;       // уровни Hi-Z, которые строятся внутри плитки
+static const int OCCLUSION_DEFAULT_WIDTH = 256;
+static const int OCCLUSION_DEFAULT_HEIGHT = 128;
+static const int OCCLUSION_DEFAULT_OCCLUDERS = 64;
+static const size_t OCCLUSION_TEST_PARALLEL_MIN = 4096; // меньше объектов — проверка без рабочих потоков
+
+// Меш-окклюдер: позиции xyz вершин с шагом stride float, треугольники по индексам.
+// Подойдёт любой замкнутый меш, целиком лежащий внутри видимого объекта
+typedef struct {
+    const float* positions;
+    int stride;
+    int vertex_count;
+    const uint16_t* indices;
+    int index_count;
+} OccluderMesh;
+
+typedef struct OcclusionCuller OcclusionCuller;
+
+typedef struct {
+    uint64_t frames;         // вызовов occlusion_cull_test
+    uint64_t occluders;
+    uint64_t triangles;      // дошли до растеризации (не за ближней плоскостью и не вне экрана)
+    uint64_t tile_triangles; // пар плитка-треугольник в корзинах
+    uint64_t tested;
+    uint64_t occluded;
+    double raster_ns;        // подготовка, корзины, растеризация и Hi-Z
+    double test_ns;
+} OcclusionCullStats;
+
+typedef struct {
+    bool enabled;   // --occlusion
+    int width;      // --occlusion-size WxH, кратно плитке
+    int height;
+    int occluders;  // --occluders N — сколько ближних объектов растеризовать
+} OcclusionCullOptions;
+
+// Размеры округляются вверх до кратных плитке; threads == 0 — по числу ядер
+OcclusionCuller* occlusion_cull_create(int width, int height, unsigned threads);
+void occlusion_cull_destroy(OcclusionCuller* culler);
+unsigned occlusion_cull_threads(const OcclusionCuller* culler);
+
+// Кандидаты в окклюдеры: до max_count объектов из visible с самым большим размером
+// на экране (сумма половин рёбер AABB, делённая на расстояние по w)
+void occlusion_select_occluders(const glm::mat4& view_projection, const BoundsSoA* bounds, const std::vector<uint32_t>& visible,
+                                int max_count, std::vector<uint32_t>* occluders);
+
+// Кадр: begin, окклюдеры, rasterize, затем проверки
+void occlusion_cull_begin(OcclusionCuller* culler, const glm::mat4& view_projection);
+void occlusion_cull_add_occluder(OcclusionCuller* culler, const OccluderMesh* mesh, const glm::mat4& mvp);
+// kernel — как у transform_batch, не выше transform_best_kernel()
+void occlusion_cull_rasterize(OcclusionCuller* culler, TransformKernel kernel);
+// Убирает из visible перекрытые объекты, сохраняя порядок; возвращает оставшееся число
+size_t occlusion_cull_test(OcclusionCuller* culler, const BoundsSoA* bounds, std::vector<uint32_t>* visible);
+
+// Глубина [0, 1] пикселя (x, y) с началом внизу слева; 1 — окклюдеров нет
+float occlusion_cull_depth(const OcclusionCuller* culler, int x, int y);
+void occlusion_cull_size(const OcclusionCuller* culler, int* width, int* height);
+
+OcclusionCullStats occlusion_cull_stats(const OcclusionCuller* culler);
+
+OcclusionCullOptions occlusion_cull_parse(int argc, char** argv);
+
+#endif
@@ -0,0 +1,120 @@
+#include "render_queue.h"
+#include <string.h>
+
+uint64_t render_sort_key(GLuint program, GLuint texture, GLuint vao, float depth, float far_plane) {
+    float normalized = far_plane > 0.0f ? depth / far_plane : 0.0f;
+    if (normalized < 0.0f)
+        normalized = 0.0f;
+    if (normalized > 1.0f)
+        normalized = 1.0f;
+    uint64_t depth_bits = (uint64_t)(normalized * 65535.0f);
+    return ((uint64_t)(program & 0xffff) << 48) | ((uint64_t)(texture & 0xffff) << 32) |
+           ((uint64_t)(vao & 0xffff) << 16) | depth_bits;
+}
+
+void render_queue_clear(RenderQueue* queue) {
+    queue->packets.clear();
+}
+
+void render_queue_push(RenderQueue* queue, const DrawPacket* packet) {
+    queue->packets.push_back(*packet);
+}
+
+void render_queue_sort(RenderQueue* queue) {
+    size_t count = queue->packets.size();
+    queue->order.resize(count);
+    queue->scratch.resize(count);
+    for (size_t i = 0; i < count; i++)
+        queue->order[i] = (uint32_t)i;
+
+    // Устойчивая поразрядная сортировка, 8 проходов по байту начиная с младшего
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (size_t i = 0; i < count; i++)
+            histogram[(queue->packets[i].key >> shift) & 0xff]++;
+        if (count == 0 || histogram[(queue->packets[0].key >> shift) & 0xff] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t packet = queue->order[i];
+            queue->scratch[histogram[(queue->packets[packet].key >> shift) & 0xff]++] = packet;
+        }
+        queue->order.swap(queue->scratch);
+    }
+}
+
+void render_queue_submit(RenderQueue* queue, RenderStateTracker* tracker, FrameProfiler* profiler) {
+    for (uint32_t index : queue->order) {
+        const DrawPacket& packet = queue->packets[index];
+        if (profiler && packet.scope)
+            frame_profiler_begin(profiler, packet.scope);
+
+        render_state_use_program(tracker, packet.program);
+        if (packet.texture)
+            render_state_bind_texture(tracker, packet.texture_target, packet.texture);
+        render_state_bind_vao(tracker, packet.vao);
+        if (packet.instance_count > 0)
+            glDrawElementsInstanced(GL_TRIANGLES, packet.index_count, GL_UNSIGNED_SHORT, (void*)0, packet.instance_count);
+        else
+            glDrawElements(GL_TRIANGLES, packet.index_count, GL_UNSIGNED_SHORT, (void*)0);
+        tracker->frame.draws++;
+        tracker->total.draws++;
+    }
+}
+
+void render_state_init(RenderStateTracker* tracker) {
+    memset(tracker, 0, sizeof(*tracker));
+    render_state_begin_frame(tracker);
+}
+
+void render_state_begin_frame(RenderStateTracker* tracker) {
+    tracker->program = tracker->texture = tracker->vao = RENDER_STATE_UNKNOWN;
+    tracker->texture_target = GL_NONE;
+    memset(&tracker->frame, 0, sizeof(tracker->frame));
+}
+
+static bool is_bound(RenderStateTracker* tracker, GLuint current, GLuint value) {
+    if (current != value)
+        return false;
+    tracker->frame.redundant++;
+    tracker->total.redundant++;
+    return true;
+}
+
+void render_state_use_program(RenderStateTracker* tracker, GLuint program) {
+    if (is_bound(tracker, tracker->program, program))
+        return;
+    glUseProgram(program);
+    tracker->program = program;
+    tracker->frame.program_binds++;
+    tracker->total.program_binds++;
+}
+
+void render_state_bind_texture(RenderStateTracker* tracker, GLenum target, GLuint texture) {
+    // У каждой цели своя привязка, так что имя без цели ничего не говорит
+    if (tracker->texture_target == target && is_bound(tracker, tracker->texture, texture))
+        return;
+    // Трекер следит только за нулевым текстурным блоком
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(target, texture);
+    tracker->texture = texture;
+    tracker->texture_target = target;
+    tracker->frame.texture_binds++;
+    tracker->total.texture_binds++;
+}
+
+void render_state_bind_vao(RenderStateTracker* tracker, GLuint vao) {
+    if (is_bound(tracker, tracker->vao, vao))
+        return;
+    glBindVertexArray(vao);
+    tracker->vao = vao;
+    tracker->frame.vao_binds++;
+    tracker->total.vao_binds++;
+}
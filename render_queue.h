@@ -0,0 +1,66 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "include/glad.h"
+#include "frame_profiler.h"
+#include <stdint.h>
+#include <vector>
+
+// Очередь отрисовки: пакеты собираются за кадр, сортируются по 64-битному ключу
+// (программа | текстура | VAO | глубина) и отправляются через трекер состояния,
+// который пропускает повторные glUseProgram/glBindTexture/glBindVertexArray.
+
+typedef struct {
+    uint64_t key;
+    GLuint program;
+    GLuint texture;        // на GL_TEXTURE0; 0 — шейдер не читает текстуру, привязка не трогается
+    GLenum texture_target; // GL_TEXTURE_2D или GL_TEXTURE_2D_ARRAY (массив текстур сцены)
+    GLuint vao;
+    GLsizei index_count;   // индексы GL_UNSIGNED_SHORT
+    GLsizei instance_count; // 0 — обычный glDrawElements
+    const char* scope;     // участок профиля или NULL
+} DrawPacket;
+
+typedef struct {
+    uint64_t program_binds;
+    uint64_t texture_binds;
+    uint64_t vao_binds;
+    uint64_t redundant;    // пропущенных привязок
+    uint64_t draws;
+} RenderStateStats;
+
+// Кэш привязанного состояния. Сбрасывается каждый кадр: чужой код (загрузка
+// текстур, UBO) может менять привязки в обход трекера.
+static const GLuint RENDER_STATE_UNKNOWN = 0xffffffffu; // привязка неизвестна, следующая пройдёт в GL
+
+typedef struct {
+    GLuint program;
+    GLuint texture;
+    GLenum texture_target;
+    GLuint vao;
+    RenderStateStats frame;  // текущий кадр
+    RenderStateStats total;  // с начала работы
+} RenderStateTracker;
+
+typedef struct {
+    std::vector<DrawPacket> packets;
+    std::vector<uint32_t> order;   // индексы пакетов после сортировки
+    std::vector<uint32_t> scratch; // второй буфер поразрядной сортировки
+} RenderQueue;
+
+// Глубина квантуется в 16 бит (ближние — меньше), остальные поля — младшие 16 бит имён GL
+uint64_t render_sort_key(GLuint program, GLuint texture, GLuint vao, float depth, float far_plane);
+
+void render_queue_clear(RenderQueue* queue);
+void render_queue_push(RenderQueue* queue, const DrawPacket* packet);
+// LSD radix sort по байтам ключа; байты, одинаковые у всех пакетов, пропускаются
+void render_queue_sort(RenderQueue* queue);
+void render_queue_submit(RenderQueue* queue, RenderStateTracker* tracker, FrameProfiler* profiler);
+
+void render_state_init(RenderStateTracker* tracker);
+void render_state_begin_frame(RenderStateTracker* tracker);
+void render_state_use_program(RenderStateTracker* tracker, GLuint program);
+void render_state_bind_texture(RenderStateTracker* tracker, GLenum target, GLuint texture);
+void render_state_bind_vao(RenderStateTracker* tracker, GLuint vao);
+
+#endif
@@ -0,0 +1,164 @@
+#include "scene.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const float CUBE_SPACING = 2.0f;
+static const int GRID_WIDTH = 100;
+static const int GRID_HEIGHT = 100;
+static const float CUBE_CENTER[3] = { 0.0f, 0.0f, 0.0f };
+static const float CUBE_HALF_EXTENT[3] = { 0.5f, 0.5f, 0.5f }; // меш куба — [-0.5, 0.5]^3
+
+static const GLfloat cube_colors[SCENE_MATERIAL_COUNT][4] = {
+    {1.0f, 0.0f, 0.0f, 1.0f}, // Красный
+    {0.0f, 1.0f, 0.0f, 1.0f}, // Зеленый
+    {0.0f, 0.0f, 1.0f, 1.0f}, // Синий
+    {1.0f, 1.0f, 0.0f, 1.0f}, // Желтый
+    {1.0f, 0.0f, 1.0f, 1.0f}  // Розовый
+};
+
+static void cube_position(int index, float* position) {
+    if (index < SCENE_MATERIAL_COUNT) {
+        // Исходный ряд: x = -4, -2, 0, 2, 4 на z = -5
+        position[0] = (index - 2) * CUBE_SPACING;
+        position[1] = 0.0f;
+        position[2] = -5.0f;
+        return;
+    }
+    int grid_index = index - SCENE_MATERIAL_COUNT;
+    int column = grid_index % GRID_WIDTH;
+    int row = (grid_index / GRID_WIDTH) % GRID_HEIGHT;
+    int layer = grid_index / (GRID_WIDTH * GRID_HEIGHT);
+    position[0] = (column - GRID_WIDTH / 2) * CUBE_SPACING;
+    position[1] = (row - GRID_HEIGHT / 2) * CUBE_SPACING;
+    position[2] = -7.0f - layer * CUBE_SPACING;
+}
+
+void scene_build_grid(Scene* scene, int cube_count) {
+    if (cube_count < 0)
+        cube_count = 0;
+
+    // Куб i рисуется материалом i % 5, как в исходном switch(i)
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++)
+        scene->material_count[m] = cube_count / SCENE_MATERIAL_COUNT + (m < cube_count % SCENE_MATERIAL_COUNT ? 1 : 0);
+    int first = 0;
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++) {
+        scene->material_first[m] = first;
+        first += scene->material_count[m];
+    }
+
+    scene->instances.resize(cube_count);
+    transform_soa_resize(&scene->models, cube_count);
+    bounds_soa_resize(&scene->bounds, cube_count);
+    int cursor[SCENE_MATERIAL_COUNT];
+    memcpy(cursor, scene->material_first, sizeof(cursor));
+
+    for (int i = 0; i < cube_count; i++) {
+        int material = i % SCENE_MATERIAL_COUNT;
+        int index = cursor[material]++;
+        CubeInstance& instance = scene->instances[index];
+
+        float position[3];
+        cube_position(i, position);
+        memset(instance.model, 0, sizeof(instance.model));
+        instance.model[0] = instance.model[5] = instance.model[10] = instance.model[15] = 1.0f;
+        instance.model[12] = position[0];
+        instance.model[13] = position[1];
+        instance.model[14] = position[2];
+        memcpy(instance.color, cube_colors[material], sizeof(instance.color));
+        instance.uv_rect[0] = instance.uv_rect[1] = 0.0f;
+        instance.uv_rect[2] = instance.uv_rect[3] = 1.0f;
+        instance.layer = 0.0f;
+        glm::mat4 model = glm::make_mat4(instance.model);
+        transform_soa_set(&scene->models, index, model);
+        bounds_soa_set_transformed(&scene->bounds, index, model, CUBE_CENTER, CUBE_HALF_EXTENT);
+    }
+
+    // Нормальные матрицы не зависят от камеры: пакет один раз, а не transpose(inverse(model)) в каждой вершине
+    Mat3SoA normals;
+    transform_batch(transform_best_kernel(), glm::mat4(1.0f), &scene->models, NULL, &normals);
+    for (int i = 0; i < cube_count; i++)
+        for (int k = 0; k < 9; k++)
+            scene->instances[i].normal_matrix[k] = normals.m[k][i];
+}
+
+void scene_assign_textures(Scene* scene, const TextureSlot* slots, int slot_count) {
+    if (slot_count <= 0)
+        return;
+    // Экземпляры лежат по материалам; исходный номер куба восстанавливаем так же, как в scene_build_grid
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++) {
+        for (int k = 0; k < scene->material_count[m]; k++) {
+            int cube = k * SCENE_MATERIAL_COUNT + m;
+            const TextureSlot& slot = slots[cube % slot_count];
+            CubeInstance& instance = scene->instances[scene->material_first[m] + k];
+            memcpy(instance.uv_rect, slot.uv_rect, sizeof(instance.uv_rect));
+            instance.layer = (GLfloat)slot.layer;
+        }
+    }
+}
+
+void scene_pack_visible(const Scene* scene, const std::vector<uint32_t>& visible, std::vector<CubeInstance>* packed,
+                        int* visible_count) {
+    packed->resize(scene->instances.size());
+    int material = 0;
+    for (int m = 0; m < SCENE_MATERIAL_COUNT; m++)
+        visible_count[m] = 0;
+    for (uint32_t index : visible) {
+        while ((int)index >= scene->material_first[material] + scene->material_count[material])
+            material++;
+        (*packed)[scene->material_first[material] + visible_count[material]++] = scene->instances[index];
+    }
+}
+
+void scene_parse_texture_paths(int argc, char** argv, std::vector<const char*>* paths) {
+    paths->clear();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--textures") != 0)
+            continue;
+        for (i++; i < argc && strncmp(argv[i], "--", 2) != 0; i++)
+            paths->push_back(argv[i]);
+        break;
+    }
+    if (paths->empty())
+        paths->push_back(SCENE_DEFAULT_TEXTURE);
+}
+
+int scene_parse_cube_count(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--cubes") == 0) {
+            int count = atoi(argv[i + 1]);
+            return count > 0 ? count : SCENE_DEFAULT_CUBES;
+        }
+    }
+    return SCENE_DEFAULT_CUBES;
+}
+
+void scene_setup_instance_attributes(GLuint instance_buffer, int first_instance) {
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    size_t base = (size_t)first_instance * sizeof(CubeInstance);
+
+    // mat4 занимает четыре подряд идущих атрибута-столбца
+    for (int column = 0; column < 4; column++) {
+        GLuint location = 3 + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+                              (void*)(base + offsetof(CubeInstance, model) + column * 4 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(base + offsetof(CubeInstance, color)));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(base + offsetof(CubeInstance, uv_rect)));
+    glEnableVertexAttribArray(8);
+    glVertexAttribDivisor(8, 1);
+    glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(base + offsetof(CubeInstance, layer)));
+    glEnableVertexAttribArray(9);
+    glVertexAttribDivisor(9, 1);
+    for (int column = 0; column < 3; column++) {
+        GLuint location = 10 + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+                              (void*)(base + offsetof(CubeInstance, normal_matrix) + column * 3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
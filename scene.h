@@ -0,0 +1,57 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "include/glad.h"
+#include "frustum_cull.h"
+#include "texture_array.h"
+#include "transform.h"
+#include <vector>
+
+// Данные одного экземпляра куба; лежат в инстанс-буфере как есть
+// (атрибуты 3..6 — модельная матрица, 7 — цвет, 8 — прямоугольник UV, 9 — слой массива текстур,
+// 10..12 — нормальная матрица)
+typedef struct {
+    GLfloat model[16];
+    GLfloat color[4];
+    GLfloat uv_rect[4];
+    GLfloat layer;
+    GLfloat normal_matrix[9];
+} CubeInstance;
+
+static const int SCENE_MATERIAL_COUNT = 5; // phong, diffuse, specular, lambert, no_lighting
+static const int SCENE_DEFAULT_CUBES = 5;
+static const char* const SCENE_DEFAULT_TEXTURE = "D:/vr/zad3/wood-2045380_1280.jpg";
+
+typedef struct {
+    // Экземпляры сгруппированы по материалу: материал m занимает
+    // [material_first[m], material_first[m] + material_count[m])
+    std::vector<CubeInstance> instances;
+    TransformSoA models;  // те же модельные матрицы в SoA для пакетных ядер transform_batch
+    BoundsSoA bounds;     // мировые AABB экземпляров для frustum_cull, в том же порядке
+    int material_first[SCENE_MATERIAL_COUNT];
+    int material_count[SCENE_MATERIAL_COUNT];
+} Scene;
+
+// Первые пять кубов стоят как в исходной сцене, остальные — сеткой за ними
+void scene_build_grid(Scene* scene, int cube_count);
+
+// Параметр --cubes N из командной строки (по умолчанию SCENE_DEFAULT_CUBES)
+int scene_parse_cube_count(int argc, char** argv);
+
+// Экземпляр k получает слот k % slot_count (сквозная нумерация кубов, а не по материалам),
+// так что у соседних кубов одного материала разные текстуры
+void scene_assign_textures(Scene* scene, const TextureSlot* slots, int slot_count);
+
+// --textures A B ...: пути до следующего флага "--..."; без флага — SCENE_DEFAULT_TEXTURE
+void scene_parse_texture_paths(int argc, char** argv, std::vector<const char*>* paths);
+
+// Видимые экземпляры (индексы по возрастанию, как их отдаёт frustum_cull) раскладываются
+// в packed так, что видимые экземпляры материала m идут подряд с material_first[m]:
+// VAO материалов не перенастраиваются, меняется только число экземпляров в вызове
+void scene_pack_visible(const Scene* scene, const std::vector<uint32_t>& visible, std::vector<CubeInstance>* packed,
+                        int* visible_count);
+
+// Атрибуты экземпляра (3..12) для текущего VAO, начиная с первого экземпляра first_instance
+void scene_setup_instance_attributes(GLuint instance_buffer, int first_instance);
+
+#endif
@@ -0,0 +1,338 @@
+#include "shader_registry.h"
+#include "hash.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const uint32_t SHADER_BINARY_MAGIC = 0x42535256; // "VRSB"
+static const uint32_t SHADER_BINARY_VERSION = 1;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t length;
+    double compile_ms;
+} ShaderBinaryHeader;
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool read_disk_file(const char* path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    text.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool read_text_file(const ShaderRegistry* registry, const char* path, std::string& text) {
+    if (const AssetPackEntry* entry = asset_pack_find(registry->pack, path)) {
+        std::vector<unsigned char> scratch;
+        const unsigned char* data;
+        size_t size;
+        if (asset_pack_read(registry->pack, entry, &data, &size, &scratch)) {
+            text.assign((const char*)data, size);
+            return true;
+        }
+    }
+    return read_disk_file(path, text);
+}
+
+static bool check_shader_compile(GLuint shader, const char* path) {
+    GLint success;
+    GLchar infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER_COMPILATION_ERROR in " << path << ": " << infoLog << std::endl;
+    }
+    return success;
+}
+
+static bool check_program_link(GLuint program) {
+    GLint success;
+    GLchar infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << infoLog << std::endl;
+    }
+    return success;
+}
+
+static GLuint compile_shader(GLenum type, const std::string& source, const char* path) {
+    GLuint shader = glCreateShader(type);
+    const char* source_cstr = source.c_str();
+    glShaderSource(shader, 1, &source_cstr, NULL);
+    glCompileShader(shader);
+    check_shader_compile(shader, path);
+    return shader;
+}
+
+static std::string binary_path(const ShaderRegistry* registry, uint64_t key) {
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)(key ^ registry->driver_hash));
+    return registry->cache_dir + "/" + name;
+}
+
+// Пытаемся поднять программу из бинарного кэша; 0 — нужна компиляция
+static GLuint load_program_binary(ShaderRegistry* registry, uint64_t key) {
+    if (!registry->binary_supported || registry->cache_dir.empty())
+        return 0;
+
+    std::string path = binary_path(registry, key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    ShaderBinaryHeader header;
+    std::vector<char> blob;
+    bool valid = (bool)file.read((char*)&header, sizeof(header))
+                 && header.magic == SHADER_BINARY_MAGIC && header.version == SHADER_BINARY_VERSION;
+    if (valid) {
+        blob.resize(header.length);
+        valid = (bool)file.read(blob.data(), header.length);
+    }
+    file.close();
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, blob.data(), (GLsizei)blob.size());
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (!program) {
+        // Драйвер обновился или файл испорчен — перекомпилируем и перезапишем
+        registry->stats.binary_rejects++;
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return 0;
+    }
+
+    double load_ms = elapsed_ms(start);
+    registry->stats.binary_loads++;
+    registry->stats.binary_load_ms += load_ms;
+    if (header.compile_ms > load_ms)
+        registry->stats.compile_ms_saved += header.compile_ms - load_ms;
+    return program;
+}
+
+static void store_program_binary(ShaderRegistry* registry, uint64_t key, GLuint program, double compile_ms) {
+    if (!registry->binary_supported || registry->cache_dir.empty())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> blob(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, blob.data());
+
+    ShaderBinaryHeader header = { SHADER_BINARY_MAGIC, SHADER_BINARY_VERSION, format, (uint32_t)length, compile_ms };
+    std::ofstream file(binary_path(registry, key), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return;
+    file.write((const char*)&header, sizeof(header));
+    file.write(blob.data(), length);
+}
+
+void shader_registry_init(ShaderRegistry* registry, const char* cache_dir) {
+    registry->programs.clear();
+    registry->block_bindings.clear();
+    registry->stats = {};
+    registry->cache_dir = cache_dir ? cache_dir : "";
+    registry->pack = NULL;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    registry->binary_supported = formats > 0;
+
+    const char* vendor = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version = (const char*)glGetString(GL_VERSION);
+    registry->driver_hash = fnv1a_64(vendor ? vendor : "");
+    registry->driver_hash = fnv1a_64(renderer ? renderer : "", registry->driver_hash);
+    registry->driver_hash = fnv1a_64(version ? version : "", registry->driver_hash);
+
+    if (!registry->cache_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(registry->cache_dir, ec);
+        if (ec)
+            registry->cache_dir.clear();
+    }
+}
+
+static void apply_block_bindings(const ShaderRegistry* registry, GLuint program) {
+    for (const auto& pair : registry->block_bindings) {
+        GLuint index = glGetUniformBlockIndex(program, pair.first.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, pair.second);
+    }
+}
+
+void shader_registry_bind_block(ShaderRegistry* registry, const char* block_name, GLuint binding) {
+    registry->block_bindings[block_name] = binding;
+}
+
+void shader_registry_shutdown(ShaderRegistry* registry) {
+    for (auto& pair : registry->programs)
+        glDeleteProgram(pair.second.program);
+    registry->programs.clear();
+}
+
+static uint64_t program_key(const std::string& vertex_source, const std::string& fragment_source) {
+    uint64_t key = fnv1a_64_bytes(vertex_source.data(), vertex_source.size());
+    key = fnv1a_64_bytes("\0", 1, key);
+    return fnv1a_64_bytes(fragment_source.data(), fragment_source.size(), key);
+}
+
+// Из бинарного кэша или компиляцией; *linked == false — программа не слинковалась
+static GLuint build_program(ShaderRegistry* registry, uint64_t key, const std::string& vertex_source, const std::string& fragment_source,
+                            const char* vertex_path, const char* fragment_path, bool* linked) {
+    *linked = true;
+    GLuint shader_program = load_program_binary(registry, key);
+    if (shader_program)
+        return shader_program;
+
+    auto start = std::chrono::steady_clock::now();
+
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source, vertex_path);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source, fragment_path);
+
+    shader_program = glCreateProgram();
+    glAttachShader(shader_program, vertex_shader);
+    glAttachShader(shader_program, fragment_shader);
+    if (registry->binary_supported)
+        glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(shader_program);
+    *linked = check_program_link(shader_program);
+    glDetachShader(shader_program, vertex_shader);
+    glDetachShader(shader_program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    double compile_ms = elapsed_ms(start);
+    registry->stats.compiles++;
+    registry->stats.compile_ms += compile_ms;
+
+    if (*linked)
+        store_program_binary(registry, key, shader_program, compile_ms);
+    return shader_program;
+}
+
+ShaderProgram* shader_registry_load(ShaderRegistry* registry, const char* vertex_path, const char* fragment_path) {
+    registry->stats.requests++;
+
+    std::string vertex_source, fragment_source;
+    if (!read_text_file(registry, vertex_path, vertex_source) || !read_text_file(registry, fragment_path, fragment_source)) {
+        std::cerr << "Error opening shader files\n";
+        return NULL;
+    }
+
+    uint64_t key = program_key(vertex_source, fragment_source);
+    auto it = registry->programs.find(key);
+    if (it != registry->programs.end())
+        return &it->second;
+
+    bool linked;
+    GLuint shader_program = build_program(registry, key, vertex_source, fragment_source, vertex_path, fragment_path, &linked);
+
+    ShaderProgram& entry = registry->programs[key];
+    entry.key = key;
+    entry.program = shader_program;
+    entry.vertex_path = vertex_path;
+    entry.fragment_path = fragment_path;
+    apply_block_bindings(registry, shader_program);
+    uniform_table_build(&entry.uniforms, shader_program);
+    return &entry;
+}
+
+int shader_registry_reload(ShaderRegistry* registry, const char* path) {
+    // Ключи меняются по ходу цикла — сначала собираем затронутые программы
+    std::vector<uint64_t> affected;
+    for (const auto& pair : registry->programs)
+        if (pair.second.vertex_path == path || pair.second.fragment_path == path)
+            affected.push_back(pair.first);
+
+    int reloaded = 0;
+    for (uint64_t old_key : affected) {
+        auto it = registry->programs.find(old_key);
+        ShaderProgram* entry = &it->second;
+        std::string vertex_source, fragment_source;
+        if (!read_disk_file(entry->vertex_path.c_str(), vertex_source) || !read_disk_file(entry->fragment_path.c_str(), fragment_source)) {
+            registry->stats.reload_failures++;
+            continue;
+        }
+        uint64_t key = program_key(vertex_source, fragment_source);
+        if (key == entry->key)
+            continue; // сохранили без изменений
+
+        bool linked;
+        GLuint program = build_program(registry, key, vertex_source, fragment_source, entry->vertex_path.c_str(),
+                                       entry->fragment_path.c_str(), &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            registry->stats.reload_failures++;
+            continue;
+        }
+        glDeleteProgram(entry->program);
+        entry->program = program;
+        apply_block_bindings(registry, program);
+        uniform_table_build(&entry->uniforms, program);
+        registry->stats.reloads++;
+        reloaded++;
+
+        // Переносим под новый ключ, как если бы программу загрузили заново; узел при этом
+        // не перевыделяется, так что выданные указатели остаются валидными. Если такие
+        // исходники уже загружены другой записью, shader_registry_load должен находить её,
+        // а эта уходит под ключ от своих путей
+        entry->key = key;
+        uint64_t map_key = key;
+        if (registry->programs.find(key) != registry->programs.end())
+            map_key = fnv1a_64((entry->vertex_path + "\n" + entry->fragment_path).c_str(), key);
+        if (map_key != old_key && registry->programs.find(map_key) == registry->programs.end()) {
+            auto node = registry->programs.extract(it);
+            node.key() = map_key;
+            registry->programs.insert(std::move(node));
+        }
+    }
+    return reloaded;
+}
+
+ShaderRegistryStats shader_registry_stats(const ShaderRegistry* registry) {
+    return registry->stats;
+}
+
+void shader_registry_print_stats(const ShaderRegistry* registry) {
+    const ShaderRegistryStats& stats = registry->stats;
+    uint64_t uploads = 0, redundant = 0;
+    for (const auto& pair : registry->programs) {
+        uploads += pair.second.uniforms.uploads;
+        redundant += pair.second.uniforms.redundant;
+    }
+    printf("Shader registry: %llu requests, %llu compiles (%.2f ms), %llu binary loads (%.2f ms), "
+           "%llu rejected, %.2f ms compile time saved\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.compiles, stats.compile_ms,
+           (unsigned long long)stats.binary_loads, stats.binary_load_ms,
+           (unsigned long long)stats.binary_rejects, stats.compile_ms_saved);
+    if (stats.reloads || stats.reload_failures)
+        printf("Shader hot reload: %llu programs rebuilt, %llu edits rejected\n",
+               (unsigned long long)stats.reloads, (unsigned long long)stats.reload_failures);
+    printf("Uniforms: %llu uploads, %llu redundant uploads skipped\n",
+           (unsigned long long)uploads, (unsigned long long)redundant);
+}
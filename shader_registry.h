@@ -0,0 +1,62 @@
+#ifndef SHADER_REGISTRY_H
+#define SHADER_REGISTRY_H
+
+#include "include/glad.h"
+#include "uniform_table.h"
+#include "asset_pack.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+typedef struct {
+    uint64_t requests;
+    uint64_t compiles;         // компиляций из исходников GLSL
+    uint64_t binary_loads;     // программ, поднятых из бинарного кэша
+    uint64_t binary_rejects;   // бинарников, отвергнутых драйвером
+    double compile_ms;         // время, потраченное на компиляцию и линковку
+    double binary_load_ms;     // время загрузки бинарников
+    double compile_ms_saved;   // сэкономлено благодаря бинарному кэшу
+    uint64_t reloads;          // программ пересобрано после правки исходника
+    uint64_t reload_failures;  // правка не скомпилировалась — осталась прежняя программа
+} ShaderRegistryStats;
+
+struct ShaderProgram {
+    uint64_t key;            // хеш исходников; ключ в programs, если их не загрузила раньше другая запись
+    GLuint program;
+    std::string vertex_path;
+    std::string fragment_path;
+    UniformTable uniforms;   // строится один раз после линковки
+};
+
+typedef struct {
+    std::string cache_dir;     // пустая строка — бинарный кэш на диске выключен
+    uint64_t driver_hash;      // бинарники не переносимы между драйверами
+    bool binary_supported;
+    const AssetPack* pack;     // исходники ищутся сначала в пакете ресурсов; NULL — только файлы
+    std::unordered_map<uint64_t, ShaderProgram> programs;
+    std::unordered_map<std::string, GLuint> block_bindings; // имя uniform-блока -> точка привязки
+    ShaderRegistryStats stats;
+} ShaderRegistry;
+
+// Требует текущий GL-контекст
+void shader_registry_init(ShaderRegistry* registry, const char* cache_dir);
+void shader_registry_shutdown(ShaderRegistry* registry);
+
+// Каждая пара (вершинный, фрагментный) исходников компилируется ровно один раз.
+// Указатель стабилен до shader_registry_shutdown.
+ShaderProgram* shader_registry_load(ShaderRegistry* registry, const char* vertex_path, const char* fragment_path);
+
+// Пересобирает программы, в которые входит исходник path (путь как в shader_registry_load),
+// читая его с диска в обход пакета ресурсов. Новая программа подменяет старую в том же
+// ShaderProgram (указатель не меняется), значения юниформов вне блоков надо задать заново.
+// При ошибке компиляции или линковки остаётся прежняя программа. Возвращает число подмен.
+int shader_registry_reload(ShaderRegistry* registry, const char* path);
+
+// Uniform-блок с этим именем в каждой загружаемой программе привязывается к binding
+// (в GLSL 330 нет layout(binding = N)). Вызывать до shader_registry_load.
+void shader_registry_bind_block(ShaderRegistry* registry, const char* block_name, GLuint binding);
+
+ShaderRegistryStats shader_registry_stats(const ShaderRegistry* registry);
+void shader_registry_print_stats(const ShaderRegistry* registry);
+
+#endif
@@ -4,10 +4,20 @@ out vec4 FragColor;
 in vec3 normal;        // Нормаль фрагмента
 in vec3 fragPos;       // Позиция фрагмента в мировых координатах
 in vec2 TexCoord;      // Текстурные координаты, передаваемые из вершинного шейдера
+flat in vec4 uvRect;   // Область текстуры объекта в слое массива
+flat in float layer;   // Слой массива текстур
 
-uniform vec3 lightPos;    // Позиция источника света
-uniform vec3 lightColor;  // Цвет света
-uniform sampler2D uTexture; // Текстура объекта
+// Покадровые константы камеры и света (FrameUniforms в frame_uniforms.h)
+layout (std140) uniform FrameData {
+    mat4 view;        // Матрица вида
+    mat4 projection;  // Матрица проекции
+    vec3 viewPos;     // Позиция камеры
+    vec3 lightPos;    // Позиция источника света
+    vec3 lightColor;  // Цвет источника света
+    mat4 viewProjection; // projection * view, перемножается на CPU раз в кадр
+};
+
+uniform sampler2DArray uTexture; // Массив текстур сцены
 
 void main() {
     // Амбиентное освещение
@@ -20,8 +30,9 @@ void main() {
     float diff = max(dot(normal, lightDir), 0.0f);
     vec3 diffuse = diff * lightColor;
 
-    // Цвет объекта из текстуры
-    vec3 objectColor = texture(uTexture, TexCoord).rgb;
+    // Цвет объекта из его области массива; clamp держит выборку внутри области и полей
+    vec2 uv = uvRect.xy + clamp(TexCoord, 0.0, 1.0) * uvRect.zw;
+    vec3 objectColor = texture(uTexture, vec3(uv, layer)).rgb;
 
     // Итоговый цвет: комбинация амбиентного и диффузного освещения, умноженная на цвет из текстуры
     vec3 finalColor = objectColor * (ambient + diffuse);
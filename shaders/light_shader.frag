@@ -3,7 +3,16 @@
 out vec4 FragColor;
 
 uniform vec3 objectColor;
-uniform vec3 lightColor;
+
+// Покадровые константы камеры и света (FrameUniforms в frame_uniforms.h)
+layout (std140) uniform FrameData {
+    mat4 view;        // Матрица вида
+    mat4 projection;  // Матрица проекции
+    vec3 viewPos;     // Позиция камеры
+    vec3 lightPos;    // Позиция источника света
+    vec3 lightColor;  // Цвет источника света
+    mat4 viewProjection; // projection * view, перемножается на CPU раз в кадр
+};
 
 void main() {
     FragColor = vec4(lightColor, 1.0f); // Отображаем свет с его цветом
@@ -3,9 +3,12 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+flat in vec4 uvRect;
+flat in float layer;
 
-uniform sampler2D uTexture;
+uniform sampler2DArray uTexture;
 
 void main() {
-    FragColor = texture(uTexture, TexCoord);
+    vec2 uv = uvRect.xy + clamp(TexCoord, 0.0, 1.0) * uvRect.zw;
+    FragColor = texture(uTexture, vec3(uv, layer));
 }
@@ -4,18 +4,37 @@ layout (location = 0) in vec3 aPos;       // Позиция
 layout (location = 1) in vec3 aNormal;    // Нормаль
 layout (location = 2) in vec2 aTexCoord;  // Текстурные координаты
 
-uniform mat4 model;       // Модельная матрица
-uniform mat4 view;        // Матрица вида
-uniform mat4 projection;  // Матрица проекции
+// Данные экземпляра (CubeInstance в scene.h), шаг — один экземпляр
+layout (location = 3) in mat4 model;      // Модельная матрица, атрибуты 3..6
+layout (location = 7) in vec4 aColor;     // Цвет объекта
+layout (location = 8) in vec4 aUvRect;    // Область текстуры в слое массива: смещение xy, масштаб zw
+layout (location = 9) in float aLayer;    // Слой массива текстур
+layout (location = 10) in mat3 aNormalMatrix; // Обратная транспонированная 3x3 модели, атрибуты 10..12
+
+// Покадровые константы камеры и света (FrameUniforms в frame_uniforms.h)
+layout (std140) uniform FrameData {
+    mat4 view;        // Матрица вида
+    mat4 projection;  // Матрица проекции
+    vec3 viewPos;     // Позиция камеры
+    vec3 lightPos;    // Позиция источника света
+    vec3 lightColor;  // Цвет источника света
+    mat4 viewProjection; // projection * view, перемножается на CPU раз в кадр
+};
 
 out vec3 fragPos;         // Позиция фрагмента в мировых координатах
 out vec3 normal;          // Нормаль фрагмента
 out vec2 TexCoord;        // Текстурные координаты
+out vec4 instanceColor;   // Цвет экземпляра
+flat out vec4 uvRect;     // Область текстуры экземпляра
+flat out float layer;     // Слой массива текстур
 
 void main() {
     fragPos = vec3(model * vec4(aPos, 1.0));          // Трансформируем позицию вершины в мировые координаты
-    normal = mat3(transpose(inverse(model))) * aNormal; // Преобразуем нормали в мировые координаты
+    normal = aNormalMatrix * aNormal;                  // Нормальная матрица посчитана на CPU пакетом для всех экземпляров
     TexCoord = aTexCoord;                              // Передаем текстурные координаты
+    instanceColor = aColor;
+    uvRect = aUvRect;
+    layer = aLayer;
 
-    gl_Position = projection * view * vec4(fragPos, 1.0); // Финальная позиция вершины
+    gl_Position = viewProjection * vec4(fragPos, 1.0); // Финальная позиция вершины
 }
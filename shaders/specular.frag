@@ -5,9 +5,15 @@ out vec4 FragColor;
 in vec3 fragPos; // Позиция фрагмента
 in vec3 normal;  // Нормаль фрагмента
 
-uniform vec3 lightPos; // Позиция источника света
-uniform vec3 viewPos;  // Позиция камеры
-uniform vec3 lightColor; // Цвет источника света
+// Покадровые константы камеры и света (FrameUniforms в frame_uniforms.h)
+layout (std140) uniform FrameData {
+    mat4 view;        // Матрица вида
+    mat4 projection;  // Матрица проекции
+    vec3 viewPos;     // Позиция камеры
+    vec3 lightPos;    // Позиция источника света
+    vec3 lightColor;  // Цвет источника света
+    mat4 viewProjection; // projection * view, перемножается на CPU раз в кадр
+};
 
 void main() {
     // Освещенность от источника света
@@ -0,0 +1,198 @@
+#include "staging_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static const GLuint64 STAGING_FENCE_TIMEOUT_NS = 1000000000ull;
+
+// Освобождает самый старый кусок; wait — ждать GPU, иначе только если забор уже пройден.
+// false — забор не пройден (в том числе за таймаут или с ошибкой ожидания), кусок не тронут
+static bool retire_oldest(StagingRing* ring, bool wait) {
+    StagingFence& oldest = ring->fences.front();
+    GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        if (!wait)
+            return false;
+        ring->stats.stalls++;
+        auto start = std::chrono::steady_clock::now();
+        status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, STAGING_FENCE_TIMEOUT_NS);
+        ring->stats.fence_wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+    glDeleteSync(oldest.fence);
+    ring->tail = (ring->tail + oldest.bytes) % ring->capacity;
+    ring->used -= oldest.bytes;
+    ring->fences.pop_front();
+    return true;
+}
+
+bool staging_ring_init(StagingRing* ring, size_t capacity) {
+    ring->buffer = 0;
+    ring->capacity = capacity;
+    ring->persistent = GLAD_GL_VERSION_4_4 != 0;
+    ring->mapped = NULL;
+    ring->range = NULL;
+    ring->head = ring->tail = ring->used = ring->pending = 0;
+    ring->fences.clear();
+    ring->frame_bytes = 0;
+    memset(&ring->stats, 0, sizeof(ring->stats));
+    if (capacity == 0)
+        return false;
+
+    glGenBuffers(1, &ring->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer);
+    if (ring->persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity, NULL, flags);
+        ring->mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)capacity, flags);
+        if (!ring->mapped) {
+            // Пересоздаём буфер: glBufferStorage делает хранилище неизменяемым
+            glDeleteBuffers(1, &ring->buffer);
+            glGenBuffers(1, &ring->buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer);
+            ring->persistent = false;
+        }
+    }
+    if (!ring->persistent)
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR) {
+        staging_ring_destroy(ring);
+        return false;
+    }
+    return true;
+}
+
+void staging_ring_destroy(StagingRing* ring) {
+    while (!ring->fences.empty()) {
+        if (!retire_oldest(ring, true)) {
+            // GPU так и не ответил: glDeleteBuffers всё равно отложит удаление до конца чтения
+            for (const StagingFence& fence : ring->fences)
+                glDeleteSync(fence.fence);
+            ring->fences.clear();
+        }
+    }
+    if (ring->buffer) {
+        if (ring->mapped || ring->range) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &ring->buffer);
+    }
+    ring->buffer = 0;
+    ring->mapped = NULL;
+    ring->range = NULL;
+    ring->capacity = 0;
+}
+
+unsigned char* staging_ring_map(StagingRing* ring, size_t size, size_t alignment, size_t* offset) {
+    if (!ring->buffer || size == 0)
+        return NULL;
+    if (size > ring->capacity) {
+        ring->stats.oversize++;
+        return NULL;
+    }
+
+    // Пройденные заборы освобождаем без ожидания, чтобы хвост не отставал
+    while (!ring->fences.empty() && retire_oldest(ring, false)) {
+    }
+
+    size_t start, skipped;
+    for (;;) {
+        // Пустое кольцо (в том числе после ожидания ниже) начинаем с нуля
+        if (ring->used == 0)
+            ring->head = ring->tail = 0;
+        start = (ring->head + alignment - 1) & ~(alignment - 1);
+        if (start + size > ring->capacity)
+            start = 0; // остаток до конца пропускаем, кусок не разрывается
+        skipped = (start >= ring->head ? start : ring->capacity) - ring->head;
+        if (ring->used + skipped + size <= ring->capacity)
+            break;
+        // Без заборов ждать нечего: место заняли куски, ещё не отданные GPU
+        if (ring->fences.empty()) {
+            ring->stats.full++;
+            return NULL;
+        }
+        // Забор не дождались — кусок ещё может читаться GPU, вызывающий загрузит напрямую
+        if (!retire_oldest(ring, true))
+            return NULL;
+    }
+
+    unsigned char* data = ring->mapped ? ring->mapped + start : NULL;
+    if (!ring->persistent) {
+        // Без синхронизации драйвера: перекрытие с GPU исключают заборы кольца
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer);
+        data = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, (GLintptr)start, (GLsizeiptr)size, flags);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (!data)
+            return NULL;
+        ring->range = data;
+    }
+
+    ring->head = start + size;
+    ring->used += skipped + size;
+    ring->pending += skipped + size;
+    ring->frame_bytes += size;
+    ring->stats.reservations++;
+    ring->stats.bytes += size;
+    *offset = start;
+    return data;
+}
+
+void staging_ring_unmap(StagingRing* ring) {
+    if (!ring->range)
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring->buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    ring->range = NULL;
+}
+
+void staging_ring_fence(StagingRing* ring) {
+    if (ring->pending == 0)
+        return;
+    StagingFence fence;
+    fence.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.bytes = ring->pending;
+    ring->fences.push_back(fence);
+    ring->pending = 0;
+}
+
+void staging_ring_end_frame(StagingRing* ring) {
+    staging_ring_fence(ring);
+    ring->stats.frames++;
+    if (ring->frame_bytes > ring->stats.frame_bytes_max)
+        ring->stats.frame_bytes_max = ring->frame_bytes;
+    ring->frame_bytes = 0;
+}
+
+bool staging_ring_upload_buffer(StagingRing* ring, GLuint buffer, GLintptr offset, const void* data, size_t size) {
+    if (!ring)
+        return false;
+    size_t source;
+    unsigned char* staging = staging_ring_map(ring, size, 16, &source);
+    if (!staging)
+        return false;
+    memcpy(staging, data, size);
+    staging_ring_unmap(ring);
+
+    // GL_COPY_READ/WRITE_BUFFER не трогают привязки VAO и индексного буфера
+    glBindBuffer(GL_COPY_READ_BUFFER, ring->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)source, offset, (GLsizeiptr)size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    staging_ring_fence(ring);
+    return true;
+}
+
+size_t staging_ring_parse_capacity(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--staging-mb") == 0)
+            return (size_t)atoi(argv[i + 1]) << 20;
+    }
+    return STAGING_RING_DEFAULT_CAPACITY;
+}
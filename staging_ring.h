@@ -0,0 +1,71 @@
+#ifndef STAGING_RING_H
+#define STAGING_RING_H
+
+#include "include/glad.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+
+// Кольцо загрузки: один большой буфер, через который идут все загрузки текстур
+// (GL_PIXEL_UNPACK_BUFFER со смещениями) и буферов (glCopyBufferSubData). Писатель
+// резервирует кусок, копирует в него данные и выдаёт команды; забор после команд
+// отмечает, когда кусок можно переписать. С GL 4.4 буфер отображён постоянно
+// (persistent + coherent), иначе каждый кусок отображается без синхронизации —
+// её заменяют те же заборы. Требует текущий GL-контекст.
+
+static const size_t STAGING_RING_DEFAULT_CAPACITY = 64u << 20;
+
+typedef struct {
+    uint64_t reservations;
+    uint64_t bytes;
+    uint64_t stalls;          // резерв ждал GPU: кольцо заполнено кусками в полёте
+    uint64_t oversize;        // больше кольца — загружено напрямую из памяти
+    uint64_t full;            // места нет, а ждать нечего: кольцо занято кусками без забора
+    double fence_wait_ms;
+    uint64_t frames;
+    uint64_t frame_bytes_max;
+} StagingRingStats;
+
+typedef struct {
+    GLsync fence;
+    size_t bytes;             // от хвоста кольца, вместе с пропуском при переходе через конец
+} StagingFence;
+
+typedef struct {
+    GLuint buffer;
+    size_t capacity;
+    bool persistent;
+    unsigned char* mapped;    // постоянное отображение; иначе — только между map и unmap
+    unsigned char* range;     // временное отображение последнего куска
+    size_t head;              // следующая запись
+    size_t tail;              // самый старый кусок, который GPU может ещё читать
+    size_t used;              // от tail до head по кольцу
+    size_t pending;           // зарезервировано после последнего забора
+    std::deque<StagingFence> fences;
+    uint64_t frame_bytes;
+    StagingRingStats stats;
+} StagingRing;
+
+// false — буфер создать не удалось; загрузки тогда идут напрямую
+bool staging_ring_init(StagingRing* ring, size_t capacity);
+void staging_ring_destroy(StagingRing* ring);
+
+// Место под size байт со смещением offset, кратным alignment (степень двойки).
+// NULL — кусок больше кольца, места нет и ждать нечего, забор не дождались или отображение
+// не удалось: грузить из памяти.
+// Отображений одновременно не больше одного: каждое закрывается staging_ring_unmap.
+unsigned char* staging_ring_map(StagingRing* ring, size_t size, size_t alignment, size_t* offset);
+// Данные записаны; дальше команды GL, читающие кольцо по смещению
+void staging_ring_unmap(StagingRing* ring);
+// Команды, читающие зарезервированное, выданы: ставит забор
+void staging_ring_fence(StagingRing* ring);
+// Раз в кадр: счётчик байт за кадр
+void staging_ring_end_frame(StagingRing* ring);
+
+// Копирует data в buffer по смещению offset через кольцо (с заборами); false — грузить напрямую
+bool staging_ring_upload_buffer(StagingRing* ring, GLuint buffer, GLintptr offset, const void* data, size_t size);
+
+// --staging-mb N (по умолчанию STAGING_RING_DEFAULT_CAPACITY); 0 — кольцо выключено
+size_t staging_ring_parse_capacity(int argc, char** argv);
+
+#endif
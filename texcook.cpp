@@ -0,0 +1,112 @@
+// Офлайн-подготовка текстур: исходное изображение -> мип-цепочка -> блочное сжатие -> KTX2/DDS.
+//   texcook <input> <output.ktx2|output.dds> [--format bc1|bc3|bc4|bc5|bc7|etc2] [--quality fast|normal|high]
+//           [--mip-filter box|kaiser|lanczos] [--no-mips] [--threads N]
+// Без --format: bc1 для изображений без альфы, bc3 — с альфой.
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "mipmap.h"
+#include "block_encoder.h"
+#include "texture_container.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static void print_usage() {
+    fprintf(stderr, "usage: texcook <input> <output.ktx2|output.dds> [--format bc1|bc3|bc4|bc5|bc7|etc2] "
+                    "[--quality fast|normal|high] [--mip-filter box|kaiser|lanczos] [--no-mips] [--threads N]\n");
+}
+
+static void push_mip_level(void* user, int level, const MipLevel* mip) {
+    block_stream_push((BlockStream*)user, level, mip->pixels.data(), mip->width, mip->height);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+    const char* input = argv[1];
+    const char* output = argv[2];
+
+    TextureContainer container;
+    if (!texture_container_from_path(output, &container)) {
+        fprintf(stderr, "Unknown container for %s: expected .ktx2 or .dds\n", output);
+        return 1;
+    }
+
+    bool format_set = false, build_mips = true;
+    BlockEncodeOptions encode = block_default_options(BLOCK_FORMAT_BC1);
+    unsigned threads = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!block_format_parse(argv[++i], &encode.format)) {
+                fprintf(stderr, "Unknown block format %s\n", argv[i]);
+                return 1;
+            }
+            format_set = true;
+        } else if (strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            if (!block_quality_parse(argv[++i], &encode.quality)) {
+                fprintf(stderr, "Unknown quality %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-mips") == 0) {
+            build_mips = false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(input, &width, &height, &channels, 0);
+    if (!pixels) {
+        fprintf(stderr, "Failed to load %s (%s)\n", input, stbi_failure_reason());
+        return 1;
+    }
+    if (!format_set)
+        encode.format = channels == 2 || channels == 4 ? BLOCK_FORMAT_BC3 : BLOCK_FORMAT_BC1;
+    const BlockFormat format = encode.format;
+    if (container == TEXTURE_CONTAINER_DDS && format == BLOCK_FORMAT_ETC2_RGB) {
+        fprintf(stderr, "DDS cannot store etc2, use .ktx2\n");
+        stbi_image_free(pixels);
+        return 1;
+    }
+
+    // Уровни сжимаются в пуле по мере построения мип-цепочки
+    BlockEncoder* encoder = block_encoder_create(threads);
+    BlockStream* stream = block_stream_begin(encoder, &encode, channels);
+    block_stream_push(stream, 0, pixels, width, height);
+    MipOptions mip_options = mip_default_options();
+    mip_options.filter = mip_parse_filter(argc, argv);
+    mip_options.level_ready = push_mip_level;
+    mip_options.level_ready_user = stream;
+    MipChain mips;
+    if (build_mips)
+        mip_build_chain(&mips, pixels, width, height, channels, &mip_options);
+
+    CompressedTexture texture;
+    block_stream_finish(stream, &texture);
+    BlockEncoderStats encoder_stats = block_encoder_stats(encoder);
+    unsigned encoder_threads = block_encoder_threads(encoder);
+    block_encoder_destroy(encoder);
+    stbi_image_free(pixels);
+
+    if (!texture_container_write(output, container, &texture)) {
+        fprintf(stderr, "Failed to write %s\n", output);
+        return 1;
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // Сравниваем с тем, что занимала бы несжатая RGBA8-текстура с мип-уровнями в видеопамяти
+    uint64_t uncompressed = 0;
+    for (const CompressedLevel& level : texture.levels)
+        uncompressed += (uint64_t)level.width * level.height * 4;
+    uint64_t compressed = compressed_texture_bytes(&texture);
+    printf("%s -> %s: %dx%d, %d levels, %s %s, %llu bytes (RGBA8 %llu, %.1fx smaller), %.1f ms\n",
+           input, output, width, height, (int)texture.levels.size(), block_format_name(format), block_quality_name(encode.quality),
+           (unsigned long long)compressed, (unsigned long long)uncompressed, (double)uncompressed / compressed, ms);
+    printf("  %llu blocks on %u threads (%s), %.0f blocks/s per core\n", (unsigned long long)encoder_stats.blocks,
+           encoder_threads, block_simd_name(), encoder_stats.busy_ms > 0.0 ? encoder_stats.blocks * 1000.0 / encoder_stats.busy_ms : 0.0);
+    return 0;
+}
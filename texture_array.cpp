@@ -0,0 +1,283 @@
+#include "texture_array.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int round_up(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Самая низкая позиция прямоугольника width x height с левым краем в начале узла index
+static bool skyline_fit(const std::vector<AtlasSkylineNode>& skyline, size_t index, int width, int height, int size, int* y) {
+    if (skyline[index].x + width > size)
+        return false;
+    int top = 0;
+    int remaining = width;
+    // Последний узел кончается на size, так что цикл не выходит за горизонт
+    for (size_t i = index; remaining > 0; i++) {
+        if (skyline[i].y > top)
+            top = skyline[i].y;
+        if (top + height > size)
+            return false;
+        remaining -= skyline[i].width;
+    }
+    *y = top;
+    return true;
+}
+
+// Bottom-left: минимальный верхний край, при равенстве — более узкий узел (меньше щелей)
+static bool skyline_insert(std::vector<AtlasSkylineNode>* skyline, int width, int height, int size, int* x, int* y) {
+    size_t best = SIZE_MAX;
+    int best_top = INT_MAX, best_width = INT_MAX;
+    for (size_t i = 0; i < skyline->size(); i++) {
+        int top;
+        if (!skyline_fit(*skyline, i, width, height, size, &top))
+            continue;
+        int node_width = (*skyline)[i].width;
+        if (top + height < best_top || (top + height == best_top && node_width < best_width)) {
+            best = i;
+            best_top = top + height;
+            best_width = node_width;
+        }
+    }
+    if (best == SIZE_MAX)
+        return false;
+
+    AtlasSkylineNode node = { (*skyline)[best].x, best_top, width };
+    *x = node.x;
+    *y = best_top - height;
+    skyline->insert(skyline->begin() + (ptrdiff_t)best, node);
+
+    // Узлы, накрытые новым, укорачиваются или уходят
+    for (size_t i = best + 1; i < skyline->size();) {
+        AtlasSkylineNode& next = (*skyline)[i];
+        int overlap = node.x + node.width - next.x;
+        if (overlap <= 0)
+            break;
+        next.x += overlap;
+        next.width -= overlap;
+        if (next.width > 0)
+            break;
+        skyline->erase(skyline->begin() + (ptrdiff_t)i);
+    }
+    // Соседи на одной высоте сливаются
+    for (size_t i = 0; i + 1 < skyline->size();) {
+        if ((*skyline)[i].y == (*skyline)[i + 1].y) {
+            (*skyline)[i].width += (*skyline)[i + 1].width;
+            skyline->erase(skyline->begin() + (ptrdiff_t)i + 1);
+        } else {
+            i++;
+        }
+    }
+    return true;
+}
+
+void texture_array_init(TextureArray* array, int size) {
+    array->size = size;
+    array->mip_levels = 1;
+    while (array->mip_levels < TEXTURE_ARRAY_MIP_LEVELS && (size >> array->mip_levels) >= 1)
+        array->mip_levels++;
+    array->gutter = TEXTURE_ARRAY_GUTTER << (array->mip_levels - 1);
+    array->texture = 0;
+    array->read_fbo = array->draw_fbo = 0;
+    array->layers.clear();
+    array->slots.clear();
+    memset(&array->stats, 0, sizeof(array->stats));
+}
+
+void texture_array_destroy(TextureArray* array) {
+    if (array->texture)
+        glDeleteTextures(1, &array->texture);
+    if (array->read_fbo)
+        glDeleteFramebuffers(1, &array->read_fbo);
+    if (array->draw_fbo)
+        glDeleteFramebuffers(1, &array->draw_fbo);
+    array->texture = 0;
+    array->read_fbo = array->draw_fbo = 0;
+    array->layers.clear();
+    array->slots.clear();
+}
+
+bool texture_array_place(TextureArray* array, TextureHandle source, int width, int height, TextureSlot* slot) {
+    if (array->texture)
+        return false;
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = 1;
+
+    TextureArraySlot placed;
+    placed.source = source;
+    placed.source_revision = UINT32_MAX; // первый sync копирует хотя бы заглушку
+    placed.whole_layer = false;
+
+    // Поле с каждой стороны и выравнивание по 2^(уровни - 1): на каждом уровне края
+    // области попадают на границы текселей, а поля не тоньше TEXTURE_ARRAY_GUTTER
+    int alignment = 1 << (array->mip_levels - 1);
+    int padded_width = round_up(width + 2 * array->gutter, alignment);
+    int padded_height = round_up(height + 2 * array->gutter, alignment);
+    if (padded_width > array->size || padded_height > array->size) {
+        placed.whole_layer = true;
+        placed.layer = (int)array->layers.size();
+        placed.x = placed.y = 0;
+        placed.width = placed.height = array->size;
+        array->layers.emplace_back();
+        array->stats.whole_layers++;
+    } else {
+        int x = 0, y = 0;
+        placed.layer = -1;
+        for (size_t layer = 0; layer < array->layers.size() && placed.layer < 0; layer++) {
+            if (!array->layers[layer].empty() && skyline_insert(&array->layers[layer], padded_width, padded_height, array->size, &x, &y))
+                placed.layer = (int)layer;
+        }
+        if (placed.layer < 0) {
+            placed.layer = (int)array->layers.size();
+            array->layers.push_back({ { 0, 0, array->size } });
+            skyline_insert(&array->layers.back(), padded_width, padded_height, array->size, &x, &y);
+        }
+        placed.x = x + array->gutter;
+        placed.y = y + array->gutter;
+        placed.width = width;
+        placed.height = height;
+        array->stats.atlas_slots++;
+        array->stats.atlas_texels += (uint64_t)padded_width * padded_height;
+    }
+    array->slots.push_back(placed);
+
+    float inverse_size = 1.0f / (float)array->size;
+    slot->layer = placed.layer;
+    slot->uv_rect[0] = placed.x * inverse_size;
+    slot->uv_rect[1] = placed.y * inverse_size;
+    slot->uv_rect[2] = placed.width * inverse_size;
+    slot->uv_rect[3] = placed.height * inverse_size;
+    return true;
+}
+
+static void create_storage(TextureArray* array) {
+    GLsizei layer_count = array->layers.empty() ? 1 : (GLsizei)array->layers.size();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glGenTextures(1, &array->texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+    array->stats.bytes = 0;
+    for (int level = 0; level < array->mip_levels; level++) {
+        GLsizei size = array->size >> level;
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, layer_count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        array->stats.bytes += (uint64_t)size * size * 4 * layer_count;
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array->mip_levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &array->read_fbo);
+    glGenFramebuffers(1, &array->draw_fbo);
+
+    // Содержимое после glTexImage3D не определено — чистим свободные места атласов
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, array->draw_fbo);
+    for (GLsizei layer = 0; layer < layer_count; layer++) {
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array->texture, 0, layer);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+}
+
+static void blit(int sx0, int sy0, int sx1, int sy1, int dx0, int dy0, int dx1, int dy1, GLenum filter) {
+    glBlitFramebuffer(sx0, sy0, sx1, sy1, dx0, dy0, dx1, dy1, GL_COLOR_BUFFER_BIT, filter);
+}
+
+// Источник растягивается в область слота, затем крайние ряды области — на поля
+static bool copy_slot(TextureArray* array, const TextureArraySlot& slot) {
+    const TextureEntry* source = slot.source;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, array->read_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source->texture, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, array->draw_fbo);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array->texture, 0, slot.layer);
+    if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE ||
+        glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return false;
+
+    int x = slot.x, y = slot.y, w = slot.width, h = slot.height;
+    blit(0, 0, source->width, source->height, x, y, x + w, y + h, GL_LINEAR);
+    if (slot.whole_layer)
+        return true;
+
+    // Поля читаются из того же слоя: области не пересекаются, так что это законно.
+    // Сначала столбцы, потом ряды во всю ширину с полями — углы заполняются сами.
+    int g = array->gutter;
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array->texture, 0, slot.layer);
+    blit(x, y, x + 1, y + h, x - g, y, x, y + h, GL_NEAREST);
+    blit(x + w - 1, y, x + w, y + h, x + w, y, x + w + g, y + h, GL_NEAREST);
+    blit(x - g, y, x + w + g, y + 1, x - g, y - g, x + w + g, y, GL_NEAREST);
+    blit(x - g, y + h - 1, x + w + g, y + h, x - g, y + h, x + w + g, y + h + g, GL_NEAREST);
+    return true;
+}
+
+void texture_array_sync(TextureArray* array) {
+    bool storage_created = false;
+    if (!array->texture) {
+        GLint previous_draw;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw);
+        create_storage(array);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)previous_draw);
+        storage_created = true;
+    }
+
+    bool changed = false;
+    GLint previous_read = 0, previous_draw = 0;
+    for (TextureArraySlot& slot : array->slots) {
+        if (!slot.source || slot.source_revision == slot.source->revision)
+            continue;
+        if (!changed) {
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw);
+            changed = true;
+        }
+        slot.source_revision = slot.source->revision;
+        if (copy_slot(array, slot)) {
+            array->stats.copies++;
+        } else {
+            array->stats.unsupported++;
+            fprintf(stderr, "Texture array: cannot copy a %dx%d texture into layer %d (not color-renderable)\n",
+                    slot.source->width, slot.source->height, slot.layer);
+        }
+    }
+    if (!changed && !storage_created)
+        return;
+    if (changed) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous_read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)previous_draw);
+    }
+
+    // Уровни всех слоёв разом: слоты меняются редко (загрузка, превью)
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    array->stats.mip_rebuilds++;
+}
+
+double texture_array_atlas_fill(const TextureArray* array) {
+    uint64_t atlas_layers = array->layers.size() - array->stats.whole_layers;
+    if (atlas_layers == 0)
+        return 0.0;
+    return (double)array->stats.atlas_texels / ((double)atlas_layers * array->size * array->size);
+}
+
+int texture_array_parse_size(int argc, char** argv) {
+    int size = TEXTURE_ARRAY_DEFAULT_SIZE;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--texture-array-size") == 0)
+            size = atoi(argv[i + 1]);
+    }
+    if (size < TEXTURE_ARRAY_MIN_SIZE)
+        size = TEXTURE_ARRAY_MIN_SIZE;
+    if (size > TEXTURE_ARRAY_MAX_SIZE)
+        size = TEXTURE_ARRAY_MAX_SIZE;
+    int power = TEXTURE_ARRAY_MIN_SIZE;
+    while (power * 2 <= size)
+        power *= 2;
+    return power;
+}
@@ -0,0 +1,93 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include "include/glad.h"
+#include "texture_cache.h"
+#include <stdint.h>
+#include <vector>
+
+// Массив текстур сцены: слои GL_TEXTURE_2D_ARRAY одного размера (RGBA8). Текстура, которая
+// не помещается в слой вместе с полями, занимает слой целиком (растягивается до него);
+// остальные упаковываются в атласы на слоях (skyline, нижний левый угол) с полями из
+// повторённых краевых текселей. Поля и выравнивание рассчитаны на все мип-уровни массива,
+// так что соседи не протекают и на дальних уровнях. Материал получает вместо своей
+// текстуры слой и прямоугольник UV — объекты с разными текстурами рисуются одним
+// инстансным вызовом.
+//
+// Пиксели копируются из записей кэша текстур на GPU (glBlitFramebuffer), поэтому заглушка,
+// превью и полная загрузка подхватываются сами. Сжатые текстуры в FBO не читаются, так что
+// источники берутся из кэша несжатыми (texture_cache_acquire_async с uncompressed). Если слот
+// всё же не скопировался, он остаётся пустым, считается в stats.unsupported и сообщается в stderr.
+
+static const int TEXTURE_ARRAY_DEFAULT_SIZE = 1024;
+static const int TEXTURE_ARRAY_MIN_SIZE = 64;
+static const int TEXTURE_ARRAY_MAX_SIZE = 8192;
+static const int TEXTURE_ARRAY_MIP_LEVELS = 5; // поля атласа растут как 2^(уровни - 1)
+static const int TEXTURE_ARRAY_GUTTER = 2;     // текселей поля на самом мелком уровне
+
+// То, что получает материал (и экземпляр в шейдере)
+typedef struct {
+    int layer;
+    float uv_rect[4]; // смещение (x, y) и масштаб (z, w) в координатах слоя
+} TextureSlot;
+
+typedef struct {
+    int x;
+    int y;      // высота занятого под отрезком [x, x + width)
+    int width;
+} AtlasSkylineNode;
+
+typedef struct {
+    TextureHandle source;
+    uint32_t source_revision; // revision записи кэша, уже скопированная в слот
+    int layer;
+    int x, y, width, height;  // область текстуры на нулевом уровне, без полей
+    bool whole_layer;
+} TextureArraySlot;
+
+typedef struct {
+    uint64_t whole_layers;
+    uint64_t atlas_slots;
+    uint64_t atlas_texels;   // занято в атласах вместе с полями и выравниванием
+    uint64_t copies;         // слот перезаписан из кэша (заглушка -> превью -> полная)
+    uint64_t unsupported;    // источник не читается через FBO
+    uint64_t mip_rebuilds;
+    uint64_t bytes;          // видеопамять массива со всеми уровнями
+} TextureArrayStats;
+
+typedef struct {
+    int size;                // сторона слоя
+    int mip_levels;
+    int gutter;              // поле на нулевом уровне: TEXTURE_ARRAY_GUTTER << (mip_levels - 1)
+    GLuint texture;          // 0 — хранилище ещё не создано (до первого texture_array_sync)
+    GLuint read_fbo;
+    GLuint draw_fbo;
+    std::vector<std::vector<AtlasSkylineNode>> layers; // горизонт атласа по слою; пусто — слой целиком
+    std::vector<TextureArraySlot> slots;
+    TextureArrayStats stats;
+} TextureArray;
+
+// Только раскладка на CPU; GL-объекты создаёт первый texture_array_sync
+void texture_array_init(TextureArray* array, int size);
+void texture_array_destroy(TextureArray* array);
+
+// Место под текстуру кэша с размером источника width x height (например, из stbi_info;
+// превью и заглушка растягиваются в ту же область). Ссылку на source держит вызывающий.
+// false — хранилище уже создано и слоёв больше не будет.
+bool texture_array_place(TextureArray* array, TextureHandle source, int width, int height, TextureSlot* slot);
+
+// Раз в кадр после texture_cache_pump: копирует в слои сменившиеся записи кэша и
+// перестраивает мип-уровни. Привязки FBO восстанавливает, привязку текстуры — нет.
+void texture_array_sync(TextureArray* array);
+
+inline GLuint texture_array_id(const TextureArray* array) {
+    return array->texture;
+}
+
+// Доля площади атласных слоёв, занятая областями с полями (0 — атласов нет)
+double texture_array_atlas_fill(const TextureArray* array);
+
+// --texture-array-size N: сторона слоя, округляется вниз до степени двойки
+int texture_array_parse_size(int argc, char** argv);
+
+#endif
@@ -0,0 +1,939 @@
+#include "texture_cache.h"
+#include "hash.h"
+#include <stb_image.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static const GLenum texture_formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+static const GLenum texture_internal_formats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+
+// Кольцо загрузки задаёт владелец GL-контекста; NULL — уровни грузятся из памяти
+static StagingRing* gl_staging = NULL;
+
+static const size_t GL_STAGING_LEVEL_ALIGNMENT = 16;
+
+void gl_texture_set_staging(StagingRing* ring) {
+    gl_staging = ring;
+}
+
+// Все уровни одним резервом в кольце; кольцо остаётся привязанным к GL_PIXEL_UNPACK_BUFFER,
+// и указатели пикселей в gl*Tex*Image2D становятся смещениями в нём.
+// false — кольца нет или место не выделено: грузить по указателям из памяти.
+static bool gl_stage_levels(const std::vector<const unsigned char*>& data, const std::vector<size_t>& sizes,
+                            std::vector<size_t>* offsets) {
+    if (!gl_staging)
+        return false;
+    offsets->resize(data.size());
+    size_t total = 0;
+    for (size_t level = 0; level < data.size(); level++) {
+        (*offsets)[level] = total;
+        total += (sizes[level] + GL_STAGING_LEVEL_ALIGNMENT - 1) / GL_STAGING_LEVEL_ALIGNMENT * GL_STAGING_LEVEL_ALIGNMENT;
+    }
+    size_t base;
+    unsigned char* staging = staging_ring_map(gl_staging, total, GL_STAGING_LEVEL_ALIGNMENT, &base);
+    if (!staging)
+        return false;
+    for (size_t level = 0; level < data.size(); level++) {
+        memcpy(staging + (*offsets)[level], data[level], sizes[level]);
+        (*offsets)[level] += base;
+    }
+    staging_ring_unmap(gl_staging);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_staging->buffer);
+    return true;
+}
+
+// Команды загрузки выданы: кольцо отвязывается, забор защищает кусок до конца чтения
+static void gl_unstage_levels() {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    staging_ring_fence(gl_staging);
+}
+
+static GLuint gl_upload_texture(const unsigned char* pixels, int width, int height, int channels, const MipChain* mips) {
+    if (channels < 1 || channels > 4)
+        return 0;
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    GLsizei levels = 1 + (mips ? (GLsizei)mips->levels.size() : 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    // Строки RGB-изображения и мелких уровней не выровнены на 4 байта
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLenum format = texture_formats[channels - 1];
+    GLenum internal_format = texture_internal_formats[channels - 1];
+
+    std::vector<const unsigned char*> level_data(1, pixels);
+    std::vector<size_t> level_sizes(1, (size_t)width * height * channels);
+    for (GLsizei level = 1; level < levels; level++) {
+        level_data.push_back(mips->levels[level - 1].pixels.data());
+        level_sizes.push_back(mips->levels[level - 1].pixels.size());
+    }
+    std::vector<size_t> offsets;
+    bool staged = gl_stage_levels(level_data, level_sizes, &offsets);
+
+    if (GLAD_GL_VERSION_4_2)
+        // Неизменяемое хранилище: драйверу не нужно проверять полноту цепочки при каждом draw
+        glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height);
+    for (GLsizei level = 0; level < levels; level++) {
+        int level_width = level == 0 ? width : mips->levels[level - 1].width;
+        int level_height = level == 0 ? height : mips->levels[level - 1].height;
+        const void* data = staged ? (const void*)(uintptr_t)offsets[level] : (const void*)level_data[level];
+        if (GLAD_GL_VERSION_4_2)
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, level_width, level_height, format, GL_UNSIGNED_BYTE, data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, internal_format, level_width, level_height, 0, format, GL_UNSIGNED_BYTE, data);
+    }
+    if (staged)
+        gl_unstage_levels();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return texture;
+}
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+static GLenum gl_compressed_format(BlockFormat format, bool srgb) {
+    switch (format) {
+        case BLOCK_FORMAT_BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BLOCK_FORMAT_BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BLOCK_FORMAT_BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case BLOCK_FORMAT_ETC2_RGB: return srgb ? GL_COMPRESSED_SRGB8_ETC2 : GL_COMPRESSED_RGB8_ETC2;
+        case BLOCK_FORMAT_BC4: return srgb ? 0 : GL_COMPRESSED_RED_RGTC1;
+        case BLOCK_FORMAT_BC5: return srgb ? 0 : GL_COMPRESSED_RG_RGTC2;
+    }
+    return 0;
+}
+
+static GLuint gl_upload_compressed_texture(const CompressedTextureView* texture) {
+    GLenum format = gl_compressed_format(texture->format, texture->srgb);
+    if (!format || texture->levels.empty())
+        return 0;
+    // Чужие ошибки не должны выглядеть как неподдержанный формат
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+
+    GLsizei levels = (GLsizei)texture->levels.size();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    std::vector<const unsigned char*> level_data;
+    std::vector<size_t> level_sizes;
+    for (const CompressedLevelView& level : texture->levels) {
+        level_data.push_back(level.data);
+        level_sizes.push_back(level.size);
+    }
+    std::vector<size_t> offsets;
+    bool staged = gl_stage_levels(level_data, level_sizes, &offsets);
+
+    if (GLAD_GL_VERSION_4_2)
+        glTexStorage2D(GL_TEXTURE_2D, levels, format, texture->width, texture->height);
+    for (GLsizei level = 0; level < levels; level++) {
+        const CompressedLevelView& data = texture->levels[level];
+        const void* pixels = staged ? (const void*)(uintptr_t)offsets[level] : (const void*)data.data;
+        if (GLAD_GL_VERSION_4_2)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, data.width, data.height, format, (GLsizei)data.size, pixels);
+        else
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, format, data.width, data.height, 0, (GLsizei)data.size, pixels);
+    }
+    if (staged)
+        gl_unstage_levels();
+
+    // Драйвер без S3TC/BPTC/ETC2 отвергнет формат — тогда откатываемся на исходник
+    if (glGetError() != GL_NO_ERROR) {
+        glDeleteTextures(1, &id);
+        return 0;
+    }
+    return id;
+}
+
+static void gl_shutdown_backend() {
+    gl_staging = NULL;
+}
+
+static void gl_destroy_texture(GLuint texture) {
+    glDeleteTextures(1, &texture);
+}
+
+const TextureBackend gl_texture_backend = { gl_upload_texture, gl_upload_compressed_texture, gl_destroy_texture, gl_shutdown_backend };
+
+// Драйверы хранят RGB8 как RGBA8, плюс ~1/3 на мип-уровни
+static uint64_t estimate_texture_bytes(int width, int height) {
+    uint64_t base = (uint64_t)width * (uint64_t)height * 4;
+    return base + base / 3;
+}
+
+static int compressed_channels(BlockFormat format) {
+    switch (format) {
+        case BLOCK_FORMAT_BC4: return 1;
+        case BLOCK_FORMAT_BC5: return 2;
+        case BLOCK_FORMAT_BC3:
+        case BLOCK_FORMAT_BC7: return 4;
+        default: return 3;
+    }
+}
+
+// Сжатая при загрузке текстура; при неподдерживаемом формате — обычная загрузка
+static GLuint upload_decoded(TextureCache* cache, const unsigned char* pixels, int width, int height, int channels,
+                             const MipChain* mips, const CompressedTexture* compressed, uint64_t* bytes) {
+    if (!compressed->levels.empty() && cache->backend.upload_compressed) {
+        CompressedTextureView view;
+        compressed_texture_view(compressed, &view);
+        if (GLuint id = cache->backend.upload_compressed(&view)) {
+            *bytes = compressed_texture_bytes(compressed);
+            cache->stats.runtime_compressed++;
+            return id;
+        }
+    }
+    *bytes = estimate_texture_bytes(width, height);
+    return cache->backend.upload(pixels, width, height, channels, mips);
+}
+
+static void push_mip_level(void* user, int level, const MipLevel* mip) {
+    block_stream_push((BlockStream*)user, level, mip->pixels.data(), mip->width, mip->height);
+}
+
+static bool read_file(const std::string& path, std::vector<unsigned char>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    data.resize((size_t)size);
+    return size == 0 || (bool)file.read((char*)data.data(), size);
+}
+
+// Запись получает текстуру (новую или уже принадлежащую другой записи)
+static void own_texture(TextureCache* cache, TextureEntry* entry, GLuint texture, uint64_t bytes) {
+    entry->texture = texture;
+    entry->bytes = bytes;
+    if (!texture || texture == cache->placeholder)
+        return;
+    TextureOwnership& ownership = cache->textures[texture];
+    if (ownership.owners++ == 0) {
+        ownership.bytes = bytes;
+        cache->stats.bytes_resident += bytes;
+    }
+}
+
+// Запись отпускает текстуру; последняя запись её удаляет
+static void release_entry_texture(TextureCache* cache, TextureEntry* entry) {
+    GLuint texture = entry->texture;
+    entry->texture = 0;
+    entry->bytes = 0;
+    auto it = cache->textures.find(texture);
+    if (it == cache->textures.end() || --it->second.owners > 0)
+        return;
+    cache->stats.bytes_resident -= it->second.bytes;
+    cache->backend.destroy(texture);
+    cache->textures.erase(it);
+}
+
+// Запись начинает показывать ту же текстуру, что и source
+static void share_texture(TextureCache* cache, TextureEntry* entry, const TextureEntry* source) {
+    own_texture(cache, entry, source->texture, source->bytes);
+    entry->content_hash = source->content_hash;
+    entry->width = source->width;
+    entry->height = source->height;
+    entry->channels = source->channels;
+    entry->revision++;
+}
+
+// Путь теперь ведёт в запись record.entry_key; списки путей обеих записей обновляются
+static void set_path(TextureCache* cache, const std::string& path, const TexturePathRecord& record) {
+    auto path_it = cache->paths.find(path);
+    if (path_it != cache->paths.end() && path_it->second.entry_key != record.entry_key) {
+        auto old = cache->entries.find(path_it->second.entry_key);
+        if (old != cache->entries.end())
+            std::erase(old->second.paths, path);
+    }
+    cache->paths[path] = record;
+    auto it = cache->entries.find(record.entry_key);
+    if (it != cache->entries.end() && std::find(it->second.paths.begin(), it->second.paths.end(), path) == it->second.paths.end())
+        it->second.paths.push_back(path);
+}
+
+// Запись переезжает под другой ключ; узел unordered_map при этом не перевыделяется,
+// так что выданные дескрипторы остаются валидными
+static void rekey_entry(TextureCache* cache, std::unordered_map<uint64_t, TextureEntry>::iterator it, uint64_t key) {
+    auto node = cache->entries.extract(it);
+    node.key() = key;
+    *node.mapped().lru_it = key;
+    for (const std::string& path : node.mapped().paths)
+        cache->paths[path].entry_key = key;
+    cache->entries.insert(std::move(node));
+}
+
+static void evict_entry(TextureCache* cache, std::unordered_map<uint64_t, TextureEntry>::iterator it) {
+    // Записи путей больше некуда вести: следующий acquire загрузит файл заново
+    for (const std::string& path : it->second.paths)
+        cache->paths.erase(path);
+    release_entry_texture(cache, &it->second);
+    cache->stats.evictions++;
+    cache->lru.erase(it->second.lru_it);
+    cache->entries.erase(it);
+}
+
+// Выгружаем давно не использованные текстуры без ссылок, пока не уложимся в бюджет
+static void evict_over_budget(TextureCache* cache) {
+    auto lru_it = cache->lru.end();
+    while (cache->stats.bytes_resident > cache->budget_bytes && lru_it != cache->lru.begin()) {
+        --lru_it;
+        auto it = cache->entries.find(*lru_it);
+        if (it == cache->entries.end() || it->second.ref_count > 0 || it->second.pending)
+            continue;
+        // erase() инвалидирует только удаляемый элемент списка
+        lru_it = std::next(lru_it);
+        evict_entry(cache, it);
+    }
+}
+
+static TextureHandle touch_entry(TextureCache* cache, TextureEntry* entry) {
+    cache->lru.splice(cache->lru.begin(), cache->lru, entry->lru_it);
+    entry->ref_count++;
+    return entry;
+}
+
+void texture_cache_init(TextureCache* cache, uint64_t budget_bytes, const TextureBackend* backend) {
+    cache->backend = *backend;
+    cache->budget_bytes = budget_bytes;
+    cache->mip_options = mip_default_options();
+    cache->compression.enabled = false;
+    cache->compression.auto_format = true;
+    cache->compression.encode = block_default_options(BLOCK_FORMAT_BC1);
+    cache->block_encoder = NULL;
+    cache->pack = NULL;
+    cache->preview_scale = 1;
+    cache->entries.clear();
+    cache->paths.clear();
+    cache->textures.clear();
+    cache->lru.clear();
+    cache->placeholder = 0;
+    cache->pending_paths.clear();
+    cache->pending_loads.clear();
+    cache->ready.clear();
+    cache->stats = {};
+}
+
+void texture_cache_shutdown(TextureCache* cache) {
+    for (auto& pair : cache->textures)
+        cache->backend.destroy(pair.first);
+    if (cache->placeholder)
+        cache->backend.destroy(cache->placeholder);
+    if (cache->backend.shutdown)
+        cache->backend.shutdown();
+    for (DecodedImage* image : cache->ready)
+        image_decoder_free(image);
+    cache->entries.clear();
+    cache->paths.clear();
+    cache->textures.clear();
+    cache->lru.clear();
+    cache->placeholder = 0;
+    cache->pending_paths.clear();
+    cache->pending_loads.clear();
+    cache->ready.clear();
+    cache->stats.bytes_resident = 0;
+    cache->stats.async_pending = 0;
+}
+
+// Канонический путь и отметки файла; false — файла нет
+static bool stat_texture_file(const char* path, std::string& key, int64_t& mtime, uint64_t& size) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    if (ec)
+        canonical = path;
+    key = canonical.generic_string();
+
+    mtime = (int64_t)fs::last_write_time(canonical, ec).time_since_epoch().count();
+    size = ec ? 0 : (uint64_t)fs::file_size(canonical, ec);
+    return !ec;
+}
+
+// Быстрый путь: файл не менялся с прошлой загрузки
+static TextureEntry* find_unchanged(TextureCache* cache, const std::string& key, int64_t mtime, uint64_t size) {
+    auto path_it = cache->paths.find(key);
+    if (path_it == cache->paths.end() || path_it->second.mtime != mtime || path_it->second.size != size)
+        return NULL;
+    auto it = cache->entries.find(path_it->second.entry_key);
+    return it != cache->entries.end() ? &it->second : NULL;
+}
+
+// С --compress несжатый вариант файла (источник для копий на GPU) живёт отдельно от сжатого:
+// у него своя запись пути и свой ключ содержимого. Без сжатия варианты совпадают
+static bool separate_uncompressed(const TextureCache* cache, bool uncompressed) {
+    return uncompressed && cache->compression.enabled;
+}
+
+static std::string record_key(const TextureCache* cache, const std::string& key, bool uncompressed) {
+    return separate_uncompressed(cache, uncompressed) ? key + "#uncompressed" : key;
+}
+
+static uint64_t content_key(const TextureCache* cache, uint64_t content_hash, bool uncompressed) {
+    return separate_uncompressed(cache, uncompressed) ? fnv1a_64("uncompressed", content_hash) : content_hash;
+}
+
+static TextureEntry* insert_entry(TextureCache* cache, uint64_t key, const TextureEntry& entry) {
+    cache->lru.push_front(key);
+    TextureEntry* inserted = &cache->entries.emplace(key, entry).first->second;
+    inserted->lru_it = cache->lru.begin();
+    return inserted;
+}
+
+// Готовая сжатая текстура от texcook: сам путь — .ktx2/.dds, либо такой файл лежит рядом
+// с исходником и не старше его
+static bool find_cooked_texture(const std::string& key, int64_t source_mtime, std::string& cooked_key, int64_t& cooked_mtime, uint64_t& cooked_size) {
+    TextureContainer container;
+    if (texture_container_from_path(key.c_str(), &container)) {
+        cooked_key = key;
+        return stat_texture_file(key.c_str(), cooked_key, cooked_mtime, cooked_size);
+    }
+    std::string stem = std::filesystem::path(key).replace_extension().generic_string();
+    static const char* const extensions[] = { ".ktx2", ".dds" };
+    for (const char* extension : extensions) {
+        if (stat_texture_file((stem + extension).c_str(), cooked_key, cooked_mtime, cooked_size) && cooked_mtime >= source_mtime)
+            return true;
+    }
+    return false;
+}
+
+// Блоки KTX2/DDS из data загружаются как есть, без копирования уровней
+static TextureHandle insert_cooked(TextureCache* cache, uint64_t content_hash, const unsigned char* data, size_t size) {
+    CompressedTextureView texture;
+    if (!texture_container_parse_view(data, size, &texture) || !cache->backend.upload_compressed)
+        return 0;
+    GLuint id = cache->backend.upload_compressed(&texture);
+    if (!id)
+        return 0;
+
+    TextureEntry entry;
+    entry.content_hash = content_hash;
+    entry.texture = 0;
+    entry.width = texture.width;
+    entry.height = texture.height;
+    entry.channels = compressed_channels(texture.format);
+    entry.bytes = 0;
+    entry.ref_count = 1;
+    entry.pending = false;
+    entry.revision = 0;
+
+    cache->stats.misses++;
+    cache->stats.cooked_loads++;
+    TextureEntry* inserted = insert_entry(cache, content_hash, entry);
+    own_texture(cache, inserted, id, compressed_view_bytes(&texture));
+    evict_over_budget(cache);
+    return inserted;
+}
+
+static TextureHandle acquire_cooked(TextureCache* cache, const std::string& key, int64_t mtime, uint64_t size) {
+    if (TextureEntry* entry = find_unchanged(cache, key, mtime, size)) {
+        cache->stats.hits++;
+        return touch_entry(cache, entry);
+    }
+
+    std::vector<unsigned char> file_data;
+    if (!read_file(key, file_data))
+        return 0;
+    uint64_t content_hash = fnv1a_64_bytes(file_data.data(), file_data.size());
+    auto it = cache->entries.find(content_hash);
+    if (it != cache->entries.end()) {
+        set_path(cache, key, { mtime, size, content_hash, content_hash });
+        cache->stats.content_hits++;
+        return touch_entry(cache, &it->second);
+    }
+
+    TextureHandle handle = insert_cooked(cache, content_hash, file_data.data(), file_data.size());
+    if (handle)
+        set_path(cache, key, { mtime, size, content_hash, content_hash });
+    return handle;
+}
+
+// Готовая текстура в пакете ресурсов: сам путь или .ktx2/.dds с тем же именем
+static const AssetPackEntry* find_packed_texture(const TextureCache* cache, const char* path) {
+    const AssetPackEntry* entry = asset_pack_find(cache->pack, path);
+    if (entry && entry->type == ASSET_TYPE_TEXTURE)
+        return entry;
+    if (!cache->pack)
+        return NULL;
+    std::string stem = std::filesystem::path(path).replace_extension().generic_string();
+    static const char* const extensions[] = { ".ktx2", ".dds" };
+    for (const char* extension : extensions) {
+        entry = asset_pack_find(cache->pack, (stem + extension).c_str());
+        if (entry && entry->type == ASSET_TYPE_TEXTURE)
+            return entry;
+    }
+    return NULL;
+}
+
+// Хеш содержимого уже записан в оглавлении, а несжатые блоки читаются прямо из отображения:
+// ни системных вызовов, ни хеширования, ни копий до буфера распаковки
+static TextureHandle acquire_packed(TextureCache* cache, const AssetPackEntry* packed) {
+    auto it = cache->entries.find(packed->content_hash);
+    if (it != cache->entries.end()) {
+        cache->stats.hits++;
+        return touch_entry(cache, &it->second);
+    }
+    std::vector<unsigned char> scratch;
+    const unsigned char* data;
+    size_t size;
+    if (!asset_pack_read(cache->pack, packed, &data, &size, &scratch))
+        return 0;
+    TextureHandle handle = insert_cooked(cache, packed->content_hash, data, size);
+    if (handle)
+        cache->stats.packed_loads++;
+    return handle;
+}
+
+TextureHandle texture_cache_acquire(TextureCache* cache, const char* path, bool uncompressed) {
+    const AssetPackEntry* packed = uncompressed ? NULL : find_packed_texture(cache, path);
+    if (packed) {
+        if (TextureHandle handle = acquire_packed(cache, packed))
+            return handle;
+    }
+
+    std::string key;
+    int64_t mtime;
+    uint64_t size;
+    if (!stat_texture_file(path, key, mtime, size)) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return 0;
+    }
+
+    std::string record = record_key(cache, key, uncompressed);
+    if (TextureEntry* entry = find_unchanged(cache, record, mtime, size)) {
+        cache->stats.hits++;
+        return touch_entry(cache, entry);
+    }
+
+    // Поиск готовой сжатой текстуры стоит нескольких stat — только после быстрого попадания
+    std::string cooked_key;
+    int64_t cooked_mtime;
+    uint64_t cooked_size;
+    if (!uncompressed && find_cooked_texture(key, mtime, cooked_key, cooked_mtime, cooked_size)) {
+        if (TextureHandle handle = acquire_cooked(cache, cooked_key, cooked_mtime, cooked_size))
+            return handle;
+    }
+
+    std::vector<unsigned char> file_data;
+    if (!read_file(key, file_data)) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return 0;
+    }
+    uint64_t content_hash = fnv1a_64_bytes(file_data.data(), file_data.size());
+    uint64_t entry_key = content_key(cache, content_hash, uncompressed);
+    auto it = cache->entries.find(entry_key);
+    if (it != cache->entries.end()) {
+        set_path(cache, record, { mtime, size, content_hash, entry_key });
+        cache->stats.content_hits++;
+        return touch_entry(cache, &it->second);
+    }
+
+    int width, height, nrChannels;
+    unsigned char* data = stbi_load_from_memory(file_data.data(), (int)file_data.size(), &width, &height, &nrChannels, 0);
+    if (!data) {
+        std::cerr << "Failed to load texture: " << path << " (" << stbi_failure_reason() << ")" << std::endl;
+        return 0;
+    }
+
+    // Уровни уходят в сжатие по мере построения цепочки
+    MipOptions mip_options = cache->mip_options;
+    BlockStream* stream = NULL;
+    if (cache->compression.enabled && !uncompressed) {
+        BlockEncodeOptions encode = block_runtime_encode_options(&cache->compression, nrChannels);
+        stream = block_stream_begin(cache->block_encoder, &encode, nrChannels);
+        block_stream_push(stream, 0, data, width, height);
+        mip_options.level_ready = push_mip_level;
+        mip_options.level_ready_user = stream;
+    }
+
+    auto mip_start = std::chrono::steady_clock::now();
+    MipChain mips;
+    mip_build_chain(&mips, data, width, height, nrChannels, &mip_options);
+    auto mip_end = std::chrono::steady_clock::now();
+    cache->stats.mip_build_ms += std::chrono::duration<double, std::milli>(mip_end - mip_start).count();
+    CompressedTexture compressed;
+    if (stream) {
+        block_stream_finish(stream, &compressed);
+        cache->stats.compress_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mip_end).count();
+    }
+
+    uint64_t bytes;
+    GLuint texture = upload_decoded(cache, data, width, height, nrChannels, &mips, &compressed, &bytes);
+    stbi_image_free(data);
+
+    TextureEntry entry;
+    entry.content_hash = content_hash;
+    entry.texture = 0;
+    entry.bytes = 0;
+    entry.width = width;
+    entry.height = height;
+    entry.channels = nrChannels;
+    entry.ref_count = 1;
+    entry.pending = false;
+    entry.revision = 0;
+
+    cache->stats.misses++;
+    cache->stats.bytes_decoded += (uint64_t)width * height * nrChannels;
+
+    TextureEntry* inserted = insert_entry(cache, entry_key, entry);
+    own_texture(cache, inserted, texture, bytes);
+    set_path(cache, record, { mtime, size, content_hash, entry_key });
+    evict_over_budget(cache);
+    return inserted;
+}
+
+// Уменьшенное декодирование есть только у JPEG; остальное превью декодировалось бы целиком
+static bool is_jpeg_path(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    for (char& c : extension)
+        c = (char)tolower((unsigned char)c);
+    return extension == ".jpg" || extension == ".jpeg";
+}
+
+TextureHandle texture_cache_acquire_async(TextureCache* cache, ImageDecoder* decoder, const char* path, bool uncompressed) {
+    const AssetPackEntry* packed = uncompressed ? NULL : find_packed_texture(cache, path);
+    if (packed) {
+        if (TextureHandle handle = acquire_packed(cache, packed))
+            return handle;
+    }
+
+    std::string key;
+    int64_t mtime;
+    uint64_t size;
+    if (!stat_texture_file(path, key, mtime, size)) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return 0;
+    }
+
+    std::string record = record_key(cache, key, uncompressed);
+    if (TextureEntry* entry = find_unchanged(cache, record, mtime, size)) {
+        cache->stats.hits++;
+        return touch_entry(cache, entry);
+    }
+
+    // Сжатые блоки декодировать не нужно — загружаем сразу, без пула потоков
+    std::string cooked_key;
+    int64_t cooked_mtime;
+    uint64_t cooked_size;
+    if (!uncompressed && find_cooked_texture(key, mtime, cooked_key, cooked_mtime, cooked_size)) {
+        if (TextureHandle handle = acquire_cooked(cache, cooked_key, cooked_mtime, cooked_size))
+            return handle;
+    }
+
+    // Уже декодируется — отдаём ту же запись
+    auto pending_it = cache->pending_paths.find(record);
+    if (pending_it != cache->pending_paths.end()) {
+        auto it = cache->entries.find(pending_it->second);
+        if (it != cache->entries.end()) {
+            cache->stats.hits++;
+            return touch_entry(cache, &it->second);
+        }
+    }
+
+    if (!cache->placeholder) {
+        static const unsigned char gray[3] = { 128, 128, 128 };
+        cache->placeholder = cache->backend.upload(gray, 1, 1, 3, NULL);
+    }
+
+    // Хеш содержимого станет известен только после декодирования,
+    // пока запись живёт под ключом от пути
+    uint64_t entry_key = fnv1a_64(record.c_str(), fnv1a_64("pending"));
+    TextureEntry* inserted;
+    auto existing = cache->entries.find(entry_key);
+    if (existing != cache->entries.end()) {
+        // Запись от прошлой загрузки этого пути (декодирование не удалось или файл с тех пор
+        // изменился) ещё живёт под тем же ключом: её дескрипторы уже выданы, поэтому
+        // декодируем заново в неё же, а до готовности остаётся прежняя текстура
+        inserted = touch_entry(cache, &existing->second);
+        inserted->pending = true;
+    } else {
+        TextureEntry entry;
+        entry.content_hash = 0;
+        entry.texture = cache->placeholder;
+        entry.width = 1;
+        entry.height = 1;
+        entry.channels = 3;
+        entry.bytes = 0;
+        entry.ref_count = 1;
+        entry.pending = true;
+        entry.revision = 0;
+        inserted = insert_entry(cache, entry_key, entry);
+    }
+
+    // Превью встаёт в начало очереди декодера, так что свободный поток возьмёт его первым
+    if (cache->preview_scale > 1 && is_jpeg_path(key)) {
+        uint64_t preview_id = image_decoder_submit_preview(decoder, key.c_str(), cache->preview_scale);
+        cache->pending_loads[preview_id] = { record, mtime, size, entry_key, true, false, uncompressed };
+    }
+    uint64_t request_id = image_decoder_submit_file(decoder, key.c_str(), 0, &cache->mip_options,
+                                                    uncompressed ? NULL : &cache->compression);
+    cache->pending_paths[record] = entry_key;
+    cache->pending_loads[request_id] = { record, mtime, size, entry_key, false, false, uncompressed };
+    cache->stats.async_pending++;
+    cache->stats.misses++;
+    return inserted;
+}
+
+// Уменьшенная копия заменяет заглушку, пока запись ждёт полного изображения
+static void show_preview(TextureCache* cache, const TexturePendingLoad& load, DecodedImage* image) {
+    auto it = cache->entries.find(load.entry_key);
+    // Полное изображение успело раньше: запись уже не ждёт или переехала под хеш содержимого
+    if (it == cache->entries.end() || !it->second.pending || !image->ok)
+        return;
+    TextureEntry* entry = &it->second;
+    GLuint texture = cache->backend.upload(image->pixels, image->width, image->height, image->channels, NULL);
+    if (!texture)
+        return;
+    release_entry_texture(cache, entry);
+    own_texture(cache, entry, texture, (uint64_t)image->width * image->height * 4);
+    entry->revision++;
+    entry->width = image->width;
+    entry->height = image->height;
+    entry->channels = image->channels;
+    cache->stats.previews++;
+}
+
+// Новая версия файла заменяет текстуру используемой записи
+static void finish_reload(TextureCache* cache, const TexturePendingLoad& load, DecodedImage* image) {
+    // Файл успели сохранить ещё раз — побеждает более поздний запрос
+    for (const auto& pair : cache->pending_loads)
+        if (pair.second.reload && pair.second.path == load.path && pair.first > image->request_id)
+            return;
+    auto it = cache->entries.find(load.entry_key);
+    if (it == cache->entries.end())
+        return;
+    if (!image->ok) {
+        std::cerr << "Failed to reload texture: " << image->path << std::endl;
+        return;
+    }
+    TextureEntry* entry = &it->second;
+    if (image->content_hash == entry->content_hash) {
+        set_path(cache, load.path, { load.mtime, load.size, image->content_hash, it->first });
+        return; // сохранили без изменений
+    }
+
+    uint64_t content = content_key(cache, image->content_hash, load.uncompressed);
+    auto existing = cache->entries.find(content);
+    bool only_path = entry->paths.empty() || (entry->paths.size() == 1 && entry->paths[0] == load.path);
+    if (!only_path && existing != cache->entries.end()) {
+        // Запись делят другие пути со старым содержимым — правленый путь уходит
+        // в запись, где новое содержимое уже загружено
+        set_path(cache, load.path, { load.mtime, load.size, image->content_hash, content });
+        cache->stats.content_hits++;
+        return;
+    }
+
+    cache->stats.mip_build_ms += image->mip_ms;
+    cache->stats.compress_ms += image->compress_ms;
+    cache->stats.bytes_decoded += (uint64_t)image->width * image->height * image->channels;
+    cache->stats.reloads++;
+
+    if (!only_path) {
+        // ...или в новую запись без ссылок. Уже выданные дескрипторы этого пути
+        // остаются со старым изображением, новое получит следующий acquire
+        TextureEntry moved;
+        moved.content_hash = image->content_hash;
+        moved.texture = 0;
+        moved.bytes = 0;
+        moved.width = image->width;
+        moved.height = image->height;
+        moved.channels = image->channels;
+        moved.ref_count = 0;
+        moved.pending = false;
+        moved.revision = 0;
+        uint64_t bytes;
+        GLuint texture = upload_decoded(cache, image->pixels, image->width, image->height, image->channels, &image->mips,
+                                        &image->compressed, &bytes);
+        TextureEntry* inserted = insert_entry(cache, content, moved);
+        own_texture(cache, inserted, texture, bytes);
+        set_path(cache, load.path, { load.mtime, load.size, image->content_hash, content });
+        return;
+    }
+
+    // Путь у записи один: текстура меняется на месте, дескрипторы и revision подхватывают её сами
+    release_entry_texture(cache, entry);
+    if (existing != cache->entries.end()) {
+        share_texture(cache, entry, &existing->second);
+    } else {
+        uint64_t bytes;
+        GLuint texture = upload_decoded(cache, image->pixels, image->width, image->height, image->channels, &image->mips,
+                                        &image->compressed, &bytes);
+        own_texture(cache, entry, texture, bytes);
+        entry->content_hash = image->content_hash;
+        entry->revision++;
+        entry->width = image->width;
+        entry->height = image->height;
+        entry->channels = image->channels;
+    }
+    set_path(cache, load.path, { load.mtime, load.size, image->content_hash, it->first });
+
+    // Старый ключ — хеш прежнего содержимого. Если новое уже загружено другой записью,
+    // эта уходит под ключ от пути, чтобы поиск по содержимому не нашёл её по старому хешу
+    uint64_t key = existing == cache->entries.end() ? content : fnv1a_64(load.path.c_str(), fnv1a_64("reloaded"));
+    if (key != it->first && cache->entries.find(key) == cache->entries.end())
+        rekey_entry(cache, it, key);
+}
+
+static void finish_pending_load(TextureCache* cache, DecodedImage* image) {
+    auto load_it = cache->pending_loads.find(image->request_id);
+    if (load_it == cache->pending_loads.end())
+        return;
+    TexturePendingLoad load = load_it->second;
+    cache->pending_loads.erase(load_it);
+    if (load.preview) {
+        show_preview(cache, load, image);
+        return;
+    }
+    if (load.reload) {
+        finish_reload(cache, load, image);
+        return;
+    }
+    cache->pending_paths.erase(load.path);
+    cache->stats.async_pending--;
+
+    auto it = cache->entries.find(load.entry_key);
+    if (it == cache->entries.end())
+        return;
+    TextureEntry* entry = &it->second;
+    entry->pending = false;
+
+    if (!image->ok) {
+        // Остаётся заглушка (или превью); запись уйдёт при вытеснении. Путь всё равно
+        // записываем: до правки файла повторный acquire — попадание, а правку подхватит reload
+        std::cerr << "Failed to load texture: " << image->path << std::endl;
+        set_path(cache, load.path, { load.mtime, load.size, 0, load.entry_key });
+        return;
+    }
+
+    cache->stats.mip_build_ms += image->mip_ms;
+    cache->stats.compress_ms += image->compress_ms;
+    cache->stats.bytes_decoded += (uint64_t)image->width * image->height * image->channels;
+    release_entry_texture(cache, entry);
+
+    // Такое содержимое уже загружено другой записью (тот же файл по другому пути).
+    // Дескрипторы этой записи уже выданы, поэтому она остаётся под ключом пути
+    // и делит с той GL-текстуру вместо второй загрузки
+    uint64_t content = content_key(cache, image->content_hash, load.uncompressed);
+    auto existing = cache->entries.find(content);
+    if (existing != cache->entries.end()) {
+        share_texture(cache, entry, &existing->second);
+        cache->stats.content_hits++;
+        set_path(cache, load.path, { load.mtime, load.size, image->content_hash, load.entry_key });
+        return;
+    }
+
+    uint64_t bytes;
+    GLuint texture = upload_decoded(cache, image->pixels, image->width, image->height, image->channels, &image->mips,
+                                    &image->compressed, &bytes);
+    own_texture(cache, entry, texture, bytes);
+    entry->content_hash = image->content_hash;
+    entry->revision++;
+    entry->width = image->width;
+    entry->height = image->height;
+    entry->channels = image->channels;
+    cache->stats.async_uploads++;
+    set_path(cache, load.path, { load.mtime, load.size, image->content_hash, load.entry_key });
+    rekey_entry(cache, it, content); // под ключ содержимого
+}
+
+int texture_cache_pump(TextureCache* cache, ImageDecoder* decoder, uint64_t upload_budget_bytes) {
+    DecodedImage* image;
+    while (image_decoder_poll(decoder, &image))
+        cache->ready.push_back(image);
+
+    int uploads = 0;
+    uint64_t uploaded_bytes = 0;
+    while (!cache->ready.empty()) {
+        image = cache->ready.front();
+        uint64_t bytes = image->compressed.levels.empty() ? (uint64_t)image->width * image->height * image->channels
+                                                          : compressed_texture_bytes(&image->compressed);
+        if (uploads > 0 && uploaded_bytes + bytes > upload_budget_bytes)
+            break;
+        cache->ready.pop_front();
+        finish_pending_load(cache, image);
+        image_decoder_free(image);
+        uploaded_bytes += bytes;
+        uploads++;
+    }
+
+    cache->stats.bytes_uploaded_last_pump = uploaded_bytes;
+    if (uploads > 0)
+        evict_over_budget(cache);
+    return uploads;
+}
+
+void texture_cache_release(TextureCache* cache, TextureHandle handle) {
+    if (!handle)
+        return;
+    if (handle->ref_count > 0)
+        handle->ref_count--;
+    if (handle->ref_count == 0)
+        evict_over_budget(cache);
+}
+
+bool texture_cache_reload(TextureCache* cache, ImageDecoder* decoder, const char* path) {
+    std::string key;
+    int64_t mtime;
+    uint64_t size;
+    if (!stat_texture_file(path, key, mtime, size))
+        return false;
+    // Сжатый и несжатый варианты файла перезагружаются каждый в свою запись
+    bool reloaded = false;
+    for (bool uncompressed : { false, true }) {
+        if (uncompressed && !separate_uncompressed(cache, uncompressed))
+            break;
+        std::string record = record_key(cache, key, uncompressed);
+        auto path_it = cache->paths.find(record);
+        if (path_it == cache->paths.end())
+            continue;
+        auto it = cache->entries.find(path_it->second.entry_key);
+        if (it == cache->entries.end() || it->second.ref_count == 0)
+            continue;
+
+        uint64_t request_id = image_decoder_submit_file(decoder, key.c_str(), 0, &cache->mip_options,
+                                                        uncompressed ? NULL : &cache->compression);
+        cache->pending_loads[request_id] = { record, mtime, size, it->first, false, true, uncompressed };
+        reloaded = true;
+    }
+    return reloaded;
+}
+
+int texture_cache_parse_preview_scale(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--texture-preview") == 0) {
+            int scale = atoi(argv[i + 1]);
+            return scale >= 8 ? 8 : scale >= 4 ? 4 : scale >= 2 ? 2 : 1;
+        }
+    }
+    return TEXTURE_PREVIEW_DEFAULT_SCALE;
+}
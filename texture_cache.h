@@ -0,0 +1,153 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "include/glad.h"
+#include "image_decoder.h"
+#include "mipmap.h"
+#include "texture_container.h"
+#include "asset_pack.h"
+#include "staging_ring.h"
+#include <stdint.h>
+#include <deque>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Бэкенд создания/удаления текстур. По умолчанию — OpenGL,
+// но можно подставить свой (например, для проверки кэша без GL-контекста).
+// mips — готовая мип-цепочка (уровни 1..N) или NULL для текстуры из одного уровня.
+// upload_compressed загружает блоки KTX2/DDS как есть; 0 — формат не поддерживается.
+// shutdown отпускает общие ресурсы бэкенда, может быть NULL.
+typedef struct {
+    GLuint (*upload)(const unsigned char* pixels, int width, int height, int channels, const MipChain* mips);
+    GLuint (*upload_compressed)(const CompressedTextureView* texture);
+    void (*destroy)(GLuint texture);
+    void (*shutdown)();
+} TextureBackend;
+
+extern const TextureBackend gl_texture_backend;
+// Уровни текстур OpenGL-бэкенда идут через кольцо загрузки; NULL — напрямую из памяти
+void gl_texture_set_staging(StagingRing* ring);
+
+static const int TEXTURE_PREVIEW_DEFAULT_SCALE = 8;
+
+typedef struct {
+    uint64_t hits;           // путь + mtime совпали, файл даже не открывали
+    uint64_t content_hits;   // файл прочитан, но такой контент уже загружен
+    uint64_t misses;         // полное декодирование и загрузка
+    uint64_t evictions;
+    uint64_t bytes_resident; // оценка занимаемой видеопамяти (с мип-уровнями)
+    uint64_t bytes_decoded;  // суммарно декодировано байт пикселей
+    uint64_t async_pending;  // ждут декодирования или загрузки
+    uint64_t async_uploads;
+    uint64_t bytes_uploaded_last_pump;
+    double mip_build_ms;     // суммарное время построения мип-цепочек на CPU
+    uint64_t cooked_loads;   // загружено готовых сжатых текстур (texcook) без декодирования
+    uint64_t packed_loads;   // из них — из пакета ресурсов, прямо из отображения файла
+    uint64_t runtime_compressed; // сжато при загрузке (--compress)
+    double compress_ms;      // ожидание сжатия сверх построения мип-цепочек
+    uint64_t previews;       // показано уменьшенных копий JPEG до полной загрузки
+    uint64_t reloads;        // текстур заменено на месте после правки файла
+} TextureCacheStats;
+
+struct TextureEntry {
+    uint64_t content_hash;
+    GLuint texture;
+    int width;
+    int height;
+    int channels;
+    uint64_t bytes;
+    int ref_count;
+    bool pending;            // пока true, texture — общая текстура-заглушка
+    uint32_t revision;       // растёт при каждой замене texture (превью, полная загрузка)
+    std::vector<std::string> paths; // записи путей (ключи TextureCache::paths), ведущие сюда
+    std::list<uint64_t>::iterator lru_it;
+};
+
+// Разделяемый дескриптор текстуры; 0 — текстура не загружена
+typedef TextureEntry* TextureHandle;
+
+typedef struct {
+    int64_t mtime;
+    uint64_t size;
+    uint64_t content_hash;
+    uint64_t entry_key;      // запись, которую получил этот путь; не всегда равен content_hash
+} TexturePathRecord;
+
+// GL-текстуру могут делить несколько записей: одинаковое содержимое, дошедшее через
+// асинхронную загрузку под ключом пути. Удаляется и выходит из bytes_resident с последней
+typedef struct {
+    int owners;
+    uint64_t bytes;
+} TextureOwnership;
+
+typedef struct {
+    std::string path;
+    int64_t mtime;
+    uint64_t size;
+    uint64_t entry_key;
+    bool preview;            // уменьшенная копия; полная загрузка идёт отдельным запросом
+    bool reload;             // файл изменился на диске; запись уже загружена и используется
+    bool uncompressed;       // без сжатия при загрузке; path — ключ записи пути этого варианта
+} TexturePendingLoad;
+
+typedef struct {
+    TextureBackend backend;
+    uint64_t budget_bytes;
+    MipOptions mip_options;  // мип-уровни строятся на CPU: в потоках декодера или при синхронной загрузке
+    BlockRuntimeOptions compression; // сжатие несжатых исходников при загрузке; по умолчанию выключено
+    BlockEncoder* block_encoder;     // пул для синхронной загрузки; NULL — сжатие в вызывающем потоке
+    const AssetPack* pack;           // готовые текстуры из пакета берутся раньше файлов; NULL — нет пакета
+    int preview_scale;               // асинхронный JPEG сначала показывается в 1/preview_scale; 1 — без превью
+    // Ключ — хеш содержимого файла, так что один и тот же файл
+    // по разным путям (или после touch) декодируется один раз
+    std::unordered_map<uint64_t, TextureEntry> entries;
+    std::unordered_map<std::string, TexturePathRecord> paths;
+    std::unordered_map<GLuint, TextureOwnership> textures; // все текстуры записей, кроме заглушки
+    std::list<uint64_t> lru; // в начале — недавно использованные
+    GLuint placeholder;
+    std::unordered_map<std::string, uint64_t> pending_paths;      // путь -> ключ записи
+    std::unordered_map<uint64_t, TexturePendingLoad> pending_loads; // id запроса декодера -> загрузка
+    std::deque<DecodedImage*> ready; // декодированы, но не влезли в бюджет кадра
+    TextureCacheStats stats;
+} TextureCache;
+
+void texture_cache_init(TextureCache* cache, uint64_t budget_bytes, const TextureBackend* backend = &gl_texture_backend);
+void texture_cache_shutdown(TextureCache* cache);
+
+// Возвращает текстуру из кэша (или загружает её) и увеличивает счётчик ссылок.
+// Если в пакете ресурсов или рядом с исходником есть image.ktx2 или image.dds (на диске —
+// не старше исходника), берётся он.
+// uncompressed — текстура из пикселей исходника (RGBA8 и т.п.), которую можно прочитать через FBO:
+// пакет, texcook и --compress пропускаются, с --compress такой вариант кэшируется отдельно.
+TextureHandle texture_cache_acquire(TextureCache* cache, const char* path, bool uncompressed = false);
+// Асинхронный вариант: декодирование уходит в пул потоков, а до загрузки
+// дескриптор указывает на текстуру-заглушку. С preview_scale > 1 заглушку для JPEG
+// вскоре сменяет уменьшенная копия (IDCT сразу в уменьшенном размере), затем — полная текстура.
+TextureHandle texture_cache_acquire_async(TextureCache* cache, ImageDecoder* decoder, const char* path,
+                                          bool uncompressed = false);
+
+// Вызывается в потоке рендера раз в кадр: забирает готовые изображения и
+// загружает их в GL, пока не исчерпан бюджет (хотя бы одно за кадр). Возвращает число загрузок.
+int texture_cache_pump(TextureCache* cache, ImageDecoder* decoder, uint64_t upload_budget_bytes);
+
+void texture_cache_release(TextureCache* cache, TextureHandle handle);
+
+// Файл path изменился на диске: если его текстура используется, она декодируется заново
+// в пуле потоков, а texture_cache_pump подменяет её в той же записи (дескрипторы не меняются,
+// revision растёт). Записи без ссылок не трогаются — их отсеет сверка mtime при следующем
+// acquire. Одинаковые по содержимому файлы делят запись; если её делят и другие пути,
+// правленый файл переезжает в свою запись — выданные по нему дескрипторы остаются со старым
+// изображением, а новое получит следующий acquire.
+// Готовые сжатые текстуры (texcook) не перезагружаются: их надо пересобрать.
+bool texture_cache_reload(TextureCache* cache, ImageDecoder* decoder, const char* path);
+
+// --texture-preview N (2, 4 или 8; по умолчанию TEXTURE_PREVIEW_DEFAULT_SCALE); 1 — без превью
+int texture_cache_parse_preview_scale(int argc, char** argv);
+
+inline GLuint texture_handle_id(TextureHandle handle) {
+    return handle ? handle->texture : 0;
+}
+
+#endif
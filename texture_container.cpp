@@ -0,0 +1,358 @@
+#include "texture_container.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+
+typedef struct {
+    BlockFormat format;
+    uint32_t vk_format;    // KTX2
+    uint32_t dxgi_format;  // DDS DX10; 0 — только FourCC
+    const char* fourcc;    // DDS; NULL — только DX10
+    uint32_t df_model;     // модель цвета в Data Format Descriptor KTX2
+    uint32_t df_channels[2]; // каналы сэмплов по 64 бита; ~0u — сэмпла нет
+    bool srgb_next;        // vk_format + 1 и dxgi_format + 1 — _SRGB-вариант (у BC4/BC5 там _SNORM)
+} BlockFormatInfo;
+
+static const uint32_t NO_CHANNEL = ~0u;
+
+static const BlockFormatInfo block_format_info[BLOCK_FORMAT_COUNT] = {
+    { BLOCK_FORMAT_BC1, 131, 71, "DXT1", 128, { 0, NO_CHANNEL }, true },       // BC1_RGB_UNORM, KHR_DF_MODEL_BC1A
+    { BLOCK_FORMAT_BC3, 137, 77, "DXT5", 130, { 15, 0 }, true },               // BC3_UNORM: альфа, затем цвет
+    { BLOCK_FORMAT_BC7, 145, 98, NULL, 134, { 0, NO_CHANNEL }, true },         // BC7_UNORM, 128-битный сэмпл
+    { BLOCK_FORMAT_ETC2_RGB, 147, 0, NULL, 161, { 2, NO_CHANNEL }, true },     // ETC2_R8G8B8_UNORM, канал COLOR
+    { BLOCK_FORMAT_BC4, 139, 80, "ATI1", 131, { 0, NO_CHANNEL }, false },      // BC4_UNORM, канал R
+    { BLOCK_FORMAT_BC5, 141, 83, "ATI2", 132, { 0, 1 }, false },               // BC5_UNORM: R, затем G
+};
+
+static const unsigned char ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+bool texture_container_from_path(const char* path, TextureContainer* container) {
+    const char* dot = strrchr(path, '.');
+    if (!dot)
+        return false;
+    std::string extension(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+    if (extension == "ktx2") {
+        *container = TEXTURE_CONTAINER_KTX2;
+        return true;
+    }
+    if (extension == "dds") {
+        *container = TEXTURE_CONTAINER_DDS;
+        return true;
+    }
+    return false;
+}
+
+uint64_t compressed_texture_bytes(const CompressedTexture* texture) {
+    uint64_t bytes = 0;
+    for (const CompressedLevel& level : texture->levels)
+        bytes += level.data.size();
+    return bytes;
+}
+
+uint64_t compressed_view_bytes(const CompressedTextureView* texture) {
+    uint64_t bytes = 0;
+    for (const CompressedLevelView& level : texture->levels)
+        bytes += level.size;
+    return bytes;
+}
+
+static void put_u32(std::vector<unsigned char>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void put_u64(std::vector<unsigned char>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void set_u64(std::vector<unsigned char>& out, size_t offset, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        out[offset + i] = (unsigned char)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t get_u64(const unsigned char* data) {
+    return (uint64_t)get_u32(data) | ((uint64_t)get_u32(data + 4) << 32);
+}
+
+// Размеры из заголовка проверяются до приведения к int, а число уровней не больше полной
+// цепочки: иначе испорченный файл заказал бы огромный resize и сдвиги на 32 бита и больше
+static bool check_dimensions(uint32_t width, uint32_t height, uint32_t* level_count) {
+    if (width == 0 || height == 0 || width > TEXTURE_CONTAINER_MAX_SIZE || height > TEXTURE_CONTAINER_MAX_SIZE)
+        return false;
+    uint32_t full_chain = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        full_chain++;
+    *level_count = std::min(std::max(1u, *level_count), full_chain);
+    return true;
+}
+
+// --- KTX2 ------------------------------------------------------------------
+
+static void write_ktx2(std::vector<unsigned char>& out, const CompressedTexture* texture) {
+    const BlockFormatInfo& info = block_format_info[texture->format];
+    const uint32_t block_bytes = (uint32_t)block_format_bytes(texture->format);
+    const uint32_t level_count = (uint32_t)texture->levels.size();
+
+    int sample_count = 0;
+    for (uint32_t channel : info.df_channels)
+        sample_count += channel != NO_CHANNEL;
+    const uint32_t dfd_size = 4 + 24 + 16 * sample_count;
+    const uint32_t dfd_offset = 80 + 24 * level_count;
+
+    out.insert(out.end(), ktx2_identifier, ktx2_identifier + 12);
+    put_u32(out, info.vk_format);
+    put_u32(out, 1); // typeSize для блочных форматов
+    put_u32(out, (uint32_t)texture->width);
+    put_u32(out, (uint32_t)texture->height);
+    put_u32(out, 0); // pixelDepth
+    put_u32(out, 0); // layerCount
+    put_u32(out, 1); // faceCount
+    put_u32(out, level_count);
+    put_u32(out, 0); // supercompressionScheme
+    put_u32(out, dfd_offset);
+    put_u32(out, dfd_size);
+    put_u32(out, 0); // kvdByteOffset
+    put_u32(out, 0); // kvdByteLength
+    put_u64(out, 0); // sgdByteOffset
+    put_u64(out, 0); // sgdByteLength
+
+    size_t level_index = out.size();
+    out.resize(out.size() + 24 * level_count, 0);
+
+    // Базовый блок Data Format Descriptor
+    put_u32(out, dfd_size);
+    put_u32(out, 0);                                  // vendorId KHRONOS, descriptorType BASICFORMAT
+    put_u32(out, 2 | ((24 + 16 * sample_count) << 16)); // versionNumber 1.3, descriptorBlockSize
+    put_u32(out, info.df_model | (1 << 8) | (1 << 16)); // BT.709, линейная передаточная функция, прямая альфа
+    put_u32(out, 3 | (3 << 8));                       // блок 4x4x1
+    put_u32(out, block_bytes);                        // bytesPlane0
+    put_u32(out, 0);
+    for (int s = 0; s < 2; s++) {
+        if (info.df_channels[s] == NO_CHANNEL)
+            continue;
+        uint32_t bit_length = sample_count == 1 ? block_bytes * 8 - 1 : 63;
+        put_u32(out, (uint32_t)(s * 64) | (bit_length << 16) | (info.df_channels[s] << 24));
+        put_u32(out, 0);          // samplePosition
+        put_u32(out, 0);          // sampleLower
+        put_u32(out, 0xffffffffu); // sampleUpper
+    }
+
+    // Данные уровней — от меньшего к большему, с выравниванием на размер блока
+    for (int level = (int)level_count - 1; level >= 0; level--) {
+        while (out.size() % block_bytes)
+            out.push_back(0);
+        const CompressedLevel& data = texture->levels[level];
+        set_u64(out, level_index + 24 * level, out.size());
+        set_u64(out, level_index + 24 * level + 8, data.data.size());
+        set_u64(out, level_index + 24 * level + 16, data.data.size());
+        out.insert(out.end(), data.data.begin(), data.data.end());
+    }
+}
+
+// Знаковые варианты (_SNORM) не принимаются: блоки загрузились бы как беззнаковые
+static bool format_from_vk(uint32_t vk_format, BlockFormat* format, bool* srgb) {
+    for (const BlockFormatInfo& info : block_format_info) {
+        if (info.vk_format == vk_format || (info.srgb_next && info.vk_format + 1 == vk_format)) {
+            *format = info.format;
+            *srgb = info.vk_format != vk_format;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_ktx2(const unsigned char* data, size_t size, CompressedTextureView* texture) {
+    if (size < 80 || memcmp(data, ktx2_identifier, 12) != 0)
+        return false;
+    if (!format_from_vk(get_u32(data + 12), &texture->format, &texture->srgb))
+        return false;
+    uint32_t level_count = get_u32(data + 40);
+    if (!check_dimensions(get_u32(data + 20), get_u32(data + 24), &level_count))
+        return false;
+    texture->width = (int)get_u32(data + 20);
+    texture->height = (int)get_u32(data + 24);
+    if (get_u32(data + 44) != 0 || size < 80 + 24 * (size_t)level_count)
+        return false; // суперсжатие не поддерживаем
+
+    texture->levels.resize(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        const unsigned char* entry = data + 80 + 24 * level;
+        uint64_t offset = get_u64(entry), length = get_u64(entry + 8);
+        if (offset > size || length > size - offset)
+            return false;
+        CompressedLevelView& out = texture->levels[level];
+        out.width = std::max(1, texture->width >> level);
+        out.height = std::max(1, texture->height >> level);
+        if (length != block_compressed_size(texture->format, out.width, out.height))
+            return false;
+        out.data = data + offset;
+        out.size = (size_t)length;
+    }
+    return true;
+}
+
+// --- DDS -------------------------------------------------------------------
+
+static const uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000;
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+static const uint32_t DDPF_FOURCC = 0x4;
+static const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+static const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+static uint32_t fourcc(const char* code) {
+    return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+static bool write_dds(std::vector<unsigned char>& out, const CompressedTexture* texture) {
+    const BlockFormatInfo& info = block_format_info[texture->format];
+    if (!info.fourcc && !info.dxgi_format)
+        return false;
+    const uint32_t level_count = (uint32_t)texture->levels.size();
+
+    put_u32(out, fourcc("DDS "));
+    put_u32(out, 124);
+    put_u32(out, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+    put_u32(out, (uint32_t)texture->height);
+    put_u32(out, (uint32_t)texture->width);
+    put_u32(out, (uint32_t)texture->levels[0].data.size());
+    put_u32(out, 0); // depth
+    put_u32(out, level_count);
+    for (int i = 0; i < 11; i++)
+        put_u32(out, 0);
+    put_u32(out, 32); // DDS_PIXELFORMAT
+    put_u32(out, DDPF_FOURCC);
+    put_u32(out, fourcc(info.fourcc ? info.fourcc : "DX10"));
+    for (int i = 0; i < 5; i++)
+        put_u32(out, 0);
+    put_u32(out, DDSCAPS_TEXTURE | (level_count > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+    for (int i = 0; i < 4; i++)
+        put_u32(out, 0);
+    if (!info.fourcc) {
+        put_u32(out, info.dxgi_format);
+        put_u32(out, DDS_DIMENSION_TEXTURE2D);
+        put_u32(out, 0); // miscFlag
+        put_u32(out, 1); // arraySize
+        put_u32(out, 0); // miscFlags2
+    }
+    for (const CompressedLevel& level : texture->levels)
+        out.insert(out.end(), level.data.begin(), level.data.end());
+    return true;
+}
+
+static bool parse_dds(const unsigned char* data, size_t size, CompressedTextureView* texture) {
+    if (size < 128 || get_u32(data) != fourcc("DDS ") || get_u32(data + 4) != 124)
+        return false;
+    uint32_t level_count = get_u32(data + 28);
+    if (!check_dimensions(get_u32(data + 16), get_u32(data + 12), &level_count))
+        return false;
+    texture->height = (int)get_u32(data + 12);
+    texture->width = (int)get_u32(data + 16);
+    uint32_t code = get_u32(data + 84);
+    size_t offset = 128;
+
+    bool known = false;
+    if (code == fourcc("DX10")) {
+        if (size < 148)
+            return false;
+        uint32_t dxgi = get_u32(data + 128);
+        offset = 148;
+        for (const BlockFormatInfo& info : block_format_info) {
+            // У BC1/BC3/BC7 следующий код DXGI — _SRGB-вариант, у BC4/BC5 — _SNORM, который не принимаем
+            if (info.dxgi_format && (dxgi == info.dxgi_format || (info.srgb_next && dxgi == info.dxgi_format + 1))) {
+                texture->format = info.format;
+                texture->srgb = dxgi != info.dxgi_format;
+                known = true;
+            }
+        }
+    } else {
+        for (const BlockFormatInfo& info : block_format_info) {
+            if (info.fourcc && code == fourcc(info.fourcc)) {
+                texture->format = info.format;
+                known = true;
+            }
+        }
+    }
+    if (!known)
+        return false;
+
+    texture->levels.resize(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        CompressedLevelView& out = texture->levels[level];
+        out.width = std::max(1, texture->width >> level);
+        out.height = std::max(1, texture->height >> level);
+        size_t length = block_compressed_size(texture->format, out.width, out.height);
+        if (length > size - offset)
+            return false;
+        out.data = data + offset;
+        out.size = length;
+        offset += length;
+    }
+    return true;
+}
+
+// --- Общий интерфейс -------------------------------------------------------
+
+bool texture_container_write(const char* path, TextureContainer container, const CompressedTexture* texture) {
+    if (texture->levels.empty())
+        return false;
+    std::vector<unsigned char> out;
+    if (container == TEXTURE_CONTAINER_KTX2)
+        write_ktx2(out, texture);
+    else if (!write_dds(out, texture))
+        return false;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write((const char*)out.data(), (std::streamsize)out.size());
+    return (bool)file;
+}
+
+bool texture_container_parse_view(const unsigned char* data, size_t size, CompressedTextureView* texture) {
+    texture->levels.clear();
+    texture->srgb = false;
+    if (size >= 12 && memcmp(data, ktx2_identifier, 12) == 0)
+        return parse_ktx2(data, size, texture);
+    return parse_dds(data, size, texture);
+}
+
+bool texture_container_parse(const unsigned char* data, size_t size, CompressedTexture* texture) {
+    CompressedTextureView view;
+    texture->levels.clear();
+    if (!texture_container_parse_view(data, size, &view))
+        return false;
+    texture->format = view.format;
+    texture->width = view.width;
+    texture->height = view.height;
+    for (const CompressedLevelView& level : view.levels)
+        texture->levels.push_back({ level.width, level.height, std::vector<unsigned char>(level.data, level.data + level.size) });
+    return true;
+}
+
+void compressed_texture_view(const CompressedTexture* texture, CompressedTextureView* view) {
+    view->format = texture->format;
+    view->srgb = false;
+    view->width = texture->width;
+    view->height = texture->height;
+    view->levels.clear();
+    for (const CompressedLevel& level : texture->levels)
+        view->levels.push_back({ level.width, level.height, level.data.data(), level.data.size() });
+}
+
+bool texture_container_read(const char* path, CompressedTexture* texture) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::vector<unsigned char> data((size_t)file.tellg());
+    file.seekg(0, std::ios::beg);
+    if (!file.read((char*)data.data(), (std::streamsize)data.size()))
+        return false;
+    return texture_container_parse(data.data(), data.size(), texture);
+}
@@ -0,0 +1,64 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include "block_compress.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Готовые к загрузке сжатые текстуры в контейнерах KTX2 и DDS.
+// Уровни хранятся блоками как есть — загрузка идёт через glCompressedTexImage2D без декодирования.
+
+// Файлы с нулевой стороной или больше этого не читаются (GL_MAX_TEXTURE_SIZE у GL 4.x — не меньше 16384)
+static const uint32_t TEXTURE_CONTAINER_MAX_SIZE = 16384;
+
+typedef struct {
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+} CompressedLevel;
+
+typedef struct {
+    BlockFormat format;
+    int width;
+    int height;
+    std::vector<CompressedLevel> levels; // начиная с нулевого
+} CompressedTexture;
+
+// Те же уровни без копирования: указывают в чужой буфер (прочитанный файл,
+// отображённый в память пакет ресурсов), который должен пережить view
+typedef struct {
+    int width;
+    int height;
+    const unsigned char* data;
+    size_t size;
+} CompressedLevelView;
+
+typedef struct {
+    BlockFormat format;
+    bool srgb;               // файл помечен как _SRGB (BC1/BC3/BC7/ETC2); CompressedTexture всегда линейная
+    int width;
+    int height;
+    std::vector<CompressedLevelView> levels;
+} CompressedTextureView;
+
+typedef enum {
+    TEXTURE_CONTAINER_KTX2,
+    TEXTURE_CONTAINER_DDS
+} TextureContainer;
+
+// По расширению .ktx2 / .dds; false — не контейнер сжатых текстур
+bool texture_container_from_path(const char* path, TextureContainer* container);
+
+// DDS не умеет ETC2 — для него false
+bool texture_container_write(const char* path, TextureContainer container, const CompressedTexture* texture);
+bool texture_container_read(const char* path, CompressedTexture* texture);
+bool texture_container_parse(const unsigned char* data, size_t size, CompressedTexture* texture);
+// Без копирования уровней: view указывает внутрь data
+bool texture_container_parse_view(const unsigned char* data, size_t size, CompressedTextureView* texture);
+void compressed_texture_view(const CompressedTexture* texture, CompressedTextureView* view);
+
+uint64_t compressed_texture_bytes(const CompressedTexture* texture);
+uint64_t compressed_view_bytes(const CompressedTextureView* texture);
+
+#endif
@@ -0,0 +1,235 @@
+#include "transform.h"
+#include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+// AVX2-ядро собирается всегда и выбирается по cpuid: сборка остаётся переносимой
+#define TRANSFORM_HAVE_AVX2 1
+#define TRANSFORM_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFORM_HAVE_SSE2 1
+#endif
+
+typedef struct {
+    float vp[16];
+    const float* in[12];
+    float* mvp[16];     // mvp[0] == NULL — MVP не нужны
+    float* normal[9];   // normal[0] == NULL — нормальные матрицы не нужны
+    size_t count;       // кратно TRANSFORM_BATCH_WIDTH
+} TransformBatch;
+
+static size_t padded_count(size_t count) {
+    return (count + TRANSFORM_BATCH_WIDTH - 1) / TRANSFORM_BATCH_WIDTH * TRANSFORM_BATCH_WIDTH;
+}
+
+void transform_soa_resize(TransformSoA* soa, size_t count) {
+    for (std::vector<float>& component : soa->affine)
+        component.resize(padded_count(count), 0.0f);
+    soa->count = count;
+}
+
+void transform_soa_set(TransformSoA* soa, size_t index, const glm::mat4& model) {
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 3; r++)
+            soa->affine[c * 3 + r][index] = model[c][r];
+}
+
+glm::mat4 transform_soa_get(const TransformSoA* soa, size_t index) {
+    glm::mat4 model(1.0f);
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 3; r++)
+            model[c][r] = soa->affine[c * 3 + r][index];
+    return model;
+}
+
+// Эталон. mvp(r, c) = vp(r, 0..2) * model(0..2, c) [+ vp(r, 3) для столбца переноса];
+// нормальная матрица — (M^-1)^T = [c1 x c2, c2 x c0, c0 x c1] / det для столбцов c0..c2
+static void batch_scalar(const TransformBatch* b) {
+    const float* vp = b->vp;
+    for (size_t i = 0; i < b->count; i++) {
+        float a[12];
+        for (int k = 0; k < 12; k++)
+            a[k] = b->in[k][i];
+        if (b->mvp[0]) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    float v = vp[r] * a[c * 3] + vp[4 + r] * a[c * 3 + 1] + vp[8 + r] * a[c * 3 + 2];
+                    if (c == 3)
+                        v += vp[12 + r];
+                    b->mvp[c * 4 + r][i] = v;
+                }
+            }
+        }
+        if (b->normal[0]) {
+            float n[9] = {
+                a[4] * a[8] - a[5] * a[7], a[5] * a[6] - a[3] * a[8], a[3] * a[7] - a[4] * a[6],
+                a[7] * a[2] - a[8] * a[1], a[8] * a[0] - a[6] * a[2], a[6] * a[1] - a[7] * a[0],
+                a[1] * a[5] - a[2] * a[4], a[2] * a[3] - a[0] * a[5], a[0] * a[4] - a[1] * a[3],
+            };
+            float inverse_det = 1.0f / (a[0] * n[0] + a[1] * n[1] + a[2] * n[2]);
+            for (int k = 0; k < 9; k++)
+                b->normal[k][i] = n[k] * inverse_det;
+        }
+    }
+}
+
+#ifdef TRANSFORM_HAVE_SSE2
+static void batch_sse2(const TransformBatch* b) {
+    __m128 vp[16];
+    for (int k = 0; k < 16; k++)
+        vp[k] = _mm_set1_ps(b->vp[k]);
+    for (size_t i = 0; i < b->count; i += 4) {
+        __m128 a[12];
+        for (int k = 0; k < 12; k++)
+            a[k] = _mm_loadu_ps(b->in[k] + i);
+        if (b->mvp[0]) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vp[r], a[c * 3]), _mm_mul_ps(vp[4 + r], a[c * 3 + 1])),
+                                          _mm_mul_ps(vp[8 + r], a[c * 3 + 2]));
+                    if (c == 3)
+                        v = _mm_add_ps(v, vp[12 + r]);
+                    _mm_storeu_ps(b->mvp[c * 4 + r] + i, v);
+                }
+            }
+        }
+        if (b->normal[0]) {
+            __m128 n[9];
+            for (int c = 0; c < 3; c++) {
+                // Столбец c — векторное произведение двух других столбцов по кругу
+                const __m128* x = a + ((c + 1) % 3) * 3;
+                const __m128* y = a + ((c + 2) % 3) * 3;
+                n[c * 3 + 0] = _mm_sub_ps(_mm_mul_ps(x[1], y[2]), _mm_mul_ps(x[2], y[1]));
+                n[c * 3 + 1] = _mm_sub_ps(_mm_mul_ps(x[2], y[0]), _mm_mul_ps(x[0], y[2]));
+                n[c * 3 + 2] = _mm_sub_ps(_mm_mul_ps(x[0], y[1]), _mm_mul_ps(x[1], y[0]));
+            }
+            __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], n[0]), _mm_mul_ps(a[1], n[1])), _mm_mul_ps(a[2], n[2]));
+            __m128 inverse_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+            for (int k = 0; k < 9; k++)
+                _mm_storeu_ps(b->normal[k] + i, _mm_mul_ps(n[k], inverse_det));
+        }
+    }
+}
+#endif
+
+#ifdef TRANSFORM_HAVE_AVX2
+TRANSFORM_AVX2_TARGET static void batch_avx2(const TransformBatch* b) {
+    __m256 vp[16];
+    for (int k = 0; k < 16; k++)
+        vp[k] = _mm256_set1_ps(b->vp[k]);
+    for (size_t i = 0; i < b->count; i += 8) {
+        __m256 a[12];
+        for (int k = 0; k < 12; k++)
+            a[k] = _mm256_loadu_ps(b->in[k] + i);
+        if (b->mvp[0]) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    __m256 v = _mm256_mul_ps(vp[r], a[c * 3]);
+                    v = _mm256_fmadd_ps(vp[4 + r], a[c * 3 + 1], v);
+                    v = _mm256_fmadd_ps(vp[8 + r], a[c * 3 + 2], v);
+                    if (c == 3)
+                        v = _mm256_add_ps(v, vp[12 + r]);
+                    _mm256_storeu_ps(b->mvp[c * 4 + r] + i, v);
+                }
+            }
+        }
+        if (b->normal[0]) {
+            __m256 n[9];
+            for (int c = 0; c < 3; c++) {
+                const __m256* x = a + ((c + 1) % 3) * 3;
+                const __m256* y = a + ((c + 2) % 3) * 3;
+                n[c * 3 + 0] = _mm256_fmsub_ps(x[1], y[2], _mm256_mul_ps(x[2], y[1]));
+                n[c * 3 + 1] = _mm256_fmsub_ps(x[2], y[0], _mm256_mul_ps(x[0], y[2]));
+                n[c * 3 + 2] = _mm256_fmsub_ps(x[0], y[1], _mm256_mul_ps(x[1], y[0]));
+            }
+            __m256 det = _mm256_fmadd_ps(a[2], n[2], _mm256_fmadd_ps(a[1], n[1], _mm256_mul_ps(a[0], n[0])));
+            __m256 inverse_det = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+            for (int k = 0; k < 9; k++)
+                _mm256_storeu_ps(b->normal[k] + i, _mm256_mul_ps(n[k], inverse_det));
+        }
+    }
+}
+#endif
+
+void transform_batch(TransformKernel kernel, const glm::mat4& view_projection, const TransformSoA* models, Mat4SoA* mvp,
+                     Mat3SoA* normals) {
+    size_t count = models->affine[0].size();
+    TransformBatch batch;
+    memcpy(batch.vp, glm::value_ptr(view_projection), sizeof(batch.vp));
+    for (int k = 0; k < 12; k++)
+        batch.in[k] = models->affine[k].data();
+    for (int k = 0; k < 16; k++) {
+        if (mvp)
+            mvp->m[k].resize(count);
+        batch.mvp[k] = mvp ? mvp->m[k].data() : NULL;
+    }
+    for (int k = 0; k < 9; k++) {
+        if (normals)
+            normals->m[k].resize(count);
+        batch.normal[k] = normals ? normals->m[k].data() : NULL;
+    }
+    if (mvp)
+        mvp->count = models->count;
+    if (normals)
+        normals->count = models->count;
+    batch.count = count;
+    if (count == 0)
+        return;
+
+    if (kernel > transform_best_kernel())
+        kernel = transform_best_kernel();
+    switch (kernel) {
+#ifdef TRANSFORM_HAVE_AVX2
+    case TRANSFORM_KERNEL_AVX2:
+        batch_avx2(&batch);
+        break;
+#endif
+#ifdef TRANSFORM_HAVE_SSE2
+    case TRANSFORM_KERNEL_SSE2:
+        batch_sse2(&batch);
+        break;
+#endif
+    default:
+        batch_scalar(&batch);
+        break;
+    }
+}
+
+TransformKernel transform_best_kernel() {
+#ifdef TRANSFORM_HAVE_AVX2
+    // cpuid читается один раз; проверка учитывает и поддержку AVX со стороны ОС
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"));
+    if (avx2)
+        return TRANSFORM_KERNEL_AVX2;
+#endif
+#ifdef TRANSFORM_HAVE_SSE2
+    return TRANSFORM_KERNEL_SSE2;
+#else
+    return TRANSFORM_KERNEL_SCALAR;
+#endif
+}
+
+const char* transform_kernel_name(TransformKernel kernel) {
+    switch (kernel) {
+    case TRANSFORM_KERNEL_SSE2:
+        return "SSE2";
+    case TRANSFORM_KERNEL_AVX2:
+        return "AVX2+FMA";
+    default:
+        return "scalar";
+    }
+}
+
+TransformKernel transform_parse_kernel(int argc, char** argv) {
+    TransformKernel kernel = transform_best_kernel();
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--transform-kernel") != 0)
+            continue;
+        if (strcmp(argv[i + 1], "scalar") == 0)
+            kernel = TRANSFORM_KERNEL_SCALAR;
+        else if (strcmp(argv[i + 1], "sse2") == 0)
+            kernel = TRANSFORM_KERNEL_SSE2;
+    }
+    return kernel;
+}
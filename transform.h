@@ -0,0 +1,76 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+// Единый математический слой. Камера, свет и отдельные матрицы — GLM с SIMD-бэкендом
+// (GLM_FORCE_INTRINSICS, выровненные типы из gtc/type_aligned.hpp); тысячи экземпляров
+// сцены — пакетные ядра над SoA: один компонент матрицы всех экземпляров лежит подряд,
+// и AVX2 считает восемь экземпляров одной FMA без перестановок внутри регистров.
+#ifndef GLM_FORCE_INTRINSICS
+#define GLM_FORCE_INTRINSICS
+#endif
+#include <glm.hpp>
+#include <gtc/matrix_inverse.hpp>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_aligned.hpp>
+#include <gtc/type_ptr.hpp>
+#include <stddef.h>
+#include <vector>
+
+static const int TRANSFORM_BATCH_WIDTH = 8; // массивы SoA дополняются до кратного, хвостов у ядер нет
+
+typedef enum {
+    TRANSFORM_KERNEL_SCALAR,
+    TRANSFORM_KERNEL_SSE2,
+    TRANSFORM_KERNEL_AVX2      // AVX2 + FMA
+} TransformKernel;
+
+// Аффинные модельные матрицы (нижняя строка — 0 0 0 1): affine[c * 3 + r] — элемент
+// строки r столбца c у всех экземпляров, как glm::mat4[c][r]
+typedef struct {
+    std::vector<float> affine[12];
+    size_t count;
+} TransformSoA;
+
+// Результаты пакета: m[c * 4 + r] (или m[c * 3 + r] для 3x3) по экземплярам
+typedef struct {
+    std::vector<float> m[16];
+    size_t count;
+} Mat4SoA;
+
+typedef struct {
+    std::vector<float> m[9];
+    size_t count;
+} Mat3SoA;
+
+void transform_soa_resize(TransformSoA* soa, size_t count);
+// Проективная часть model (нижняя строка) отбрасывается
+void transform_soa_set(TransformSoA* soa, size_t index, const glm::mat4& model);
+glm::mat4 transform_soa_get(const TransformSoA* soa, size_t index);
+
+// mvp[i] = view_projection * model[i]; normals[i] — обратная транспонированная 3x3 часть
+// model[i] (от камеры не зависит — считается при изменении моделей). NULL — не нужно.
+void transform_batch(TransformKernel kernel, const glm::mat4& view_projection, const TransformSoA* models, Mat4SoA* mvp,
+                     Mat3SoA* normals);
+
+inline glm::mat4 mat4_soa_get(const Mat4SoA* soa, size_t index) {
+    glm::mat4 m;
+    for (int i = 0; i < 16; i++)
+        glm::value_ptr(m)[i] = soa->m[i][index];
+    return m;
+}
+
+inline glm::mat3 mat3_soa_get(const Mat3SoA* soa, size_t index) {
+    glm::mat3 m;
+    for (int i = 0; i < 9; i++)
+        glm::value_ptr(m)[i] = soa->m[i][index];
+    return m;
+}
+
+// Лучшее ядро, которое поддерживают и сборка, и процессор
+TransformKernel transform_best_kernel();
+const char* transform_kernel_name(TransformKernel kernel);
+
+// --transform-kernel scalar|sse2|avx2; не выше transform_best_kernel()
+TransformKernel transform_parse_kernel(int argc, char** argv);
+
+#endif
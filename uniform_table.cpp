@@ -0,0 +1,110 @@
+#include "uniform_table.h"
+#include <string.h>
+#include <algorithm>
+
+static uint32_t type_components(GLenum type) {
+    switch (type) {
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: return 4;
+        case GL_FLOAT_MAT3: return 9;
+        case GL_FLOAT_MAT4: return 16;
+        case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2: return 6;
+        case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2: return 8;
+        case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3: return 12;
+        default: return 1; // скаляры и сэмплеры
+    }
+}
+
+void uniform_table_build(UniformTable* table, GLuint program) {
+    table->slots.clear();
+    table->values.clear();
+    table->uploads = 0;
+    table->redundant = 0;
+
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+
+    for (GLint i = 0; i < count; i++) {
+        GLchar name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+        // Члены uniform-блоков не имеют location
+        GLint location = glGetUniformLocation(program, name);
+        if (location < 0)
+            continue;
+
+        // Массивы приходят как "name[0]" — ищем их по имени без индекса
+        if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+            name[length - 3] = '\0';
+
+        UniformSlot slot;
+        slot.name_hash = fnv1a_64(name);
+        slot.location = location;
+        slot.type = type;
+        slot.components = type_components(type) * (uint32_t)size;
+        slot.cache_offset = (uint32_t)table->values.size();
+        slot.has_value = false;
+        table->values.resize(table->values.size() + slot.components);
+        table->slots.push_back(slot);
+    }
+
+    std::sort(table->slots.begin(), table->slots.end(),
+              [](const UniformSlot& a, const UniformSlot& b) { return a.name_hash < b.name_hash; });
+}
+
+const UniformSlot* uniform_table_find(const UniformTable* table, uint64_t name_hash) {
+    auto it = std::lower_bound(table->slots.begin(), table->slots.end(), name_hash,
+                               [](const UniformSlot& slot, uint64_t hash) { return slot.name_hash < hash; });
+    if (it == table->slots.end() || it->name_hash != name_hash)
+        return NULL;
+    return &*it;
+}
+
+// Возвращает слот, если значение изменилось и его надо загрузить
+static UniformSlot* update_cached(UniformTable* table, uint64_t name_hash, const void* value, uint32_t components) {
+    UniformSlot* slot = (UniformSlot*)uniform_table_find(table, name_hash);
+    if (!slot)
+        return NULL;
+    if (components > slot->components)
+        components = slot->components;
+
+    uint32_t* cached = table->values.data() + slot->cache_offset;
+    size_t bytes = components * sizeof(uint32_t);
+    if (slot->has_value && memcmp(cached, value, bytes) == 0) {
+        table->redundant++;
+        return NULL;
+    }
+    memcpy(cached, value, bytes);
+    slot->has_value = true;
+    table->uploads++;
+    return slot;
+}
+
+void uniform_set_int(UniformTable* table, uint64_t name_hash, GLint value) {
+    if (UniformSlot* slot = update_cached(table, name_hash, &value, 1))
+        glUniform1i(slot->location, value);
+}
+
+void uniform_set_float(UniformTable* table, uint64_t name_hash, GLfloat value) {
+    if (UniformSlot* slot = update_cached(table, name_hash, &value, 1))
+        glUniform1f(slot->location, value);
+}
+
+void uniform_set_vec3(UniformTable* table, uint64_t name_hash, const GLfloat* value) {
+    if (UniformSlot* slot = update_cached(table, name_hash, value, 3))
+        glUniform3fv(slot->location, 1, value);
+}
+
+void uniform_set_vec4(UniformTable* table, uint64_t name_hash, const GLfloat* value) {
+    if (UniformSlot* slot = update_cached(table, name_hash, value, 4))
+        glUniform4fv(slot->location, 1, value);
+}
+
+void uniform_set_mat4(UniformTable* table, uint64_t name_hash, const GLfloat* value) {
+    if (UniformSlot* slot = update_cached(table, name_hash, value, 16))
+        glUniformMatrix4fv(slot->location, 1, GL_FALSE, value);
+}
@@ -0,0 +1,44 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include "include/glad.h"
+#include "hash.h"
+#include <stdint.h>
+#include <vector>
+
+// Таблица активных юниформов программы: заполняется один раз после линковки,
+// дальше поиск идёт по хешу имени без обращений к драйверу.
+
+typedef struct {
+    uint64_t name_hash;
+    GLint location;
+    GLenum type;
+    uint32_t components;   // число 32-битных слов во всём значении (с учётом массива)
+    uint32_t cache_offset; // смещение последнего загруженного значения в values
+    bool has_value;
+} UniformSlot;
+
+typedef struct {
+    std::vector<UniformSlot> slots;  // отсортированы по name_hash
+    std::vector<uint32_t> values;    // последние загруженные значения (побитово)
+    uint64_t uploads;
+    uint64_t redundant;              // пропущенные повторные загрузки
+} UniformTable;
+
+// Хеш имени юниформа гарантированно считается при компиляции
+consteval uint64_t uniform_hash(const char* name) {
+    return fnv1a_64(name);
+}
+
+void uniform_table_build(UniformTable* table, GLuint program);
+const UniformSlot* uniform_table_find(const UniformTable* table, uint64_t name_hash);
+
+// Сеттеры работают с программой, активной через glUseProgram.
+// Неизвестные имена молча пропускаются, как location == -1 в glUniform*.
+void uniform_set_int(UniformTable* table, uint64_t name_hash, GLint value);
+void uniform_set_float(UniformTable* table, uint64_t name_hash, GLfloat value);
+void uniform_set_vec3(UniformTable* table, uint64_t name_hash, const GLfloat* value);
+void uniform_set_vec4(UniformTable* table, uint64_t name_hash, const GLfloat* value);
+void uniform_set_mat4(UniformTable* table, uint64_t name_hash, const GLfloat* value);
+
+#endif